@@ -65,7 +65,8 @@
             0, \
             "static_cast<bool>(" #p ")", \
             "false" \
-        );
+        ); \
+        jewel::Log::flush();
 #else
 #   define JEWEL_LOG_ASSERTION_AUX(p) if (false) { }
 #endif  // JEWEL_ENABLE_ASSERTION_LOGGING
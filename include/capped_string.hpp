@@ -23,6 +23,8 @@
 #include "log.hpp"
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <istream>
 #include <iterator>
 #include <ostream>
@@ -339,6 +341,18 @@ operator<<
     CappedString<N> const& p_str
 );
 
+/**
+ * Writes the characters of \e p_str to [p_first, p_last), and returns a
+ * pointer one past the last character written, or a null pointer if the
+ * range is too small. No terminating null character is written. This
+ * makes CappedString a type that JEWEL_LOG_VALUE can format without heap
+ * allocation (see also jewel::to_chars in "to_chars.hpp").
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+template <std::size_t N>
+char* to_chars(char* p_first, char* p_last, CappedString<N> const& p_str);
+
 /*
  * Read from an input stream.
  *
@@ -649,7 +663,46 @@ operator<<
     return os << str.c_str();
 }
 
+template <std::size_t N>
+inline
+char* to_chars(char* p_first, char* p_last, CappedString<N> const& p_str)
+{
+    if (p_last - p_first < static_cast<std::ptrdiff_t>(p_str.size()))
+    {
+        return nullptr;
+    }
+    return std::copy(p_str.begin(), p_str.end(), p_first);
+}
+
 
 }  // namespace jewel
 
+
+namespace std
+{
+
+/**
+ * Specialization of std::hash for CappedString, so that a CappedString
+ * can be used as the key of an unordered container, or of a
+ * jewel::GroupByAggregator, without conversion to std::string.
+ *
+ * Uses the 64-bit FNV-1a hash of the characters of the string.
+ */
+template <std::size_t N>
+struct hash<jewel::CappedString<N> >
+{
+    std::size_t operator()(jewel::CappedString<N> const& p_str) const
+    {
+        std::uint64_t ret = 14695981039346656037ULL;
+        for (char c: p_str)
+        {
+            ret ^= static_cast<unsigned char>(c);
+            ret *= 1099511628211ULL;
+        }
+        return static_cast<std::size_t>(ret);
+    }
+};
+
+}  // namespace std
+
 #endif   // GUARD_capped_string_hpp_6740592125216774
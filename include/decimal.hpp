@@ -24,9 +24,11 @@
 #include <boost/numeric/conversion/cast.hpp>
 #include <algorithm>
 #include <cctype>
+#include <cstddef>
 #include <cstdlib>  // for abs
 #include <cmath>
 #include <istream>
+#include <limits>
 #include <locale>
 #include <memory>  // for allocator
 #include <ostream>
@@ -410,6 +412,73 @@ public:
      */
     Decimal& operator/=(Decimal);
 
+    /**
+     * Multiplies the Decimal by the integer \e n, with a single checked
+     * multiplication of the underlying integer. This is considerably
+     * faster than multiplying by Decimal(n, 0). Unlike operator*=, this
+     * never changes the number of places of the Decimal.
+     *
+     * @exception DecimalMultiplicationException thrown if multiplication
+     * would cause overflow.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal& mul(int_type n);
+
+    /**
+     * Divides the Decimal by the integer \e n, rounding the result half
+     * away from zero (as does round()) to the number of places the Decimal
+     * already has. This is considerably faster than dividing by
+     * Decimal(n, 0). Unlike operator/=, this never changes the number of
+     * places of the Decimal; so round() the Decimal to more places first
+     * if a more precise quotient is needed.
+     *
+     * @exception DecimalDivisionByZeroException thrown if \e n is zero.
+     *
+     * @exception DecimalDivisionException thrown if division would cause
+     * overflow (which only occurs for the smallest possible underlying
+     * integer divided by -1).
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal& div(int_type n);
+
+    /**
+     * Adds \e n units of the last place of the Decimal; e.g. for a Decimal
+     * with 2 places, adds n hundredths. Never changes the number of places
+     * of the Decimal.
+     *
+     * @exception DecimalAdditionException thrown if addition would cause
+     * overflow.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal& add_units(int_type n);
+
+    /**
+     * Equivalent to mul(n).
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal& operator*=(int_type n);
+
+    /// @cond
+    // Floating point arguments would otherwise be silently truncated to
+    // int_type.
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, Decimal&>::type
+    mul(T) = delete;
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, Decimal&>::type
+    div(T) = delete;
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, Decimal&>::type
+    add_units(T) = delete;
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, Decimal&>::type
+    operator*=(T) = delete;
+    /// @endcond
+
     /**
      * @exception DecimalIncrementationException is thrown if incrementing
      * would cause overflow. If this happens, the Decimal will be unchanged
@@ -561,12 +630,19 @@ private:
 
     /**
      * Maximum number of decimal places of precision to the right of
-     * the decimal point.
+     * the decimal point. This is the number of digits in the smallest
+     * int_type.
      */
-    static size_t const s_max_places;
+    static size_t constexpr s_max_places =
+        std::numeric_limits<int_type>::digits10 + 1;
 
     /**
      * Largest possible Decimal.
+     *
+     * This and s_minimum are initialized by a constexpr constructor, so are
+     * constant-initialized before any dynamic initialization occurs, and
+     * can be read safely from any thread (or from the constructor of another
+     * static object).
      */
     static Decimal const s_maximum;
 
@@ -598,9 +674,43 @@ private:
 
     /**
      * Power of 10 by which the underlying integer is implicitly divided.
+     *
+     * Precondition: m_places is less than s_max_places, as otherwise the
+     * divisor is not representable as an int_type.
      */
     int_type implicit_divisor() const;
 
+    /**
+     * Out-of-line general cases of operator+=, operator-=, operator< and
+     * operator==, for operands with different numbers of places, or
+     * whose underlying integers would overflow. The operators themselves
+     * handle the common case inline, and call these otherwise.
+     */
+    Decimal& add_general(Decimal rhs);
+    Decimal& subtract_general(Decimal rhs);
+    bool is_less_general(Decimal rhs) const;
+    bool is_equal_general(Decimal rhs) const;
+
+    /**
+     * Tag type for selecting the constexpr constructor.
+     */
+    struct UncheckedTag
+    {
+    };
+
+    /**
+     * Constructs a Decimal with an underlying integer of p_intval and with
+     * p_places decimal places, without checking p_places. Unlike the
+     * public constructor, this can be used in a constant expression.
+     *
+     * Precondition: p_places does not exceed s_max_places.
+     */
+    constexpr Decimal
+    (   int_type p_intval,
+        places_type p_places,
+        UncheckedTag
+    );
+
     /** This constructor is deliberately unimplemented. Ensures if an int or
      * a convertible-to-int is passed to constructor, compilation will fail.
      */
@@ -756,6 +866,35 @@ bool operator>(Decimal const& lhs, Decimal const& rhs);
  */
 bool operator>=(Decimal const& lhs, Decimal const& rhs);
 
+/**
+ * @relates Decimal
+ *
+ * @returns the product of \e lhs and the integer \e rhs, which has the
+ * same number of places as \e lhs. See Decimal::mul.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal const operator*(Decimal lhs, Decimal::int_type rhs);
+
+/**
+ * @relates Decimal
+ *
+ * @returns the product of the integer \e lhs and \e rhs, which has the
+ * same number of places as \e rhs. See Decimal::mul.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal const operator*(Decimal::int_type lhs, Decimal rhs);
+
+/// @cond
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, Decimal>::type
+operator*(Decimal, T) = delete;
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, Decimal>::type
+operator*(T, Decimal) = delete;
+/// @endcond
+
 /** Unary minus
  *
  * @relates Decimal
@@ -801,6 +940,71 @@ Decimal operator+(Decimal const& d);
  */
 Decimal round(Decimal const& x, Decimal::places_type decimal_places);
 
+/**
+ * @enum RoundingMode
+ *
+ * @relates Decimal
+ *
+ * Determines how a Decimal is rounded to fewer decimal places by the
+ * overloads of round() and by round_n() that take a RoundingMode.
+ */
+enum RoundingMode
+{
+    round_half_up = 0,   /**< nearest, with ties away from zero (as round()) */
+    round_half_even,     /**< nearest, with ties to even ("banker's") */
+    round_floor,         /**< towards negative infinity */
+    round_ceiling,       /**< towards positive infinity */
+    round_truncate       /**< towards zero */
+};
+
+/** Rounding function with selectable rounding mode
+ *
+ * @relates Decimal
+ *
+ * Behaves as round(x, decimal_places), except that where places are
+ * removed, the result is rounded according to \e mode.
+ *
+ * @exception DecimalRangeException thrown if \e decimal_places exceeds
+ * Decimal::maximum_precision(), or if achieving the requested degree of
+ * precision would cause overflow.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal round
+(   Decimal const& x,
+    Decimal::places_type decimal_places,
+    RoundingMode mode
+);
+
+/** Batch rounding function
+ *
+ * @relates Decimal
+ *
+ * Rounds each of the \e n Decimals starting at \e in to \e decimal_places
+ * places according to \e mode, as would round(x, decimal_places, mode),
+ * writing the results to the corresponding positions starting at
+ * \e out. \e in and \e out may be equal, but the ranges should not
+ * otherwise overlap. Does not allocate memory.
+ *
+ * This is considerably faster than calling round() for each Decimal,
+ * particularly where consecutive Decimals have the same number of places.
+ *
+ * @exception DecimalRangeException thrown if \e decimal_places exceeds
+ * Decimal::maximum_precision(), or if any of the Decimals cannot be
+ * rounded safely.
+ *
+ * Exception safety: <em>basic guarantee</em>. If an exception is thrown,
+ * the results for some of the Decimals preceding the one that could not
+ * be rounded may have been written.
+ */
+void round_n
+(   Decimal const* in,
+    Decimal* out,
+    std::size_t n,
+    Decimal::places_type decimal_places,
+    RoundingMode mode
+);
+
 
 }  // namespace jewel
 
@@ -810,6 +1014,8 @@ Decimal round(Decimal const& x, Decimal::places_type decimal_places);
 #include "assert.hpp"
 #include "decimal_exceptions.hpp"
 #include "exception.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/helper_macros.hpp"
 
 namespace jewel
 {
@@ -882,7 +1088,7 @@ Decimal::Decimal(std::basic_string<charT, traits, Alloc> const& str):
     
     if (str.empty())
     {
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalFromStringException,
             "Cannot construct Decimal from an empty string"
         );
@@ -908,7 +1114,7 @@ Decimal::Decimal(std::basic_string<charT, traits, Alloc> const& str):
         JEWEL_ASSERT (si < str_end);
         if (!detail::is_digit(*si))
         {
-            JEWEL_THROW
+            JEWEL_DETAIL_DECIMAL_THROW
             (   DecimalFromStringException,
                 "Invalid string passed to Decimal constructor."
             );
@@ -941,7 +1147,7 @@ Decimal::Decimal(std::basic_string<charT, traits, Alloc> const& str):
             {
                 JEWEL_ASSERT (m_places == 0);
                 JEWEL_ASSERT (m_intval == 0);
-                JEWEL_THROW
+                JEWEL_DETAIL_DECIMAL_THROW
                 (   DecimalFromStringException,
                     "Invalid string passed to Decimal constructor."
                 );
@@ -953,7 +1159,7 @@ Decimal::Decimal(std::basic_string<charT, traits, Alloc> const& str):
     }
     if (spot_position > s_max_places)
     {
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalRangeException,
             "Attempt to set m_places to a value exceeding that returned by "
             "Decimal::maximum_precision()."
@@ -967,7 +1173,7 @@ Decimal::Decimal(std::basic_string<charT, traits, Alloc> const& str):
             str_rep == stringT(1, plus_char)
         )
         {
-            JEWEL_THROW
+            JEWEL_DETAIL_DECIMAL_THROW
             (   DecimalFromStringException,
                 "Attempt to create a Decimal without any digits."
             );
@@ -981,7 +1187,7 @@ Decimal::Decimal(std::basic_string<charT, traits, Alloc> const& str):
     }
     catch (boost::bad_lexical_cast&)
     {
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalRangeException,
             "Attempt to create Decimal that is either too large, too small "
             "or too precise than is supported by the Decimal implementation."
@@ -1016,6 +1222,91 @@ Decimal::places() const
     return m_places;
 }
 
+inline
+Decimal&
+Decimal::operator*=(int_type n)
+{
+    return mul(n);
+}
+
+inline
+Decimal&
+Decimal::operator+=(Decimal rhs)
+{
+    int_type const y = rhs.m_intval;
+    if
+    (   JEWEL_DETAIL_LIKELY
+        (   (m_places == rhs.m_places) &&
+            (   (y >= 0)?
+                (m_intval <= std::numeric_limits<int_type>::max() - y):
+                (m_intval >= std::numeric_limits<int_type>::min() - y)
+            )
+        )
+    )
+    {
+        m_intval += y;
+        return *this;
+    }
+    return add_general(rhs);
+}
+
+inline
+Decimal&
+Decimal::operator-=(Decimal rhs)
+{
+    int_type const y = rhs.m_intval;
+    if
+    (   JEWEL_DETAIL_LIKELY
+        (   (m_places == rhs.m_places) &&
+            (   (y >= 0)?
+                (m_intval >= std::numeric_limits<int_type>::min() + y):
+                (m_intval <= std::numeric_limits<int_type>::max() + y)
+            )
+        )
+    )
+    {
+        m_intval -= y;
+        return *this;
+    }
+    return subtract_general(rhs);
+}
+
+inline
+bool
+Decimal::operator<(Decimal rhs) const
+{
+    if (JEWEL_DETAIL_LIKELY(m_places == rhs.m_places))
+    {
+        return m_intval < rhs.m_intval;
+    }
+    return is_less_general(rhs);
+}
+
+inline
+bool
+Decimal::operator==(Decimal rhs) const
+{
+    if (JEWEL_DETAIL_LIKELY(m_places == rhs.m_places))
+    {
+        return m_intval == rhs.m_intval;
+    }
+    return is_equal_general(rhs);
+}
+
+// Inline constructor
+
+constexpr
+Decimal::Decimal
+(   int_type p_intval,
+    places_type p_places,
+    UncheckedTag
+):
+    m_places(p_places),
+    m_intval(p_intval)
+{
+}
+
+
 // Inline static class functions
 
 inline
@@ -1073,6 +1364,22 @@ operator/(Decimal lhs, Decimal const& rhs)
     return lhs;
 }
 
+inline
+Decimal const
+operator*(Decimal lhs, Decimal::int_type rhs)
+{
+    lhs.mul(rhs);
+    return lhs;
+}
+
+inline
+Decimal const
+operator*(Decimal::int_type lhs, Decimal rhs)
+{
+    rhs.mul(lhs);
+    return rhs;
+}
+
 inline
 Decimal
 operator+(Decimal const& d)
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_decimal64_hpp_3306174597264410
+#define GUARD_decimal64_hpp_3306174597264410
+
+/** @file
+ *
+ * @brief Exact conversion between jewel::Decimal and the IEEE 754-2008
+ * \e decimal64 interchange format, using the binary integer decimal (BID)
+ * encoding.
+ *
+ * A \e decimal64 is passed around here as the \e std::uint64_t holding its
+ * 64-bit encoding, in the form in which it would be stored by e.g. a
+ * database or by a compiler's \e _Decimal64 type on a BID platform.
+ *
+ * Conversion in either direction is exact, or else fails: no rounding
+ * ever occurs. A \e decimal64 has a 16-digit coefficient, while a Decimal
+ * can have up to Decimal::maximum_precision() digits; and a \e decimal64 has
+ * a much wider exponent range than a Decimal. Conversion to \e decimal64
+ * preserves the number of places of the Decimal wherever the coefficient
+ * permits, so that a round trip via \e decimal64 yields a Decimal that is not
+ * only equal to, but has the same places() as, the original.
+ */
+
+#include "decimal.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace jewel
+{
+
+/**
+ * @relates Decimal
+ *
+ * @returns the BID-encoded \e decimal64 that is exactly equal to \e x.
+ *
+ * Trailing fractional zeroes are only removed from \e x to the extent
+ * necessary to fit the coefficient into 16 digits.
+ *
+ * @exception DecimalRangeException thrown if \e x cannot be represented
+ * exactly as a \e decimal64 (i.e. if it has more than 16 significant
+ * digits, ignoring trailing zeroes).
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+std::uint64_t to_decimal64(Decimal const& x);
+
+/**
+ * @relates Decimal
+ *
+ * @returns the Decimal that is exactly equal to the BID-encoded
+ * \e decimal64 \e p_bits. The number of places of the result is the
+ * negative of the exponent of \e p_bits where possible. Non-canonical
+ * encodings are treated as zero, per IEEE 754-2008.
+ *
+ * @exception DecimalRangeException thrown if \e p_bits encodes an
+ * infinity or a NaN, or a number that cannot be represented exactly by
+ * a Decimal.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal from_decimal64(std::uint64_t p_bits);
+
+/**
+ * @relates Decimal
+ *
+ * Converts each of the \e n Decimals starting at \e in into a
+ * BID-encoded \e decimal64, which is written to the corresponding position
+ * starting at \e out. Does not allocate memory.
+ *
+ * Conversion stops at the first Decimal that cannot be represented exactly.
+ *
+ * @returns the number of Decimals successfully converted. If this is
+ * less than \e n, it is the index of the Decimal that could not be
+ * converted.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+std::size_t to_decimal64
+(   Decimal const* in,
+    std::uint64_t* out,
+    std::size_t n
+);
+
+/**
+ * @relates Decimal
+ *
+ * Converts each of the \e n BID-encoded \e decimal64 values starting at
+ * \e in into a Decimal, which is written to the corresponding position
+ * starting at \e out. Does not allocate memory.
+ *
+ * Conversion stops at the first value that is an infinity or NaN, or
+ * that cannot be represented exactly by a Decimal.
+ *
+ * @returns the number of values successfully converted. If this is
+ * less than \e n, it is the index of the value that could not be
+ * converted.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+std::size_t from_decimal64
+(   std::uint64_t const* in,
+    Decimal* out,
+    std::size_t n
+);
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal64_hpp_3306174597264410
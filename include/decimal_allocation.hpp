@@ -0,0 +1,76 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GUARD_decimal_allocation_hpp_8214630598172254
+#define GUARD_decimal_allocation_hpp_8214630598172254
+
+/** @file
+ *
+ * @brief Pro-rata allocation of a jewel::Decimal total, such that the
+ * parts sum exactly to the total.
+ */
+
+#include "decimal.hpp"
+#include <cstddef>
+
+namespace jewel
+{
+
+/**
+ * @relates Decimal
+ *
+ * Splits \e total into \e n parts in proportion to the \e n weights
+ * starting at \e weights, and writes them, each with exactly \e places
+ * decimal places, to the corresponding positions starting at \e out.
+ * The parts always sum exactly to \e total.
+ *
+ * Each part is first set to its exact pro-rata share, rounded towards
+ * zero to \e places places. The units of the last place that this leaves
+ * unallocated are then given out, one each, to the parts whose shares were
+ * most reduced by that rounding (the "largest remainder" method), with ties
+ * going to the earlier part. No part therefore differs from its exact
+ * share by as much as one unit of the last place.
+ *
+ * The calculation uses 128-bit integer arithmetic, so is exact, and takes
+ * time proportional to \e n on average.
+ *
+ * @exception DecimalRangeException thrown if \e places exceeds
+ * Decimal::maximum_precision(); if \e total cannot be represented exactly
+ * with \e places places; or if the weights, expressed as integers with the
+ * greatest number of places of any weight, do not all fit in 64 bits.
+ *
+ * @exception DecimalDomainException thrown if any weight is negative.
+ *
+ * @exception DecimalDivisionByZeroException thrown if the weights sum to
+ * zero (including if \e n is zero).
+ *
+ * @exception std::bad_alloc thrown in the unlikely event of memory
+ * allocation failure. (Memory is allocated for the remainders.)
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+void allocate
+(   Decimal const& total,
+    Decimal const* weights,
+    std::size_t n,
+    Decimal::places_type places,
+    Decimal* out
+);
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal_allocation_hpp_8214630598172254
@@ -0,0 +1,541 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_decimal_column_hpp_5820943168735214
+#define GUARD_decimal_column_hpp_5820943168735214
+
+/** @file
+ *
+ * @brief Facilities for storing a column of Decimal numbers on disk, in a
+ * simple binary format that can be memory-mapped and read without parsing.
+ *
+ * @see jewel::DecimalColumnWriter
+ * @see jewel::DecimalColumn
+ * @see jewel::DecimalColumnException
+ */
+
+#include "decimal.hpp"
+#include "exception.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace jewel
+{
+
+/** @class jewel::DecimalColumnException
+ *
+ * @extends jewel::Exception
+ *
+ * Exception to be thrown when a Decimal column file cannot be written,
+ * opened or mapped, or when its contents are not in the expected format.
+ */
+
+/// @cond
+JEWEL_DERIVED_EXCEPTION(DecimalColumnException, jewel::Exception);
+/// @endcond
+
+
+/// @cond
+namespace detail
+{
+
+/**
+ * Layout of the header at the start of a Decimal column file. All
+ * integers are stored in the byte order of the machine that wrote the
+ * file; \e byte_order_mark allows a reader on a machine of the other
+ * endianness to detect this and refuse the file.
+ */
+struct DecimalColumnHeader
+{
+    char magic[8];
+    std::uint32_t byte_order_mark;
+    std::uint32_t version;
+    std::uint32_t scale_mode;
+    std::uint32_t reserved;
+    std::uint64_t value_count;
+    std::uint64_t block_size;
+    std::uint64_t block_count;
+    std::uint64_t block_table_offset;
+};
+
+/**
+ * Layout of each entry in the block table at the end of a Decimal column
+ * file. The mantissas of the block are stored as a contiguous array of
+ * Decimal::int_type, starting \e offset bytes from the start of the file;
+ * each of them is implicitly divided by 10 raised to \e places.
+ */
+struct DecimalColumnBlockInfo
+{
+    std::int64_t min_intval;
+    std::int64_t max_intval;
+    std::uint64_t offset;
+    std::uint32_t count;
+    std::uint8_t places;
+    std::uint8_t reserved[3];
+};
+
+}  // namespace detail
+/// @endcond
+
+
+/**
+ * @brief Writes a sequence of Decimal numbers to a file in a columnar
+ * binary format, suitable for reading back via a DecimalColumn.
+ *
+ * The file consists of a header, followed by the values grouped into
+ * blocks of (at most) a fixed number of values, followed by a table
+ * recording, for each block, its location in the file, its scale (number
+ * of decimal places) and the minimum and maximum values in the block.
+ * Within each block the underlying integers of the values are stored
+ * as a plain array, all at the same scale, so that a reader can map the
+ * file into memory and use the arrays directly.
+ *
+ * The scale of each block is determined by the ScaleMode passed to the
+ * constructor. With \e fixed_scale, every value is rounded (using
+ * jewel::round) to the number of places passed to the constructor. With
+ * \e per_block_scale, each block is stored at the greatest number of places
+ * of any value in that block, so that no precision is lost.
+ *
+ * Values are buffered in memory until a block is complete. The block table
+ * and header are only written when close() is called (or the writer is
+ * destroyed). A file that has not been closed is not a valid column file.
+ *
+ * Files are written in the native byte order of the machine, and can only
+ * be read on a machine of the same byte order.
+ *
+ * Exception safety: if append() throws DecimalRangeException, it offers
+ * the <em>strong guarantee</em>, and further values can still be appended.
+ * Otherwise, appending a value or closing offers the <em>basic
+ * guarantee</em> only; if writing to the file fails, the file should be
+ * regarded as unusable.
+ */
+class DecimalColumnWriter
+{
+public:
+
+    /**
+     * @enum ScaleMode
+     *
+     * Determines how the scale (number of decimal places) of each block
+     * is chosen. See class documentation.
+     */
+    enum ScaleMode
+    {
+        fixed_scale = 0,     /**< all blocks share a single scale */
+        per_block_scale      /**< each block has its own scale */
+    };
+
+    /**
+     * Default number of values per block.
+     */
+    static std::size_t const default_block_size = 4096;
+
+    /**
+     * Opens \e p_filepath for writing, truncating any existing file.
+     *
+     * @param p_places the number of decimal places at which to store the
+     * values if \e p_scale_mode is \e fixed_scale; ignored otherwise.
+     *
+     * @param p_block_size the maximum number of values in each block. Must
+     * be greater than 0.
+     *
+     * @exception DecimalColumnException thrown if the file cannot be opened,
+     * if \e p_block_size is 0, or if \e p_places exceeds
+     * Decimal::maximum_precision().
+     */
+    DecimalColumnWriter
+    (   std::string const& p_filepath,
+        ScaleMode p_scale_mode,
+        Decimal::places_type p_places = 0,
+        std::size_t p_block_size = default_block_size
+    );
+
+    DecimalColumnWriter(DecimalColumnWriter const&) = delete;
+    DecimalColumnWriter(DecimalColumnWriter&&) = delete;
+    DecimalColumnWriter& operator=(DecimalColumnWriter const&) = delete;
+    DecimalColumnWriter& operator=(DecimalColumnWriter&&) = delete;
+
+    /**
+     * Calls close() if it has not already been called, swallowing any
+     * exception. Call close() explicitly if you want to be told about
+     * failure.
+     */
+    ~DecimalColumnWriter();
+
+    /**
+     * Append a value to the column.
+     *
+     * @exception DecimalRangeException thrown if the value cannot be
+     * represented at the scale of the block it falls into (including as
+     * a result of rounding to the fixed scale, if applicable), or if,
+     * with \e per_block_scale, the values already in that block cannot be
+     * represented at the number of places of the new value. The value is
+     * then not appended.
+     *
+     * @exception DecimalColumnException thrown if writing to the file
+     * fails, or if close() has already been called.
+     */
+    void append(Decimal const& p_value);
+
+    /**
+     * Append \e p_count values, starting at \e p_values.
+     *
+     * Behaviour re. exceptions is the same as for append(Decimal const&).
+     */
+    void append(Decimal const* p_values, std::size_t p_count);
+
+    /**
+     * Write any partially filled block, the block table and the header,
+     * and close the file. Calling close() more than once has no further
+     * effect.
+     *
+     * @exception DecimalColumnException thrown if writing to the file fails.
+     */
+    void close();
+
+private:
+
+    void write_block();
+    void write_raw(void const* p_data, std::size_t p_size);
+
+    std::ofstream m_file;
+    ScaleMode const m_scale_mode;
+    Decimal::places_type const m_places;
+    std::size_t const m_block_size;
+    std::uint64_t m_value_count;
+    std::uint64_t m_offset;
+    bool m_is_closed;
+
+    // The scale of, and the underlying integers of, the values in the
+    // block not yet written.
+    Decimal::places_type m_block_places;
+    std::vector<Decimal::int_type> m_intvals;
+    std::vector<detail::DecimalColumnBlockInfo> m_blocks;
+};
+
+
+/**
+ * @brief Provides read-only access to a file written by DecimalColumnWriter,
+ * without parsing or copying the values.
+ *
+ * On construction the file is mapped into memory (using \e mmap on
+ * POSIX systems). The arrays of underlying integers in each block are then
+ * exposed directly via DecimalColumn::Block, so that a client can scan
+ * the values at the speed of a plain integer array. (On Windows the file
+ * is currently read into memory instead, as memory mapping is not yet
+ * implemented there.)
+ *
+ * The minimum and maximum values recorded for each block allow range
+ * queries, via for_each_in_range(), to skip whole blocks that cannot
+ * contain any value in the range.
+ *
+ * Exception safety: apart from the constructor, and unless otherwise
+ * stated, member functions offer the <em>nothrow guarantee</em>.
+ */
+class DecimalColumn
+{
+public:
+
+    /**
+     * @brief A read-only view of a single block of a DecimalColumn.
+     *
+     * The Block remains valid only as long as the DecimalColumn from which
+     * it was obtained.
+     */
+    class Block
+    {
+    public:
+
+        /**
+         * @returns a pointer to the first of size() underlying integers
+         * in the block. Each is implicitly divided by 10 raised to
+         * places().
+         */
+        Decimal::int_type const* intvals() const;
+
+        /**
+         * @returns the number of values in the block.
+         */
+        std::size_t size() const;
+
+        /**
+         * @returns the number of decimal places shared by all the values
+         * in the block.
+         */
+        Decimal::places_type places() const;
+
+        /**
+         * @returns the value at position \e p_index within the block.
+         * Behaviour is undefined if \e p_index is out of range.
+         */
+        Decimal operator[](std::size_t p_index) const;
+
+        /**
+         * @returns the smallest value in the block.
+         */
+        Decimal minimum() const;
+
+        /**
+         * @returns the largest value in the block.
+         */
+        Decimal maximum() const;
+
+        /**
+         * Translate the closed range [\e p_lower, \e p_upper] into a
+         * closed range [\e p_lower_intval, \e p_upper_intval] of underlying
+         * integers at the scale of this block, so that a value in the block
+         * lies within the range of Decimals if and only if its
+         * underlying integer lies within the range of integers.
+         *
+         * @returns \e false if no value at the scale of this block could
+         * lie within the range, in which case \e p_lower_intval and
+         * \e p_upper_intval are left unchanged; otherwise \e true.
+         */
+        bool intval_bounds
+        (   Decimal const& p_lower,
+            Decimal const& p_upper,
+            Decimal::int_type& p_lower_intval,
+            Decimal::int_type& p_upper_intval
+        ) const;
+
+    private:
+        friend class DecimalColumn;
+        Block
+        (   detail::DecimalColumnBlockInfo const* p_info,
+            Decimal::int_type const* p_intvals
+        );
+        detail::DecimalColumnBlockInfo const* m_info;
+        Decimal::int_type const* m_intvals;
+    };
+
+    /**
+     * Maps the file at \e p_filepath into memory.
+     *
+     * @exception DecimalColumnException thrown if the file cannot be
+     * opened or mapped, or is not a valid Decimal column file written on
+     * a machine with the same byte order.
+     */
+    explicit DecimalColumn(std::string const& p_filepath);
+
+    DecimalColumn(DecimalColumn const&) = delete;
+    DecimalColumn(DecimalColumn&&) = delete;
+    DecimalColumn& operator=(DecimalColumn const&) = delete;
+    DecimalColumn& operator=(DecimalColumn&&) = delete;
+
+    /**
+     * Unmaps the file.
+     */
+    ~DecimalColumn();
+
+    /**
+     * @returns the total number of values in the column.
+     */
+    std::size_t size() const;
+
+    /**
+     * @returns the value at position \e p_index in the column. Behaviour is
+     * undefined if \e p_index is out of range.
+     */
+    Decimal operator[](std::size_t p_index) const;
+
+    /**
+     * @returns the number of blocks in the column.
+     */
+    std::size_t block_count() const;
+
+    /**
+     * @returns the number of values per block (the last block may contain
+     * fewer).
+     */
+    std::size_t block_size() const;
+
+    /**
+     * @returns a view of the block at position \e p_index. Behaviour is
+     * undefined if \e p_index is out of range.
+     */
+    Block block(std::size_t p_index) const;
+
+    /**
+     * Call \e p_func(i, x) for each value \e x in the column such that
+     * <tt>p_lower <= x && x <= p_upper</tt>, in order of position \e i.
+     * Blocks whose minimum and maximum show that they cannot contain any
+     * such value are skipped without being read.
+     *
+     * @returns the number of values for which \e p_func was called.
+     *
+     * Exception safety: depends on \e p_func. This function itself
+     * does not throw.
+     */
+    template <typename Func>
+    std::size_t for_each_in_range
+    (   Decimal const& p_lower,
+        Decimal const& p_upper,
+        Func p_func
+    ) const;
+
+private:
+
+    unsigned char const* data() const;
+
+    detail::DecimalColumnHeader const* m_header;
+    detail::DecimalColumnBlockInfo const* m_blocks;
+    void* m_mapping;
+    std::size_t m_mapping_size;
+    std::vector<unsigned char> m_buffer;  // used only if not memory mapped
+};
+
+
+// INLINE FUNCTION DEFINITIONS
+
+inline
+DecimalColumn::Block::Block
+(   detail::DecimalColumnBlockInfo const* p_info,
+    Decimal::int_type const* p_intvals
+):
+    m_info(p_info),
+    m_intvals(p_intvals)
+{
+}
+
+inline
+Decimal::int_type const*
+DecimalColumn::Block::intvals() const
+{
+    return m_intvals;
+}
+
+inline
+std::size_t
+DecimalColumn::Block::size() const
+{
+    return m_info->count;
+}
+
+inline
+Decimal::places_type
+DecimalColumn::Block::places() const
+{
+    return m_info->places;
+}
+
+inline
+Decimal
+DecimalColumn::Block::operator[](std::size_t p_index) const
+{
+    JEWEL_ASSERT (p_index < size());
+    return Decimal(m_intvals[p_index], places());
+}
+
+inline
+Decimal
+DecimalColumn::Block::minimum() const
+{
+    return Decimal(m_info->min_intval, places());
+}
+
+inline
+Decimal
+DecimalColumn::Block::maximum() const
+{
+    return Decimal(m_info->max_intval, places());
+}
+
+inline
+std::size_t
+DecimalColumn::size() const
+{
+    return m_header->value_count;
+}
+
+inline
+std::size_t
+DecimalColumn::block_count() const
+{
+    return m_header->block_count;
+}
+
+inline
+std::size_t
+DecimalColumn::block_size() const
+{
+    return m_header->block_size;
+}
+
+inline
+DecimalColumn::Block
+DecimalColumn::block(std::size_t p_index) const
+{
+    JEWEL_ASSERT (p_index < block_count());
+    detail::DecimalColumnBlockInfo const* const info = m_blocks + p_index;
+    return Block
+    (   info,
+        reinterpret_cast<Decimal::int_type const*>(data() + info->offset)
+    );
+}
+
+inline
+Decimal
+DecimalColumn::operator[](std::size_t p_index) const
+{
+    JEWEL_ASSERT (p_index < size());
+    return block(p_index / block_size())[p_index % block_size()];
+}
+
+template <typename Func>
+std::size_t
+DecimalColumn::for_each_in_range
+(   Decimal const& p_lower,
+    Decimal const& p_upper,
+    Func p_func
+) const
+{
+    std::size_t ret = 0;
+    std::size_t const num_blocks = block_count();
+    for (std::size_t i = 0; i != num_blocks; ++i)
+    {
+        Block const blk = block(i);
+        Decimal::int_type lower = 0;
+        Decimal::int_type upper = 0;
+        if
+        (   !blk.intval_bounds(p_lower, p_upper, lower, upper) ||
+            (m_blocks[i].max_intval < lower) ||
+            (m_blocks[i].min_intval > upper)
+        )
+        {
+            continue;
+        }
+        std::size_t const base = i * block_size();
+        Decimal::int_type const* const intvals = blk.intvals();
+        std::size_t const sz = blk.size();
+        for (std::size_t j = 0; j != sz; ++j)
+        {
+            Decimal::int_type const x = intvals[j];
+            if (x >= lower && x <= upper)
+            {
+                p_func(base + j, Decimal(x, blk.places()));
+                ++ret;
+            }
+        }
+    }
+    return ret;
+}
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal_column_hpp_5820943168735214
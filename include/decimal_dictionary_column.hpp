@@ -0,0 +1,327 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_decimal_dictionary_column_hpp_8780932329255674
+#define GUARD_decimal_dictionary_column_hpp_8780932329255674
+
+/** @file
+ *
+ * @brief A compact in-memory column of Decimal numbers, for data in which
+ * relatively few distinct values are repeated many times.
+ *
+ * @see jewel::DecimalDictionaryColumn
+ */
+
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "detail/bit_packing.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jewel
+{
+
+/**
+ * @brief Stores a sequence of Decimal numbers as a sorted dictionary of the
+ * distinct values in the sequence, plus, for each position, a bit-packed
+ * code identifying its value in the dictionary.
+ *
+ * This suits "low-cardinality" data, such as prices, where a column of
+ * many millions of values may contain only a few thousand distinct
+ * values. Each value then occupies only as many bits as are needed to
+ * number the distinct values (12 bits for 4096 of them), rather than the
+ * 16 bytes or so of a Decimal.
+ *
+ * The dictionary holds the distinct values as underlying integers at a
+ * single scale, being the greatest number of places of any value in the
+ * column. Values are therefore decoded with that number of places: a
+ * column encoded from "1.5" and "2.25" decodes to "1.50" and "2.25". The
+ * values compare equal to the originals, but may print differently.
+ *
+ * As the dictionary is sorted, code order is the same as value order.
+ * Aggregation and range queries are carried out on the codes, consulting
+ * the dictionary only once per distinct value, rather than once per
+ * position: see sum(), count_in_range() and for_each_in_range().
+ *
+ * A DecimalDictionaryColumn is immutable once constructed, and so may be
+ * read concurrently from multiple threads.
+ *
+ * Exception safety: apart from the constructor, and unless otherwise
+ * stated, member functions offer the <em>nothrow guarantee</em>.
+ */
+class DecimalDictionaryColumn
+{
+public:
+
+    /**
+     * Integer type identifying a value in the dictionary. Code \e c
+     * corresponds to the <em>c</em>th smallest distinct value.
+     */
+    typedef std::uint32_t code_type;
+
+    /**
+     * Constructs an empty column.
+     */
+    DecimalDictionaryColumn();
+
+    /**
+     * Encodes the \e p_count values starting at \e p_values.
+     *
+     * @exception DecimalRangeException thrown if some value cannot be
+     * represented with as many places as the value in the sequence with
+     * the most places. (This can only happen for values very close to the
+     * limits of Decimal, or with many places.)
+     *
+     * @exception std::bad_alloc thrown in the unlikely event of memory
+     * allocation failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    DecimalDictionaryColumn(Decimal const* p_values, std::size_t p_count);
+
+    /**
+     * @returns the number of values in the column.
+     */
+    std::size_t size() const;
+
+    /**
+     * @returns the number of decimal places with which values are decoded.
+     */
+    Decimal::places_type places() const;
+
+    /**
+     * @returns the number of distinct values in the column.
+     */
+    std::size_t dictionary_size() const;
+
+    /**
+     * @returns the number of bits occupied by each code.
+     */
+    unsigned int code_width() const;
+
+    /**
+     * @returns the number of bytes of memory occupied by the dictionary
+     * and the codes.
+     */
+    std::size_t memory_usage() const;
+
+    /**
+     * @returns the value corresponding to code \e p_code. Behaviour is
+     * undefined unless <tt>p_code < dictionary_size()</tt>.
+     */
+    Decimal dictionary_entry(code_type p_code) const;
+
+    /**
+     * @returns the code of the value at position \e p_index. Behaviour is
+     * undefined if \e p_index is out of range.
+     */
+    code_type code(std::size_t p_index) const;
+
+    /**
+     * @returns the value at position \e p_index. Behaviour is
+     * undefined if \e p_index is out of range.
+     */
+    Decimal operator[](std::size_t p_index) const;
+
+    /**
+     * Decodes the \e p_count values starting at position \e p_first, and
+     * writes them to \e p_out. Behaviour is undefined if the range is not
+     * within the column.
+     */
+    void decode
+    (   std::size_t p_first,
+        std::size_t p_count,
+        Decimal* p_out
+    ) const;
+
+    /**
+     * Translate the closed range [\e p_lower, \e p_upper] into a
+     * closed range [\e p_first_code, \e p_last_code] of codes, so that a
+     * value in the column lies within the range of Decimals if and only if
+     * its code lies within the range of codes. This requires only a binary
+     * search of the dictionary.
+     *
+     * @returns \e false if no value in the column lies within the range,
+     * in which case \e p_first_code and \e p_last_code are left unchanged;
+     * otherwise \e true.
+     */
+    bool code_bounds
+    (   Decimal const& p_lower,
+        Decimal const& p_upper,
+        code_type& p_first_code,
+        code_type& p_last_code
+    ) const;
+
+    /**
+     * @returns the sum of all the values in the column, with places()
+     * decimal places, computed from the number of occurrences of each
+     * code.
+     *
+     * @exception DecimalAdditionException thrown if the sum cannot be
+     * represented as a Decimal.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal sum() const;
+
+    /**
+     * @returns the sum of the values \e x in the column such that
+     * <tt>p_lower <= x && x <= p_upper</tt>, with places() decimal places.
+     *
+     * @exception DecimalAdditionException thrown if the sum cannot be
+     * represented as a Decimal.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal sum_in_range(Decimal const& p_lower, Decimal const& p_upper) const;
+
+    /**
+     * @returns the number of values \e x in the column such that
+     * <tt>p_lower <= x && x <= p_upper</tt>.
+     */
+    std::size_t count_in_range
+    (   Decimal const& p_lower,
+        Decimal const& p_upper
+    ) const;
+
+    /**
+     * Call \e p_func(i, x) for each value \e x in the column such that
+     * <tt>p_lower <= x && x <= p_upper</tt>, in order of position \e i.
+     * Each position is tested by comparing its code with the bounds
+     * obtained from code_bounds(), without decoding the value.
+     *
+     * @returns the number of values for which \e p_func was called.
+     *
+     * Exception safety: depends on \e p_func. This function itself
+     * does not throw.
+     */
+    template <typename Func>
+    std::size_t for_each_in_range
+    (   Decimal const& p_lower,
+        Decimal const& p_upper,
+        Func p_func
+    ) const;
+
+private:
+
+    /**
+     * Writes to \e p_counts, which must hold dictionary_size() elements,
+     * the number of occurrences of each code.
+     */
+    void count_codes(std::vector<std::size_t>& p_counts) const;
+
+    /**
+     * @returns the sum of the values with codes in the closed range
+     * [\e p_first_code, \e p_last_code].
+     */
+    Decimal sum_codes(code_type p_first_code, code_type p_last_code) const;
+
+    std::size_t m_size;
+    Decimal::places_type m_places;
+    unsigned int m_code_width;
+    std::vector<Decimal::int_type> m_dictionary;
+    std::vector<std::uint64_t> m_words;
+};
+
+
+// INLINE FUNCTION DEFINITIONS
+
+inline
+std::size_t
+DecimalDictionaryColumn::size() const
+{
+    return m_size;
+}
+
+inline
+Decimal::places_type
+DecimalDictionaryColumn::places() const
+{
+    return m_places;
+}
+
+inline
+std::size_t
+DecimalDictionaryColumn::dictionary_size() const
+{
+    return m_dictionary.size();
+}
+
+inline
+unsigned int
+DecimalDictionaryColumn::code_width() const
+{
+    return m_code_width;
+}
+
+inline
+Decimal
+DecimalDictionaryColumn::dictionary_entry(code_type p_code) const
+{
+    JEWEL_ASSERT (p_code < dictionary_size());
+    return Decimal(m_dictionary[p_code], m_places);
+}
+
+inline
+DecimalDictionaryColumn::code_type
+DecimalDictionaryColumn::code(std::size_t p_index) const
+{
+    JEWEL_ASSERT (p_index < size());
+    return static_cast<code_type>
+    (   detail::unpack_bit_field(&m_words[0], m_code_width, p_index)
+    );
+}
+
+inline
+Decimal
+DecimalDictionaryColumn::operator[](std::size_t p_index) const
+{
+    return dictionary_entry(code(p_index));
+}
+
+template <typename Func>
+std::size_t
+DecimalDictionaryColumn::for_each_in_range
+(   Decimal const& p_lower,
+    Decimal const& p_upper,
+    Func p_func
+) const
+{
+    code_type first_code = 0;
+    code_type last_code = 0;
+    if (!code_bounds(p_lower, p_upper, first_code, last_code))
+    {
+        return 0;
+    }
+    // A single unsigned comparison tests both bounds.
+    code_type const span = last_code - first_code;
+    std::size_t ret = 0;
+    for (std::size_t i = 0; i != m_size; ++i)
+    {
+        code_type const c = code(i);
+        if (static_cast<code_type>(c - first_code) <= span)
+        {
+            p_func(i, Decimal(m_dictionary[c], m_places));
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal_dictionary_column_hpp_8780932329255674
@@ -97,6 +97,12 @@ JEWEL_DERIVED_EXCEPTION(DecimalException, Exception);
     JEWEL_DERIVED_EXCEPTION(DecimalStreamReadException, DecimalException);
     /// @endcond
 
+    /// @class jewel::DecimalDomainException
+    /// @extends jewel::DecimalException
+    /// @cond
+    JEWEL_DERIVED_EXCEPTION(DecimalDomainException, DecimalException);
+    /// @endcond
+
 }  // namespace jewel
 
 #endif  // GUARD_decimal_exceptions_hpp_7516391215620745
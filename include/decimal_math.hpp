@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_decimal_math_hpp_3416865653824462
+#define GUARD_decimal_math_hpp_3416865653824462
+
+/** @file
+ *
+ * @brief Mathematical functions of jewel::Decimal.
+ *
+ * Each function returns a Decimal with exactly the number of decimal places
+ * requested by the caller, rounded half away from zero (as with
+ * jewel::round). The calculation is performed using integer arithmetic only,
+ * with 128-bit and 256-bit intermediates carrying around 38 significant
+ * digits, so results are correctly rounded except, conceivably, in
+ * cases lying within about 10<sup>-30</sup> of a rounding boundary.
+ * sqrt() is always correctly rounded.
+ *
+ * As with the rest of the Decimal API, the result must fit within a
+ * Decimal; so, for example, \c exp(Decimal("40"), 5) throws, as the
+ * result would require more than Decimal::maximum_precision() digits,
+ * whereas \c exp(Decimal("40"), 1) succeeds.
+ */
+
+#include "decimal.hpp"
+
+namespace jewel
+{
+
+/**
+ * @relates Decimal
+ *
+ * @returns the square root of \e x, rounded to \e places decimal places.
+ *
+ * @exception DecimalDomainException thrown if \e x is negative.
+ *
+ * @exception DecimalRangeException thrown if \e places exceeds
+ * Decimal::maximum_precision(), or if the result cannot be represented
+ * with \e places decimal places.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal sqrt(Decimal const& x, Decimal::places_type places);
+
+/**
+ * @relates Decimal
+ *
+ * @returns \e x raised to the power \e n, rounded to \e places decimal
+ * places. Zero raised to the power zero is one. The calculation is
+ * performed by binary exponentiation, so takes time proportional to the
+ * logarithm of \e n.
+ *
+ * @exception DecimalDivisionByZeroException thrown if \e x is zero and
+ * \e n is negative.
+ *
+ * @exception DecimalRangeException thrown if \e places exceeds
+ * Decimal::maximum_precision(), or if the result cannot be represented
+ * with \e places decimal places.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal pow(Decimal const& x, int n, Decimal::places_type places);
+
+/**
+ * @relates Decimal
+ *
+ * @returns \e e raised to the power \e x, rounded to \e places decimal
+ * places.
+ *
+ * @exception DecimalRangeException thrown if \e places exceeds
+ * Decimal::maximum_precision(), or if the result cannot be represented
+ * with \e places decimal places.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal exp(Decimal const& x, Decimal::places_type places);
+
+/**
+ * @relates Decimal
+ *
+ * @returns the natural logarithm of \e x, rounded to \e places decimal
+ * places.
+ *
+ * @exception DecimalDomainException thrown if \e x is not positive.
+ *
+ * @exception DecimalRangeException thrown if \e places exceeds
+ * Decimal::maximum_precision(), or if the result cannot be represented
+ * with \e places decimal places.
+ *
+ * Exception safety: <em>strong guarantee</em>.
+ */
+Decimal ln(Decimal const& x, Decimal::places_type places);
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal_math_hpp_3416865653824462
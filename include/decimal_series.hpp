@@ -0,0 +1,216 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_decimal_series_hpp_9706269431606775
+#define GUARD_decimal_series_hpp_9706269431606775
+
+/** @file
+ *
+ * @brief A compressed in-memory series of Decimal numbers, for data such as
+ * prices and balances that change by small steps.
+ *
+ * @see jewel::DecimalSeries
+ */
+
+#include "decimal.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jewel
+{
+
+/**
+ * @brief Stores a growing sequence of Decimal numbers, all with the same
+ * number of decimal places, compressed in fixed-size blocks.
+ *
+ * Values are appended one at a time, or in batches. Each is first rounded
+ * (using jewel::round) to the number of places passed to the constructor,
+ * and its underlying integer stored. Once \e block_size values have been
+ * appended, they are compressed into a block, in whichever of the
+ * following two forms is the smaller:
+ *
+ * - <em>frame of reference</em>: the smallest underlying integer in the
+ *   block is stored as the block's base, and each value is stored as its
+ *   difference from the base, bit-packed using just enough bits for the
+ *   largest such difference; or
+ *
+ * - <em>delta</em>: the first underlying integer in the block is stored
+ *   as the block's base, and each subsequent value is stored as its
+ *   difference from the one before, bit-packed in the same way (after
+ *   mapping signed differences to unsigned integers).
+ *
+ * A price series that moves by a few ticks at a time thus needs only a few
+ * bits per value, rather than the 16 bytes or so of a Decimal. Values
+ * appended since the last complete block are kept uncompressed until the
+ * block is complete.
+ *
+ * Blocks can be decoded independently of one another, so that any block
+ * can be accessed at random via decode_block(). Decoding a block is a
+ * single branch-free loop over its packed words.
+ *
+ * Exception safety: apart from the constructor, and unless otherwise
+ * stated, member functions offer the <em>nothrow guarantee</em>.
+ */
+class DecimalSeries
+{
+public:
+
+    /**
+     * Number of values in each compressed block.
+     */
+    static std::size_t const block_size = 128;
+
+    /**
+     * Constructs an empty series, in which values will be stored with
+     * \e p_places decimal places.
+     *
+     * @exception DecimalRangeException thrown if \e p_places exceeds
+     * Decimal::maximum_precision().
+     *
+     * @exception std::bad_alloc thrown in the unlikely event of memory
+     * allocation failure.
+     */
+    explicit DecimalSeries(Decimal::places_type p_places);
+
+    /**
+     * Append a value to the series.
+     *
+     * @exception DecimalRangeException thrown if the value cannot be
+     * represented with places() decimal places.
+     *
+     * @exception std::bad_alloc thrown in the unlikely event of memory
+     * allocation failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    void append(Decimal const& p_value);
+
+    /**
+     * Append \e p_count values, starting at \e p_values.
+     *
+     * Exceptions are as for append(Decimal const&).
+     *
+     * Exception safety: <em>basic guarantee</em>. If an exception is
+     * thrown, the values before the one that caused it will have been
+     * appended.
+     */
+    void append(Decimal const* p_values, std::size_t p_count);
+
+    /**
+     * @returns the number of values in the series.
+     */
+    std::size_t size() const;
+
+    /**
+     * @returns the number of decimal places shared by all the values in
+     * the series.
+     */
+    Decimal::places_type places() const;
+
+    /**
+     * @returns the number of blocks in the series, including the final,
+     * incomplete block (if any), of values not yet compressed. All blocks
+     * but the last contain exactly \e block_size values.
+     */
+    std::size_t block_count() const;
+
+    /**
+     * @returns the number of bytes of memory occupied by the series.
+     */
+    std::size_t memory_usage() const;
+
+    /**
+     * Writes the underlying integers of the values in the block at
+     * position \e p_index to \e p_intvals, which must have room for
+     * \e block_size integers. Each is implicitly divided by 10 raised to
+     * places(). Behaviour is undefined if \e p_index is out of range.
+     *
+     * @returns the number of values in the block.
+     */
+    std::size_t decode_block
+    (   std::size_t p_index,
+        Decimal::int_type* p_intvals
+    ) const;
+
+    /**
+     * Decodes the \e p_count values starting at position \e p_first, and
+     * writes them to \e p_out. Behaviour is undefined if the range is not
+     * within the series.
+     */
+    void decode
+    (   std::size_t p_first,
+        std::size_t p_count,
+        Decimal* p_out
+    ) const;
+
+    /**
+     * @returns the value at position \e p_index. Behaviour is undefined if
+     * \e p_index is out of range.
+     *
+     * This takes constant time if the containing block is in frame of
+     * reference form, but time proportional to the position of the value
+     * within the block if it is in delta form. Use decode() or
+     * decode_block() to read many values.
+     */
+    Decimal operator[](std::size_t p_index) const;
+
+private:
+
+    struct BlockInfo
+    {
+        Decimal::int_type base;
+        std::size_t word_offset;
+        unsigned int width;
+        bool is_delta;
+    };
+
+    void seal_block();
+
+    Decimal::places_type m_places;
+    std::size_t m_size;
+    std::vector<BlockInfo> m_blocks;
+    std::vector<std::uint64_t> m_words;
+    std::vector<Decimal::int_type> m_pending;
+};
+
+
+// INLINE FUNCTION DEFINITIONS
+
+inline
+std::size_t
+DecimalSeries::size() const
+{
+    return m_size;
+}
+
+inline
+Decimal::places_type
+DecimalSeries::places() const
+{
+    return m_places;
+}
+
+inline
+std::size_t
+DecimalSeries::block_count() const
+{
+    return (m_size + block_size - 1) / block_size;
+}
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal_series_hpp_9706269431606775
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GUARD_decimal_stats_hpp_4471928305569164
+#define GUARD_decimal_stats_hpp_4471928305569164
+
+/** @file
+ *
+ * @brief Optional counters recording what Decimal arithmetic spends its
+ * time on.
+ */
+
+#include <cstdint>
+#include <ostream>
+
+namespace jewel
+{
+
+/**
+ * Represents a snapshot of counters kept by the Decimal arithmetic
+ * operations, recording how often each of the slower parts of those
+ * operations has run. This helps to explain why Decimal-heavy code is
+ * slow, e.g. whether the time goes in rescaling operands, or in the "long
+ * division" loop of Decimal::operator/=.
+ *
+ * The counters are only kept if the Jewel library itself was compiled with
+ * \b JEWEL_DECIMAL_STATS defined (which the CMake option
+ * \b ENABLE_DECIMAL_STATS arranges). Otherwise the instrumentation
+ * compiles to nothing, and every snapshot is all zeroes. Each thread
+ * keeps its own counters, so counting does not require synchronization
+ * between threads.
+ *
+ * Counters only ever increase. To measure a piece of work, take a snapshot
+ * before and after it, and subtract the first from the second.
+ *
+ * <em>Exception safety</em>: All of the member and related non-member
+ * functions in this header offer the <em>nothrow guarantee</em>, apart
+ * from global_snapshot(), and the stream output operator (which could throw
+ * in case exceptions have been enabled on the stream and an error occurs
+ * during output).
+ */
+class DecimalStats
+{
+public:
+
+    typedef std::uint64_t count_type;
+
+    /**
+     * Identifies each of the counters.
+     */
+    enum Counter
+    {
+        /**
+         * Calls to Decimal::rescale that changed (or tried to change) the
+         * number of places.
+         */
+        rescales = 0,
+
+        /**
+         * Trailing zeroes removed by Decimal::rationalize.
+         */
+        rationalize_iterations,
+
+        /**
+         * Operations that had to bring two Decimals with different
+         * numbers of places to the same number of places.
+         */
+        co_normalizations,
+
+        /**
+         * Iterations of the "long division" loop of Decimal::operator/=,
+         * each of which yields a further digit of the quotient.
+         */
+        division_iterations,
+
+        /**
+         * Exceptions thrown by Decimal operations, including construction
+         * from a string, and the functions in decimal_math.hpp,
+         * decimal64.hpp and decimal_allocation.hpp.
+         */
+        exceptions,
+
+        num_counters
+    };
+
+    /**
+     * Constructs a DecimalStats with every counter zero.
+     */
+    DecimalStats();
+
+    DecimalStats(DecimalStats const& rhs) = default;
+    DecimalStats(DecimalStats&& rhs) = default;
+    DecimalStats& operator=(DecimalStats const& rhs) = default;
+    DecimalStats& operator=(DecimalStats&& rhs) = default;
+    ~DecimalStats() = default;
+
+    /**
+     * @returns \e true if and only if the Jewel library was compiled with
+     * \b JEWEL_DECIMAL_STATS defined, so that counters are actually kept.
+     */
+    static bool enabled();
+
+    /**
+     * @returns the counters for the calling thread only.
+     */
+    static DecimalStats thread_snapshot();
+
+    /**
+     * @returns the counters summed across all threads, including threads
+     * that have since exited. Threads may be counting while this is called,
+     * in which case each counter is read at a slightly different moment.
+     *
+     * Exception safety: <em>basic guarantee</em>. (Could throw
+     * std::system_error if the internal mutex cannot be locked.)
+     */
+    static DecimalStats global_snapshot();
+
+    /**
+     * @returns a short name for \e p_counter, suitable for output, e.g.
+     * "rescales".
+     */
+    static char const* name(Counter p_counter);
+
+    /**
+     * @returns the value of \e p_counter.
+     */
+    count_type count(Counter p_counter) const;
+
+    /**
+     * Adds each of the counters in \e rhs to the corresponding counter in
+     * \e *this.
+     */
+    DecimalStats& operator+=(DecimalStats const& rhs);
+
+    /**
+     * Subtracts each of the counters in \e rhs from the corresponding
+     * counter in \e *this. Each counter in \e rhs should be no greater
+     * than the corresponding counter in \e *this, as is the case when
+     * \e rhs is an earlier snapshot of the same counters.
+     */
+    DecimalStats& operator-=(DecimalStats const& rhs);
+
+private:
+    count_type m_counts[num_counters];
+
+};  // class DecimalStats
+
+/// @name Arithmetic operations on DecimalStats.
+/// @relates DecimalStats
+//@{
+/**
+ */
+DecimalStats operator+(DecimalStats const& lhs, DecimalStats const& rhs);
+
+/**
+ */
+DecimalStats operator-(DecimalStats const& lhs, DecimalStats const& rhs);
+//@}
+
+/**
+ * Write \e p_stats to \e p_os, one counter per line, in the form
+ * "[name]: [count]".
+ */
+template <typename charT, typename traits>
+std::basic_ostream<charT, traits>&
+operator<<
+(   std::basic_ostream<charT, traits>& p_os,
+    DecimalStats const& p_stats
+);
+
+
+// INLINE IMPLEMENTATIONS
+
+inline
+DecimalStats::count_type
+DecimalStats::count(Counter p_counter) const
+{
+    return m_counts[p_counter];
+}
+
+
+// FUNCTION TEMPLATE IMPLEMENTATION
+
+template <typename charT, typename traits>
+std::basic_ostream<charT, traits>&
+operator<<
+(   std::basic_ostream<charT, traits>& p_os,
+    DecimalStats const& p_stats
+)
+{
+    for (int i = 0; i != DecimalStats::num_counters; ++i)
+    {
+        DecimalStats::Counter const counter =
+            static_cast<DecimalStats::Counter>(i);
+        p_os << DecimalStats::name(counter)
+             << ": "
+             << p_stats.count(counter)
+             << '\n';
+    }
+    return p_os;
+}
+
+
+}  // namespace jewel
+
+#endif  // GUARD_decimal_stats_hpp_4471928305569164
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_bit_packing_hpp_8470259508219441
+#define GUARD_bit_packing_hpp_8470259508219441
+
+/** @file
+ *
+ * @brief Functions for storing small unsigned integers of a fixed bit
+ * width contiguously in an array of 64-bit words, which are used in the
+ * implementation of jewel::DecimalDictionaryColumn and jewel::DecimalSeries.
+ *
+ * Client code can ignore what's in the detail namespace.
+ */
+
+#include "../assert.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace jewel
+{
+namespace detail
+{
+
+/**
+ * @returns the number of bits needed to represent every integer from 0
+ * to \e p_max inclusive, and in any case at least 1.
+ */
+inline
+unsigned int bits_required(std::uint64_t p_max)
+{
+    unsigned int ret = 1;
+    while (ret != 64 && (p_max >> ret) != 0)
+    {
+        ++ret;
+    }
+    return ret;
+}
+
+/**
+ * @returns the number of 64-bit words needed to hold \e p_count fields of
+ * \e p_width bits each. This includes one word of padding at the end, so
+ * that reading a field never needs to check whether it straddles the end
+ * of the array.
+ */
+inline
+std::size_t packed_word_count(std::size_t p_count, unsigned int p_width)
+{
+    return (p_count * p_width + 63) / 64 + 1;
+}
+
+/**
+ * Writes \e p_count fields of \e p_width bits, taken from \e p_in, to the
+ * array of words starting at \e p_out, starting with the field at position
+ * \e p_first. The bits to be written must initially be zero. Precondition:
+ * each value in \e p_in must fit in \e p_width bits, and 0 < \e p_width
+ * <= 64. \e UInt should be std::uint32_t or std::uint64_t.
+ */
+template <typename UInt>
+void pack_bits
+(   UInt const* p_in,
+    std::size_t p_count,
+    unsigned int p_width,
+    std::size_t p_first,
+    std::uint64_t* p_out
+)
+{
+    JEWEL_ASSERT (p_width > 0 && p_width <= 64);
+    std::size_t bit = p_first * p_width;
+    for (std::size_t i = 0; i != p_count; ++i, bit += p_width)
+    {
+        std::uint64_t const value = p_in[i];
+        JEWEL_ASSERT (p_width == 64 || (value >> p_width) == 0);
+        unsigned int const shift = bit % 64;
+        std::uint64_t* const word = p_out + bit / 64;
+        word[0] |= value << shift;
+
+        // The two-step shift yields zero, rather than being undefined,
+        // when shift is 0.
+        word[1] |= (value >> 1) >> (63 - shift);
+    }
+    return;
+}
+
+/**
+ * @returns the field of \e p_width bits at position \e p_index in the
+ * array of words starting at \e p_words. Precondition: 0 < \e p_width
+ * <= 64.
+ */
+inline
+std::uint64_t unpack_bit_field
+(   std::uint64_t const* p_words,
+    unsigned int p_width,
+    std::size_t p_index
+)
+{
+    JEWEL_ASSERT (p_width > 0 && p_width <= 64);
+    std::size_t const bit = p_index * p_width;
+    unsigned int const shift = bit % 64;
+    std::uint64_t const* const word = p_words + bit / 64;
+    std::uint64_t const mask =
+        ~static_cast<std::uint64_t>(0) >> (64 - p_width);
+    return ((word[0] >> shift) | ((word[1] << 1) << (63 - shift))) & mask;
+}
+
+/**
+ * Reads \e p_count fields of \e p_width bits, starting with the field at
+ * position \e p_first in the array of words starting at \e p_words, and
+ * writes them to \e p_out. Precondition: each field must fit in
+ * \e UInt, and 0 < \e p_width <= 64.
+ */
+template <typename UInt>
+void unpack_bits
+(   std::uint64_t const* p_words,
+    unsigned int p_width,
+    std::size_t p_first,
+    std::size_t p_count,
+    UInt* p_out
+)
+{
+    for (std::size_t i = 0; i != p_count; ++i)
+    {
+        p_out[i] = static_cast<UInt>
+        (   unpack_bit_field(p_words, p_width, p_first + i)
+        );
+    }
+    return;
+}
+
+}  // namespace detail
+}  // namespace jewel
+
+#endif  // GUARD_bit_packing_hpp_8470259508219441
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GUARD_decimal_stats_detail_hpp_0918273645512093
+#define GUARD_decimal_stats_detail_hpp_0918273645512093
+
+/** @file
+ *
+ * @brief Macros used within the implementation of jewel::Decimal to
+ * update the counters reported by jewel::DecimalStats.
+ *
+ * Client code can ignore what's in the detail namespace.
+ */
+
+#include "../decimal_stats.hpp"
+#include "../exception.hpp"
+
+namespace jewel
+{
+namespace detail
+{
+
+/**
+ * Adds \e p_n to \e p_counter for the calling thread.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+void decimal_stats_add
+(   DecimalStats::Counter p_counter,
+    DecimalStats::count_type p_n
+) noexcept;
+
+/**
+ * Counts an exception thrown by Decimal, if the Jewel library was compiled
+ * with JEWEL_DECIMAL_STATS defined; otherwise does nothing. As this is
+ * not inline, it may be called from the inline functions of Decimal,
+ * which are compiled as part of client code, where JEWEL_DECIMAL_STATS
+ * need not be defined.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+void decimal_stats_count_exception() noexcept;
+
+}  // namespace detail
+}  // namespace jewel
+
+
+/*
+ * JEWEL_DETAIL_DECIMAL_STATS_ADD(COUNTER, N) adds N to the
+ * jewel::DecimalStats counter named COUNTER, if JEWEL_DECIMAL_STATS is
+ * defined; otherwise it does nothing, and N is not evaluated.
+ *
+ * JEWEL_DETAIL_DECIMAL_THROW(TYPE, MESSAGE) counts an exception, then does
+ * the same as JEWEL_THROW(TYPE, MESSAGE). It can be used in headers as well
+ * as in the library itself, as the counting is done out of line.
+ */
+#ifdef JEWEL_DECIMAL_STATS
+#   define JEWEL_DETAIL_DECIMAL_STATS_ADD(COUNTER, N) \
+        jewel::detail::decimal_stats_add(jewel::DecimalStats::COUNTER, (N))
+#else
+#   define JEWEL_DETAIL_DECIMAL_STATS_ADD(COUNTER, N) \
+        static_cast<void>(0)
+#endif
+
+#define JEWEL_DETAIL_DECIMAL_THROW(TYPE, MESSAGE) \
+    do \
+    { \
+        jewel::detail::decimal_stats_count_exception(); \
+        JEWEL_THROW(TYPE, MESSAGE); \
+    } \
+    while (false)
+
+
+#endif  // GUARD_decimal_stats_detail_hpp_0918273645512093
@@ -27,5 +27,25 @@
 
 #define JEWEL_DETAIL_MAKE_STRING_B(x) JEWEL_DETAIL_MAKE_STRING_A(x)
 
+/*
+ * JEWEL_DETAIL_LIKELY(x) and JEWEL_DETAIL_UNLIKELY(x) evaluate to the
+ * boolean value of x, while telling the compiler which value to expect, so
+ * that it can lay out the expected path as straight-line code.
+ *
+ * JEWEL_DETAIL_NOINLINE marks a function not to be inlined, so that a
+ * general, slower path is kept out of the way of the code calling it.
+ * (GCC's "cold" attribute would also do this, but causes the function to
+ * be optimized for size, which makes it noticeably slower.)
+ */
+#if defined(__GNUC__)
+#   define JEWEL_DETAIL_LIKELY(x) (__builtin_expect(!!(x), 1))
+#   define JEWEL_DETAIL_UNLIKELY(x) (__builtin_expect(!!(x), 0))
+#   define JEWEL_DETAIL_NOINLINE __attribute__((noinline))
+#else
+#   define JEWEL_DETAIL_LIKELY(x) (!!(x))
+#   define JEWEL_DETAIL_UNLIKELY(x) (!!(x))
+#   define JEWEL_DETAIL_NOINLINE
+#endif
+
 
 #endif   // GUARD_helper_macros_hpp_723136290778935
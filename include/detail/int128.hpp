@@ -0,0 +1,630 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_int128_hpp_1640693797531375
+#define GUARD_int128_hpp_1640693797531375
+
+/** @file
+ *
+ * @brief Typedefs for 128-bit integer types, which are used as
+ * intermediates in parts of the implementation of Decimal arithmetic, and
+ * related helper functions.
+ *
+ * Where the compiler provides 128-bit integers as an extension (as GCC
+ * and Clang do on 64-bit platforms), these are the built-in types.
+ * Elsewhere (e.g. with MSVC, or on 32-bit platforms), or if
+ * JEWEL_DETAIL_PORTABLE_INT128 is defined, they are classes holding two
+ * 64-bit halves, which provide the operations that Jewel needs, more
+ * slowly.
+ *
+ * This header is not installed, and should be included only from source
+ * files, never from the public headers. Client code can ignore what's in
+ * the detail namespace.
+ */
+
+#include "../assert.hpp"
+#include <cstdint>
+
+#if defined(__SIZEOF_INT128__) && !defined(JEWEL_DETAIL_PORTABLE_INT128)
+#   define JEWEL_DETAIL_NATIVE_INT128
+#else
+#   include <type_traits>
+#endif
+
+namespace jewel
+{
+namespace detail
+{
+
+/**
+ * @returns the number of bits needed to represent \e x, i.e. the position
+ * of its most significant set bit, counting from 1; or 0 if \e x is 0.
+ */
+inline
+unsigned int bit_length_64(std::uint64_t x)
+{
+#   if defined(__GNUC__)
+        return (x == 0)? 0: (64 - __builtin_clzll(x));
+#   else
+        unsigned int ret = 0;
+        for ( ; x != 0; x >>= 1)
+        {
+            ++ret;
+        }
+        return ret;
+#   endif
+}
+
+#ifdef JEWEL_DETAIL_NATIVE_INT128
+
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+
+#else
+
+/**
+ * Unsigned 128-bit integer, with the same arithmetic as a built-in
+ * unsigned integer type (i.e. modulo 2 to the power of 128). It converts
+ * implicitly from, and explicitly to, the built-in integer types.
+ */
+class UInt128
+{
+public:
+    UInt128() = default;
+
+    template
+    <   typename T,
+        typename std::enable_if<std::is_integral<T>::value, int>::type = 0
+    >
+    constexpr UInt128(T p_value):
+        m_high(is_negative(p_value, std::is_signed<T>())? ~std::uint64_t(0): 0),
+        m_low(static_cast<std::uint64_t>(p_value))
+    {
+    }
+
+    constexpr UInt128(std::uint64_t p_high, std::uint64_t p_low):
+        m_high(p_high),
+        m_low(p_low)
+    {
+    }
+
+    /**
+     * @returns the value modulo 2 to the power of the number of bits in T,
+     * as for a built-in integer type.
+     */
+    template
+    <   typename T,
+        typename std::enable_if
+        <   std::is_integral<T>::value && !std::is_same<T, bool>::value,
+            int
+        >::type = 0
+    >
+    explicit constexpr operator T() const
+    {
+        return static_cast<T>(m_low);
+    }
+
+    explicit constexpr operator bool() const
+    {
+        return (m_high != 0) || (m_low != 0);
+    }
+
+    constexpr std::uint64_t high() const
+    {
+        return m_high;
+    }
+
+    constexpr std::uint64_t low() const
+    {
+        return m_low;
+    }
+
+    friend constexpr UInt128 operator~(UInt128 x)
+    {
+        return UInt128(~x.m_high, ~x.m_low);
+    }
+
+    friend constexpr UInt128 operator&(UInt128 lhs, UInt128 rhs)
+    {
+        return UInt128(lhs.m_high & rhs.m_high, lhs.m_low & rhs.m_low);
+    }
+
+    friend constexpr UInt128 operator|(UInt128 lhs, UInt128 rhs)
+    {
+        return UInt128(lhs.m_high | rhs.m_high, lhs.m_low | rhs.m_low);
+    }
+
+    friend constexpr UInt128 operator^(UInt128 lhs, UInt128 rhs)
+    {
+        return UInt128(lhs.m_high ^ rhs.m_high, lhs.m_low ^ rhs.m_low);
+    }
+
+    friend constexpr UInt128 operator<<(UInt128 x, unsigned int n)
+    {
+        return
+            (n == 0)? x:
+            (n >= 128)? UInt128(0, 0):
+            (n >= 64)? UInt128(x.m_low << (n - 64), 0):
+            UInt128((x.m_high << n) | (x.m_low >> (64 - n)), x.m_low << n);
+    }
+
+    friend constexpr UInt128 operator>>(UInt128 x, unsigned int n)
+    {
+        return
+            (n == 0)? x:
+            (n >= 128)? UInt128(0, 0):
+            (n >= 64)? UInt128(0, x.m_high >> (n - 64)):
+            UInt128(x.m_high >> n, (x.m_low >> n) | (x.m_high << (64 - n)));
+    }
+
+    friend constexpr UInt128 operator+(UInt128 lhs, UInt128 rhs)
+    {
+        return UInt128
+        (   lhs.m_high + rhs.m_high +
+                ((lhs.m_low + rhs.m_low < lhs.m_low)? 1: 0),
+            lhs.m_low + rhs.m_low
+        );
+    }
+
+    friend constexpr UInt128 operator-(UInt128 lhs, UInt128 rhs)
+    {
+        return UInt128
+        (   lhs.m_high - rhs.m_high - ((lhs.m_low < rhs.m_low)? 1: 0),
+            lhs.m_low - rhs.m_low
+        );
+    }
+
+    friend constexpr UInt128 operator*(UInt128 lhs, UInt128 rhs)
+    {
+        return UInt128
+        (   multiply_64(lhs.m_low, rhs.m_low).m_high +
+                lhs.m_high * rhs.m_low +
+                lhs.m_low * rhs.m_high,
+            lhs.m_low * rhs.m_low
+        );
+    }
+
+    friend UInt128 operator/(UInt128 lhs, UInt128 rhs)
+    {
+        UInt128 remainder;
+        return divide(lhs, rhs, remainder);
+    }
+
+    friend UInt128 operator%(UInt128 lhs, UInt128 rhs)
+    {
+        UInt128 remainder;
+        divide(lhs, rhs, remainder);
+        return remainder;
+    }
+
+    friend constexpr bool operator==(UInt128 lhs, UInt128 rhs)
+    {
+        return (lhs.m_high == rhs.m_high) && (lhs.m_low == rhs.m_low);
+    }
+
+    friend constexpr bool operator!=(UInt128 lhs, UInt128 rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend constexpr bool operator<(UInt128 lhs, UInt128 rhs)
+    {
+        return
+            (lhs.m_high < rhs.m_high) ||
+            ((lhs.m_high == rhs.m_high) && (lhs.m_low < rhs.m_low));
+    }
+
+    friend constexpr bool operator>(UInt128 lhs, UInt128 rhs)
+    {
+        return rhs < lhs;
+    }
+
+    friend constexpr bool operator<=(UInt128 lhs, UInt128 rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    friend constexpr bool operator>=(UInt128 lhs, UInt128 rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    UInt128& operator+=(UInt128 rhs)
+    {
+        return *this = *this + rhs;
+    }
+
+    UInt128& operator-=(UInt128 rhs)
+    {
+        return *this = *this - rhs;
+    }
+
+    UInt128& operator*=(UInt128 rhs)
+    {
+        return *this = *this * rhs;
+    }
+
+    UInt128& operator/=(UInt128 rhs)
+    {
+        return *this = *this / rhs;
+    }
+
+    UInt128& operator%=(UInt128 rhs)
+    {
+        return *this = *this % rhs;
+    }
+
+    UInt128& operator<<=(unsigned int n)
+    {
+        return *this = *this << n;
+    }
+
+    UInt128& operator>>=(unsigned int n)
+    {
+        return *this = *this >> n;
+    }
+
+    UInt128& operator++()
+    {
+        return *this += 1;
+    }
+
+    UInt128& operator--()
+    {
+        return *this -= 1;
+    }
+
+    /**
+     * @returns \e p_numerator divided by \e p_divisor, and writes the
+     * remainder to \e p_remainder.
+     */
+    static UInt128 divide
+    (   UInt128 p_numerator,
+        UInt128 p_divisor,
+        UInt128& p_remainder
+    )
+    {
+        JEWEL_ASSERT (p_divisor != 0);
+        if ((p_numerator.m_high == 0) && (p_divisor.m_high == 0))
+        {
+            p_remainder = p_numerator.m_low % p_divisor.m_low;
+            return p_numerator.m_low / p_divisor.m_low;
+        }
+        if (p_numerator < p_divisor)
+        {
+            p_remainder = p_numerator;
+            return 0;
+        }
+        // Binary long division
+        unsigned int const shift =
+            p_numerator.bit_length() - p_divisor.bit_length();
+        p_divisor <<= shift;
+        UInt128 quotient = 0;
+        for (unsigned int i = 0; i <= shift; ++i)
+        {
+            quotient <<= 1;
+            if (p_numerator >= p_divisor)
+            {
+                p_numerator -= p_divisor;
+                quotient.m_low |= 1;
+            }
+            p_divisor >>= 1;
+        }
+        p_remainder = p_numerator;
+        return quotient;
+    }
+
+    unsigned int bit_length() const
+    {
+        return
+            (m_high != 0)?
+            (64 + bit_length_64(m_high)):
+            bit_length_64(m_low);
+    }
+
+private:
+    template <typename T>
+    static constexpr bool is_negative(T p_value, std::true_type)
+    {
+        return p_value < 0;
+    }
+
+    template <typename T>
+    static constexpr bool is_negative(T, std::false_type)
+    {
+        return false;
+    }
+
+    static constexpr std::uint64_t low_32(std::uint64_t x)
+    {
+        return x & 0xFFFFFFFFu;
+    }
+
+    static constexpr std::uint64_t high_32(std::uint64_t x)
+    {
+        return x >> 32;
+    }
+
+    // The full product of two 64-bit integers, computed from the products
+    // of their 32-bit halves in single expressions, so as to be constexpr.
+    static constexpr UInt128 multiply_64(std::uint64_t lhs, std::uint64_t rhs)
+    {
+        return multiply_64
+        (   low_32(lhs) * low_32(rhs),
+            low_32(lhs) * high_32(rhs),
+            high_32(lhs) * low_32(rhs),
+            high_32(lhs) * high_32(rhs)
+        );
+    }
+
+    static constexpr UInt128 multiply_64
+    (   std::uint64_t p00,
+        std::uint64_t p01,
+        std::uint64_t p10,
+        std::uint64_t p11
+    )
+    {
+        return multiply_64
+        (   high_32(p00) + low_32(p01) + low_32(p10),
+            p00,
+            p01,
+            p10,
+            p11
+        );
+    }
+
+    static constexpr UInt128 multiply_64
+    (   std::uint64_t p_middle,
+        std::uint64_t p00,
+        std::uint64_t p01,
+        std::uint64_t p10,
+        std::uint64_t p11
+    )
+    {
+        return UInt128
+        (   p11 + high_32(p01) + high_32(p10) + high_32(p_middle),
+            low_32(p00) | (p_middle << 32)
+        );
+    }
+
+    std::uint64_t m_high;
+    std::uint64_t m_low;
+};
+
+/**
+ * Signed 128-bit integer in two's complement, with the same arithmetic as
+ * a built-in signed integer type (except that overflow wraps around). It
+ * converts implicitly from, and explicitly to, the built-in integer types,
+ * and explicitly to and from UInt128.
+ */
+class Int128
+{
+public:
+    Int128() = default;
+
+    template
+    <   typename T,
+        typename std::enable_if<std::is_integral<T>::value, int>::type = 0
+    >
+    constexpr Int128(T p_value): m_bits(p_value)
+    {
+    }
+
+    explicit constexpr Int128(UInt128 p_bits): m_bits(p_bits)
+    {
+    }
+
+    template
+    <   typename T,
+        typename std::enable_if
+        <   std::is_integral<T>::value && !std::is_same<T, bool>::value,
+            int
+        >::type = 0
+    >
+    explicit constexpr operator T() const
+    {
+        return static_cast<T>(m_bits);
+    }
+
+    explicit constexpr operator bool() const
+    {
+        return static_cast<bool>(m_bits);
+    }
+
+    explicit constexpr operator UInt128() const
+    {
+        return m_bits;
+    }
+
+    friend constexpr Int128 operator-(Int128 x)
+    {
+        return Int128(UInt128(0) - x.m_bits);
+    }
+
+    friend constexpr Int128 operator+(Int128 lhs, Int128 rhs)
+    {
+        return Int128(lhs.m_bits + rhs.m_bits);
+    }
+
+    friend constexpr Int128 operator-(Int128 lhs, Int128 rhs)
+    {
+        return Int128(lhs.m_bits - rhs.m_bits);
+    }
+
+    friend constexpr Int128 operator*(Int128 lhs, Int128 rhs)
+    {
+        return Int128(lhs.m_bits * rhs.m_bits);
+    }
+
+    /**
+     * Rounds towards zero, as for a built-in integer type.
+     */
+    friend Int128 operator/(Int128 lhs, Int128 rhs)
+    {
+        Int128 const quotient(lhs.magnitude() / rhs.magnitude());
+        return (lhs.is_negative() != rhs.is_negative())? -quotient: quotient;
+    }
+
+    /**
+     * Has the sign of \e lhs, as for a built-in integer type.
+     */
+    friend Int128 operator%(Int128 lhs, Int128 rhs)
+    {
+        Int128 const remainder(lhs.magnitude() % rhs.magnitude());
+        return lhs.is_negative()? -remainder: remainder;
+    }
+
+    friend constexpr bool operator==(Int128 lhs, Int128 rhs)
+    {
+        return lhs.m_bits == rhs.m_bits;
+    }
+
+    friend constexpr bool operator!=(Int128 lhs, Int128 rhs)
+    {
+        return lhs.m_bits != rhs.m_bits;
+    }
+
+    friend constexpr bool operator<(Int128 lhs, Int128 rhs)
+    {
+        // Flipping the sign bit lets the values be compared as unsigned.
+        return (lhs.m_bits ^ sign_bit()) < (rhs.m_bits ^ sign_bit());
+    }
+
+    friend constexpr bool operator>(Int128 lhs, Int128 rhs)
+    {
+        return rhs < lhs;
+    }
+
+    friend constexpr bool operator<=(Int128 lhs, Int128 rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    friend constexpr bool operator>=(Int128 lhs, Int128 rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    Int128& operator+=(Int128 rhs)
+    {
+        return *this = *this + rhs;
+    }
+
+    Int128& operator-=(Int128 rhs)
+    {
+        return *this = *this - rhs;
+    }
+
+    Int128& operator*=(Int128 rhs)
+    {
+        return *this = *this * rhs;
+    }
+
+    Int128& operator/=(Int128 rhs)
+    {
+        return *this = *this / rhs;
+    }
+
+    Int128& operator%=(Int128 rhs)
+    {
+        return *this = *this % rhs;
+    }
+
+private:
+    static constexpr UInt128 sign_bit()
+    {
+        return UInt128(std::uint64_t(1) << 63, 0);
+    }
+
+    constexpr bool is_negative() const
+    {
+        return (m_bits.high() >> 63) != 0;
+    }
+
+    constexpr UInt128 magnitude() const
+    {
+        return is_negative()? (UInt128(0) - m_bits): m_bits;
+    }
+
+    UInt128 m_bits;
+};
+
+typedef Int128 int128_t;
+typedef UInt128 uint128_t;
+
+#endif  // JEWEL_DETAIL_NATIVE_INT128
+
+/**
+ * Greatest and least values of int128_t, and greatest value of uint128_t.
+ * (std::numeric_limits is not specialized for 128-bit integers in strict
+ * C++11 mode, or for the portable classes.)
+ */
+int128_t const int128_max =
+    static_cast<int128_t>(~static_cast<uint128_t>(0) >> 1);
+int128_t const int128_min = -int128_max - 1;
+uint128_t const uint128_max = ~static_cast<uint128_t>(0);
+
+/**
+ * @returns the number of bits needed to represent \e x; or 0 if \e x is
+ * 0.
+ */
+inline
+unsigned int bit_length(uint128_t x)
+{
+    std::uint64_t const high = static_cast<std::uint64_t>(x >> 64);
+    std::uint64_t const low = static_cast<std::uint64_t>(x);
+    return (high != 0)? (64 + bit_length_64(high)): bit_length_64(low);
+}
+
+/**
+ * @returns \e p_numerator divided by \e p_divisor, and writes the
+ * remainder to \e p_remainder. Precondition: the quotient must fit in
+ * 64 bits.
+ */
+inline
+std::uint64_t divide_step
+(   uint128_t p_numerator,
+    std::uint64_t p_divisor,
+    std::uint64_t& p_remainder
+)
+{
+    JEWEL_ASSERT ((p_numerator >> 64) < p_divisor);
+#   if defined(JEWEL_DETAIL_NATIVE_INT128) && defined(__x86_64__)
+        // The compiler would otherwise call a library routine that
+        // can't assume the quotient fits in 64 bits.
+        std::uint64_t quotient;
+        __asm__
+        (   "divq %4"
+            :   "=a" (quotient), "=d" (p_remainder)
+            :   "a" (static_cast<std::uint64_t>(p_numerator)),
+                "d" (static_cast<std::uint64_t>(p_numerator >> 64)),
+                "rm" (p_divisor)
+        );
+        return quotient;
+#   else
+        std::uint64_t const quotient =
+            static_cast<std::uint64_t>(p_numerator / p_divisor);
+        p_remainder = static_cast<std::uint64_t>
+        (   p_numerator - static_cast<uint128_t>(quotient) * p_divisor
+        );
+        return quotient;
+#   endif
+}
+
+}  // namespace detail
+}  // namespace jewel
+
+#endif  // GUARD_int128_hpp_1640693797531375
@@ -0,0 +1,259 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef GUARD_log_format_hpp_3620958174420618
+#define GUARD_log_format_hpp_3620958174420618
+
+/** @file
+ *
+ * @brief The representation of a logging event, and the functions that
+ * format it as text, as JSON or as binary, shared by jewel::Log and by
+ * jewel::decode_binary_log.
+ *
+ * The text format is described in the documentation of jewel::Log. In
+ * the JSON format, each record is a line holding a JSON object, whose
+ * members are the fields of the text format, in the same order.
+ *
+ * A binary log file starts with the eight characters "JEWELLOG", followed
+ * by a byte giving the version of the format. Then follows a sequence
+ * of entries, each of which starts with a byte identifying the kind of
+ * entry:
+ *
+ * - \e site ('S'): site id; line; then the function, file,
+ *   compilation date, compilation time, exception type and expression
+ *   strings. Defines a site, i.e. the strings that are the same for every
+ *   record logged from a given place in the source code. Appears before
+ *   any record that refers to it.
+ * - \e record ('R'): site id; record id; timestamp, in microseconds
+ *   since the Unix epoch; a byte for the severity; then the message and
+ *   value strings.
+ * - \e event ('E'): a byte for the kind of event (commenced or ended);
+ *   record id; then the message and date-time strings. Records the
+ *   start or end of logging to the file.
+ *
+ * Integers are written as unsigned LEB128 (seven bits per byte, least
+ * significant first, with the high bit set on all but the last byte), with
+ * the line number zigzag-encoded. Each string is written as its length
+ * plus one, followed by its characters, or as 0 if the string is absent
+ * (a null pointer).
+ *
+ * Client code can ignore what's in the detail namespace.
+ */
+
+#include "../log.hpp"
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace jewel
+{
+namespace detail
+{
+
+/**
+ * The details of a single logging event, as passed to Log::log, together
+ * with the time at which it was logged. Absent strings are null pointers.
+ */
+struct LogRecord
+{
+    long long timestamp;  /**< microseconds since the Unix epoch */
+    Log::Level severity;
+    int line;
+    char const* message;
+    char const* function;
+    char const* file;
+    char const* compilation_date;
+    char const* compilation_time;
+    char const* exception_type;
+    char const* expression;
+    char const* value;
+};
+
+/**
+ * The kinds of event that are logged other than by Log::log.
+ */
+enum LogEvent
+{
+    log_commenced = 0,  /**< logging to the file has commenced */
+    log_ended = 1       /**< logging to the file has ended */
+};
+
+/**
+ * @returns the name of \e p_level, as written in the log, or
+ * "unrecognized" if \e p_level is not a Log::Level.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+char const* log_severity_name(Log::Level p_level);
+
+/**
+ * Appends the text of a record to \e p_out, including the blank line
+ * that ends it.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_text_record
+(   std::string& p_out,
+    LogRecord const& p_record,
+    long long p_id
+);
+
+/**
+ * Appends \e p_microseconds, a time in microseconds since the Unix
+ * epoch, to \e p_out as the local date and time in ISO format, to the
+ * microsecond (e.g. "2013-11-29T09:41:57.000123"). The date and time
+ * are formatted only once per second per thread. If they cannot be
+ * determined, \e p_microseconds is appended as an integer instead.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_timestamp(std::string& p_out, long long p_microseconds);
+
+/**
+ * Appends the text of a record of \e p_event to \e p_out.
+ * \e p_date_time may be a null pointer.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_text_event
+(   std::string& p_out,
+    LogEvent p_event,
+    long long p_id,
+    char const* p_message,
+    char const* p_date_time
+);
+
+/**
+ * Appends a record to \e p_out as a single line of JSON, an object with
+ * the same fields as in the text format, ended by a newline. Strings are
+ * escaped as JSON requires.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_json_record
+(   std::string& p_out,
+    LogRecord const& p_record,
+    long long p_id
+);
+
+/**
+ * Appends a record of the commencement or end of logging to \e p_out as
+ * a single line of JSON. \e p_date_time may be a null pointer.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_json_event
+(   std::string& p_out,
+    long long p_id,
+    char const* p_message,
+    char const* p_date_time
+);
+
+char const log_binary_magic[] = "JEWELLOG";
+
+std::size_t const log_binary_magic_size = sizeof(log_binary_magic) - 1;
+
+unsigned char const log_binary_version = 1;
+
+enum LogBinaryTag
+{
+    log_binary_site = 'S',
+    log_binary_record = 'R',
+    log_binary_event = 'E'
+};
+
+/**
+ * Appends \e p_value to \e p_out as unsigned LEB128.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_varint(std::string& p_out, unsigned long long p_value);
+
+/**
+ * Appends \e p_text, which may be a null pointer, to \e p_out.
+ *
+ * Exception safety: <em>basic guarantee</em>; could throw std::bad_alloc.
+ */
+void append_log_string(std::string& p_out, char const* p_text);
+
+/**
+ * @returns \e p_value zigzag-encoded, so that integers of small
+ * magnitude have small encodings.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+unsigned long long log_zigzag_encode(long long p_value);
+
+/**
+ * @returns the inverse of log_zigzag_encode.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+long long log_zigzag_decode(unsigned long long p_value);
+
+
+// INLINE IMPLEMENTATIONS
+
+inline
+void
+append_log_varint(std::string& p_out, unsigned long long p_value)
+{
+    while (p_value >= 0x80)
+    {
+        p_out += static_cast<char>((p_value & 0x7F) | 0x80);
+        p_value >>= 7;
+    }
+    p_out += static_cast<char>(p_value);
+    return;
+}
+
+inline
+void
+append_log_string(std::string& p_out, char const* p_text)
+{
+    if (!p_text)
+    {
+        p_out += '\0';
+        return;
+    }
+    std::size_t const length = std::strlen(p_text);
+    append_log_varint(p_out, static_cast<unsigned long long>(length) + 1);
+    p_out.append(p_text, length);
+    return;
+}
+
+inline
+unsigned long long
+log_zigzag_encode(long long p_value)
+{
+    unsigned long long const value = static_cast<unsigned long long>(p_value);
+    return (value << 1) ^ ((p_value < 0)? ~0ULL: 0ULL);
+}
+
+inline
+long long
+log_zigzag_decode(unsigned long long p_value)
+{
+    unsigned long long const ret = (p_value >> 1) ^ (0ULL - (p_value & 1));
+    return static_cast<long long>(ret);
+}
+
+}  // namespace detail
+}  // namespace jewel
+
+#endif  // GUARD_log_format_hpp_3620958174420618
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_log_site_hpp_7305928164420173
+#define GUARD_log_site_hpp_7305928164420173
+
+/** @file
+ *
+ * @brief The descriptor of a place in the source code from which the
+ * logging macros log, used by those macros to decide whether to log.
+ *
+ * Client code can ignore what's in the detail namespace.
+ */
+
+#include <atomic>
+#include <climits>
+
+namespace jewel
+{
+namespace detail
+{
+
+/**
+ * Describes a place in the source code (a "site") from which one of the
+ * logging macros logs. Each expansion of a logging macro has a static
+ * LogSite of its own, constructed the first time the expansion is
+ * executed.
+ *
+ * A LogSite holds a flag that determines whether the site logs at all,
+ * which is set by Log::enable_sites and Log::disable_sites, and counters
+ * used by JEWEL_LOG_EVERY_N, JEWEL_LOG_FIRST_N and JEWEL_LOG_EVERY_MS.
+ * All of its member functions may be called from any number of threads
+ * at once.
+ */
+class LogSite
+{
+public:
+
+    /**
+     * Registers the site with Log, and sets whether it is enabled
+     * according to the calls already made to Log::enable_sites and
+     * Log::disable_sites. The strings must outlive the LogSite (as
+     * string literals and __func__ do).
+     *
+     * Never throws.
+     */
+    LogSite(char const* p_function, char const* p_file, int p_line);
+
+    LogSite(LogSite const&) = delete;
+    LogSite(LogSite&&) = delete;
+    LogSite& operator=(LogSite const&) = delete;
+    LogSite& operator=(LogSite&&) = delete;
+    ~LogSite() = default;
+
+    /**
+     * @returns true if the site is enabled.
+     *
+     * Never throws.
+     */
+    bool should_log() const;
+
+    /**
+     * Counts an execution of the site, if it is enabled.
+     *
+     * @returns true if the site is enabled and this is the 1st,
+     * (p_n + 1)th, (2 * p_n + 1)th... execution counted. Always returns
+     * false if \e p_n is 0.
+     *
+     * Never throws.
+     */
+    bool should_log_every_n(unsigned long long p_n);
+
+    /**
+     * Counts an execution of the site, if it is enabled.
+     *
+     * @returns true if the site is enabled and fewer than \e p_n
+     * executions were counted before this one.
+     *
+     * Never throws.
+     */
+    bool should_log_first_n(unsigned long long p_n);
+
+    /**
+     * @returns true if the site is enabled, and either this is the first
+     * time it has returned true, or at least \e p_milliseconds
+     * milliseconds have passed since it last did so.
+     *
+     * Never throws.
+     */
+    bool should_log_every_ms(unsigned long long p_milliseconds);
+
+    /**
+     * Never throws.
+     */
+    void set_enabled(bool p_enabled);
+
+    char const* function() const;
+    char const* file() const;
+    int line() const;
+
+    /**
+     * The next site in the list of all sites registered with Log.
+     */
+    LogSite* next() const;
+
+private:
+    static long long const s_never = LLONG_MIN;
+
+    char const* const m_function;
+    char const* const m_file;
+    int const m_line;
+    std::atomic<bool> m_enabled;
+    std::atomic<unsigned long long> m_count;
+    std::atomic<long long> m_last_logged;  // milliseconds, steady clock
+    LogSite* m_next;
+};
+
+
+// INLINE IMPLEMENTATIONS
+
+inline
+bool
+LogSite::should_log() const
+{
+    return m_enabled.load(std::memory_order_relaxed);
+}
+
+inline
+bool
+LogSite::should_log_every_n(unsigned long long p_n)
+{
+    return
+        should_log() &&
+        (p_n != 0) &&
+        (m_count.fetch_add(1, std::memory_order_relaxed) % p_n == 0);
+}
+
+inline
+bool
+LogSite::should_log_first_n(unsigned long long p_n)
+{
+    // Once p_n executions have been counted, we stop counting, so that the
+    // count cannot wrap around.
+    return
+        should_log() &&
+        (m_count.load(std::memory_order_relaxed) < p_n) &&
+        (m_count.fetch_add(1, std::memory_order_relaxed) < p_n);
+}
+
+inline
+void
+LogSite::set_enabled(bool p_enabled)
+{
+    m_enabled.store(p_enabled, std::memory_order_relaxed);
+    return;
+}
+
+inline
+char const*
+LogSite::function() const
+{
+    return m_function;
+}
+
+inline
+char const*
+LogSite::file() const
+{
+    return m_file;
+}
+
+inline
+int
+LogSite::line() const
+{
+    return m_line;
+}
+
+inline
+LogSite*
+LogSite::next() const
+{
+    return m_next;
+}
+
+}  // namespace detail
+}  // namespace jewel
+
+#endif  // GUARD_log_site_hpp_7305928164420173
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_log_value_hpp_4819203657718342
+#define GUARD_log_value_hpp_4819203657718342
+
+/** @file
+ *
+ * @brief The conversion to text of the values logged by JEWEL_LOG_VALUE.
+ *
+ * Client code can ignore what's in the detail namespace.
+ */
+
+#include "../to_chars.hpp"
+#include <boost/lexical_cast.hpp>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace jewel
+{
+namespace detail
+{
+
+/**
+ * Has a static member \e value that is true if and only if there is an
+ * overload of jewel::to_chars (or one found by argument-dependent lookup)
+ * that can be called with an argument of type T.
+ */
+template <typename T>
+class HasToChars
+{
+private:
+    template <typename U>
+    static auto test(int) -> decltype
+    (   to_chars
+        (   static_cast<char*>(nullptr),
+            static_cast<char*>(nullptr),
+            std::declval<U const&>()
+        ),
+        std::true_type()
+    );
+
+    template <typename U>
+    static std::false_type test(...);
+
+public:
+    static bool const value = decltype(test<T>(0))::value;
+};
+
+/**
+ * Has a static member \e value that is true if and only if JEWEL_LOG_VALUE
+ * formats values of type T using jewel::to_chars. This is so for the
+ * arithmetic types other than the character types (which
+ * boost::lexical_cast writes as characters rather than as numbers), and
+ * for the class types for which there is an overload of to_chars, such as
+ * Decimal, CappedString and Version. Enumerations are excluded, so that
+ * any stream output operators defined for them are still used.
+ */
+template <typename T>
+struct IsFormattedByToChars: std::integral_constant
+<   bool,
+    (   std::is_arithmetic<T>::value &&
+        !std::is_same<T, char>::value &&
+        !std::is_same<T, signed char>::value &&
+        !std::is_same<T, unsigned char>::value &&
+        !std::is_same<T, wchar_t>::value &&
+        !std::is_same<T, char16_t>::value &&
+        !std::is_same<T, char32_t>::value
+    ) ||
+    (std::is_class<T>::value && HasToChars<T>::value)
+>
+{
+};
+
+/**
+ * Holds the text of a value logged by JEWEL_LOG_VALUE.
+ *
+ * Values of the types for which IsFormattedByToChars is true are
+ * written by jewel::to_chars into a buffer within the LogValue, without
+ * heap allocation; others (and those too long for the buffer) are
+ * converted by boost::lexical_cast.
+ */
+class LogValue
+{
+public:
+
+    /**
+     * @throws boost::bad_lexical_cast or std::bad_alloc, if \e p_value is
+     * converted by boost::lexical_cast, and the conversion fails.
+     */
+    template <typename T>
+    explicit LogValue(T const& p_value);
+
+    LogValue(LogValue const&) = delete;
+    LogValue(LogValue&&) = delete;
+    LogValue& operator=(LogValue const&) = delete;
+    LogValue& operator=(LogValue&&) = delete;
+    ~LogValue() = default;
+
+    /**
+     * Never throws.
+     */
+    char const* c_str() const;
+
+private:
+    template <typename T>
+    void format(T const& p_value, std::true_type);
+
+    template <typename T>
+    void format(T const& p_value, std::false_type);
+
+    // Large enough for any number, and for the values of the "value"
+    // field that are not truncated in asynchronous mode.
+    static std::size_t const s_buffer_size = 128;
+
+    char const* m_text;
+    char m_buffer[s_buffer_size];
+    std::string m_converted;
+};
+
+
+// INLINE IMPLEMENTATIONS
+
+template <typename T>
+inline
+LogValue::LogValue(T const& p_value): m_text(m_buffer)
+{
+    format(p_value, IsFormattedByToChars<T>());
+}
+
+inline
+char const*
+LogValue::c_str() const
+{
+    return m_text;
+}
+
+template <typename T>
+inline
+void
+LogValue::format(T const& p_value, std::true_type)
+{
+    char* const last =
+        to_chars(m_buffer, m_buffer + s_buffer_size - 1, p_value);
+    if (last)
+    {
+        *last = '\0';
+        return;
+    }
+    format(p_value, std::false_type());
+    return;
+}
+
+template <typename T>
+inline
+void
+LogValue::format(T const& p_value, std::false_type)
+{
+    m_converted = boost::lexical_cast<std::string>(p_value);
+    m_text = m_converted.c_str();
+    return;
+}
+
+}  // namespace detail
+}  // namespace jewel
+
+#endif  // GUARD_log_value_hpp_4819203657718342
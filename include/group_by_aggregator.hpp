@@ -0,0 +1,675 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_group_by_aggregator_hpp_6860293149221347
+#define GUARD_group_by_aggregator_hpp_6860293149221347
+
+/** @file
+ *
+ * @brief Facilities for computing the count, sum, minimum and maximum of
+ * Decimal values grouped by a key.
+ *
+ * @see jewel::DecimalAggregate
+ * @see jewel::GroupByAggregator
+ */
+
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace jewel
+{
+
+/// @cond
+namespace detail
+{
+
+/**
+ * A 128-bit two's complement integer, held as two 64-bit halves so that
+ * DecimalAggregate can be declared without relying on compiler support
+ * for 128-bit integers. Arithmetic beyond what is needed to add a value
+ * is done in group_by_aggregator.cpp.
+ */
+struct AggregateWord
+{
+    std::uint64_t high;
+    std::uint64_t low;
+};
+
+AggregateWord make_aggregate_word(std::int64_t p_value);
+
+/**
+ * @returns true if and only if \e p_lhs is less than \e p_rhs.
+ */
+bool less(AggregateWord const& p_lhs, AggregateWord const& p_rhs);
+
+/**
+ * Adds \e p_rhs to \e p_lhs, unless the sum would overflow, in which case
+ * \e p_lhs is left unchanged.
+ *
+ * @returns false if and only if the sum would overflow.
+ */
+bool add(AggregateWord& p_lhs, AggregateWord const& p_rhs);
+
+}  // namespace detail
+/// @endcond
+
+
+/**
+ * @brief Accumulates the count, sum, minimum and maximum of a sequence of
+ * Decimal numbers.
+ *
+ * The running sum, minimum and maximum are held as 128-bit integers at the
+ * greatest number of places of any value added so far, so that the sum is
+ * exact even where it exceeds the range of Decimal part-way through, and
+ * adding a value takes only a few integer operations where its number of
+ * places is the same as before.
+ *
+ * Exception safety: unless otherwise stated, member functions offer the
+ * <em>nothrow guarantee</em>.
+ */
+class DecimalAggregate
+{
+public:
+
+    /**
+     * Constructs an aggregate of no values.
+     */
+    DecimalAggregate();
+
+    /**
+     * Constructs an aggregate of the single value \e p_value.
+     */
+    explicit DecimalAggregate(Decimal const& p_value);
+
+    /**
+     * Add \e p_value to the aggregate.
+     *
+     * @exception DecimalAdditionException thrown if the sum overflows 128
+     * bits, which is possible only after adding very many values close to
+     * the limits of Decimal.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    void add(Decimal const& p_value);
+
+    /**
+     * Combine the values aggregated by \e p_other into this aggregate.
+     *
+     * @exception DecimalAdditionException thrown in the same circumstances
+     * as for add().
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    void merge(DecimalAggregate const& p_other);
+
+    /**
+     * @returns the number of values aggregated.
+     */
+    std::size_t count() const;
+
+    /**
+     * @returns the sum of the values aggregated (zero if there are none),
+     * with as many places as the value with the most places, or with
+     * fewer if the sum could not otherwise be represented.
+     *
+     * @exception DecimalAdditionException thrown if the sum cannot be
+     * represented as a Decimal.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    Decimal sum() const;
+
+    /**
+     * @returns the smallest value aggregated, expressed in the same way as
+     * the sum. Behaviour is undefined if count() is 0.
+     */
+    Decimal minimum() const;
+
+    /**
+     * @returns the largest value aggregated, expressed in the same way as
+     * the sum. Behaviour is undefined if count() is 0.
+     */
+    Decimal maximum() const;
+
+private:
+    void rescale(Decimal::places_type p_places);
+    static Decimal to_decimal
+    (   detail::AggregateWord const& p_intval,
+        Decimal::places_type p_places
+    );
+
+    detail::AggregateWord m_sum;
+    detail::AggregateWord m_minimum;
+    detail::AggregateWord m_maximum;
+    std::size_t m_count;
+    Decimal::places_type m_places;
+};
+
+
+/**
+ * @brief Computes aggregates of values grouped by key.
+ *
+ * Only Decimal values are currently supported; see the specialization
+ * GroupByAggregator<Key, Decimal, Hash>.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key> >
+class GroupByAggregator;
+
+
+/**
+ * @brief Computes the count, sum, minimum and maximum of Decimal values
+ * grouped by a key of type \e Key.
+ *
+ * @tparam Key the type of the key. Must be default-constructible,
+ * copyable and equality-comparable. A jewel::CappedString is a good
+ * choice for short codes such as account codes, as it is stored inline
+ * without heap allocation.
+ *
+ * @tparam Hash a function object type returning a std::size_t hash of a
+ * \e Key.
+ *
+ * The groups are held in a single array, using open addressing with linear
+ * probing. Each slot of the array holds the key, its hash and its
+ * DecimalAggregate inline, so that adding a value to an existing group
+ * allocates no memory and usually touches a single cache line or two.
+ * (Compare a <b>std::map<std::string, Decimal></b>, which allocates a
+ * node, and often a string, for each group, and whose lookups follow a
+ * pointer at each level of a tree.)
+ *
+ * To aggregate in parallel, give each thread its own GroupByAggregator,
+ * and then merge() them all into one.
+ *
+ * Exception safety: unless otherwise stated, member functions offer the
+ * <em>nothrow guarantee</em>, provided that the operations of \e Key and
+ * \e Hash do not throw.
+ */
+template <typename Key, typename Hash>
+class GroupByAggregator<Key, Decimal, Hash>
+{
+public:
+
+    typedef Key key_type;
+
+    /**
+     * Constructs an empty aggregator, with room for \e p_expected_groups
+     * groups before its table needs to grow.
+     *
+     * @exception std::bad_alloc thrown in the unlikely event of memory
+     * allocation failure.
+     */
+    explicit GroupByAggregator(std::size_t p_expected_groups = 0);
+
+    /**
+     * Add \e p_value to the group for \e p_key, creating the group if
+     * necessary.
+     *
+     * @exception DecimalAdditionException thrown if the group's sum
+     * overflows 128 bits (see DecimalAggregate::add()).
+     *
+     * @exception std::bad_alloc thrown in the unlikely event of memory
+     * allocation failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    void add(Key const& p_key, Decimal const& p_value);
+
+    /**
+     * Add each of the \e p_count values starting at \e p_values to the
+     * group for the corresponding key starting at \e p_keys.
+     *
+     * Exceptions are as for add(Key const&, Decimal const&).
+     *
+     * Exception safety: <em>basic guarantee</em>. If an exception is
+     * thrown, the pairs before the one that caused it will have been added.
+     */
+    void add(Key const* p_keys, Decimal const* p_values, std::size_t p_count);
+
+    /**
+     * Combine each group of \e p_other into the group of this aggregator
+     * with the same key, creating groups as necessary.
+     *
+     * Exceptions are as for add(Key const&, Decimal const&).
+     *
+     * Exception safety: <em>basic guarantee</em>.
+     */
+    void merge(GroupByAggregator const& p_other);
+
+    /**
+     * @returns the number of groups.
+     */
+    std::size_t size() const;
+
+    /**
+     * @returns \e true if and only if there are no groups.
+     */
+    bool empty() const;
+
+    /**
+     * @returns a pointer to the aggregate for the group for \e p_key, or
+     * a null pointer if there is no such group. The pointer is invalidated
+     * by any subsequent call to a non-const member function.
+     */
+    DecimalAggregate const* find(Key const& p_key) const;
+
+    /**
+     * Call \e p_func(key, aggregate) for each group, in no particular
+     * order, where \e key is a <tt>Key const&</tt> and \e aggregate a
+     * <tt>DecimalAggregate const&</tt>.
+     *
+     * Exception safety: depends on \e p_func.
+     */
+    template <typename Func>
+    void for_each(Func p_func) const;
+
+    /**
+     * Remove all the groups.
+     */
+    void clear();
+
+private:
+
+    struct Slot
+    {
+        Key key;
+        std::size_t hash;
+        bool is_occupied;
+        DecimalAggregate aggregate;
+    };
+
+    /**
+     * @returns the position of the slot holding the group for \e p_key,
+     * whose hash is \e p_hash, or, if there is no such group, of the empty
+     * slot at which it should be inserted.
+     */
+    std::size_t probe(Key const& p_key, std::size_t p_hash) const;
+
+    /**
+     * Insert a group for \e p_key, known not to exist already, growing the
+     * table if necessary.
+     */
+    void insert
+    (   Key const& p_key,
+        std::size_t p_hash,
+        DecimalAggregate const& p_aggregate
+    );
+
+    void rebuild(std::size_t p_capacity);
+
+    static std::size_t const min_capacity = 16;
+
+    std::vector<Slot> m_slots;
+    std::size_t m_size;
+    unsigned int m_shift;
+    Hash m_hasher;
+};
+
+
+// INLINE FUNCTION DEFINITIONS
+
+namespace detail
+{
+
+inline
+AggregateWord
+make_aggregate_word(std::int64_t p_value)
+{
+    AggregateWord ret;
+    ret.high = (p_value < 0)? ~std::uint64_t(0): 0;
+    ret.low = static_cast<std::uint64_t>(p_value);
+    return ret;
+}
+
+inline
+bool
+less(AggregateWord const& p_lhs, AggregateWord const& p_rhs)
+{
+    // Flipping the sign bit lets the high halves be compared as unsigned.
+    std::uint64_t const sign_bit = std::uint64_t(1) << 63;
+    std::uint64_t const lhs_high = p_lhs.high ^ sign_bit;
+    std::uint64_t const rhs_high = p_rhs.high ^ sign_bit;
+    return
+        (lhs_high < rhs_high) ||
+        ((lhs_high == rhs_high) && (p_lhs.low < p_rhs.low));
+}
+
+inline
+bool
+add(AggregateWord& p_lhs, AggregateWord const& p_rhs)
+{
+    std::uint64_t const low = p_lhs.low + p_rhs.low;
+    std::uint64_t const carry = (low < p_lhs.low)? 1: 0;
+    std::uint64_t const high = p_lhs.high + p_rhs.high + carry;
+
+    // Overflow if and only if the operands have the same sign, and the
+    // result's sign differs from it.
+    std::uint64_t const sign_bit = std::uint64_t(1) << 63;
+    if ((~(p_lhs.high ^ p_rhs.high) & (p_lhs.high ^ high)) & sign_bit)
+    {
+        return false;
+    }
+    p_lhs.high = high;
+    p_lhs.low = low;
+    return true;
+}
+
+}  // namespace detail
+
+inline
+DecimalAggregate::DecimalAggregate():
+    m_sum(detail::make_aggregate_word(0)),
+    m_minimum(detail::make_aggregate_word(0)),
+    m_maximum(detail::make_aggregate_word(0)),
+    m_count(0),
+    m_places(0)
+{
+}
+
+inline
+DecimalAggregate::DecimalAggregate(Decimal const& p_value):
+    m_sum(detail::make_aggregate_word(p_value.intval())),
+    m_minimum(m_sum),
+    m_maximum(m_sum),
+    m_count(1),
+    m_places(p_value.places())
+{
+}
+
+inline
+void
+DecimalAggregate::add(Decimal const& p_value)
+{
+    if (m_count == 0)
+    {
+        *this = DecimalAggregate(p_value);
+        return;
+    }
+    DecimalAggregate other(p_value);
+    if (other.m_places == m_places)
+    {
+        // The common case, which we keep simple.
+        detail::AggregateWord const& x = other.m_sum;
+        if (!detail::add(m_sum, x))
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalAdditionException,
+                "Unsafe addition."
+            );
+        }
+        if (detail::less(x, m_minimum)) m_minimum = x;
+        if (detail::less(m_maximum, x)) m_maximum = x;
+        ++m_count;
+        return;
+    }
+    merge(other);
+    return;
+}
+
+inline
+std::size_t
+DecimalAggregate::count() const
+{
+    return m_count;
+}
+
+inline
+Decimal
+DecimalAggregate::sum() const
+{
+    return to_decimal(m_sum, m_places);
+}
+
+inline
+Decimal
+DecimalAggregate::minimum() const
+{
+    JEWEL_ASSERT (m_count > 0);
+    return to_decimal(m_minimum, m_places);
+}
+
+inline
+Decimal
+DecimalAggregate::maximum() const
+{
+    JEWEL_ASSERT (m_count > 0);
+    return to_decimal(m_maximum, m_places);
+}
+
+template <typename Key, typename Hash>
+std::size_t const GroupByAggregator<Key, Decimal, Hash>::min_capacity;
+
+template <typename Key, typename Hash>
+GroupByAggregator<Key, Decimal, Hash>::GroupByAggregator
+(   std::size_t p_expected_groups
+):
+    m_size(0),
+    m_shift(0)
+{
+    std::size_t capacity = min_capacity;
+    while (capacity / 4 * 3 < p_expected_groups)
+    {
+        capacity *= 2;
+    }
+    rebuild(capacity);
+}
+
+template <typename Key, typename Hash>
+inline
+void
+GroupByAggregator<Key, Decimal, Hash>::add
+(   Key const& p_key,
+    Decimal const& p_value
+)
+{
+    std::size_t const hash = m_hasher(p_key);
+    Slot& slot = m_slots[probe(p_key, hash)];
+    if (slot.is_occupied)
+    {
+        slot.aggregate.add(p_value);
+    }
+    else
+    {
+        insert(p_key, hash, DecimalAggregate(p_value));
+    }
+    return;
+}
+
+template <typename Key, typename Hash>
+void
+GroupByAggregator<Key, Decimal, Hash>::add
+(   Key const* p_keys,
+    Decimal const* p_values,
+    std::size_t p_count
+)
+{
+    for (std::size_t i = 0; i != p_count; ++i)
+    {
+        add(p_keys[i], p_values[i]);
+    }
+    return;
+}
+
+template <typename Key, typename Hash>
+void
+GroupByAggregator<Key, Decimal, Hash>::merge
+(   GroupByAggregator const& p_other
+)
+{
+    JEWEL_ASSERT (&p_other != this);
+    for (Slot const& other_slot: p_other.m_slots)
+    {
+        if (!other_slot.is_occupied)
+        {
+            continue;
+        }
+        Slot& slot = m_slots[probe(other_slot.key, other_slot.hash)];
+        if (slot.is_occupied)
+        {
+            slot.aggregate.merge(other_slot.aggregate);
+        }
+        else
+        {
+            insert(other_slot.key, other_slot.hash, other_slot.aggregate);
+        }
+    }
+    return;
+}
+
+template <typename Key, typename Hash>
+inline
+std::size_t
+GroupByAggregator<Key, Decimal, Hash>::size() const
+{
+    return m_size;
+}
+
+template <typename Key, typename Hash>
+inline
+bool
+GroupByAggregator<Key, Decimal, Hash>::empty() const
+{
+    return m_size == 0;
+}
+
+template <typename Key, typename Hash>
+DecimalAggregate const*
+GroupByAggregator<Key, Decimal, Hash>::find(Key const& p_key) const
+{
+    Slot const& slot = m_slots[probe(p_key, m_hasher(p_key))];
+    return slot.is_occupied? &slot.aggregate: nullptr;
+}
+
+template <typename Key, typename Hash>
+template <typename Func>
+void
+GroupByAggregator<Key, Decimal, Hash>::for_each(Func p_func) const
+{
+    for (Slot const& slot: m_slots)
+    {
+        if (slot.is_occupied)
+        {
+            p_func(slot.key, slot.aggregate);
+        }
+    }
+    return;
+}
+
+template <typename Key, typename Hash>
+void
+GroupByAggregator<Key, Decimal, Hash>::clear()
+{
+    for (Slot& slot: m_slots)
+    {
+        slot.is_occupied = false;
+    }
+    m_size = 0;
+    return;
+}
+
+template <typename Key, typename Hash>
+inline
+std::size_t
+GroupByAggregator<Key, Decimal, Hash>::probe
+(   Key const& p_key,
+    std::size_t p_hash
+) const
+{
+    // Multiplying by 2^64 divided by the golden ratio, and taking the
+    // high bits, spreads out keys whose hashes differ only in their low
+    // bits (as is common with std::hash for integers).
+    std::size_t const mask = m_slots.size() - 1;
+    std::size_t i = static_cast<std::size_t>
+    (   (static_cast<std::uint64_t>(p_hash) * 11400714819323198485ULL) >>
+        m_shift
+    );
+    for ( ; ; i = (i + 1) & mask)
+    {
+        Slot const& slot = m_slots[i];
+        if
+        (   !slot.is_occupied ||
+            (slot.hash == p_hash && slot.key == p_key)
+        )
+        {
+            return i;
+        }
+    }
+}
+
+template <typename Key, typename Hash>
+void
+GroupByAggregator<Key, Decimal, Hash>::insert
+(   Key const& p_key,
+    std::size_t p_hash,
+    DecimalAggregate const& p_aggregate
+)
+{
+    // Keep the load factor at most 3/4, so that probe sequences stay
+    // short, and there is always an empty slot to end them.
+    if (m_size + 1 > m_slots.size() / 4 * 3)
+    {
+        rebuild(m_slots.size() * 2);
+    }
+    Slot& slot = m_slots[probe(p_key, p_hash)];
+    JEWEL_ASSERT (!slot.is_occupied);
+    slot.key = p_key;
+    slot.hash = p_hash;
+    slot.aggregate = p_aggregate;
+    slot.is_occupied = true;
+    ++m_size;
+    return;
+}
+
+template <typename Key, typename Hash>
+void
+GroupByAggregator<Key, Decimal, Hash>::rebuild(std::size_t p_capacity)
+{
+    JEWEL_ASSERT (p_capacity >= min_capacity);
+    JEWEL_ASSERT ((p_capacity & (p_capacity - 1)) == 0);
+    unsigned int shift = 64;
+    for (std::size_t c = p_capacity; c != 1; c /= 2)
+    {
+        --shift;
+    }
+    std::vector<Slot> slots(p_capacity);
+    for (Slot& slot: slots)
+    {
+        slot.is_occupied = false;
+    }
+
+    // Nothing below can throw (given a non-throwing Key).
+    slots.swap(m_slots);
+    m_shift = shift;
+    for (Slot const& old_slot: slots)
+    {
+        if (old_slot.is_occupied)
+        {
+            m_slots[probe(old_slot.key, old_slot.hash)] = old_slot;
+        }
+    }
+    return;
+}
+
+}  // namespace jewel
+
+#endif  // GUARD_group_by_aggregator_hpp_6860293149221347
@@ -22,7 +22,12 @@
  * @brief Logging facilities
  */
 
+#include "detail/helper_macros.hpp"
+#include "detail/log_site.hpp"
+#include "detail/log_value.hpp"
 #include <boost/lexical_cast.hpp>
+#include <atomic>
+#include <cstddef>
 #include <exception>
 #include <new>
 #include <string>
@@ -59,9 +64,18 @@ namespace jewel
  * If we were to enable a stream to be passed to
  * Log, then it might be that exceptions are enabled on that stream, and it then
  * becomes difficult/complicated if we still want to offer the no-throw
- * guarantee. The main price paid for this policy is that logging cannot
- * (at least, not easily) be directed to standard output / standard error - we
- * can only easily direct it to a file.
+ * guarantee. Logging can nevertheless be directed to standard error, which
+ * is written to directly via its file descriptor, by passing
+ * Log::standard_error_filepath to Log::add_sink.
+ *
+ * Besides the file set by Log::set_filepath, records can be written to
+ * any number of further files (sinks), each added by Log::add_sink with a
+ * threshold, Format and FlushPolicy of its own; so that, for example,
+ * errors can be written to standard error while everything down to trace
+ * is written to a file. Each record is formatted at most once in each
+ * format, however many files it is written to in that format. The set of
+ * files is published in such a way that threads logging never wait for a
+ * lock to find them, even while files are being added or removed.
  *
  * The format of the resulting log file is designed to be both readable for
  * a human and easy to parse. In particular, if desired, it can be converted
@@ -73,6 +87,7 @@ namespace jewel
  * <em>
  * {R}\n
  * {F}[id]198\n
+ * {F}[timestamp]2013-11-29T09:43:02.417306\n
  * {F}[severity]warning\n
  * {F}[message]Division by zero.\n
  * {F}[function]operator/=\n
@@ -97,15 +112,40 @@ namespace jewel
  * conversion to CSV via the Python script is itself quite robust, with
  * proper escaping etc. performed.
  *
- * <b>NOTE These logging facilities are not thread-safe!</b>
+ * The "timestamp" is the local date and time at which Log::log was called,
+ * to the microsecond. It is read from a monotonic clock, offset to agree
+ * with the system clock as it was when logging first took place, so that
+ * adjustments to the system clock while the program is running do not
+ * disturb the intervals between records. (Records from different threads
+ * may nevertheless appear slightly out of order.) The date and time are
+ * formatted only once per second per thread, so that the cost of
+ * timestamping each record is little more than that of reading the clock.
+ *
+ * These logging facilities are thread-safe: the logging macros, and the
+ * functions of Log, may be called from any number of threads at once. Each
+ * thread formats its records in a buffer of its own, and each record is then
+ * appended to the file with a single write, so that records from different
+ * threads are never interleaved. Note that records from different threads
+ * are not necessarily written in the order of their ids.
  *
- * @todo MEDIUM PRIORITY Provide a way to direct logging to standard output
- * streams without sacrificing exception safety and without complicating the
- * API too much. Note on Unix-like systems the client can pass "/dev/tty",
- * "/dev/stderr" or "/dev/stdout" to set_filepath(). Is there an equivalent on
- * Windows?
+ * In asynchronous mode, Log::log merely copies the logging event into a
+ * fixed-size slot in a lock-free queue, and a background thread formats the
+ * queued events in batches and writes them to the file. This takes the cost
+ * of formatting and of file output off the logging thread. What happens
+ * when the queue is full is determined by the Log::QueueFullPolicy passed
+ * to set_asynchronous. Note that in asynchronous mode, the "message" and
+ * "value" fields are truncated to 255 and 127 characters respectively.
+ * Records still queued when the log file is changed, or when the program
+ * exits normally, are written before the file is closed.
  *
- * @todo MEDIUM PRIORITY Write unit tests for this.
+ * Besides the thresholds, each place in the source code from which one of
+ * the logging macros logs (each "site") can be switched off and on while
+ * the program is running, by file or by function, using
+ * Log::disable_sites and Log::enable_sites. This allows a single chatty
+ * site to be silenced without raising the threshold for the whole program.
+ * The JEWEL_LOG_EVERY_N, JEWEL_LOG_FIRST_N and JEWEL_LOG_EVERY_MS macros
+ * log only some of the times they are executed, so that logging can be
+ * left in hot code paths.
  *
  * <em>Important:</em> To avoid complications involving the destruction order
  * of function-local static objects, it is best to set up logging facilities
@@ -135,28 +175,397 @@ public:
     };
 
     /**
-     * Tell the logging engine the file you want log messages written to.
-     * This must be called or logging will not occur at all.
+     * @enum Format
+     *
+     * The format in which the log file is written.
+     */
+    enum Format
+    {
+        /** the "{R}" / "{F}" text format described above */
+        text = 0,
+
+        /**
+         * a compact binary format, in which the strings that are the same
+         * for every record logged from a given place in the source code
+         * (the function, file, line, compilation date and time, exception
+         * type and expression) are written only once per file, and each
+         * record consists of only a reference to those strings, its id, a
+         * timestamp, its severity and its message and value (if any).
+         * The file can be converted into the text format, or into CSV, by
+         * jewel::decode_binary_log and jewel::convert_log_to_csv, or by
+         * the "jewel_log_decode" tool.
+         */
+        binary,
+
+        /**
+         * one line of JSON per record, holding an object with the same
+         * fields as the text format, in the same order, e.g.
+         * {"id":198,"timestamp":"2013-11-29T09:43:02.417306",
+         * "severity":"warning","message":"Division by zero.",...}
+         * (but all on one line). Suitable for log collectors that read
+         * JSON lines.
+         */
+        json
+    };
+
+    /**
+     * @enum QueueFullPolicy
+     *
+     * Determines what happens to a logging event in asynchronous mode
+     * if the queue of events waiting to be written is full.
+     */
+    enum QueueFullPolicy
+    {
+        block,          /**< wait until there is room in the queue */
+        drop,           /**< silently discard the event */
+        drop_and_count  /**< discard the event, and write a warning
+                             saying how many events were discarded,
+                             once there is room */
+    };
+
+    /**
+     * The default number of logging events that may be queued in
+     * asynchronous mode.
+     */
+    static std::size_t const default_queue_capacity = 8192;
+
+    /**
+     * @brief Determines when records are written to the log file, as
+     * opposed to being held in a buffer in memory.
+     *
+     * Under the default policy, every_record(), each record is written to
+     * the file as soon as it is logged, which costs a system call per
+     * record. Under the other policies, records are gathered in a buffer
+     * of \e buffer_size bytes, and the buffer is written to the file
+     * (flushed) as soon as any of the following occurs:
+     *
+     * - the buffer holds at least \e records records (if \e records is
+     *   not 0);
+     * - the buffer holds at least \e bytes bytes (if \e bytes is not 0);
+     * - the oldest record in the buffer was logged at least
+     *   \e milliseconds milliseconds ago (if \e milliseconds is not 0);
+     * - a record with a severity of at least \e severity is logged;
+     * - the next record would not fit in the buffer;
+     * - Log::flush is called, the log file is changed, the program exits
+     *   normally, or std::terminate is called (including by a failed
+     *   JEWEL_ASSERT or JEWEL_HARD_ASSERT).
+     *
+     * The static functions return the commonest policies, which can be
+     * combined by setting further members of the result.
+     */
+    struct FlushPolicy
+    {
+        /**
+         * Constructs the same policy as every_record().
+         *
+         * Never throws.
+         */
+        FlushPolicy();
+
+        /** Flush after every record. */
+        static FlushPolicy every_record();
+
+        /**
+         * Flush once \e p_records records are buffered, or a record
+         * of severity Log::error is logged.
+         */
+        static FlushPolicy every_n_records(std::size_t p_records);
+
+        /**
+         * Flush once \e p_bytes bytes are buffered, or a record of
+         * severity Log::error is logged.
+         */
+        static FlushPolicy every_n_bytes(std::size_t p_bytes);
+
+        /**
+         * Flush once the oldest record buffered is \e p_milliseconds
+         * milliseconds old, or a record of severity Log::error is logged.
+         */
+        static FlushPolicy every_n_milliseconds(unsigned int p_milliseconds);
+
+        /**
+         * Flush only when a record of severity at least \e p_severity is
+         * logged (or the buffer is full).
+         */
+        static FlushPolicy at_severity(Level p_severity);
+
+        std::size_t records;        /**< 1 to write each record at once */
+        std::size_t bytes;          /**< 0 for no limit short of a full
+                                         buffer */
+        unsigned int milliseconds;  /**< 0 for no limit */
+        Level severity;
+        std::size_t buffer_size;
+    };
+
+    /**
+     * The default FlushPolicy::buffer_size.
+     */
+    static std::size_t const default_buffer_size = 1 << 20;
+
+    /**
+     * Tell the logging engine the file you want log messages written to,
+     * and the Format in which to write them. This must be called or
+     * logging will not occur at all.
      *
      * @throws std::bad_alloc in the unlikely event of memory allocation
      * failure while creating the underlying logging stream.
      */
-    static void set_filepath(std::string const& p_filepath);
+    static void set_filepath
+    (   std::string const& p_filepath,
+        Format p_format = text
+    );
 
     /**
      * Sets the logging threshold so that logging events will be written
-     * to the file if and only if their severity is greater than or
-     * equal to \e p_level. By default, the threshold is Log::info.
+     * to the file set by set_filepath if and only if their severity is
+     * greater than or equal to \e p_level. By default, the threshold is
+     * Log::info. (The files added by add_sink have thresholds of their
+     * own.)
      *
      * Never throws.
      */
     static void set_threshold(Level p_level);
 
+    /**
+     * The filepath which, passed to add_sink, denotes standard error.
+     */
+    static char const standard_error_filepath[];
+
+    /**
+     * Causes logging events to be written, in addition to the file set by
+     * set_filepath, to the file at \e p_filepath (a sink), if and only if
+     * their severity is greater than or equal to \e p_threshold. The
+     * records are written in the Format \e p_format, and buffered
+     * according to \e p_flush_policy, independently of the other files.
+     * The file is truncated and starts with a "Commenced logging" record,
+     * as does the file set by set_filepath.
+     *
+     * If \e p_filepath is standard_error_filepath, the records are written
+     * to standard error (which is not truncated).
+     *
+     * If a sink with the same filepath has already been added, it is
+     * removed (as by remove_sink) before the file is opened again with the
+     * new settings. \e p_filepath should differ from that passed to
+     * set_filepath. If the file cannot be opened, no sink is added.
+     *
+     * Threads that are logging do not wait for a lock while a sink is
+     * added, but this function waits for them to finish writing to the
+     * files they found before it returns.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure.
+     *
+     * @throws std::system_error if \e p_flush_policy has a non-zero
+     * \e milliseconds, and the thread that flushes buffers periodically
+     * could not be started.
+     *
+     * Exception safety: <em>basic guarantee</em>.
+     */
+    static void add_sink
+    (   std::string const& p_filepath,
+        Level p_threshold,
+        Format p_format = text,
+        FlushPolicy const& p_flush_policy = FlushPolicy()
+    );
+
+    /**
+     * Stops logging to the sink added by add_sink with filepath
+     * \e p_filepath, if any, after writing any records buffered or
+     * queued for it, and finishing it with an "End log" record.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    static void remove_sink(std::string const& p_filepath);
+
+    /**
+     * Causes subsequent logging events to be written asynchronously
+     * by a background thread, via a queue with room for at least
+     * \e p_queue_capacity events (rounded up to a power of two), with
+     * \e p_policy determining what happens when the queue is full.
+     * If logging is already asynchronous, the events already queued are
+     * written, and a new queue and thread are then set up.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure while creating the queue.
+     *
+     * @throws std::system_error if the background thread could not be
+     * started.
+     *
+     * Exception safety: <em>basic guarantee</em>. If an exception is
+     * thrown, logging will be synchronous.
+     */
+    static void set_asynchronous
+    (   std::size_t p_queue_capacity = default_queue_capacity,
+        QueueFullPolicy p_policy = block
+    );
+
+    /**
+     * Causes subsequent logging events to be written by the thread that
+     * logs them, as is the default. If logging was asynchronous, this
+     * waits until all queued events have been written, and then stops the
+     * background thread.
+     *
+     * Never throws.
+     */
+    static void set_synchronous();
+
+    /**
+     * @returns the number of logging events that have been discarded,
+     * since the program started, because the queue was full in asynchronous
+     * mode under the Log::drop or Log::drop_and_count policy.
+     *
+     * Never throws.
+     */
+    static unsigned long long dropped_records();
+
+    /**
+     * Sets the policy that determines when records are written to the log
+     * file, both for the current file and for files set subsequently by
+     * set_filepath. (The files added by add_sink have flush policies of
+     * their own.) Any records already buffered are written first.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure while creating the buffer.
+     *
+     * @throws std::system_error if \e p_policy has a non-zero
+     * \e milliseconds, and the thread that flushes the buffer periodically
+     * could not be started.
+     *
+     * Exception safety: <em>basic guarantee</em>.
+     */
+    static void set_flush_policy(FlushPolicy const& p_policy);
+
+    /**
+     * Writes any buffered records (including those still queued in
+     * asynchronous mode) to the log file, and to the files added by
+     * add_sink.
+     *
+     * Never throws.
+     */
+    static void flush();
+
+    /**
+     * The default number of records kept per thread by the flight
+     * recorder.
+     */
+    static std::size_t const default_flight_recorder_records = 1024;
+
+    /**
+     * Starts the flight recorder, which keeps the \e p_records_per_thread
+     * records most recently logged by each thread, of severity at least
+     * \e p_threshold, in memory, without writing them to the file. The
+     * records held are written to the file set by set_filepath (dumped),
+     * and the flight recorder emptied, when dump_flight_recorder is
+     * called, and whenever a record of severity at least
+     * \e p_dump_severity is logged. (By
+     * default, this includes every failed JEWEL_ASSERT or
+     * JEWEL_HARD_ASSERT, if \b JEWEL_ENABLE_ASSERTION_LOGGING is defined.
+     * To dump whenever an exception is thrown by JEWEL_THROW, pass
+     * Log::warning.) The records dumped are ordered by their timestamps,
+     * and preceded and followed by a record of severity Log::info
+     * marking the dump.
+     *
+     * The threshold of the flight recorder is independent of the
+     * threshold of the file set by set_threshold; so, for example, trace
+     * records can be recorded in memory, at a cost of some tens of
+     * nanoseconds each, while only records of severity Log::warning and
+     * above are written to the file. A record that passes both thresholds
+     * is both recorded and written.
+     *
+     * Any flight recorder already running is replaced, and the records it
+     * holds are discarded. As with the asynchronous mode, the "message"
+     * and "value" fields of the records recorded are truncated to 255 and
+     * 127 characters respectively. \e p_records_per_thread is capped at
+     * 2<sup>20</sup>; each record takes about 450 bytes.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    static void set_flight_recorder
+    (   std::size_t p_records_per_thread = default_flight_recorder_records,
+        Level p_threshold = trace,
+        Level p_dump_severity = error
+    );
+
+    /**
+     * Stops the flight recorder, if running, discarding the records it
+     * holds.
+     *
+     * Never throws.
+     */
+    static void unset_flight_recorder();
+
+    /**
+     * Writes the records held by the flight recorder, if running, to the
+     * file, and empties the flight recorder. See set_flight_recorder.
+     *
+     * Never throws. (In the unlikely event of memory allocation failure,
+     * nothing is written.)
+     */
+    static void dump_flight_recorder();
+
+    /**
+     * Enables logging from the sites, i.e. the expansions of the logging
+     * macros, whose function name or file path matches \e p_pattern.
+     * In \e p_pattern, '*' matches any sequence of characters and '?'
+     * matches any single character; so e.g. "*decimal.cpp" matches
+     * every site in any file called "decimal.cpp", and "operator/="
+     * matches every site in any function of that name.
+     *
+     * The setting applies both to the sites that have already logged, and
+     * to those that have yet to do so. Where several calls to
+     * enable_sites and disable_sites match a site, the latest prevails.
+     * All sites are enabled initially.
+     *
+     * Records that are filtered out by the thresholds are not logged,
+     * whether or not their site is enabled.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    static void enable_sites(std::string const& p_pattern);
+
+    /**
+     * Disables logging from the sites whose function name or file path
+     * matches \e p_pattern, as described for enable_sites.
+     *
+     * @throws std::bad_alloc in the unlikely event of memory allocation
+     * failure.
+     *
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    static void disable_sites(std::string const& p_pattern);
+
+    /**
+     * @returns true if a record of severity \e p_severity would pass the
+     * runtime threshold set by set_threshold, that of any file added by
+     * add_sink, or that of the flight recorder (see set_flight_recorder).
+     * The logging macros call this inline before anything else, so that a
+     * statement below the threshold costs no more than a load and a
+     * comparison.
+     *
+     * Never throws.
+     */
+    static bool passes_threshold(Level p_severity);
+
     /**
      * Passes a logging event to the logging mechanism. Note this should
      * not normally be called by client code, which should instead use
      * the convenience macros provided (see class documentation for log.hpp).
      *
+     * In Log::binary format, \e p_function, \e p_file,
+     * \e p_compilation_date, \e p_compilation_time, \e p_exception_type
+     * and \e p_expression are assumed to be string literals (or at least
+     * never to change while the program runs), as the place in the source
+     * code from which a record is logged is identified by their addresses.
+     *
      * Never throws.
      */
     static void log
@@ -178,11 +587,7 @@ private:
 
     static char const* severity_string(Level p_level);
 
-    // Pass a stream pointer to set the static stream pointer that lives
-    // inside the function. Pass nothing to simply retrieve that pointer.
-    static std::ostream* stream_aux(std::ostream* p_stream = 0);
-
-    static Level& threshold_aux();
+    static std::atomic<Level>& threshold_aux();
 
 };
 
@@ -225,8 +630,17 @@ private:
  * it to the macro. The log will also show the function, file and line number
  * in the source code where is appears.
  *
- * Note the definition of this macro makes use of
- * boost::lexical_cast, the implementation of which inserts the passed
+ * Values of arithmetic types (other than character types), and of types
+ * for which there is an overload of jewel::to_chars (such as
+ * jewel::Decimal, jewel::CappedString and jewel::Version), are written
+ * by jewel::to_chars into a buffer on the stack, without heap allocation.
+ * Support for a further class type can be added by declaring, in the
+ * namespace of that type, a function
+ * <tt>char* to_chars(char* p_first, char* p_last, T const& p_value)</tt>
+ * that follows the conventions described in "to_chars.hpp".
+ *
+ * Values of other types are converted using boost::lexical_cast, the
+ * implementation of which inserts the passed
  * expression onto a std::ostream during the casting process. If this process
  * of calling boost::lexical_cast results in either boost::bad_lexical_cast or
  * std::bad_alloc being thrown, then that exception will be swallowed rather
@@ -235,16 +649,62 @@ private:
  * not be caught.
  */
 
+/** @def JEWEL_LOG_EVERY_N(severity, n, message)
+ * @hideinitializer
+ * @see jewel::Log
+ *
+ * Like JEWEL_LOG_MESSAGE, but logs only the 1st, (n + 1)th,
+ * (2 * n + 1)th... time it is executed (while its site is enabled).
+ *
+ * Never throws.
+ */
+
+/** @def JEWEL_LOG_FIRST_N(severity, n, message)
+ * @hideinitializer
+ * @see jewel::Log
+ *
+ * Like JEWEL_LOG_MESSAGE, but logs only the first \e n times it is
+ * executed (while its site is enabled).
+ *
+ * Never throws.
+ */
+
+/** @def JEWEL_LOG_EVERY_MS(severity, milliseconds, message)
+ * @hideinitializer
+ * @see jewel::Log
+ *
+ * Like JEWEL_LOG_MESSAGE, but logs only the first time it is executed
+ * (while its site is enabled), and thereafter only if at least
+ * \e milliseconds milliseconds have passed since it last logged.
+ *
+ * Never throws.
+ */
+
 
 /// @cond
 
+// Evaluates to a reference to the jewel::detail::LogSite of the
+// expansion, which is constructed the first time the expansion is
+// executed. The lambda is there only to give each expansion a static
+// of its own, in an expression.
+#define JEWEL_DETAIL_LOG_SITE() \
+    ([](char const* p_function) -> jewel::detail::LogSite& \
+    { \
+        static jewel::detail::LogSite site(p_function, __FILE__, __LINE__); \
+        return site; \
+    }(__func__))
+
 #ifdef JEWEL_ENABLE_LOGGING
 
 #   ifndef JEWEL_HARD_LOGGING_THRESHOLD
 #       define JEWEL_HARD_LOGGING_THRESHOLD 0
 #   endif
+#   define JEWEL_DETAIL_LOG_FILTERED_OUT(severity) \
+        JEWEL_DETAIL_LIKELY(!jewel::Log::passes_threshold(severity))
 #   define JEWEL_LOG_TRACE() \
         if (jewel::Log::trace < JEWEL_HARD_LOGGING_THRESHOLD) ; \
+        else if (JEWEL_DETAIL_LOG_FILTERED_OUT(jewel::Log::trace)) ; \
+        else if (!JEWEL_DETAIL_LOG_SITE().should_log()) ; \
         else \
             jewel::Log::log \
             (   jewel::Log::trace, \
@@ -255,8 +715,10 @@ private:
                 __DATE__, \
                 __TIME__ \
             )
-#   define JEWEL_LOG_MESSAGE(severity, message) \
+#   define JEWEL_DETAIL_LOG_MESSAGE_IF(severity, should_log, message) \
         if (severity < JEWEL_HARD_LOGGING_THRESHOLD) ; \
+        else if (JEWEL_DETAIL_LOG_FILTERED_OUT(severity)) ; \
+        else if (!JEWEL_DETAIL_LOG_SITE().should_log) ; \
         else \
             jewel::Log::log \
             (   severity, \
@@ -267,8 +729,22 @@ private:
                 __DATE__, \
                 __TIME__ \
             )
+#   define JEWEL_LOG_MESSAGE(severity, message) \
+        JEWEL_DETAIL_LOG_MESSAGE_IF(severity, should_log(), message)
+#   define JEWEL_LOG_EVERY_N(severity, n, message) \
+        JEWEL_DETAIL_LOG_MESSAGE_IF(severity, should_log_every_n(n), message)
+#   define JEWEL_LOG_FIRST_N(severity, n, message) \
+        JEWEL_DETAIL_LOG_MESSAGE_IF(severity, should_log_first_n(n), message)
+#   define JEWEL_LOG_EVERY_MS(severity, milliseconds, message) \
+        JEWEL_DETAIL_LOG_MESSAGE_IF \
+        (   severity, \
+            should_log_every_ms(milliseconds), \
+            message \
+        )
 #   define JEWEL_LOG_VALUE(severity, expression) \
         if (severity < JEWEL_HARD_LOGGING_THRESHOLD) ; \
+        else if (JEWEL_DETAIL_LOG_FILTERED_OUT(severity)) ; \
+        else if (!JEWEL_DETAIL_LOG_SITE().should_log()) ; \
         else \
             try \
             { \
@@ -282,10 +758,10 @@ private:
                     __TIME__, \
                     0, \
                     #expression, \
-                    boost::lexical_cast<std::string>(expression).c_str() \
+                    jewel::detail::LogValue(expression).c_str() \
                 ); \
             } \
-            catch (boost::bad_lexical_cast) \
+            catch (boost::bad_lexical_cast&) \
             { \
                 JEWEL_LOG_MESSAGE \
                 ( \
@@ -294,7 +770,7 @@ private:
                     "caught boost::bad_lexical_cast." \
                 ); \
             } \
-            catch (std::bad_alloc) \
+            catch (std::bad_alloc&) \
             { \
                 JEWEL_LOG_MESSAGE \
                 ( \
@@ -309,6 +785,15 @@ private:
         if (false) { (void)(severity); (void)(message); }  // Silence compiler warnings re. unused variables, and prevent them from being evaluated.
 #   define JEWEL_LOG_VALUE(severity, expression) \
         if (false) { (void)(severity); (void)(expression); } // Silence compiler warnings re. unused variables, and prevent them from being evaluated.
+#   define JEWEL_LOG_EVERY_N(severity, n, message) \
+        if (false) { (void)(severity); (void)(n); (void)(message); }
+#   define JEWEL_LOG_FIRST_N(severity, n, message) \
+        if (false) { (void)(severity); (void)(n); (void)(message); }
+#   define JEWEL_LOG_EVERY_MS(severity, milliseconds, message) \
+        if (false) \
+        { \
+            (void)(severity); (void)(milliseconds); (void)(message); \
+        }
         
 #endif  // JEWEL_ENABLE_LOGGING
 
@@ -322,10 +807,17 @@ namespace jewel
 
 
 inline
-Log::Level&
+bool
+Log::passes_threshold(Level p_severity)
+{
+    return p_severity >= threshold_aux().load(std::memory_order_relaxed);
+}
+
+inline
+std::atomic<Log::Level>&
 Log::threshold_aux()
 {
-    static Level ret = info;
+    static std::atomic<Level> ret(info);
     return ret;
 }
 
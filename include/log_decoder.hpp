@@ -0,0 +1,94 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef GUARD_log_decoder_hpp_5830174926381047
+#define GUARD_log_decoder_hpp_5830174926381047
+
+/** @file
+ *
+ * @brief Functions for converting log files written by jewel::Log in
+ * binary format into the text format, and log files in the text format
+ * into CSV.
+ *
+ * @see jewel::decode_binary_log
+ * @see jewel::convert_log_to_csv
+ */
+
+#include "exception.hpp"
+#include <istream>
+#include <ostream>
+
+namespace jewel
+{
+
+/** @class jewel::LogDecoderException
+ *
+ * @extends jewel::Exception
+ *
+ * Exception to be thrown when a log file cannot be decoded or converted,
+ * because it is not in the expected format.
+ */
+
+/// @cond
+JEWEL_DERIVED_EXCEPTION(LogDecoderException, jewel::Exception);
+/// @endcond
+
+
+/**
+ * Reads a log file written by jewel::Log in Log::binary format from
+ * \e p_binary_log, and writes it to \e p_text_log in Log::text format,
+ * exactly as Log would have written it had it been writing in that
+ * format (apart from the record ids and the dates and times, which are
+ * those that were written to the binary file). The timestamps of the
+ * records are written as local dates and times, in the time zone of the
+ * program calling this function.
+ *
+ * \e p_binary_log should have been opened in binary mode.
+ *
+ * @throws LogDecoderException if \e p_binary_log is not a binary log
+ * file, is of an unsupported version of the format, or ends part way
+ * through an entry. Any complete entries preceding the problem will
+ * already have been written to \e p_text_log.
+ *
+ * Exception safety: <em>basic guarantee</em>.
+ */
+void decode_binary_log(std::istream& p_binary_log, std::ostream& p_text_log);
+
+/**
+ * Reads a log file in Log::text format from \e p_text_log, and writes it
+ * to \e p_csv as CSV, with the same output as the
+ * "jewel_log_to_csv.py" script in the "tools" directory: a header line
+ * naming each field that appears in any record (in the order in which the
+ * fields first appear), followed by a line for each record. Lines are
+ * terminated by "\r\n", and fields are quoted if they contain commas,
+ * double quotes or line breaks.
+ *
+ * As with that script, leading and trailing white space is stripped from
+ * each field, and any ']' characters within the contents of a field are
+ * removed.
+ *
+ * @throws LogDecoderException if a field in \e p_text_log does not
+ * start with "[".
+ *
+ * Exception safety: <em>basic guarantee</em>.
+ */
+void convert_log_to_csv(std::istream& p_text_log, std::ostream& p_csv);
+
+}  // namespace jewel
+
+#endif  // GUARD_log_decoder_hpp_5830174926381047
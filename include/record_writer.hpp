@@ -0,0 +1,356 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GUARD_record_writer_hpp_6093317458201746
+#define GUARD_record_writer_hpp_6093317458201746
+
+/** @file
+ *
+ * @brief Facilities for writing records of Decimal numbers, integers and
+ * strings as CSV or JSON lines, without the overhead of streams.
+ *
+ * @see jewel::RecordWriter
+ * @see jewel::RecordSink
+ * @see jewel::RecordWriterException
+ */
+
+#include "capped_string.hpp"
+#include "decimal_fwd.hpp"
+#include "exception.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace jewel
+{
+
+/** @class jewel::RecordWriterException
+ *
+ * @extends jewel::Exception
+ *
+ * Exception to be thrown when a RecordWriter is used incorrectly, or
+ * when a RecordSink fails to write.
+ */
+
+/// @cond
+JEWEL_DERIVED_EXCEPTION(RecordWriterException, jewel::Exception);
+/// @endcond
+
+
+/**
+ * @brief Abstract destination for the bytes written by a RecordWriter.
+ *
+ * Derive from this to send records somewhere other than a file descriptor
+ * or memory.
+ */
+class RecordSink
+{
+public:
+    RecordSink() = default;
+    RecordSink(RecordSink const&) = delete;
+    RecordSink(RecordSink&&) = delete;
+    RecordSink& operator=(RecordSink const&) = delete;
+    RecordSink& operator=(RecordSink&&) = delete;
+    virtual ~RecordSink();
+
+    /**
+     * Writes all of the \e p_size bytes starting at \e p_data.
+     *
+     * @exception RecordWriterException should be thrown if the bytes
+     * cannot all be written.
+     */
+    virtual void write(char const* p_data, std::size_t p_size) = 0;
+};
+
+
+/**
+ * @brief RecordSink that writes to a file descriptor, e.g. of a file,
+ * pipe or socket.
+ *
+ * The file descriptor is not closed by the FileDescriptorSink.
+ */
+class FileDescriptorSink: public RecordSink
+{
+public:
+    explicit FileDescriptorSink(int p_file_descriptor);
+    virtual ~FileDescriptorSink();
+
+    /**
+     * Writes the bytes using the \e write system call, repeating it as
+     * necessary if it is interrupted or writes only some of the bytes.
+     *
+     * @exception RecordWriterException thrown if \e write fails.
+     *
+     * Exception safety: <em>basic guarantee</em>. If an exception is
+     * thrown, some of the bytes may already have been written.
+     */
+    virtual void write(char const* p_data, std::size_t p_size);
+
+private:
+    int const m_file_descriptor;
+};
+
+
+/**
+ * @brief RecordSink that appends to a string in memory.
+ */
+class MemorySink: public RecordSink
+{
+public:
+    MemorySink() = default;
+    virtual ~MemorySink();
+
+    /**
+     * Exception safety: <em>strong guarantee</em>.
+     */
+    virtual void write(char const* p_data, std::size_t p_size);
+
+    /**
+     * @returns everything written so far.
+     *
+     * Exception safety: <em>nothrow guarantee</em>.
+     */
+    std::string const& contents() const;
+
+    /**
+     * Discards everything written so far.
+     *
+     * Exception safety: <em>nothrow guarantee</em>.
+     */
+    void clear();
+
+private:
+    std::string m_contents;
+};
+
+
+/**
+ * @brief Writes records, each consisting of a sequence of fields, as CSV
+ * or as JSON lines, to a RecordSink.
+ *
+ * Each field is added to the current record using one of the overloads of
+ * append(), and the record is completed using end_record(). For example:
+ *
+ * <pre>
+ *     FileDescriptorSink sink(1);
+ *     RecordWriter writer(sink, RecordWriter::csv, field_names);
+ *     writer.append(account).append(Decimal("-12.50")).append(42);
+ *     writer.end_record();
+ * </pre>
+ *
+ * Numbers are formatted directly into an internal buffer using
+ * jewel::to_chars, with no streams or locales involved. Strings are quoted
+ * for CSV (as per RFC 4180: fields containing commas, double quotes or line
+ * breaks are enclosed in double quotes, with internal double quotes
+ * doubled) or escaped for JSON, as required. Strings are assumed to
+ * be UTF-8, and are otherwise passed through unchanged.
+ *
+ * Decimal numbers are written as their exact text, e.g. "-12.50", which is
+ * also a valid JSON number. Note that a \e char passed to append() is
+ * written as an integer; pass a string to write a character.
+ *
+ * Completed records are held in the buffer until it reaches the size passed
+ * to the constructor, and are then passed to the sink in a single call to
+ * RecordSink::write, so that there is typically one system call per many
+ * records. A record is never split between two calls to RecordSink::write.
+ * Records are also passed to the sink by flush(), and by the destructor.
+ *
+ * Exception safety: except where otherwise stated, member functions offer
+ * the <em>basic guarantee</em>. If an exception is thrown while a record
+ * is being built, the incomplete record is discarded.
+ */
+class RecordWriter
+{
+public:
+
+    /**
+     * @enum Format
+     *
+     * Determines how records are written.
+     */
+    enum Format
+    {
+        /**
+         * Comma-separated values, one record per line. If field names are
+         * passed to the constructor, they are written first, as a header
+         * line.
+         */
+        csv = 0,
+
+        /**
+         * One JSON object per line, mapping each of the field names passed
+         * to the constructor to the value of that field.
+         */
+        json_lines
+    };
+
+    /**
+     * Default size, in bytes, of the buffer of records.
+     */
+    static std::size_t const default_buffer_size = 65536;
+
+    /**
+     * @param p_sink where the records will be written. Must outlive the
+     * RecordWriter.
+     *
+     * @param p_field_names the name of each field. Required for
+     * \e json_lines; optional for \e csv. If there are any field names,
+     * every record must have exactly one field per name.
+     *
+     * @param p_buffer_size the number of bytes of records to accumulate
+     * before writing them to \e p_sink.
+     *
+     * @exception RecordWriterException thrown if \e p_format is
+     * \e json_lines and \e p_field_names is empty.
+     */
+    RecordWriter
+    (   RecordSink& p_sink,
+        Format p_format,
+        std::vector<std::string> const& p_field_names =
+            std::vector<std::string>(),
+        std::size_t p_buffer_size = default_buffer_size
+    );
+
+    RecordWriter(RecordWriter const&) = delete;
+    RecordWriter(RecordWriter&&) = delete;
+    RecordWriter& operator=(RecordWriter const&) = delete;
+    RecordWriter& operator=(RecordWriter&&) = delete;
+
+    /**
+     * Calls flush(), swallowing any exception. Call flush() explicitly if
+     * you want to be told about failure. Any incomplete record is
+     * discarded.
+     */
+    ~RecordWriter();
+
+    /// @name Append a field to the current record.
+    ///
+    /// @exception RecordWriterException thrown if field names were passed
+    /// to the constructor, and the current record already has a field for
+    /// each of them.
+    //@{
+    /**
+     */
+    RecordWriter& append(Decimal const& p_value);
+
+    /**
+     */
+    RecordWriter& append(int p_value);
+
+    /**
+     */
+    RecordWriter& append(long p_value);
+
+    /**
+     */
+    RecordWriter& append(long long p_value);
+
+    /**
+     */
+    RecordWriter& append(unsigned int p_value);
+
+    /**
+     */
+    RecordWriter& append(unsigned long p_value);
+
+    /**
+     */
+    RecordWriter& append(unsigned long long p_value);
+
+    /**
+     * Appends a null-terminated string.
+     */
+    RecordWriter& append(char const* p_string);
+
+    /**
+     * Appends the \e p_size characters starting at \e p_data.
+     */
+    RecordWriter& append(char const* p_data, std::size_t p_size);
+
+    /**
+     */
+    RecordWriter& append(std::string const& p_string);
+
+    /**
+     */
+    template <std::size_t N>
+    RecordWriter& append(CappedString<N> const& p_string);
+    //@}
+
+    /**
+     * Completes the current record, and writes the buffer to the sink
+     * if it has reached the size passed to the constructor.
+     *
+     * @exception RecordWriterException thrown if field names were passed
+     * to the constructor and the record does not have a field for each of
+     * them (in which case the record is discarded), or if the sink fails to
+     * write.
+     */
+    void end_record();
+
+    /**
+     * Writes all complete records in the buffer to the sink. Any incomplete
+     * record remains in the buffer.
+     *
+     * @exception RecordWriterException thrown if the sink fails to write.
+     * In this case the records that were in the buffer are discarded, as
+     * the sink may have written some of them.
+     */
+    void flush();
+
+private:
+
+    void begin_field();
+    void discard_record();
+    void remove_complete_records();
+    char* reserve(std::size_t p_size);
+    void append_csv_text(char const* p_data, std::size_t p_size);
+    void append_json_text(char const* p_data, std::size_t p_size);
+
+    template <typename Number>
+    RecordWriter& append_number(Number const& p_value);
+
+    RecordSink& m_sink;
+    Format const m_format;
+    std::size_t const m_buffer_size;
+    std::size_t m_num_fields;
+
+    // For json_lines, the text that precedes each field, e.g. "{\"a\":"
+    // and ",\"b\":"; for csv, empty.
+    std::vector<std::string> m_prefixes;
+
+    std::vector<char> m_buffer;
+    std::size_t m_size;
+    std::size_t m_record_start;
+    std::size_t m_field_index;
+};
+
+
+// FUNCTION TEMPLATE IMPLEMENTATIONS
+
+template <std::size_t N>
+inline
+RecordWriter&
+RecordWriter::append(CappedString<N> const& p_string)
+{
+    return append(p_string.c_str(), p_string.size());
+}
+
+
+}  // namespace jewel
+
+#endif  // GUARD_record_writer_hpp_6093317458201746
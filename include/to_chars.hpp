@@ -0,0 +1,255 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GUARD_to_chars_hpp_2765190348817236
+#define GUARD_to_chars_hpp_2765190348817236
+
+/** @file
+ *
+ * @brief Functions for writing numbers as text directly into a character
+ * buffer, without the use of streams, locales or heap allocation.
+ *
+ * Each overload of jewel::to_chars writes its value to the range
+ * [p_first, p_last), and returns a pointer one past the last character
+ * written, or a null pointer if the range is too small to hold the
+ * result (in which case the contents of the range are unspecified). No
+ * terminating null character is written.
+ *
+ * The text is the same as would be written by the stream output operator
+ * using the "C" locale, e.g. "-1234" or "-1234.50", except that floating
+ * point numbers are written with enough significant digits to be read
+ * back exactly, as by boost::lexical_cast. A buffer of
+ * jewel::max_numeric_chars characters is always large enough.
+ *
+ * Other headers provide further overloads for the types they define (e.g.
+ * jewel::CappedString and jewel::Version), so that jewel::to_chars can be
+ * used as a customization point: see JEWEL_LOG_VALUE.
+ */
+
+#include "decimal_fwd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace jewel
+{
+
+/**
+ * The greatest number of characters written by any of the overloads of
+ * to_chars in this header. This is at least 32, and enough for a long
+ * double in scientific notation: a sign, the significant digits, a
+ * point, "e", and a signed exponent of up to 4 digits. (A long double
+ * has 36 significant digits where it is IEEE quadruple precision.)
+ */
+std::size_t const max_numeric_chars =
+    (std::numeric_limits<long double>::max_digits10 + 8 > 32)?
+    std::numeric_limits<long double>::max_digits10 + 8:
+    32;
+
+/// @cond
+namespace detail
+{
+
+/**
+ * Writes the decimal digits of \e p_value backwards, ending just before
+ * \e p_end, and returns a pointer to the first digit written. There must
+ * be room for at least 20 characters before \e p_end.
+ */
+inline
+char* write_digits_backwards(char* p_end, std::uint64_t p_value)
+{
+    static char const pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    char* ret = p_end;
+    while (p_value >= 100)
+    {
+        unsigned int const pair = static_cast<unsigned int>(p_value % 100);
+        p_value /= 100;
+        *--ret = pairs[2 * pair + 1];
+        *--ret = pairs[2 * pair];
+    }
+    if (p_value >= 10)
+    {
+        unsigned int const pair = static_cast<unsigned int>(p_value);
+        *--ret = pairs[2 * pair + 1];
+        *--ret = pairs[2 * pair];
+    }
+    else
+    {
+        *--ret = static_cast<char>('0' + p_value);
+    }
+    return ret;
+}
+
+/**
+ * Writes \e p_magnitude, preceded by a minus sign if \e p_is_negative,
+ * to [p_first, p_last).
+ */
+inline
+char* integer_to_chars
+(   char* p_first,
+    char* p_last,
+    std::uint64_t p_magnitude,
+    bool p_is_negative
+)
+{
+    char digits[20];
+    char* const end = digits + sizeof(digits);
+    char const* begin = write_digits_backwards(end, p_magnitude);
+    std::ptrdiff_t const length = (end - begin) + (p_is_negative? 1: 0);
+    if (p_last - p_first < length)
+    {
+        return nullptr;
+    }
+    if (p_is_negative)
+    {
+        *p_first++ = '-';
+    }
+    while (begin != end)
+    {
+        *p_first++ = *begin++;
+    }
+    return p_first;
+}
+
+/**
+ * Writes \e p_value to [p_first, p_last), for any signed integral type.
+ */
+inline
+char* signed_to_chars(char* p_first, char* p_last, long long p_value)
+{
+    // Negating in unsigned arithmetic is well defined even for the most
+    // negative value.
+    bool const is_negative = (p_value < 0);
+    std::uint64_t const magnitude =
+    (   is_negative?
+        (0 - static_cast<std::uint64_t>(p_value)):
+        static_cast<std::uint64_t>(p_value)
+    );
+    return integer_to_chars(p_first, p_last, magnitude, is_negative);
+}
+
+}  // namespace detail
+/// @endcond
+
+
+/// @name Write integers as text.
+//@{
+/**
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+inline
+char* to_chars(char* p_first, char* p_last, int p_value)
+{
+    return detail::signed_to_chars(p_first, p_last, p_value);
+}
+
+/**
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+inline
+char* to_chars(char* p_first, char* p_last, long p_value)
+{
+    return detail::signed_to_chars(p_first, p_last, p_value);
+}
+
+/**
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+inline
+char* to_chars(char* p_first, char* p_last, long long p_value)
+{
+    return detail::signed_to_chars(p_first, p_last, p_value);
+}
+
+/**
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+inline
+char* to_chars(char* p_first, char* p_last, unsigned int p_value)
+{
+    return detail::integer_to_chars(p_first, p_last, p_value, false);
+}
+
+/**
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+inline
+char* to_chars(char* p_first, char* p_last, unsigned long p_value)
+{
+    return detail::integer_to_chars(p_first, p_last, p_value, false);
+}
+
+/**
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+inline
+char* to_chars(char* p_first, char* p_last, unsigned long long p_value)
+{
+    return detail::integer_to_chars(p_first, p_last, p_value, false);
+}
+//@}
+
+/// @name Write floating point numbers as text.
+//@{
+/**
+ * Writes \e p_value as by the stream output operator in the "C" locale,
+ * with a precision of std::numeric_limits<double>::max_digits10 (17),
+ * e.g. "0.10000000000000001" for 0.1, "1e+100" for 1e100, or "inf".
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+char* to_chars(char* p_first, char* p_last, double p_value);
+
+/**
+ * As for double, with a precision of 9.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+char* to_chars(char* p_first, char* p_last, float p_value);
+
+/**
+ * As for double, with a precision of
+ * std::numeric_limits<long double>::max_digits10.
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+char* to_chars(char* p_first, char* p_last, long double p_value);
+//@}
+
+/**
+ * Writes \e p_value as text, with a '.' as the decimal point, and without
+ * any grouping of digits. This is the same as the text written by
+ * Decimal's stream output operator using the "C" locale, e.g. "0.050" for
+ * Decimal("0.050").
+ *
+ * Exception safety: <em>nothrow guarantee</em>.
+ */
+char* to_chars(char* p_first, char* p_last, Decimal const& p_value);
+
+}  // namespace jewel
+
+#endif  // GUARD_to_chars_hpp_2765190348817236
@@ -19,6 +19,7 @@
 
 /// @file
 
+#include "to_chars.hpp"
 #include <cstddef>
 #include <ostream>
 
@@ -95,6 +96,15 @@ template <typename charT, typename traits>
 std::basic_ostream<charT, traits>&
 operator<<(std::basic_ostream<charT, traits>& p_os, Version const& p_version);
 
+/**
+ * Writes \e p_version to [p_first, p_last) as "[major].[minor].[patch]",
+ * and returns a pointer one past the last character written, or a null
+ * pointer if the range is too small. No terminating null character is
+ * written. A buffer of jewel::max_numeric_chars characters is always large
+ * enough. (See also jewel::to_chars in "to_chars.hpp".)
+ */
+char* to_chars(char* p_first, char* p_last, Version const& p_version);
+
 
 // INLINE IMPLEMENTATIONS
 
@@ -127,6 +137,31 @@ Version::patch() const
     return m_patch;
 }
 
+inline
+char*
+to_chars(char* p_first, char* p_last, Version const& p_version)
+{
+    unsigned const parts[] =
+        { p_version.major(), p_version.minor(), p_version.patch() };
+    for (unsigned i = 0; i != 3; ++i)
+    {
+        if (i != 0)
+        {
+            if (p_first == p_last)
+            {
+                return nullptr;
+            }
+            *p_first++ = '.';
+        }
+        p_first = to_chars(p_first, p_last, parts[i]);
+        if (!p_first)
+        {
+            return nullptr;
+        }
+    }
+    return p_first;
+}
+
 
 // FUNCTION TEMPLATE IMPLEMENTATION
 
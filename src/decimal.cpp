@@ -20,6 +20,8 @@
 #include "decimal_exceptions.hpp"
 #include "exception.hpp"
 #include "num_digits.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/helper_macros.hpp"
 #include <boost/numeric/conversion/cast.hpp>
 #include <algorithm>
 #include <cmath>
@@ -27,7 +29,6 @@
 #include <cctype>
 #include <limits>
 #include <numeric>
-#include <vector>
 
 using boost::numeric_cast;
 using std::accumulate;
@@ -35,8 +36,6 @@ using std::find;
 using std::numeric_limits;
 using std::max_element;
 using std::max;
-using std::pow;
-using std::vector;
 
 namespace jewel
 {
@@ -87,6 +86,188 @@ namespace
         return Converter<Target>::template convert(p_source);
     }
 
+    typedef Decimal::int_type int_type;
+
+    /*
+     * Powers of 10 that are representable as an int_type, indexed by
+     * exponent.
+     */
+    constexpr int_type powers_of_ten[] =
+    {   1LL,
+        10LL,
+        100LL,
+        1000LL,
+        10000LL,
+        100000LL,
+        1000000LL,
+        10000000LL,
+        100000000LL,
+        1000000000LL,
+        10000000000LL,
+        100000000000LL,
+        1000000000000LL,
+        10000000000000LL,
+        100000000000000LL,
+        1000000000000000LL,
+        10000000000000000LL,
+        100000000000000000LL,
+        1000000000000000000LL
+    };
+
+    size_t const num_powers_of_ten =
+        sizeof(powers_of_ten) / sizeof(powers_of_ten[0]);
+
+    static_assert
+    (   num_powers_of_ten == numeric_limits<int_type>::digits10 + 1,
+        "powers_of_ten should contain every power of 10 representable as "
+        "an int_type."
+    );
+
+    typedef Decimal::places_type places_type;
+
+    /*
+     * Where \e p_quotient and \e p_remainder are the quotient and remainder
+     * of a truncating division by a power of 10 of which \e p_half is
+     * half, returns the quotient rounded according to \e Mode. Never
+     * overflows, as the quotient is much smaller in magnitude than the
+     * largest int_type.
+     */
+    template <RoundingMode Mode>
+    inline
+    int_type rounded_quotient
+    (   int_type p_quotient,
+        int_type p_remainder,
+        int_type p_half
+    )
+    {
+        switch (Mode)
+        {
+        case round_half_up:
+            return
+                p_quotient +
+                (p_remainder >= p_half) -
+                (p_remainder <= -p_half);
+        case round_half_even:
+            {
+                bool const odd = ((p_quotient & 1) != 0);
+                return
+                    p_quotient +
+                    (p_remainder > p_half || (odd && p_remainder == p_half)) -
+                    (p_remainder < -p_half || (odd && p_remainder == -p_half));
+            }
+        case round_floor:
+            return p_quotient - (p_remainder < 0);
+        case round_ceiling:
+            return p_quotient + (p_remainder > 0);
+        case round_truncate:
+            return p_quotient;
+        }
+        JEWEL_HARD_ASSERT (false);
+        return p_quotient;
+    }
+
+    /*
+     * Rounds Decimals, starting at \e p_in, with exactly \e p_places + Shift
+     * places to \e p_places places, writing the results to \e p_out.
+     * Stops at the first Decimal with a different number of places, or
+     * after \e p_n Decimals. Returns the number of Decimals rounded.
+     *
+     * As Shift is a compile-time constant, the compiler can replace
+     * division by 10^Shift with a cheaper multiplication.
+     */
+    template <RoundingMode Mode, unsigned int Shift>
+    size_t round_run
+    (   Decimal const* p_in,
+        Decimal* p_out,
+        size_t p_n,
+        places_type p_places
+    )
+    {
+        // Where all places are removed from a Decimal with the maximum
+        // number of places, 10^Shift is not representable as an int_type,
+        // but the quotient is always zero.
+        bool const removes_all = (Shift == num_powers_of_ten);
+        int_type const divisor = powers_of_ten[removes_all? 0: Shift];
+        int_type const half =
+        (   removes_all?
+            (powers_of_ten[num_powers_of_ten - 1] * 5):
+            (divisor / 2)
+        );
+        unsigned int const source_places = p_places + Shift;
+        size_t i = 0;
+        for ( ; (i != p_n) && (p_in[i].places() == source_places); ++i)
+        {
+            int_type const intval = p_in[i].intval();
+            int_type result = intval;
+            if (Shift != 0)
+            {
+                int_type const quotient = removes_all? 0: (intval / divisor);
+                int_type const remainder =
+                    removes_all? intval: (intval % divisor);
+                result = rounded_quotient<Mode>(quotient, remainder, half);
+            }
+            p_out[i] = Decimal(result, p_places);
+        }
+        return i;
+    }
+
+    typedef size_t (*RunRounder)
+    (   Decimal const*,
+        Decimal*,
+        size_t,
+        places_type
+    );
+
+    size_t const num_shifts = num_powers_of_ten + 1;
+
+    /*
+     * Rounding function for each number of places to be removed, for
+     * rounding mode \e Mode.
+     */
+    template <RoundingMode Mode>
+    struct RunRounders
+    {
+        static RunRounder const table[num_shifts];
+    };
+
+    template <RoundingMode Mode>
+    RunRounder const RunRounders<Mode>::table[num_shifts] =
+    {   &round_run<Mode, 0>,
+        &round_run<Mode, 1>,
+        &round_run<Mode, 2>,
+        &round_run<Mode, 3>,
+        &round_run<Mode, 4>,
+        &round_run<Mode, 5>,
+        &round_run<Mode, 6>,
+        &round_run<Mode, 7>,
+        &round_run<Mode, 8>,
+        &round_run<Mode, 9>,
+        &round_run<Mode, 10>,
+        &round_run<Mode, 11>,
+        &round_run<Mode, 12>,
+        &round_run<Mode, 13>,
+        &round_run<Mode, 14>,
+        &round_run<Mode, 15>,
+        &round_run<Mode, 16>,
+        &round_run<Mode, 17>,
+        &round_run<Mode, 18>,
+        &round_run<Mode, 19>
+    };
+
+    RunRounder const* run_rounders(RoundingMode p_mode)
+    {
+        switch (p_mode)
+        {
+        case round_half_up: return RunRounders<round_half_up>::table;
+        case round_half_even: return RunRounders<round_half_even>::table;
+        case round_floor: return RunRounders<round_floor>::table;
+        case round_ceiling: return RunRounders<round_ceiling>::table;
+        case round_truncate: return RunRounders<round_truncate>::table;
+        }
+        JEWEL_HARD_ASSERT (false);
+        return 0;
+    }
+
 }  // end anonymous namespace
 
 
@@ -104,16 +285,22 @@ namespace
 
 // initialize static data members
 
-size_t const
-Decimal::s_max_places = NumDigits::num_digits
-(   numeric_limits<int_type>::min()
-);
+size_t constexpr
+Decimal::s_max_places;
 
 Decimal const
-Decimal::s_maximum = Decimal(numeric_limits<int_type>::max(), 0);
+Decimal::s_maximum
+(   numeric_limits<int_type>::max(),
+    0,
+    UncheckedTag()
+);
 
 Decimal const
-Decimal::s_minimum = Decimal(numeric_limits<int_type>::min(), 0);
+Decimal::s_minimum
+(   numeric_limits<int_type>::min(),
+    0,
+    UncheckedTag()
+);
 
 
 // static member functions
@@ -123,13 +310,14 @@ void Decimal::co_normalize(Decimal& x, Decimal& y)
 {
     if (x.m_places == y.m_places)
     {
-        // do nothing
+        return;
     }
-    else if (x.m_places < y.m_places)
+    JEWEL_DETAIL_DECIMAL_STATS_ADD(co_normalizations, 1);
+    if (x.m_places < y.m_places)
     {
         if (x.rescale(y.m_places) != 0)
         {
-            JEWEL_THROW
+            JEWEL_DETAIL_DECIMAL_THROW
             (   DecimalRangeException,
                 "Unsafe attempt to set fractional precision in course "
                 "of co-normalization attempt."
@@ -141,7 +329,7 @@ void Decimal::co_normalize(Decimal& x, Decimal& y)
         JEWEL_ASSERT (y.m_places < x.m_places);
         if (y.rescale(x.m_places) != 0)
         {
-            JEWEL_THROW
+            JEWEL_DETAIL_DECIMAL_THROW
             (   DecimalRangeException,
                 "Unsafe attempt to set fractional precision in course "
                 "of co-normalization attempt."
@@ -170,7 +358,7 @@ Decimal::Decimal(int_type p_intval, places_type p_places):
         // other valid value) here, since the Decimal instance is not going
         // to be created anyway - nothing will be able to refer to it after
         // this exception is thrown.
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalRangeException,
             "Attempt to construct Decimal with precision greater"
             " than maximum precision."
@@ -181,13 +369,24 @@ Decimal::Decimal(int_type p_intval, places_type p_places):
 void
 Decimal::rationalize(places_type min_places)
 {
-    JEWEL_ASSERT (s_base > 0);
-    JEWEL_ASSERT (!remainder_is_unsafe(m_intval, s_base));
-    while ((m_places > min_places) && (m_intval % s_base == 0))
+    if (m_places <= min_places)
+    {
+        return;
+    }
+    // Dividing by a constant lets the compiler test divisibility by
+    // multiplying by its modular inverse rather than dividing, which is
+    // cheaper than stripping several places at a time (and keeps this
+    // small enough to be inlined).
+    JEWEL_ASSERT (s_base == 10);
+    if (m_intval == 0)
+    {
+        m_places = min_places;
+        return;
+    }
+    while ((m_places > min_places) && (m_intval % 10 == 0))
     {
-        JEWEL_ASSERT (!division_is_unsafe(m_intval, s_base));
-        m_intval /= s_base;
-        JEWEL_ASSERT (m_places > 0);
+        JEWEL_DETAIL_DECIMAL_STATS_ADD(rationalize_iterations, 1);
+        m_intval /= 10;
         --m_places;
     }
     return;
@@ -204,6 +403,7 @@ int Decimal::rescale(places_type p_places)
     {
         return 0;
     }
+    JEWEL_DETAIL_DECIMAL_STATS_ADD(rescales, 1);
 
     // remember sign
     bool const is_positive = (m_intval > 0);
@@ -221,71 +421,71 @@ int Decimal::rescale(places_type p_places)
             return 1;
         }
         JEWEL_ASSERT (p_places <= s_max_places);
-        // This should never cause overflow, as p_places is never greater
-        // than s_max_places, and s_base raised to a number equal to or
-        // greater than p_places will always be less than
-        // numeric_limits<int_type>::max(), given that s_max_places is
-        // equal to the number of digits in numeric_limits<int_type>::min().
-        JEWEL_ASSERT (!subtraction_is_unsafe(p_places, m_places));
-        int_type multiplier = JEWEL_NUMERIC_CAST<int_type>
-        (   pow(s_base, p_places - m_places)
-        );
-
-        if (multiplication_is_unsafe(m_intval, multiplier))
+        unsigned int const shift = p_places - m_places;
+        if (shift >= num_powers_of_ten)
         {
-            JEWEL_ASSERT (m_places == DEBUGVARIABLE_orig_places);
-            JEWEL_ASSERT (m_intval == DEBUGVARIABLE_orig_intval);
-            return 1;
-         }
-        m_intval *= multiplier;
+            // Only zero can be scaled up this far.
+            if (m_intval != 0)
+            {
+                JEWEL_ASSERT (m_places == DEBUGVARIABLE_orig_places);
+                JEWEL_ASSERT (m_intval == DEBUGVARIABLE_orig_intval);
+                return 1;
+            }
+        }
+        else
+        {
+            int_type const multiplier = powers_of_ten[shift];
+            if (multiplication_is_unsafe(m_intval, multiplier))
+            {
+                JEWEL_ASSERT (m_places == DEBUGVARIABLE_orig_places);
+                JEWEL_ASSERT (m_intval == DEBUGVARIABLE_orig_intval);
+                return 1;
+            }
+            m_intval *= multiplier;
+        }
     }
     else
     {
         JEWEL_ASSERT (p_places < m_places);
-
-        // truncate all but one of the required places
-        JEWEL_ASSERT (m_places > 0);
-        for (unsigned int j = m_places - 1; j != p_places; --j)
+        unsigned int const shift = m_places - p_places;
+        JEWEL_ASSERT (shift > 0);
+
+        // Remove all the places with a single division, and round
+        // according to what has been removed.
+        JEWEL_ASSERT (shift <= num_powers_of_ten);
+        int_type quotient = 0;
+        int_type remainder = m_intval;
+        if (shift < num_powers_of_ten)
         {
-            JEWEL_ASSERT (!division_is_unsafe(m_intval, s_base));
-            m_intval /= s_base;
+            int_type const divisor = powers_of_ten[shift];
+            JEWEL_ASSERT (!division_is_unsafe(m_intval, divisor));
+            quotient = m_intval / divisor;
+            remainder = m_intval % divisor;
         }
-
-        // with one more place still to eliminate, we calculate
-        // whether rounding is required
-        JEWEL_ASSERT (!remainder_is_unsafe(m_intval, s_base));
-        bool remainder =
-        (   std::abs(m_intval % s_base) >=
-            s_rounding_threshold
-        );
-
-        // now remove the remaining place
-        JEWEL_ASSERT (!division_is_unsafe(m_intval, s_base));
-        JEWEL_ASSERT (s_base > 1);
-        m_intval /= s_base;
-        JEWEL_ASSERT (m_intval < numeric_limits<int_type>::max());
-        JEWEL_ASSERT (m_intval > numeric_limits<int_type>::min());
-
-        // and add rounding if required
-        if (remainder)
+        int_type const rounding_threshold =
+            s_rounding_threshold * powers_of_ten[shift - 1];
+        JEWEL_ASSERT (quotient < numeric_limits<int_type>::max());
+        JEWEL_ASSERT (quotient > numeric_limits<int_type>::min());
+        if (is_positive)
         {
-            if (is_positive)
+            if (remainder >= rounding_threshold)
             {
                 JEWEL_ASSERT
-                (   !addition_is_unsafe(m_intval, static_cast<int_type>(1))
+                (   !addition_is_unsafe(quotient, static_cast<int_type>(1))
                 );
-                ++m_intval;
-            }
-            else
-            {
-                JEWEL_ASSERT (is_negative);
-                JEWEL_ASSERT (!is_zero);
-                JEWEL_ASSERT
-                (   !subtraction_is_unsafe(m_intval, static_cast<int_type>(1))
-                );
-                --m_intval;
+                ++quotient;
             }
         }
+        else if (remainder <= -rounding_threshold)
+        {
+            JEWEL_ASSERT (is_negative);
+            JEWEL_ASSERT (!is_zero);
+            JEWEL_ASSERT
+            (   !subtraction_is_unsafe(quotient, static_cast<int_type>(1))
+            );
+            --quotient;
+        }
+        m_intval = quotient;
     }
     m_places = p_places;
     return 0;
@@ -294,39 +494,93 @@ int Decimal::rescale(places_type p_places)
 
 Decimal::int_type
 Decimal::implicit_divisor() const
-{   
-    static bool calculated_already = false;
-    static vector<int_type> divisor_lookup(1, 1);
-    while (!calculated_already)
-    {
-        while (divisor_lookup.size() != s_max_places)
-        {
-            JEWEL_ASSERT (!divisor_lookup.empty());
-            JEWEL_ASSERT
-            (   !multiplication_is_unsafe(divisor_lookup.back(), s_base)
-            );
-            divisor_lookup.push_back(divisor_lookup.back() * s_base);
-        }
-        calculated_already = true;
-    }
-    JEWEL_ASSERT (m_places < divisor_lookup.size());
-    return divisor_lookup[m_places];
+{
+    JEWEL_ASSERT (m_places < num_powers_of_ten);
+    return powers_of_ten[m_places];
 }
 
 
 
 // operators
 
+Decimal& Decimal::mul(int_type n)
+{
+    if (multiplication_is_unsafe(m_intval, n))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalMultiplicationException,
+            "Unsafe multiplication."
+        );
+    }
+    m_intval *= n;
+    return *this;
+}
+
+Decimal& Decimal::div(int_type n)
+{
+    if (n == 0)
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDivisionByZeroException,
+            "Attempted division by zero."
+        );
+    }
+    if (division_is_unsafe(m_intval, n))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDivisionException,
+            "Unsafe division."
+        );
+    }
+    int_type quotient = m_intval / n;
+    int_type const remainder = m_intval % n;
+
+    // Round half away from zero, comparing magnitudes in unsigned
+    // arithmetic, which is safe even for the smallest int_type.
+    typedef unsigned long long uint_type;
+    uint_type const abs_remainder =
+    (   (remainder < 0)?
+        (0 - static_cast<uint_type>(remainder)):
+        static_cast<uint_type>(remainder)
+    );
+    uint_type const abs_n =
+        (n < 0)? (0 - static_cast<uint_type>(n)): static_cast<uint_type>(n);
+    if (abs_remainder != 0 && abs_n - abs_remainder <= abs_remainder)
+    {
+        // As |n| is at least 2, this can't overflow.
+        JEWEL_ASSERT (abs_n >= 2);
+        quotient += (((m_intval < 0) != (n < 0))? -1: 1);
+    }
+    m_intval = quotient;
+    return *this;
+}
+
+Decimal& Decimal::add_units(int_type n)
+{
+    if (addition_is_unsafe(m_intval, n))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalAdditionException,
+            "Unsafe addition."
+        );
+    }
+    m_intval += n;
+    return *this;
+}
+
 Decimal const& Decimal::operator++()
 {
     #ifndef NDEBUG
         places_type const benchmark_places = m_places;
         Decimal const orig = *this;
     #endif
-    if (addition_is_unsafe(m_intval, implicit_divisor()))
+    if
+    (   (m_places >= num_powers_of_ten) ||
+        addition_is_unsafe(m_intval, implicit_divisor())
+    )
     {
         JEWEL_ASSERT (*this == orig);
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalIncrementationException,
             "Incrementation may cause overflow."
         );
@@ -349,10 +603,13 @@ Decimal const& Decimal::operator--()
         places_type const benchmark_places = m_places;
         Decimal const orig = *this;
     #endif
-    if (subtraction_is_unsafe(m_intval, implicit_divisor()))
+    if
+    (   (m_places >= num_powers_of_ten) ||
+        subtraction_is_unsafe(m_intval, implicit_divisor())
+    )
     {
         JEWEL_ASSERT (*this == orig);
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalDecrementationException,
             "Decrementation may cause "
             "overflow."
@@ -370,7 +627,8 @@ Decimal Decimal::operator--(int)
     return ret;
 }
 
-Decimal& Decimal::operator+=(Decimal rhs)
+JEWEL_DETAIL_NOINLINE
+Decimal& Decimal::add_general(Decimal rhs)
 {
     #ifndef NDEBUG
         places_type const benchmark_places = max(m_places, rhs.m_places);
@@ -380,7 +638,10 @@ Decimal& Decimal::operator+=(Decimal rhs)
     if (addition_is_unsafe(m_intval, rhs.m_intval))
     {
         *this = orig;
-        JEWEL_THROW(DecimalAdditionException, "Addition may cause overflow.");
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalAdditionException,
+            "Addition may cause overflow."
+        );
     }
     m_intval += rhs.m_intval;
     JEWEL_ASSERT (m_places >= benchmark_places);
@@ -389,7 +650,8 @@ Decimal& Decimal::operator+=(Decimal rhs)
 
 
 
-Decimal& Decimal::operator-=(Decimal rhs)
+JEWEL_DETAIL_NOINLINE
+Decimal& Decimal::subtract_general(Decimal rhs)
 {
     #ifndef NDEBUG
         places_type const benchmark_places = max(m_places, rhs.m_places);
@@ -399,7 +661,7 @@ Decimal& Decimal::operator-=(Decimal rhs)
     if (subtraction_is_unsafe(m_intval, rhs.m_intval))
     {
         *this = orig;
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalSubtractionException,
             "Subtraction may cause overflow."
         );
@@ -416,13 +678,17 @@ Decimal& Decimal::operator*=(Decimal rhs)
     rationalize();
     rhs.rationalize();
 
-    // Rule out problematic smallest Decimal
+    // Rule out problematic smallest underlying integer (as in the smallest
+    // Decimal), which can't be made absolute.
     JEWEL_ASSERT (minimum() == Decimal(numeric_limits<int_type>::min(), 0));
     JEWEL_ASSERT (maximum() == Decimal(numeric_limits<int_type>::max(), 0));
-    if (*this == minimum() || rhs == minimum())
+    if
+    (   m_intval == numeric_limits<int_type>::min() ||
+        rhs.m_intval == numeric_limits<int_type>::min()
+    )
     {
         JEWEL_ASSERT (*this == orig);
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalMultiplicationException,
             "Cannot multiply smallest possible "
             "Decimal safely."
@@ -482,7 +748,10 @@ Decimal& Decimal::operator*=(Decimal rhs)
     }
 
     *this = orig;
-    JEWEL_THROW(DecimalMultiplicationException, "Unsafe multiplication.");
+    JEWEL_DETAIL_DECIMAL_THROW
+    (   DecimalMultiplicationException,
+        "Unsafe multiplication."
+    );
     JEWEL_HARD_ASSERT (false);  // Execution should never reach here.
     return *this;    // Silence compiler re. return from non-void function.
 
@@ -500,7 +769,10 @@ Decimal& Decimal::operator/=(Decimal rhs)
     if (rhs.m_intval == 0)
     {
         JEWEL_ASSERT (*this == orig);
-        JEWEL_THROW(DecimalDivisionByZeroException, "Division by zero.");
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDivisionByZeroException,
+            "Division by zero."
+        );
     }
     
     // To prevent complications
@@ -508,7 +780,7 @@ Decimal& Decimal::operator/=(Decimal rhs)
       rhs.m_intval == numeric_limits<int_type>::min() )
     {
         JEWEL_ASSERT (*this == orig);
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalDivisionException,
             "Smallest possible Decimal cannot "
             "feature in division operation."
@@ -518,7 +790,7 @@ Decimal& Decimal::operator/=(Decimal rhs)
     if (NumDigits::num_digits(rhs.m_intval) == maximum_precision())
     {
         JEWEL_ASSERT (*this == orig);
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalDivisionException,
             "Dividend has a number of significant"
              "digits that is greater than or equal to the return value of "
@@ -551,7 +823,10 @@ Decimal& Decimal::operator/=(Decimal rhs)
     {
         // We can't rescale high enough to proceed, so reset and throw
         *this = orig;
-        JEWEL_THROW(DecimalDivisionException, "Unsafe division.");
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDivisionException,
+            "Unsafe division."
+        );
     }
 
     // Proceed with basic division algorithm
@@ -568,6 +843,7 @@ Decimal& Decimal::operator/=(Decimal rhs)
     // Deal with any remainder using "long division"
     while (remainder != 0 && rescale(m_places + 1) == 0)
     {
+        JEWEL_DETAIL_DECIMAL_STATS_ADD(division_iterations, 1);
         JEWEL_ASSERT (!multiplication_is_unsafe(remainder, s_base));
 
         /*
@@ -642,7 +918,10 @@ Decimal& Decimal::operator/=(Decimal rhs)
         if (addition_is_unsafe(m_intval, JEWEL_NUMERIC_CAST<int_type>(1)))
         {
             *this = orig;
-            JEWEL_THROW(DecimalDivisionException, "Unsafe division.");
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalDivisionException,
+                "Unsafe division."
+            );
         }
         // Do the rounding, it's safe
         ++m_intval;
@@ -659,7 +938,8 @@ Decimal& Decimal::operator/=(Decimal rhs)
 }
 
 
-bool Decimal::operator<(Decimal rhs) const
+JEWEL_DETAIL_NOINLINE
+bool Decimal::is_less_general(Decimal rhs) const
 {   
     Decimal lhs = *this;
     lhs.rationalize();
@@ -668,6 +948,7 @@ bool Decimal::operator<(Decimal rhs) const
     {
         return lhs.m_intval < rhs.m_intval;
     }
+    JEWEL_DETAIL_DECIMAL_STATS_ADD(co_normalizations, 1);
     bool const left_is_longer = (lhs.m_places > rhs.m_places);
     Decimal const *const shorter = (left_is_longer? &rhs: &lhs);
     Decimal const *const longer = (left_is_longer? &lhs: &rhs);
@@ -695,7 +976,8 @@ bool Decimal::operator<(Decimal rhs) const
 }
 
 
-bool Decimal::operator==(Decimal rhs) const
+JEWEL_DETAIL_NOINLINE
+bool Decimal::is_equal_general(Decimal rhs) const
 {
     Decimal temp_lhs = *this;
     temp_lhs.rationalize();
@@ -712,7 +994,7 @@ Decimal round(Decimal const& x, Decimal::places_type decimal_places)
     Decimal ret = x;
     if (ret.rescale(decimal_places) != 0)
     {   
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalRangeException,
             "Decimal number cannot safely be rounded to "
             "this number of places."
@@ -721,13 +1003,63 @@ Decimal round(Decimal const& x, Decimal::places_type decimal_places)
     return ret;
 }
 
+Decimal round
+(   Decimal const& x,
+    Decimal::places_type decimal_places,
+    RoundingMode mode
+)
+{
+    Decimal ret;
+    round_n(&x, &ret, 1, decimal_places, mode);
+    return ret;
+}
+
+void round_n
+(   Decimal const* in,
+    Decimal* out,
+    size_t n,
+    Decimal::places_type decimal_places,
+    RoundingMode mode
+)
+{
+    if (decimal_places > Decimal::maximum_precision())
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Cannot round Decimal to more than maximum precision."
+        );
+    }
+    RunRounder const* const rounders = run_rounders(mode);
+    size_t i = 0;
+    while (i != n)
+    {
+        Decimal::places_type const source_places = in[i].places();
+        if (source_places < decimal_places)
+        {
+            // Adding places involves no rounding.
+            out[i] = round(in[i], decimal_places);
+            ++i;
+        }
+        else
+        {
+            unsigned int const shift = source_places - decimal_places;
+            JEWEL_ASSERT (shift < num_shifts);
+            size_t const num_rounded =
+                rounders[shift](in + i, out + i, n - i, decimal_places);
+            JEWEL_ASSERT (num_rounded > 0);
+            i += num_rounded;
+        }
+    }
+    return;
+}
+
 
 Decimal operator-(Decimal const& d)
 {
     typedef Decimal::int_type int_type;
     if (d.m_intval == numeric_limits<int_type>::min())
     {
-        JEWEL_THROW
+        JEWEL_DETAIL_DECIMAL_THROW
         (   DecimalUnaryMinusException,
             "Unsafe arithmetic operation (unary minus)."
         );
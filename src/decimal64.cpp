@@ -0,0 +1,269 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal64.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+using std::numeric_limits;
+using std::size_t;
+using std::uint64_t;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+    typedef Decimal::places_type places_type;
+
+    static_assert
+    (   sizeof(int_type) <= sizeof(uint64_t),
+        "decimal64 conversion assumes Decimal::int_type is at most 64 bits."
+    );
+
+    // Parameters of the decimal64 format
+    int const exponent_bias = 398;
+    int const max_biased_exponent = 767;
+    uint64_t const max_coefficient = 9999999999999999ULL;  // 16 digits
+    uint64_t const sign_mask = 1ULL << 63;
+    uint64_t const steering_mask = 3ULL << 61;   // "11" selects large form
+    uint64_t const special_mask = 0xFULL << 59;  // "1111" infinity or NaN
+    uint64_t const small_coefficient_limit = 1ULL << 53;
+    uint64_t const small_coefficient_mask = small_coefficient_limit - 1;
+    uint64_t const large_coefficient_mask = (1ULL << 51) - 1;
+    uint64_t const large_coefficient_prefix = 4ULL << 51;  // implicit "100"
+
+    uint64_t const powers_of_ten[] =
+    {   1ULL,
+        10ULL,
+        100ULL,
+        1000ULL,
+        10000ULL,
+        100000ULL,
+        1000000ULL,
+        10000000ULL,
+        100000000ULL,
+        1000000000ULL,
+        10000000000ULL,
+        100000000000ULL,
+        1000000000000ULL,
+        10000000000000ULL,
+        100000000000000ULL,
+        1000000000000000ULL,
+        10000000000000000ULL,
+        100000000000000000ULL,
+        1000000000000000000ULL,
+        10000000000000000000ULL
+    };
+
+    /*
+     * Encode a Decimal with underlying integer \e p_intval and \e p_places
+     * decimal places. Returns false, leaving \e p_bits unchanged, if this
+     * can't be done exactly.
+     */
+    inline
+    bool encode(int_type p_intval, places_type p_places, uint64_t& p_bits)
+    {
+        uint64_t const sign = (p_intval < 0)? sign_mask: 0;
+
+        // Negate in unsigned arithmetic, which is safe even for the
+        // smallest int_type.
+        uint64_t coefficient =
+        (   sign?
+            (0 - static_cast<uint64_t>(p_intval)):
+            static_cast<uint64_t>(p_intval)
+        );
+        int exponent = -static_cast<int>(p_places);
+        while (coefficient > max_coefficient)
+        {
+            // Only reached with more than 16 digits; drop trailing zeroes
+            // if we can do so without losing information.
+            if (coefficient % 10 != 0)
+            {
+                return false;
+            }
+            coefficient /= 10;
+            ++exponent;
+        }
+        uint64_t const biased =
+            static_cast<uint64_t>(exponent + exponent_bias);
+        JEWEL_ASSERT (exponent + exponent_bias >= 0);
+        JEWEL_ASSERT (exponent + exponent_bias <= max_biased_exponent);
+        if (coefficient < small_coefficient_limit)
+        {
+            p_bits = sign | (biased << 53) | coefficient;
+        }
+        else
+        {
+            p_bits =
+                sign |
+                steering_mask |
+                (biased << 51) |
+                (coefficient & large_coefficient_mask);
+        }
+        return true;
+    }
+
+    /*
+     * Decode \e p_bits into an underlying integer and number of places.
+     * Returns false, leaving \e p_intval and \e p_places unchanged, if this
+     * can't be done exactly.
+     */
+    inline
+    bool decode(uint64_t p_bits, int_type& p_intval, places_type& p_places)
+    {
+        uint64_t coefficient;
+        int exponent;
+        if ((p_bits & steering_mask) != steering_mask)
+        {
+            coefficient = p_bits & small_coefficient_mask;
+            exponent = static_cast<int>((p_bits >> 53) & 0x3FF);
+        }
+        else if ((p_bits & special_mask) == special_mask)
+        {
+            return false;  // infinity or NaN
+        }
+        else
+        {
+            coefficient =
+                large_coefficient_prefix | (p_bits & large_coefficient_mask);
+            exponent = static_cast<int>((p_bits >> 51) & 0x3FF);
+            if (coefficient > max_coefficient)
+            {
+                coefficient = 0;  // non-canonical
+            }
+        }
+        if (exponent > max_biased_exponent)
+        {
+            return false;
+        }
+        exponent -= exponent_bias;
+        int const max_places = Decimal::maximum_precision();
+        if (coefficient == 0)
+        {
+            p_intval = 0;
+            p_places = static_cast<places_type>
+            (   (exponent >= 0)? 0:
+                (-exponent > max_places)? max_places:
+                -exponent
+            );
+            return true;
+        }
+        if (exponent > 0)
+        {
+            uint64_t const limit =
+            (   static_cast<uint64_t>(numeric_limits<int_type>::max()) +
+                ((p_bits & sign_mask)? 1: 0)
+            );
+            if
+            (   (exponent >= max_places) ||
+                (coefficient > limit / powers_of_ten[exponent])
+            )
+            {
+                return false;
+            }
+            coefficient *= powers_of_ten[exponent];
+            exponent = 0;
+        }
+        while (-exponent > max_places)
+        {
+            if (coefficient % 10 != 0)
+            {
+                return false;
+            }
+            coefficient /= 10;
+            ++exponent;
+        }
+        JEWEL_ASSERT (coefficient <= max_coefficient || exponent == 0);
+        p_intval =
+        (   (p_bits & sign_mask)?
+            static_cast<int_type>(0 - coefficient):
+            static_cast<int_type>(coefficient)
+        );
+        p_places = static_cast<places_type>(-exponent);
+        return true;
+    }
+
+}  // end anonymous namespace
+
+
+uint64_t
+to_decimal64(Decimal const& x)
+{
+    uint64_t ret = 0;
+    if (!encode(x.intval(), x.places(), ret))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Decimal cannot be represented exactly as a decimal64."
+        );
+    }
+    return ret;
+}
+
+Decimal
+from_decimal64(uint64_t p_bits)
+{
+    int_type intval = 0;
+    places_type places = 0;
+    if (!decode(p_bits, intval, places))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "decimal64 cannot be represented exactly as a Decimal."
+        );
+    }
+    return Decimal(intval, places);
+}
+
+size_t
+to_decimal64(Decimal const* in, uint64_t* out, size_t n)
+{
+    for (size_t i = 0; i != n; ++i)
+    {
+        if (!encode(in[i].intval(), in[i].places(), out[i]))
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+size_t
+from_decimal64(uint64_t const* in, Decimal* out, size_t n)
+{
+    for (size_t i = 0; i != n; ++i)
+    {
+        int_type intval;
+        places_type places;
+        if (!decode(in[i], intval, places))
+        {
+            return i;
+        }
+        JEWEL_ASSERT (places <= Decimal::maximum_precision());
+        out[i] = Decimal(intval, places);
+    }
+    return n;
+}
+
+}  // namespace jewel
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal_allocation.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/int128.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using jewel::detail::divide_step;
+using jewel::detail::uint128_t;
+using std::nth_element;
+using std::numeric_limits;
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+    typedef Decimal::places_type places_type;
+
+    uint64_t const powers_of_ten[] =
+    {   1ULL,
+        10ULL,
+        100ULL,
+        1000ULL,
+        10000ULL,
+        100000ULL,
+        1000000ULL,
+        10000000ULL,
+        100000000ULL,
+        1000000000ULL,
+        10000000000ULL,
+        100000000000ULL,
+        1000000000000ULL,
+        10000000000000ULL,
+        100000000000000ULL,
+        1000000000000000ULL,
+        10000000000000000ULL,
+        100000000000000000ULL,
+        1000000000000000000ULL,
+        10000000000000000000ULL
+    };
+
+    // Negate in unsigned arithmetic, which is safe even for the smallest
+    // int_type.
+    inline
+    uint64_t magnitude(int_type x)
+    {
+        return
+        (   (x < 0)?
+            (0 - static_cast<uint64_t>(x)):
+            static_cast<uint64_t>(x)
+        );
+    }
+
+    /*
+     * Writes to \e p_units the magnitude of \e p_total in units of
+     * 10^-p_places. Returns false if this can't be done exactly, or if
+     * the result wouldn't fit in an int_type with the sign of \e p_total.
+     */
+    bool total_units
+    (   Decimal const& p_total,
+        places_type p_places,
+        uint64_t& p_units
+    )
+    {
+        uint64_t units = magnitude(p_total.intval());
+        if (p_total.places() > p_places)
+        {
+            uint64_t const divisor =
+                powers_of_ten[p_total.places() - p_places];
+            if (units % divisor != 0)
+            {
+                return false;
+            }
+            units /= divisor;
+        }
+        else
+        {
+            uint128_t const scaled =
+                static_cast<uint128_t>(units) *
+                powers_of_ten[p_places - p_total.places()];
+            uint64_t const limit =
+                static_cast<uint64_t>(numeric_limits<int_type>::max()) +
+                ((p_total.intval() < 0)? 1: 0);
+            if (scaled > limit)
+            {
+                return false;
+            }
+            units = static_cast<uint64_t>(scaled);
+        }
+        p_units = units;
+        return true;
+    }
+
+    /*
+     * @returns \e p_weight as an integer in units of 10^-p_places, which
+     * must be no less than its places().
+     */
+    inline
+    uint128_t scaled_weight(Decimal const& p_weight, places_type p_places)
+    {
+        JEWEL_ASSERT (p_weight.intval() >= 0);
+        JEWEL_ASSERT (p_places >= p_weight.places());
+        return
+            static_cast<uint128_t>(p_weight.intval()) *
+            powers_of_ten[p_places - p_weight.places()];
+    }
+
+    /*
+     * The part of the product of the total and a weight that is lost when
+     * their quotient by the total weight is rounded towards zero, together
+     * with the position of that weight.
+     */
+    struct Remainder
+    {
+        uint128_t value;
+        size_t index;
+    };
+
+    // Orders Remainders so that those due an extra unit come first.
+    inline
+    bool precedes(Remainder const& lhs, Remainder const& rhs)
+    {
+        return
+        (   (lhs.value > rhs.value) ||
+            ((lhs.value == rhs.value) && (lhs.index < rhs.index))
+        );
+    }
+
+}  // end anonymous namespace
+
+
+void allocate
+(   Decimal const& total,
+    Decimal const* weights,
+    size_t n,
+    Decimal::places_type places,
+    Decimal* out
+)
+{
+    if (places > Decimal::maximum_precision())
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Cannot allocate with more than maximum precision."
+        );
+    }
+    uint64_t units = 0;
+    if (!total_units(total, places, units))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Total cannot be represented exactly with this number of places."
+        );
+    }
+
+    // Express the weights as integers with a common number of places, and
+    // sum them. The sum of fewer than 2^64 64-bit integers can't overflow
+    // 128 bits.
+    places_type weight_places = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        if (weights[i].intval() < 0)
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalDomainException,
+                "Negative weight."
+            );
+        }
+        weight_places = std::max(weight_places, weights[i].places());
+    }
+    uint128_t total_weight = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint128_t const weight = scaled_weight(weights[i], weight_places);
+        if (weight > numeric_limits<uint64_t>::max())
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalRangeException,
+                "Weights cannot be expressed as 64-bit integers with a "
+                "common number of places."
+            );
+        }
+        total_weight += weight;
+    }
+    if (total_weight == 0)
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDivisionByZeroException,
+            "Weights sum to zero."
+        );
+    }
+
+    // Nothing can throw after this allocation, so the strong guarantee
+    // is upheld.
+    vector<Remainder> remainders(n);
+
+    // Give each part its share rounded towards zero. As each share is no
+    // greater than the total, it fits in 64 bits, which permits a cheaper
+    // division where the total weight also does.
+    bool const is_negative = (total.intval() < 0);
+    bool const narrow = (total_weight <= numeric_limits<uint64_t>::max());
+    uint64_t allocated = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint128_t const product =
+            units * scaled_weight(weights[i], weight_places);
+        uint64_t share = 0;
+        if (narrow)
+        {
+            uint64_t remainder = 0;
+            share = divide_step
+            (   product,
+                static_cast<uint64_t>(total_weight),
+                remainder
+            );
+            remainders[i].value = remainder;
+        }
+        else
+        {
+            share = static_cast<uint64_t>(product / total_weight);
+            remainders[i].value = product % total_weight;
+        }
+        remainders[i].index = i;
+        allocated += share;
+        out[i] = Decimal
+        (   is_negative?
+                static_cast<int_type>(0 - share):
+                static_cast<int_type>(share),
+            places
+        );
+    }
+
+    // Fewer than n units remain, as each share was reduced by less than one.
+    JEWEL_ASSERT (allocated <= units);
+    uint64_t const leftover = units - allocated;
+    JEWEL_ASSERT (leftover < n || leftover == 0);
+    if (leftover == 0)
+    {
+        return;
+    }
+    Remainder* const first = &remainders[0];
+    Remainder* const last = first + n;
+    nth_element(first, first + leftover - 1, last, precedes);
+    int_type const unit = is_negative? -1: 1;
+    for (Remainder const* it = first; it != first + leftover; ++it)
+    {
+        Decimal& part = out[it->index];
+        part = Decimal(part.intval() + unit, places);
+    }
+    return;
+}
+
+}  // namespace jewel
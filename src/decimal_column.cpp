@@ -0,0 +1,549 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_column.hpp"
+#include "assert.hpp"
+#include "checked_arithmetic.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "on_windows.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifndef JEWEL_ON_WINDOWS
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+using std::ifstream;
+using std::ios;
+using std::max;
+using std::memcmp;
+using std::memcpy;
+using std::numeric_limits;
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+    typedef Decimal::places_type places_type;
+    typedef detail::DecimalColumnHeader Header;
+    typedef detail::DecimalColumnBlockInfo BlockInfo;
+
+    char const magic[8] = { 'J', 'W', 'L', 'D', 'C', 'O', 'L', '\0' };
+    uint32_t const byte_order_mark = 0x01020304;
+    uint32_t const current_version = 1;
+
+    static_assert
+    (   sizeof(int_type) == sizeof(std::int64_t),
+        "Decimal column format assumes Decimal::int_type is 64 bits."
+    );
+    static_assert
+    (   sizeof(Header) % sizeof(int_type) == 0,
+        "Header size must preserve alignment of mantissa arrays."
+    );
+
+    /*
+     * Represents an underlying integer at some scale, which may have
+     * overflowed the range of int_type in one direction or the other.
+     */
+    struct ScaledIntval
+    {
+        int overflow;  // -1 if below range, 1 if above range, otherwise 0
+        int_type value;
+    };
+
+    /*
+     * Express \e p_x as an underlying integer at \e p_places decimal
+     * places, rounding towards negative infinity if \e p_round_up is
+     * false, or towards positive infinity if it is true.
+     */
+    ScaledIntval scale_intval
+    (   Decimal const& p_x,
+        places_type p_places,
+        bool p_round_up
+    )
+    {
+        ScaledIntval ret = { 0, p_x.intval() };
+        places_type const x_places = p_x.places();
+        if (p_places >= x_places)
+        {
+            for (places_type i = x_places; i != p_places; ++i)
+            {
+                if (multiplication_is_unsafe(ret.value, int_type(10)))
+                {
+                    ret.overflow = ((p_x.intval() > 0)? 1: -1);
+                    return ret;
+                }
+                ret.value *= 10;
+            }
+            return ret;
+        }
+        JEWEL_ASSERT (p_places < x_places);
+        int_type quotient = ret.value;
+        bool inexact = false;
+        for (places_type i = p_places; i != x_places; ++i)
+        {
+            inexact = inexact || (quotient % 10 != 0);
+            quotient /= 10;
+        }
+        if (inexact)
+        {
+            // Truncation has rounded towards zero.
+            if (p_round_up && (ret.value > 0)) ++quotient;
+            if (!p_round_up && (ret.value < 0)) --quotient;
+        }
+        ret.value = quotient;
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+
+// DecimalColumnWriter
+
+DecimalColumnWriter::DecimalColumnWriter
+(   string const& p_filepath,
+    ScaleMode p_scale_mode,
+    Decimal::places_type p_places,
+    size_t p_block_size
+):
+    m_scale_mode(p_scale_mode),
+    m_places(p_places),
+    m_block_size(p_block_size),
+    m_value_count(0),
+    m_offset(0),
+    m_is_closed(false),
+    m_block_places(p_places)
+{
+    if (m_block_size == 0)
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Block size of Decimal column must be greater than 0."
+        );
+    }
+    if (m_block_size > numeric_limits<uint32_t>::max())
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Block size of Decimal column is too large."
+        );
+    }
+    if (m_places > Decimal::maximum_precision())
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Scale of Decimal column exceeds "
+            "Decimal::maximum_precision()."
+        );
+    }
+    m_file.open
+    (   p_filepath.c_str(),
+        ios::out | ios::binary | ios::trunc
+    );
+    if (!m_file)
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Could not open Decimal column file for writing."
+        );
+    }
+    m_intvals.reserve(m_block_size);
+
+    // Placeholder for the header, which is rewritten on closing.
+    Header const header = Header();
+    write_raw(&header, sizeof(header));
+}
+
+DecimalColumnWriter::~DecimalColumnWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+void
+DecimalColumnWriter::append(Decimal const& p_value)
+{
+    if (m_is_closed)
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Cannot append to Decimal column after it has been closed."
+        );
+    }
+    places_type places = m_places;
+    if (m_scale_mode == per_block_scale)
+    {
+        places = p_value.places();
+        if (!m_intvals.empty())
+        {
+            places = max(places, m_block_places);
+        }
+    }
+    else
+    {
+        JEWEL_ASSERT (m_scale_mode == fixed_scale);
+    }
+
+    // round will throw DecimalRangeException if a value cannot be
+    // represented at this scale, so we do all the rounding before changing
+    // anything.
+    int_type const intval =
+    (   (p_value.places() == places)?
+        p_value.intval():
+        round(p_value, places).intval()
+    );
+    if (!m_intvals.empty() && (places != m_block_places))
+    {
+        JEWEL_ASSERT (places > m_block_places);
+        vector<int_type> rescaled;
+        rescaled.reserve(m_block_size);
+        for (int_type const existing: m_intvals)
+        {
+            rescaled.push_back
+            (   round(Decimal(existing, m_block_places), places).intval()
+            );
+        }
+        m_intvals.swap(rescaled);
+    }
+    m_intvals.push_back(intval);
+    m_block_places = places;
+    ++m_value_count;
+    if (m_intvals.size() == m_block_size)
+    {
+        write_block();
+    }
+    return;
+}
+
+void
+DecimalColumnWriter::append(Decimal const* p_values, size_t p_count)
+{
+    for (size_t i = 0; i != p_count; ++i)
+    {
+        append(p_values[i]);
+    }
+    return;
+}
+
+void
+DecimalColumnWriter::close()
+{
+    if (m_is_closed)
+    {
+        return;
+    }
+    if (!m_intvals.empty())
+    {
+        write_block();
+    }
+    Header header = Header();
+    memcpy(header.magic, magic, sizeof(magic));
+    header.byte_order_mark = byte_order_mark;
+    header.version = current_version;
+    header.scale_mode = m_scale_mode;
+    header.value_count = m_value_count;
+    header.block_size = m_block_size;
+    header.block_count = m_blocks.size();
+    header.block_table_offset = m_offset;
+    if (!m_blocks.empty())
+    {
+        write_raw(&m_blocks[0], m_blocks.size() * sizeof(BlockInfo));
+    }
+    m_file.seekp(0);
+    write_raw(&header, sizeof(header));
+    m_file.close();
+    if (!m_file)
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Error closing Decimal column file."
+        );
+    }
+    m_is_closed = true;
+    return;
+}
+
+void
+DecimalColumnWriter::write_block()
+{
+    JEWEL_ASSERT (!m_intvals.empty());
+    JEWEL_ASSERT (m_intvals.size() <= m_block_size);
+    BlockInfo info = BlockInfo();
+    info.min_intval = *std::min_element(m_intvals.begin(), m_intvals.end());
+    info.max_intval = *std::max_element(m_intvals.begin(), m_intvals.end());
+    info.offset = m_offset;
+    info.count = static_cast<uint32_t>(m_intvals.size());
+    info.places = m_block_places;
+    write_raw(&m_intvals[0], m_intvals.size() * sizeof(int_type));
+    m_blocks.push_back(info);
+    m_intvals.clear();
+    return;
+}
+
+void
+DecimalColumnWriter::write_raw(void const* p_data, size_t p_size)
+{
+    m_file.write(static_cast<char const*>(p_data), p_size);
+    if (!m_file)
+    {
+        JEWEL_THROW
+        (   DecimalColumnException,
+            "Error writing to Decimal column file."
+        );
+    }
+    m_offset += p_size;
+    return;
+}
+
+
+// DecimalColumn::Block
+
+bool
+DecimalColumn::Block::intval_bounds
+(   Decimal const& p_lower,
+    Decimal const& p_upper,
+    Decimal::int_type& p_lower_intval,
+    Decimal::int_type& p_upper_intval
+) const
+{
+    ScaledIntval const lower = scale_intval(p_lower, places(), true);
+    ScaledIntval const upper = scale_intval(p_upper, places(), false);
+    if (lower.overflow > 0 || upper.overflow < 0)
+    {
+        return false;
+    }
+    int_type const lower_intval =
+    (   (lower.overflow < 0)?
+        numeric_limits<int_type>::min():
+        lower.value
+    );
+    int_type const upper_intval =
+    (   (upper.overflow > 0)?
+        numeric_limits<int_type>::max():
+        upper.value
+    );
+    if (lower_intval > upper_intval)
+    {
+        return false;
+    }
+    p_lower_intval = lower_intval;
+    p_upper_intval = upper_intval;
+    return true;
+}
+
+
+// DecimalColumn
+
+DecimalColumn::DecimalColumn(string const& p_filepath):
+    m_header(nullptr),
+    m_blocks(nullptr),
+    m_mapping(nullptr),
+    m_mapping_size(0)
+{
+#   ifdef JEWEL_ON_WINDOWS
+        ifstream file(p_filepath.c_str(), ios::in | ios::binary);
+        if (!file)
+        {
+            JEWEL_THROW
+            (   DecimalColumnException,
+                "Could not open Decimal column file for reading."
+            );
+        }
+        file.seekg(0, ios::end);
+        m_buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0, ios::beg);
+        if (!m_buffer.empty())
+        {
+            file.read(reinterpret_cast<char*>(&m_buffer[0]), m_buffer.size());
+        }
+        if (!file)
+        {
+            JEWEL_THROW
+            (   DecimalColumnException,
+                "Error reading Decimal column file."
+            );
+        }
+        m_mapping_size = m_buffer.size();
+#   else
+        int const fd = ::open(p_filepath.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            JEWEL_THROW
+            (   DecimalColumnException,
+                "Could not open Decimal column file for reading."
+            );
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            JEWEL_THROW
+            (   DecimalColumnException,
+                "Could not determine size of Decimal column file."
+            );
+        }
+        m_mapping_size = static_cast<size_t>(st.st_size);
+        if (m_mapping_size < sizeof(Header))
+        {
+            ::close(fd);
+            JEWEL_THROW
+            (   DecimalColumnException,
+                "File is too small to be a Decimal column file."
+            );
+        }
+        void* const mapping =
+            ::mmap(nullptr, m_mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // The mapping remains valid after closing.
+        if (mapping == MAP_FAILED)
+        {
+            JEWEL_THROW
+            (   DecimalColumnException,
+                "Could not map Decimal column file into memory."
+            );
+        }
+        m_mapping = mapping;
+#   endif
+
+    // Validate the header and block table. From here on, we must unmap
+    // on failure, as the destructor will not be called.
+    char const* error_message = nullptr;
+    if (m_mapping_size < sizeof(Header))
+    {
+        error_message = "File is too small to be a Decimal column file.";
+    }
+    else
+    {
+        m_header = reinterpret_cast<Header const*>(data());
+        if (memcmp(m_header->magic, magic, sizeof(magic)) != 0)
+        {
+            error_message = "File is not a Decimal column file.";
+        }
+        else if (m_header->byte_order_mark != byte_order_mark)
+        {
+            error_message =
+                "Decimal column file was written with a different byte order.";
+        }
+        else if (m_header->version != current_version)
+        {
+            error_message = "Unsupported Decimal column file version.";
+        }
+        else if
+        (   (m_header->block_size == 0) ||
+            (m_header->block_table_offset > m_mapping_size) ||
+            (   m_header->block_count >
+                (m_mapping_size - m_header->block_table_offset) /
+                    sizeof(BlockInfo)
+            ) ||
+            (m_header->block_table_offset % sizeof(int_type) != 0) ||
+            (   (m_header->value_count != 0) &&
+                (   (m_header->block_count == 0) ||
+                    (   (m_header->value_count - 1) / m_header->block_count >=
+                        m_header->block_size
+                    )
+                )
+            )
+        )
+        {
+            error_message = "Decimal column file is corrupt.";
+        }
+        else
+        {
+            m_blocks = reinterpret_cast<BlockInfo const*>
+            (   data() + m_header->block_table_offset
+            );
+            // Every block but the last must be full, as operator[] relies
+            // on this to locate a value; and the counts must add up.
+            uint64_t total_count = 0;
+            for (size_t i = 0; i != m_header->block_count; ++i)
+            {
+                BlockInfo const& info = m_blocks[i];
+                bool const is_last = (i + 1 == m_header->block_count);
+                total_count += info.count;
+                if
+                (   (info.count > m_header->block_size) ||
+                    (!is_last && (info.count != m_header->block_size)) ||
+                    (total_count > m_header->value_count) ||
+                    (is_last && (total_count != m_header->value_count)) ||
+                    (info.places > Decimal::maximum_precision()) ||
+                    (info.offset % sizeof(int_type) != 0) ||
+                    (info.offset > m_header->block_table_offset) ||
+                    (   info.count * sizeof(int_type) >
+                        m_header->block_table_offset - info.offset
+                    )
+                )
+                {
+                    error_message = "Decimal column file is corrupt.";
+                    break;
+                }
+            }
+        }
+    }
+    if (error_message)
+    {
+#       ifndef JEWEL_ON_WINDOWS
+            ::munmap(m_mapping, m_mapping_size);
+#       endif
+        JEWEL_THROW(DecimalColumnException, error_message);
+    }
+}
+
+DecimalColumn::~DecimalColumn()
+{
+#   ifndef JEWEL_ON_WINDOWS
+        if (m_mapping)
+        {
+            ::munmap(m_mapping, m_mapping_size);
+        }
+#   endif
+}
+
+unsigned char const*
+DecimalColumn::data() const
+{
+    if (m_mapping)
+    {
+        return static_cast<unsigned char const*>(m_mapping);
+    }
+    JEWEL_ASSERT (!m_buffer.empty());
+    return &m_buffer[0];
+}
+
+
+}  // namespace jewel
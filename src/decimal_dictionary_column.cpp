@@ -0,0 +1,343 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_dictionary_column.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/bit_packing.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/int128.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using jewel::detail::bits_required;
+using jewel::detail::int128_t;
+using jewel::detail::pack_bits;
+using jewel::detail::packed_word_count;
+using jewel::detail::unpack_bit_field;
+using std::lower_bound;
+using std::max;
+using std::numeric_limits;
+using std::size_t;
+using std::sort;
+using std::uint64_t;
+using std::unordered_map;
+using std::upper_bound;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+    typedef Decimal::places_type places_type;
+    typedef DecimalDictionaryColumn::code_type code_type;
+
+    /*
+     * Orders provisional codes by the dictionary values they refer to.
+     */
+    class ProvisionalCodeLess
+    {
+    public:
+        explicit ProvisionalCodeLess(vector<int_type> const& p_values):
+            m_values(p_values)
+        {
+        }
+        bool operator()(code_type p_lhs, code_type p_rhs) const
+        {
+            return m_values[p_lhs] < m_values[p_rhs];
+        }
+    private:
+        vector<int_type> const& m_values;
+    };
+
+    /*
+     * Compares underlying integers at a given scale with Decimals, for
+     * binary searches of the dictionary.
+     */
+    class ScaledIntvalLess
+    {
+    public:
+        explicit ScaledIntvalLess(places_type p_places): m_places(p_places)
+        {
+        }
+        bool operator()(int_type p_lhs, Decimal const& p_rhs) const
+        {
+            return Decimal(p_lhs, m_places) < p_rhs;
+        }
+        bool operator()(Decimal const& p_lhs, int_type p_rhs) const
+        {
+            return p_lhs < Decimal(p_rhs, m_places);
+        }
+    private:
+        places_type m_places;
+    };
+
+}  // end anonymous namespace
+
+
+DecimalDictionaryColumn::DecimalDictionaryColumn():
+    m_size(0),
+    m_places(0),
+    m_code_width(1),
+    m_words(packed_word_count(0, 1), 0)
+{
+}
+
+DecimalDictionaryColumn::DecimalDictionaryColumn
+(   Decimal const* p_values,
+    size_t p_count
+):
+    m_size(0),
+    m_places(0),
+    m_code_width(1)
+{
+    places_type places = 0;
+    for (size_t i = 0; i != p_count; ++i)
+    {
+        places = max(places, p_values[i].places());
+    }
+
+    // Number the distinct values in order of first appearance. Runs of
+    // equal values are common in the data this class is designed for, so
+    // we avoid looking up a value that repeats the previous one.
+    vector<int_type> dictionary;
+    vector<code_type> codes(p_count);
+    unordered_map<int_type, code_type> provisional_codes;
+    int_type previous = 0;
+    code_type previous_code = 0;
+    for (size_t i = 0; i != p_count; ++i)
+    {
+        Decimal const& value = p_values[i];
+        int_type const x =
+        (   (value.places() == places)?
+            value.intval():
+            round(value, places).intval()
+        );
+        if (x != previous || i == 0)
+        {
+            code_type const next_code =
+                static_cast<code_type>(dictionary.size());
+            auto const insertion =
+                provisional_codes.insert(std::make_pair(x, next_code));
+            if (insertion.second)
+            {
+                JEWEL_HARD_ASSERT
+                (   dictionary.size() <= numeric_limits<code_type>::max()
+                );
+                dictionary.push_back(x);
+            }
+            previous = x;
+            previous_code = insertion.first->second;
+        }
+        codes[i] = previous_code;
+    }
+
+    // Sort the dictionary, and renumber the codes to match.
+    vector<code_type> order(dictionary.size());
+    for (size_t i = 0; i != order.size(); ++i)
+    {
+        order[i] = static_cast<code_type>(i);
+    }
+    sort(order.begin(), order.end(), ProvisionalCodeLess(dictionary));
+    vector<code_type> final_codes(order.size());
+    vector<int_type> sorted_dictionary(order.size());
+    for (size_t i = 0; i != order.size(); ++i)
+    {
+        final_codes[order[i]] = static_cast<code_type>(i);
+        sorted_dictionary[i] = dictionary[order[i]];
+    }
+    for (size_t i = 0; i != p_count; ++i)
+    {
+        codes[i] = final_codes[codes[i]];
+    }
+
+    unsigned int const code_width = bits_required
+    (   sorted_dictionary.empty()?
+        0:
+        static_cast<code_type>(sorted_dictionary.size() - 1)
+    );
+    vector<uint64_t> words(packed_word_count(p_count, code_width), 0);
+    if (p_count != 0)
+    {
+        pack_bits(&codes[0], p_count, code_width, 0, &words[0]);
+    }
+
+    // Nothing below can throw.
+    m_size = p_count;
+    m_places = places;
+    m_code_width = code_width;
+    m_dictionary.swap(sorted_dictionary);
+    m_words.swap(words);
+}
+
+size_t
+DecimalDictionaryColumn::memory_usage() const
+{
+    return
+        sizeof(*this) +
+        m_dictionary.size() * sizeof(int_type) +
+        m_words.size() * sizeof(uint64_t);
+}
+
+void
+DecimalDictionaryColumn::decode
+(   size_t p_first,
+    size_t p_count,
+    Decimal* p_out
+) const
+{
+    JEWEL_ASSERT (p_first <= m_size && p_count <= m_size - p_first);
+    for (size_t i = 0; i != p_count; ++i)
+    {
+        code_type const c = static_cast<code_type>
+        (   unpack_bit_field(&m_words[0], m_code_width, p_first + i)
+        );
+        p_out[i] = Decimal(m_dictionary[c], m_places);
+    }
+    return;
+}
+
+bool
+DecimalDictionaryColumn::code_bounds
+(   Decimal const& p_lower,
+    Decimal const& p_upper,
+    code_type& p_first_code,
+    code_type& p_last_code
+) const
+{
+    ScaledIntvalLess const less(m_places);
+    vector<int_type>::const_iterator const first =
+        lower_bound(m_dictionary.begin(), m_dictionary.end(), p_lower, less);
+    vector<int_type>::const_iterator const end =
+        upper_bound(m_dictionary.begin(), m_dictionary.end(), p_upper, less);
+    if (first >= end)
+    {
+        return false;
+    }
+    p_first_code = static_cast<code_type>(first - m_dictionary.begin());
+    p_last_code = static_cast<code_type>(end - m_dictionary.begin() - 1);
+    return true;
+}
+
+Decimal
+DecimalDictionaryColumn::sum() const
+{
+    if (m_dictionary.empty())
+    {
+        return Decimal(0, m_places);
+    }
+    return sum_codes
+    (   0,
+        static_cast<code_type>(m_dictionary.size() - 1)
+    );
+}
+
+Decimal
+DecimalDictionaryColumn::sum_in_range
+(   Decimal const& p_lower,
+    Decimal const& p_upper
+) const
+{
+    code_type first_code = 0;
+    code_type last_code = 0;
+    if (!code_bounds(p_lower, p_upper, first_code, last_code))
+    {
+        return Decimal(0, m_places);
+    }
+    return sum_codes(first_code, last_code);
+}
+
+size_t
+DecimalDictionaryColumn::count_in_range
+(   Decimal const& p_lower,
+    Decimal const& p_upper
+) const
+{
+    code_type first_code = 0;
+    code_type last_code = 0;
+    if (!code_bounds(p_lower, p_upper, first_code, last_code))
+    {
+        return 0;
+    }
+    code_type const span = last_code - first_code;
+    size_t ret = 0;
+    for (size_t i = 0; i != m_size; ++i)
+    {
+        code_type const c = static_cast<code_type>
+        (   unpack_bit_field(&m_words[0], m_code_width, i)
+        );
+        ret += (static_cast<code_type>(c - first_code) <= span);
+    }
+    return ret;
+}
+
+void
+DecimalDictionaryColumn::count_codes(vector<size_t>& p_counts) const
+{
+    JEWEL_ASSERT (p_counts.size() == m_dictionary.size());
+    for (size_t i = 0; i != m_size; ++i)
+    {
+        ++p_counts[unpack_bit_field(&m_words[0], m_code_width, i)];
+    }
+    return;
+}
+
+Decimal
+DecimalDictionaryColumn::sum_codes
+(   code_type p_first_code,
+    code_type p_last_code
+) const
+{
+    JEWEL_ASSERT (p_first_code <= p_last_code);
+    JEWEL_ASSERT (p_last_code < m_dictionary.size());
+    vector<size_t> counts(m_dictionary.size(), 0);
+    count_codes(counts);
+
+    // Neither the negative terms nor the positive terms can together
+    // exceed size() * 2^63 in magnitude, so the sum can't overflow 128
+    // bits along the way.
+    int128_t total = 0;
+    for (code_type c = p_first_code; ; ++c)
+    {
+        total += static_cast<int128_t>(counts[c]) * m_dictionary[c];
+        if (c == p_last_code)
+        {
+            break;
+        }
+    }
+    if
+    (   total > numeric_limits<int_type>::max() ||
+        total < numeric_limits<int_type>::min()
+    )
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalAdditionException,
+            "Unsafe addition."
+        );
+    }
+    return Decimal(static_cast<int_type>(total), m_places);
+}
+
+}  // namespace jewel
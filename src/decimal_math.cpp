@@ -0,0 +1,858 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_math.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/int128.hpp"
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+using jewel::detail::bit_length;
+using jewel::detail::divide_step;
+using jewel::detail::uint128_t;
+using jewel::detail::uint128_max;
+using std::numeric_limits;
+using std::swap;
+using std::uint64_t;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+    typedef Decimal::places_type places_type;
+
+    // Number of significant digits carried by Wide.
+    unsigned int const wide_digits = 38;
+
+    uint64_t const low_mask = numeric_limits<uint64_t>::max();
+
+    constexpr uint128_t ten_to(unsigned int n)
+    {
+        return (n == 0)? 1: (10 * ten_to(n - 1));
+    }
+
+    uint128_t const powers_of_ten[wide_digits + 1] =
+    {
+        ten_to(0),
+        ten_to(1),
+        ten_to(2),
+        ten_to(3),
+        ten_to(4),
+        ten_to(5),
+        ten_to(6),
+        ten_to(7),
+        ten_to(8),
+        ten_to(9),
+        ten_to(10),
+        ten_to(11),
+        ten_to(12),
+        ten_to(13),
+        ten_to(14),
+        ten_to(15),
+        ten_to(16),
+        ten_to(17),
+        ten_to(18),
+        ten_to(19),
+        ten_to(20),
+        ten_to(21),
+        ten_to(22),
+        ten_to(23),
+        ten_to(24),
+        ten_to(25),
+        ten_to(26),
+        ten_to(27),
+        ten_to(28),
+        ten_to(29),
+        ten_to(30),
+        ten_to(31),
+        ten_to(32),
+        ten_to(33),
+        ten_to(34),
+        ten_to(35),
+        ten_to(36),
+        ten_to(37),
+        ten_to(38)
+    };
+
+    inline
+    uint128_t power_of_ten(unsigned int n)
+    {
+        JEWEL_ASSERT (n <= wide_digits);
+        return powers_of_ten[n];
+    }
+
+    inline
+    unsigned int num_digits(uint128_t x)
+    {
+        // 1233 / 4096 approximates log10(2), so this is the number of
+        // digits, or one more.
+        unsigned int const estimate = (bit_length(x) * 1233) >> 12;
+        return (x < power_of_ten(estimate))? estimate: (estimate + 1);
+    }
+
+    uint128_t isqrt(uint128_t n)
+    {
+        if (n < 2)
+        {
+            return n;
+        }
+        // Newton's method, starting from a power of two that is no less
+        // than the root, converges on the root from above.
+        uint128_t x = uint128_t(1) << ((bit_length(n) + 1) / 2);
+        while (true)
+        {
+            uint128_t const y = (x + n / x) / 2;
+            if (y >= x)
+            {
+                return x;
+            }
+            x = y;
+        }
+    }
+
+    /*
+     * 256-bit unsigned integer, sufficient to hold the product of two
+     * 128-bit integers.
+     */
+    struct U256
+    {
+        uint128_t high;
+        uint128_t low;
+    };
+
+    bool operator<(U256 const& lhs, U256 const& rhs)
+    {
+        return
+            (lhs.high < rhs.high) ||
+            (lhs.high == rhs.high && lhs.low < rhs.low);
+    }
+
+    U256 multiply(uint128_t lhs, uint128_t rhs)
+    {
+        uint128_t const lhs0 = lhs & low_mask;
+        uint128_t const lhs1 = lhs >> 64;
+        uint128_t const rhs0 = rhs & low_mask;
+        uint128_t const rhs1 = rhs >> 64;
+        uint128_t const p00 = lhs0 * rhs0;
+        uint128_t const p01 = lhs0 * rhs1;
+        uint128_t const p10 = lhs1 * rhs0;
+        uint128_t const p11 = lhs1 * rhs1;
+        uint128_t const middle =
+            (p00 >> 64) + (p01 & low_mask) + (p10 & low_mask);
+        U256 ret;
+        ret.low = (p00 & low_mask) | (middle << 64);
+        ret.high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+        return ret;
+    }
+
+    /*
+     * @returns \e x divided by \e divisor, and writes the remainder to
+     * \e p_remainder.
+     */
+    inline
+    uint128_t divide(uint128_t x, uint64_t divisor, uint64_t& p_remainder)
+    {
+        JEWEL_ASSERT (divisor != 0);
+        uint64_t const high = static_cast<uint64_t>(x >> 64);
+        uint128_t const quotient_high = high / divisor;
+        uint128_t const partial =
+            (static_cast<uint128_t>(high % divisor) << 64) |
+            static_cast<uint64_t>(x);
+        return
+            (quotient_high << 64) |
+            divide_step(partial, divisor, p_remainder);
+    }
+
+    /*
+     * Divides \e x by \e divisor in place, discarding the remainder.
+     */
+    void divide(U256& x, uint64_t divisor)
+    {
+        uint64_t remainder = 0;
+        x.high = divide(x.high, divisor, remainder);
+        uint128_t const partial =
+            (static_cast<uint128_t>(remainder) << 64) | (x.low >> 64);
+        uint128_t const quotient_middle =
+            divide_step(partial, divisor, remainder);
+        uint128_t const quotient_low = divide_step
+        (   (static_cast<uint128_t>(remainder) << 64) |
+                static_cast<uint64_t>(x.low),
+            divisor,
+            remainder
+        );
+        x.low = (quotient_middle << 64) | quotient_low;
+        return;
+    }
+
+    /*
+     * One step of Knuth's Algorithm D, using 64-bit digits. Divides
+     * \e p_partial, with \e p_next appended as a further digit, by
+     * \e p_divisor, which must have its top bit set. Returns the quotient
+     * digit, and replaces \e p_partial with the remainder.
+     * Precondition: \e p_partial is less than \e p_divisor.
+     */
+    uint64_t quotient_digit
+    (   uint128_t& p_partial,
+        uint64_t p_next,
+        uint128_t p_divisor
+    )
+    {
+        JEWEL_ASSERT (p_partial < p_divisor);
+        JEWEL_ASSERT ((p_divisor >> 127) == 1);
+        uint64_t const divisor_high = static_cast<uint64_t>(p_divisor >> 64);
+        uint64_t const divisor_low = static_cast<uint64_t>(p_divisor);
+
+        // Estimate the quotient digit from the leading digits. The estimate
+        // is then at most one too large.
+        uint128_t estimate = low_mask;
+        uint128_t estimate_remainder =
+            static_cast<uint128_t>(static_cast<uint64_t>(p_partial)) +
+            divisor_high;
+        if ((p_partial >> 64) < divisor_high)
+        {
+            uint64_t remainder = 0;
+            estimate = divide_step(p_partial, divisor_high, remainder);
+            estimate_remainder = remainder;
+        }
+        while
+        (   (estimate_remainder <= low_mask) &&
+            (   estimate * divisor_low >
+                ((estimate_remainder << 64) | p_next)
+            )
+        )
+        {
+            --estimate;
+            estimate_remainder += divisor_high;
+        }
+
+        // Subtract estimate * p_divisor, adding back if that goes negative.
+        uint128_t const product_low = estimate * divisor_low;
+        uint128_t const product_high =
+            estimate * divisor_high + (product_low >> 64);
+        bool const borrow = (p_next < static_cast<uint64_t>(product_low));
+        uint64_t remainder_low = p_next - static_cast<uint64_t>(product_low);
+        uint128_t remainder_high = p_partial - product_high - borrow;
+        if
+        (   (p_partial < product_high) ||
+            (p_partial == product_high && borrow)
+        )
+        {
+            --estimate;
+            uint64_t const sum = remainder_low + divisor_low;
+            remainder_high += divisor_high + (sum < remainder_low? 1: 0);
+            remainder_low = sum;
+        }
+        JEWEL_ASSERT ((remainder_high >> 64) == 0);
+        p_partial = (remainder_high << 64) | remainder_low;
+        return static_cast<uint64_t>(estimate);
+    }
+
+    /*
+     * @returns \e x divided by \e divisor, discarding the remainder.
+     * Precondition: the quotient must fit in 128 bits, and \e divisor
+     * must be at least 2 to the power of 64.
+     */
+    uint128_t divide_narrow(U256 const& x, uint128_t divisor)
+    {
+        JEWEL_ASSERT (x.high < divisor);
+        JEWEL_ASSERT ((divisor >> 64) != 0);
+
+        // Normalize so that the divisor has its top bit set.
+        unsigned int const shift = 128 - bit_length(divisor);
+        uint128_t partial = x.high;
+        uint128_t low = x.low;
+        if (shift != 0)
+        {
+            partial = (partial << shift) | (low >> (128 - shift));
+            low <<= shift;
+        }
+        uint128_t const normalized_divisor = divisor << shift;
+        uint128_t const quotient_high = quotient_digit
+        (   partial,
+            static_cast<uint64_t>(low >> 64),
+            normalized_divisor
+        );
+        uint128_t const quotient_low = quotient_digit
+        (   partial,
+            static_cast<uint64_t>(low),
+            normalized_divisor
+        );
+        return (quotient_high << 64) | quotient_low;
+    }
+
+    U256 const& ten_to_75()
+    {
+        static U256 const ret = multiply(power_of_ten(38), power_of_ten(37));
+        return ret;
+    }
+
+    /*
+     * A decimal floating point number with wide_digits significant digits,
+     * representing coefficient * 10^exponent, negated if \e negative.
+     * Unless zero, the coefficient always has exactly wide_digits digits.
+     * Rounding is always towards zero, which is accurate enough for the
+     * purpose, given that the results are rounded to at most
+     * Decimal::maximum_precision() digits.
+     */
+    struct Wide
+    {
+        uint128_t coefficient;
+        int exponent;
+        bool negative;
+    };
+
+    Wide make_wide(uint128_t p_coefficient, int p_exponent, bool p_negative)
+    {
+        Wide ret;
+        ret.coefficient = p_coefficient;
+        ret.exponent = p_exponent;
+        ret.negative = p_negative;
+        if (p_coefficient == 0)
+        {
+            ret.exponent = 0;
+            ret.negative = false;
+            return ret;
+        }
+        unsigned int const digits = num_digits(p_coefficient);
+        if (digits > wide_digits)
+        {
+            JEWEL_ASSERT (digits == wide_digits + 1);
+            ret.coefficient /= 10;
+            ++ret.exponent;
+        }
+        else
+        {
+            ret.coefficient *= power_of_ten(wide_digits - digits);
+            ret.exponent -= (wide_digits - digits);
+        }
+        return ret;
+    }
+
+    Wide make_wide(int_type x)
+    {
+        uint128_t const magnitude =
+        (   (x < 0)?
+            (0 - static_cast<uint128_t>(x)):
+            static_cast<uint128_t>(x)
+        );
+        return make_wide(magnitude, 0, x < 0);
+    }
+
+    Wide make_wide(Decimal const& x)
+    {
+        Wide ret = make_wide(x.intval());
+        ret.exponent -= x.places();
+        return ret;
+    }
+
+    /*
+     * @returns a Wide from a constant expressed as the first and last
+     * 19 digits of its coefficient.
+     */
+    Wide make_constant(uint64_t p_first, uint64_t p_last, int p_exponent)
+    {
+        return make_wide
+        (   p_first * power_of_ten(19) + p_last,
+            p_exponent,
+            false
+        );
+    }
+
+    bool is_zero(Wide const& x)
+    {
+        return x.coefficient == 0;
+    }
+
+    Wide operator-(Wide x)
+    {
+        x.negative = !x.negative && !is_zero(x);
+        return x;
+    }
+
+    Wide operator+(Wide lhs, Wide rhs)
+    {
+        if (is_zero(rhs)) return lhs;
+        if (is_zero(lhs)) return rhs;
+        if
+        (   (lhs.exponent < rhs.exponent) ||
+            (lhs.exponent == rhs.exponent && lhs.coefficient < rhs.coefficient)
+        )
+        {
+            swap(lhs, rhs);
+        }
+        // lhs now has the greater magnitude
+        unsigned int const shift = lhs.exponent - rhs.exponent;
+        uint128_t aligned = 0;
+        if (shift < 20)
+        {
+            uint64_t remainder = 0;
+            aligned = divide
+            (   rhs.coefficient,
+                static_cast<uint64_t>(power_of_ten(shift)),
+                remainder
+            );
+        }
+        else if (shift <= wide_digits)
+        {
+            aligned = rhs.coefficient / power_of_ten(shift);
+        }
+        if (lhs.negative == rhs.negative)
+        {
+            return make_wide
+            (   lhs.coefficient + aligned,
+                lhs.exponent,
+                lhs.negative
+            );
+        }
+        JEWEL_ASSERT (lhs.coefficient >= aligned);
+        return make_wide
+        (   lhs.coefficient - aligned,
+            lhs.exponent,
+            lhs.negative
+        );
+    }
+
+    Wide operator-(Wide const& lhs, Wide const& rhs)
+    {
+        return lhs + (-rhs);
+    }
+
+    Wide operator*(Wide const& lhs, Wide const& rhs)
+    {
+        if (is_zero(lhs) || is_zero(rhs))
+        {
+            return make_wide(0);
+        }
+        // The product of the coefficients lies in [10^74, 10^76).
+        U256 product = multiply(lhs.coefficient, rhs.coefficient);
+        int exponent = lhs.exponent + rhs.exponent;
+        uint64_t const ten_to_19 = 10000000000000000000ULL;
+        bool const is_short = (product < ten_to_75());
+        divide(product, ten_to_19);
+        if (is_short)
+        {
+            divide(product, ten_to_19 / 10);
+            exponent += 37;
+        }
+        else
+        {
+            divide(product, ten_to_19);
+            exponent += 38;
+        }
+        JEWEL_ASSERT (product.high == 0);
+        return make_wide(product.low, exponent, lhs.negative != rhs.negative);
+    }
+
+    /*
+     * Precondition: \e rhs is not zero.
+     */
+    Wide operator/(Wide const& lhs, Wide const& rhs)
+    {
+        JEWEL_ASSERT (!is_zero(rhs));
+        if (is_zero(lhs))
+        {
+            return lhs;
+        }
+        // Scale the dividend so that the quotient lies in [10^37, 10^38).
+        unsigned int const scale =
+            (lhs.coefficient < rhs.coefficient)? wide_digits: wide_digits - 1;
+        uint128_t const quotient = divide_narrow
+        (   multiply(lhs.coefficient, power_of_ten(scale)),
+            rhs.coefficient
+        );
+        return make_wide
+        (   quotient,
+            lhs.exponent - rhs.exponent - static_cast<int>(scale),
+            lhs.negative != rhs.negative
+        );
+    }
+
+    /*
+     * Division by a small positive integer, which is much faster than
+     * general division.
+     */
+    Wide operator/(Wide const& lhs, uint64_t rhs)
+    {
+        JEWEL_ASSERT (rhs != 0);
+        uint64_t remainder = 0;
+        uint128_t quotient = divide(lhs.coefficient, rhs, remainder);
+        int exponent = lhs.exponent;
+        while (quotient != 0 && quotient < power_of_ten(wide_digits - 1))
+        {
+            uint128_t const digit = divide_step
+            (   static_cast<uint128_t>(remainder) * 10,
+                rhs,
+                remainder
+            );
+            quotient = quotient * 10 + digit;
+            --exponent;
+        }
+        return make_wide(quotient, exponent, lhs.negative);
+    }
+
+    /*
+     * @returns \e x with the fractional part discarded, rounding towards
+     * negative infinity. Precondition: the result must fit in an int.
+     */
+    int floor_to_int(Wide const& x)
+    {
+        if (x.exponent >= 0)
+        {
+            JEWEL_ASSERT (is_zero(x));
+            return 0;
+        }
+        unsigned int const shift = -x.exponent;
+        uint128_t whole = 0;
+        bool inexact = !is_zero(x);
+        if (shift <= wide_digits)
+        {
+            whole = x.coefficient / power_of_ten(shift);
+            inexact = (x.coefficient % power_of_ten(shift) != 0);
+        }
+        JEWEL_ASSERT
+        (   whole <= static_cast<uint128_t>(numeric_limits<int>::max())
+        );
+        int const ret = static_cast<int>(whole);
+        return x.negative? (-ret - (inexact? 1: 0)): ret;
+    }
+
+    /*
+     * Rounds \e x half away from zero to \e p_places places, and writes
+     * the result to \e p_out. Returns false, leaving \e p_out unchanged,
+     * if the result cannot be represented as a Decimal.
+     */
+    bool to_decimal(Wide const& x, places_type p_places, Decimal& p_out)
+    {
+        JEWEL_ASSERT (p_places <= Decimal::maximum_precision());
+        if (is_zero(x))
+        {
+            p_out = Decimal(0, p_places);
+            return true;
+        }
+        int const shift = x.exponent + p_places;
+        if (shift >= 0)
+        {
+            // Result has at least wide_digits digits.
+            return false;
+        }
+        uint128_t magnitude = 0;
+        unsigned int const divisor_digits = -shift;
+        if (divisor_digits <= wide_digits)
+        {
+            uint128_t const divisor = power_of_ten(divisor_digits);
+            magnitude = x.coefficient / divisor;
+            uint128_t const remainder = x.coefficient % divisor;
+            if (remainder >= divisor - remainder)
+            {
+                ++magnitude;
+            }
+        }
+        uint128_t const max_magnitude =
+            static_cast<uint128_t>(numeric_limits<int_type>::max());
+        if (magnitude > max_magnitude)
+        {
+            return false;
+        }
+        int_type const intval = static_cast<int_type>(magnitude);
+        p_out = Decimal(x.negative? -intval: intval, p_places);
+        return true;
+    }
+
+    Decimal to_decimal(Wide const& x, places_type p_places)
+    {
+        Decimal ret;
+        if (!to_decimal(x, p_places, ret))
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalRangeException,
+                "Result cannot be represented with the requested number "
+                "of places."
+            );
+        }
+        return ret;
+    }
+
+    // Constants, to wide_digits significant digits
+    Wide const& ln_2()
+    {
+        static Wide const ret =
+            make_constant(6931471805599453094ULL, 1723212145817656808ULL, -38);
+        return ret;
+    }
+
+    Wide const& ln_10()
+    {
+        static Wide const ret =
+            make_constant(2302585092994045684ULL, 179914546843642076ULL, -37);
+        return ret;
+    }
+
+    Wide const& reciprocal_of_ln_2()
+    {
+        static Wide const ret =
+            make_constant(1442695040888963407ULL, 3599246810018921374ULL, -37);
+        return ret;
+    }
+
+    /*
+     * @returns true if \e term is too small to affect \e sum.
+     */
+    bool is_negligible(Wide const& term, Wide const& sum)
+    {
+        return
+            is_zero(term) ||
+            (term.exponent < sum.exponent - static_cast<int>(wide_digits));
+    }
+
+    void check_places(places_type p_places)
+    {
+        if (p_places > Decimal::maximum_precision())
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalRangeException,
+                "Requested number of places exceeds maximum precision of "
+                "Decimal."
+            );
+        }
+        return;
+    }
+
+}  // end anonymous namespace
+
+
+Decimal sqrt(Decimal const& x, Decimal::places_type places)
+{
+    check_places(places);
+    if (x.intval() < 0)
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDomainException,
+            "Attempted to take square root of negative Decimal."
+        );
+    }
+    // We want the square root of intval * 10^(2 * places - x.places()),
+    // rounded to an integer.
+    uint128_t const intval = static_cast<uint128_t>(x.intval());
+    int const shift = 2 * static_cast<int>(places) - x.places();
+    uint128_t root = 0;
+    bool round_up = false;
+    if (shift >= 0)
+    {
+        uint128_t const multiplier = power_of_ten(shift);
+        if (intval > uint128_max / multiplier)
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalRangeException,
+                "Result cannot be represented with the requested number "
+                "of places."
+            );
+        }
+        uint128_t const radicand = intval * multiplier;
+        root = isqrt(radicand);
+
+        // The exact root is at least root + 0.5 iff the radicand is at
+        // least root^2 + root + 0.25.
+        round_up = (radicand - root * root > root);
+    }
+    else
+    {
+        uint128_t const divisor = power_of_ten(-shift);
+        root = isqrt(intval / divisor);
+        round_up =
+            (4 * intval >= (4 * root * root + 4 * root + 1) * divisor);
+    }
+    if (round_up)
+    {
+        ++root;
+    }
+    if (root > static_cast<uint128_t>(numeric_limits<int_type>::max()))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Result cannot be represented with the requested number "
+            "of places."
+        );
+    }
+    return Decimal(static_cast<int_type>(root), places);
+}
+
+Decimal pow(Decimal const& x, int n, Decimal::places_type places)
+{
+    check_places(places);
+    Wide base = make_wide(x);
+    if (n < 0)
+    {
+        if (is_zero(base))
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalDivisionByZeroException,
+                "Attempted to raise zero to a negative power."
+            );
+        }
+        base = make_wide(1) / base;
+    }
+    unsigned long long remaining =
+    (   (n < 0)?
+        (0 - static_cast<unsigned long long>(n)):
+        static_cast<unsigned long long>(n)
+    );
+    // Beyond these exponents a Wide is definitely too large to be a Decimal,
+    // or definitely rounds to zero.
+    int const overflow_exponent = 0;
+    int const underflow_exponent = -2 * static_cast<int>(wide_digits);
+    Wide ret = make_wide(1);
+    while (remaining != 0)
+    {
+        if (remaining & 1)
+        {
+            ret = ret * base;
+        }
+        remaining >>= 1;
+        if (remaining != 0)
+        {
+            // base will be used again, and any later result is at least
+            // as far from one as base is.
+            base = base * base;
+        }
+        if
+        (   (ret.exponent > overflow_exponent) ||
+            (base.exponent > overflow_exponent)
+        )
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalRangeException,
+                "Result of pow is too large to be represented as a Decimal."
+            );
+        }
+        if (base.exponent < underflow_exponent)
+        {
+            base = make_wide(0);
+        }
+    }
+    return to_decimal(ret, places);
+}
+
+Decimal exp(Decimal const& x, Decimal::places_type places)
+{
+    check_places(places);
+
+    // e^44 exceeds the largest Decimal, while e^-47 rounds to zero at
+    // any number of places.
+    if (Decimal(44, 0) < x)
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Result of exp is too large to be represented as a Decimal."
+        );
+    }
+    if (x < Decimal(-47, 0))
+    {
+        return Decimal(0, places);
+    }
+
+    // Reduce to e^x = 2^k * e^r, where 0 <= r < ln 2.
+    Wide const w = make_wide(x);
+    int k = floor_to_int(w * reciprocal_of_ln_2());
+    Wide r = w - make_wide(k) * ln_2();
+    if (r.negative)
+    {
+        r = r + ln_2();
+        --k;
+    }
+
+    // Further reduce by evaluating the series for e^(r / 2^8), then
+    // squaring the result 8 times.
+    int const halvings = 8;
+    r = r * make_wide(390625);  // 5^8
+    r.exponent -= halvings;
+
+    Wide sum = make_wide(1);
+    Wide term = sum;
+    for (uint64_t i = 1; ; ++i)
+    {
+        term = (term * r) / i;
+        if (is_negligible(term, sum))
+        {
+            break;
+        }
+        sum = sum + term;
+    }
+    for (int i = 0; i != halvings; ++i)
+    {
+        sum = sum * sum;
+    }
+    Wide const two_to_k =
+        make_wide(uint128_t(1) << (k < 0? -k: k), 0, false);
+    sum = (k < 0)? (sum / two_to_k): (sum * two_to_k);
+    return to_decimal(sum, places);
+}
+
+Decimal ln(Decimal const& x, Decimal::places_type places)
+{
+    check_places(places);
+    if (x.intval() <= 0)
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalDomainException,
+            "Attempted to take logarithm of non-positive Decimal."
+        );
+    }
+
+    // Reduce to ln x = k * ln 10 + j * ln 2 + ln y, where 0.75 <= y < 1.5.
+    Wide y = make_wide(x);
+    int const k = y.exponent + static_cast<int>(wide_digits) - 1;
+    y.exponent = 1 - static_cast<int>(wide_digits);
+    Wide const one = make_wide(1);
+    Wide const one_and_a_half = make_wide(15, -1, false);
+    int j = 0;
+    while (!(y - one_and_a_half).negative)
+    {
+        y = y * make_wide(5);
+        y.exponent -= 1;
+        ++j;
+    }
+
+    // ln y = 2 * atanh(z), where z = (y - 1) / (y + 1), with
+    // atanh(z) = z + z^3 / 3 + z^5 / 5 + ...
+    Wide const z = (y - one) / (y + one);
+    Wide const z_squared = z * z;
+    Wide power = z;
+    Wide sum = z;
+    for (uint64_t i = 3; ; i += 2)
+    {
+        power = power * z_squared;
+        Wide const term = power / i;
+        if (is_negligible(term, sum))
+        {
+            break;
+        }
+        sum = sum + term;
+    }
+    Wide const ret =
+        make_wide(k) * ln_10() +
+        make_wide(j) * ln_2() +
+        sum * make_wide(2);
+    return to_decimal(ret, places);
+}
+
+}  // namespace jewel
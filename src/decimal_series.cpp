@@ -0,0 +1,314 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_series.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/bit_packing.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using jewel::detail::bits_required;
+using jewel::detail::pack_bits;
+using jewel::detail::packed_word_count;
+using jewel::detail::unpack_bit_field;
+using std::max;
+using std::min;
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+
+    /*
+     * Map signed differences, held in unsigned integers, to unsigned
+     * integers such that differences of small magnitude, whether positive
+     * or negative, map to small integers.
+     */
+    uint64_t zigzag(uint64_t p_difference)
+    {
+        return (p_difference << 1) ^ (0 - (p_difference >> 63));
+    }
+
+    uint64_t unzigzag(uint64_t p_code)
+    {
+        return (p_code >> 1) ^ (0 - (p_code & 1));
+    }
+
+    /*
+     * In both of the following, arithmetic is performed on unsigned
+     * integers, as the intermediate results of delta decoding may wrap
+     * around, while the final values are always representable as
+     * int_type.
+     */
+
+    void decode_frame_of_reference
+    (   uint64_t const* p_words,
+        unsigned int p_width,
+        int_type p_base,
+        size_t p_count,
+        int_type* p_out
+    )
+    {
+        uint64_t const base = static_cast<uint64_t>(p_base);
+        for (size_t i = 0; i != p_count; ++i)
+        {
+            p_out[i] = static_cast<int_type>
+            (   base + unpack_bit_field(p_words, p_width, i)
+            );
+        }
+        return;
+    }
+
+    void decode_delta
+    (   uint64_t const* p_words,
+        unsigned int p_width,
+        int_type p_base,
+        size_t p_count,
+        int_type* p_out
+    )
+    {
+        uint64_t x = static_cast<uint64_t>(p_base);
+        for (size_t i = 0; i != p_count; ++i)
+        {
+            x += unzigzag(unpack_bit_field(p_words, p_width, i));
+            p_out[i] = static_cast<int_type>(x);
+        }
+        return;
+    }
+
+}  // end anonymous namespace
+
+
+size_t const DecimalSeries::block_size;
+
+DecimalSeries::DecimalSeries(Decimal::places_type p_places):
+    m_places(p_places),
+    m_size(0),
+    m_words(1, 0)
+{
+    if (m_places > Decimal::maximum_precision())
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalRangeException,
+            "Scale of Decimal series exceeds Decimal::maximum_precision()."
+        );
+    }
+
+    // Ensures that appending to m_pending never throws.
+    m_pending.reserve(block_size);
+}
+
+void
+DecimalSeries::append(Decimal const& p_value)
+{
+    int_type const x =
+    (   (p_value.places() == m_places)?
+        p_value.intval():
+        round(p_value, m_places).intval()
+    );
+    JEWEL_ASSERT (m_pending.size() < block_size);
+    m_pending.push_back(x);
+    if (m_pending.size() == block_size)
+    {
+        try
+        {
+            seal_block();
+        }
+        catch (...)
+        {
+            m_pending.pop_back();
+            throw;
+        }
+    }
+    ++m_size;
+    return;
+}
+
+void
+DecimalSeries::append(Decimal const* p_values, size_t p_count)
+{
+    for (size_t i = 0; i != p_count; ++i)
+    {
+        append(p_values[i]);
+    }
+    return;
+}
+
+size_t
+DecimalSeries::memory_usage() const
+{
+    return
+        sizeof(*this) +
+        m_blocks.capacity() * sizeof(BlockInfo) +
+        m_words.capacity() * sizeof(uint64_t) +
+        m_pending.capacity() * sizeof(int_type);
+}
+
+size_t
+DecimalSeries::decode_block(size_t p_index, int_type* p_intvals) const
+{
+    JEWEL_ASSERT (p_index < block_count());
+    if (p_index == m_blocks.size())
+    {
+        std::copy(m_pending.begin(), m_pending.end(), p_intvals);
+        return m_pending.size();
+    }
+    BlockInfo const& info = m_blocks[p_index];
+    uint64_t const* const words = &m_words[info.word_offset];
+    if (info.is_delta)
+    {
+        decode_delta(words, info.width, info.base, block_size, p_intvals);
+    }
+    else
+    {
+        decode_frame_of_reference
+        (   words,
+            info.width,
+            info.base,
+            block_size,
+            p_intvals
+        );
+    }
+    return block_size;
+}
+
+void
+DecimalSeries::decode
+(   size_t p_first,
+    size_t p_count,
+    Decimal* p_out
+) const
+{
+    JEWEL_ASSERT (p_first <= m_size && p_count <= m_size - p_first);
+    int_type intvals[block_size];
+    size_t const end = p_first + p_count;
+    size_t i = p_first;
+    while (i != end)
+    {
+        size_t const num_decoded = decode_block(i / block_size, intvals);
+        size_t j = i % block_size;
+        size_t const stop = min(num_decoded, j + (end - i));
+        for ( ; j != stop; ++j, ++i, ++p_out)
+        {
+            *p_out = Decimal(intvals[j], m_places);
+        }
+    }
+    return;
+}
+
+Decimal
+DecimalSeries::operator[](size_t p_index) const
+{
+    JEWEL_ASSERT (p_index < m_size);
+    size_t const block_index = p_index / block_size;
+    size_t const position = p_index % block_size;
+    if (block_index == m_blocks.size())
+    {
+        return Decimal(m_pending[position], m_places);
+    }
+    BlockInfo const& info = m_blocks[block_index];
+    uint64_t const* const words = &m_words[info.word_offset];
+    uint64_t x = static_cast<uint64_t>(info.base);
+    if (info.is_delta)
+    {
+        for (size_t i = 1; i <= position; ++i)
+        {
+            x += unzigzag(unpack_bit_field(words, info.width, i));
+        }
+    }
+    else
+    {
+        x += unpack_bit_field(words, info.width, position);
+    }
+    return Decimal(static_cast<int_type>(x), m_places);
+}
+
+void
+DecimalSeries::seal_block()
+{
+    JEWEL_ASSERT (m_pending.size() == block_size);
+
+    // Work out the width needed for each form of the block. The first
+    // delta is always zero, so that the block's base is the first value.
+    uint64_t deltas[block_size];
+    deltas[0] = 0;
+    int_type lowest = m_pending[0];
+    int_type highest = m_pending[0];
+    uint64_t delta_bits = 0;
+    for (size_t i = 1; i != block_size; ++i)
+    {
+        lowest = min(lowest, m_pending[i]);
+        highest = max(highest, m_pending[i]);
+        deltas[i] = zigzag
+        (   static_cast<uint64_t>(m_pending[i]) -
+            static_cast<uint64_t>(m_pending[i - 1])
+        );
+        delta_bits |= deltas[i];
+    }
+    unsigned int const frame_width = bits_required
+    (   static_cast<uint64_t>(highest) - static_cast<uint64_t>(lowest)
+    );
+    unsigned int const delta_width = bits_required(delta_bits);
+
+    BlockInfo info;
+    info.is_delta = (delta_width < frame_width);
+    info.width = (info.is_delta? delta_width: frame_width);
+    info.base = (info.is_delta? m_pending[0]: lowest);
+    if (!info.is_delta)
+    {
+        for (size_t i = 0; i != block_size; ++i)
+        {
+            deltas[i] =
+                static_cast<uint64_t>(m_pending[i]) -
+                static_cast<uint64_t>(lowest);
+        }
+    }
+
+    // The packed block overwrites the padding word at the end of m_words,
+    // and is followed by a fresh one.
+    info.word_offset = m_words.size() - 1;
+    m_blocks.push_back(info);
+    try
+    {
+        m_words.resize
+        (   info.word_offset + packed_word_count(block_size, info.width),
+            0
+        );
+    }
+    catch (...)
+    {
+        m_blocks.pop_back();
+        throw;
+    }
+
+    // Nothing below can throw.
+    pack_bits(deltas, block_size, info.width, 0, &m_words[info.word_offset]);
+    m_pending.clear();
+    return;
+}
+
+}  // namespace jewel
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal_stats.hpp"
+#include "assert.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/helper_macros.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using std::atomic;
+using std::find;
+using std::lock_guard;
+using std::memory_order_relaxed;
+using std::mutex;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef DecimalStats::count_type count_type;
+
+    // The counters of a single thread. Only that thread writes to them,
+    // but DecimalStats::global_snapshot may read them from another thread,
+    // so they are atomic; relaxed loads and stores are enough for that, and
+    // cost no more than plain ones.
+    struct ThreadCounters
+    {
+        atomic<count_type> counts[DecimalStats::num_counters];
+    };
+
+    // The counters of all the threads that are currently counting, and
+    // the totals of those that have exited.
+    struct Registry
+    {
+        Registry()
+        {
+            for (int i = 0; i != DecimalStats::num_counters; ++i)
+            {
+                retired[i].store(0, memory_order_relaxed);
+            }
+        }
+        mutex live_mutex;
+        vector<ThreadCounters*> live;
+        atomic<count_type> retired[DecimalStats::num_counters];
+    };
+
+    Registry& registry()
+    {
+        // Deliberately never destroyed, so that it outlives the
+        // thread-local counters of every thread, including those of the
+        // main thread, which are destroyed during exit.
+        static Registry* const ret = new Registry;
+        return *ret;
+    }
+
+    // Points to the counters of the calling thread, once that thread has
+    // counted something.
+    thread_local ThreadCounters* t_counters = nullptr;
+
+    // True once the calling thread's counters have been retired during
+    // thread exit, after which anything it counts goes straight to the
+    // retired totals.
+    thread_local bool t_exited = false;
+
+    // Registers the counters of the thread that constructs it, and
+    // retires them when the thread exits.
+    class ThreadRegistration
+    {
+    public:
+        ThreadRegistration()
+        {
+            for (int i = 0; i != DecimalStats::num_counters; ++i)
+            {
+                counters.counts[i].store(0, memory_order_relaxed);
+            }
+            Registry& reg = registry();
+            lock_guard<mutex> lock(reg.live_mutex);
+            reg.live.push_back(&counters);
+        }
+        ThreadRegistration(ThreadRegistration const&) = delete;
+        ThreadRegistration& operator=(ThreadRegistration const&) = delete;
+        ~ThreadRegistration()
+        {
+            Registry& reg = registry();
+            lock_guard<mutex> lock(reg.live_mutex);
+            for (int i = 0; i != DecimalStats::num_counters; ++i)
+            {
+                reg.retired[i].fetch_add
+                (   counters.counts[i].load(memory_order_relaxed),
+                    memory_order_relaxed
+                );
+            }
+            auto const it = find(reg.live.begin(), reg.live.end(), &counters);
+            JEWEL_ASSERT (it != reg.live.end());
+            reg.live.erase(it);
+            t_counters = nullptr;
+            t_exited = true;
+        }
+        ThreadCounters counters;
+    };
+
+    // Returns the calling thread's counters, registering them first if
+    // necessary; or returns nullptr if the thread has exited or its
+    // counters could not be registered.
+    ThreadCounters* register_thread() noexcept
+    {
+        if (t_exited)
+        {
+            return nullptr;
+        }
+        try
+        {
+            static thread_local ThreadRegistration registration;
+            return &registration.counters;
+        }
+        catch (...)
+        {
+            return nullptr;
+        }
+    }
+
+}  // end anonymous namespace
+
+
+namespace detail
+{
+
+void decimal_stats_add
+(   DecimalStats::Counter p_counter,
+    DecimalStats::count_type p_n
+) noexcept
+{
+    JEWEL_ASSERT (p_counter >= 0);
+    JEWEL_ASSERT (p_counter < DecimalStats::num_counters);
+    ThreadCounters* counters = t_counters;
+    if (JEWEL_DETAIL_UNLIKELY(counters == nullptr))
+    {
+        counters = t_counters = register_thread();
+        if (counters == nullptr)
+        {
+            registry().retired[p_counter].fetch_add
+            (   p_n,
+                memory_order_relaxed
+            );
+            return;
+        }
+    }
+    atomic<count_type>& counter = counters->counts[p_counter];
+    counter.store
+    (   counter.load(memory_order_relaxed) + p_n,
+        memory_order_relaxed
+    );
+    return;
+}
+
+void decimal_stats_count_exception() noexcept
+{
+    JEWEL_DETAIL_DECIMAL_STATS_ADD(exceptions, 1);
+    return;
+}
+
+}  // namespace detail
+
+
+DecimalStats::DecimalStats()
+{
+    for (int i = 0; i != num_counters; ++i)
+    {
+        m_counts[i] = 0;
+    }
+}
+
+bool
+DecimalStats::enabled()
+{
+#   ifdef JEWEL_DECIMAL_STATS
+        return true;
+#   else
+        return false;
+#   endif
+}
+
+DecimalStats
+DecimalStats::thread_snapshot()
+{
+    DecimalStats ret;
+    if (t_counters != nullptr)
+    {
+        for (int i = 0; i != num_counters; ++i)
+        {
+            ret.m_counts[i] = t_counters->counts[i].load(memory_order_relaxed);
+        }
+    }
+    return ret;
+}
+
+DecimalStats
+DecimalStats::global_snapshot()
+{
+    DecimalStats ret;
+    Registry& reg = registry();
+    lock_guard<mutex> lock(reg.live_mutex);
+    for (int i = 0; i != num_counters; ++i)
+    {
+        ret.m_counts[i] = reg.retired[i].load(memory_order_relaxed);
+        for (ThreadCounters const* counters: reg.live)
+        {
+            ret.m_counts[i] += counters->counts[i].load(memory_order_relaxed);
+        }
+    }
+    return ret;
+}
+
+char const*
+DecimalStats::name(Counter p_counter)
+{
+    switch (p_counter)
+    {
+    case rescales:
+        return "rescales";
+    case rationalize_iterations:
+        return "rationalize_iterations";
+    case co_normalizations:
+        return "co_normalizations";
+    case division_iterations:
+        return "division_iterations";
+    case exceptions:
+        return "exceptions";
+    default:
+        JEWEL_HARD_ASSERT (false);
+        return "";
+    }
+}
+
+DecimalStats&
+DecimalStats::operator+=(DecimalStats const& rhs)
+{
+    for (int i = 0; i != num_counters; ++i)
+    {
+        m_counts[i] += rhs.m_counts[i];
+    }
+    return *this;
+}
+
+DecimalStats&
+DecimalStats::operator-=(DecimalStats const& rhs)
+{
+    for (int i = 0; i != num_counters; ++i)
+    {
+        JEWEL_ASSERT (rhs.m_counts[i] <= m_counts[i]);
+        m_counts[i] -= rhs.m_counts[i];
+    }
+    return *this;
+}
+
+DecimalStats
+operator+(DecimalStats const& lhs, DecimalStats const& rhs)
+{
+    DecimalStats ret(lhs);
+    ret += rhs;
+    return ret;
+}
+
+DecimalStats
+operator-(DecimalStats const& lhs, DecimalStats const& rhs)
+{
+    DecimalStats ret(lhs);
+    ret -= rhs;
+    return ret;
+}
+
+}  // namespace jewel
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "group_by_aggregator.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "exception.hpp"
+#include "detail/decimal_stats_detail.hpp"
+#include "detail/int128.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+using jewel::detail::AggregateWord;
+using jewel::detail::int128_max;
+using jewel::detail::int128_min;
+using jewel::detail::int128_t;
+using jewel::detail::uint128_t;
+using std::max;
+using std::numeric_limits;
+using std::uint64_t;
+
+namespace jewel
+{
+
+namespace
+{
+    int128_t to_int128(AggregateWord const& p_word)
+    {
+        return static_cast<int128_t>
+        (   (static_cast<uint128_t>(p_word.high) << 64) | p_word.low
+        );
+    }
+
+    AggregateWord to_word(int128_t p_value)
+    {
+        AggregateWord ret;
+        ret.high =
+            static_cast<uint64_t>(static_cast<uint128_t>(p_value) >> 64);
+        ret.low = static_cast<uint64_t>(p_value);
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+void
+DecimalAggregate::merge(DecimalAggregate const& p_other)
+{
+    if (p_other.m_count == 0)
+    {
+        return;
+    }
+    if (m_count == 0)
+    {
+        *this = p_other;
+        return;
+    }
+    Decimal::places_type const places = max(m_places, p_other.m_places);
+    DecimalAggregate lhs(*this);
+    DecimalAggregate rhs(p_other);
+    lhs.rescale(places);
+    rhs.rescale(places);
+    if (!detail::add(lhs.m_sum, rhs.m_sum))
+    {
+        JEWEL_DETAIL_DECIMAL_THROW
+        (   DecimalAdditionException,
+            "Unsafe addition."
+        );
+    }
+    if (detail::less(rhs.m_minimum, lhs.m_minimum))
+    {
+        lhs.m_minimum = rhs.m_minimum;
+    }
+    if (detail::less(lhs.m_maximum, rhs.m_maximum))
+    {
+        lhs.m_maximum = rhs.m_maximum;
+    }
+    lhs.m_count += rhs.m_count;
+    *this = lhs;
+    return;
+}
+
+void
+DecimalAggregate::rescale(Decimal::places_type p_places)
+{
+    JEWEL_ASSERT (p_places >= m_places);
+    JEWEL_ASSERT (p_places <= Decimal::maximum_precision());
+    int128_t sum = to_int128(m_sum);
+    int128_t minimum = to_int128(m_minimum);
+    int128_t maximum = to_int128(m_maximum);
+    for (Decimal::places_type places = m_places; places != p_places; ++places)
+    {
+        if (sum > int128_max / 10 || sum < int128_min / 10)
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalAdditionException,
+                "Unsafe addition."
+            );
+        }
+        sum *= 10;
+
+        // The minimum and maximum started out as Decimal::int_type, and
+        // are scaled by at most 10^19, so can't overflow.
+        minimum *= 10;
+        maximum *= 10;
+    }
+    m_sum = to_word(sum);
+    m_minimum = to_word(minimum);
+    m_maximum = to_word(maximum);
+    m_places = p_places;
+    return;
+}
+
+Decimal
+DecimalAggregate::to_decimal
+(   AggregateWord const& p_word,
+    Decimal::places_type p_places
+)
+{
+    int128_t intval = to_int128(p_word);
+    int128_t const highest = numeric_limits<Decimal::int_type>::max();
+    int128_t const lowest = numeric_limits<Decimal::int_type>::min();
+    while (intval > highest || intval < lowest)
+    {
+        // Drop trailing zeros, if this is enough to fit.
+        if (p_places == 0 || intval % 10 != 0)
+        {
+            JEWEL_DETAIL_DECIMAL_THROW
+            (   DecimalAdditionException,
+                "Unsafe addition."
+            );
+        }
+        intval /= 10;
+        --p_places;
+    }
+    return Decimal(static_cast<Decimal::int_type>(intval), p_places);
+}
+
+}  // namespace jewel
@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+
 #include "log.hpp"
+#include "on_windows.hpp"
+#include "to_chars.hpp"
+#include "detail/log_format.hpp"
+#include "detail/log_site.hpp"
 
 // We deliberately do NOT use "jewel/assert.hpp" here,
 // as we might one day want a call the assert to invoke
@@ -22,54 +27,84 @@
 // circularity here.
 #include <cassert>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
 #include <ctime>
-#include <fstream>
-#include <ios>
-#include <iostream>
-#include <iterator>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#ifdef JEWEL_ON_WINDOWS
+#   include <fcntl.h>
+#   include <io.h>
+#   include <sys/stat.h>
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
 
-using std::begin;
-using std::cerr;
-using std::clog;
-using std::cout;
-using std::end;
-using std::endl;
-using std::ios;
-using std::localtime;
-using std::ofstream;
-using std::ostream;
+using std::atomic;
+using std::condition_variable;
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::min;
+using std::mutex;
+using std::shared_ptr;
+using std::size_t;
 using std::strftime;
 using std::string;
+using std::thread;
 using std::time;
 using std::time_t;
 using std::tm;
+using std::unique_lock;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
 
 namespace jewel
 {
 
 namespace
 {
-    // If current date and time can be obtained and formatted
-    // successfully, writes a single field to p_os (a record
-    // should already have been commenced) with this date and time.
-    // Otherwise, does nothing. Does not write a newline at the end.
-    // But does commence with a newline.
-    void write_date_time_now(ostream& p_os)
+    // Returns the current local date and time, in ISO format, or an
+    // empty string if they cannot be obtained and formatted. Could throw
+    // std::bad_alloc.
+    string date_time_now()
     {
         time_t const now = time(0);
         if (now != static_cast<time_t>(-1))
         {
-            // NOTE std::localtime may not be thread-safe. This is
-            // only ONE of the reasons why jewel::Log is not
-            // thread-safe.
-            tm const* const now_local = localtime(&now);
-            if (!now_local)
-            {
-                return;
-            }
-            assert (now_local != 0);
+            // std::localtime returns a pointer to static data, so is not
+            // safe to call from multiple threads; the reentrant
+            // equivalent is used instead.
+            tm now_local;
+#           ifdef JEWEL_ON_WINDOWS
+                if (localtime_s(&now_local, &now) != 0)
+                {
+                    return string();
+                }
+#           else
+                if (!localtime_r(&now, &now_local))
+                {
+                    return string();
+                }
+#           endif
             size_t const date_time_str_len =
                 10 +     // for ISO date format
                 1 +      // for ISO 'T' character separating date & time
@@ -80,197 +115,2645 @@ namespace
             (   date_time_arr,
                 date_time_str_len + 1,
                 format_str,
-                now_local
+                &now_local
             );
             if (check == date_time_str_len)
             {
-                p_os << "\n{F}[date_time_written]"
-                     << date_time_arr;
+                return string(date_time_arr);
             }
         }
-        return;    
+        return string();
+    }
+
+    template <typename Clock>
+    long long microseconds_on()
+    {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        return duration_cast<microseconds>
+        (   Clock::now().time_since_epoch()
+        ).count();
+    }
+
+    // Returns the current time in microseconds since the Unix epoch, as
+    // read from the steady clock, offset to agree with the system clock
+    // as it was when first called.
+    long long microseconds_since_epoch()
+    {
+        using std::chrono::steady_clock;
+        using std::chrono::system_clock;
+        static long long const offset =
+            microseconds_on<system_clock>() - microseconds_on<steady_clock>();
+        return microseconds_on<steady_clock>() + offset;
     }
     
+    atomic<long long> last_id(-1);
+
     long long next_id()
     {
-        static long long ret = -1;
-        return ++ret;
+        return last_id.fetch_add(1, memory_order_relaxed) + 1;
     }
 
-    struct StreamHolder
+    typedef detail::LogRecord Record;
+
+    // Keeps count of the threads that are using an object that is
+    // published through an atomic pointer, so that a thread that has
+    // replaced the pointer can wait until the old object is no longer in
+    // use before destroying it.
+    //
+    // Users are counted under one of two epochs. Waiting for departures
+    // moves new arrivals to the other epoch, and then waits for the users
+    // of the old epoch to depart, so that the wait cannot be prolonged
+    // indefinitely by a steady stream of new arrivals.
+    class ActiveUsers
+    {
+    public:
+        ActiveUsers(): m_epoch(0)
+        {
+            m_counts[0].store(0);
+            m_counts[1].store(0);
+        }
+        ActiveUsers(ActiveUsers const&) = delete;
+        ActiveUsers(ActiveUsers&&) = delete;
+        ActiveUsers& operator=(ActiveUsers const&) = delete;
+        ActiveUsers& operator=(ActiveUsers&&) = delete;
+
+        // Returns the epoch that must be passed to depart().
+        unsigned int arrive()
+        {
+            while (true)
+            {
+                unsigned int const epoch = m_epoch.load();
+                m_counts[epoch].fetch_add(1);
+                if (m_epoch.load() == epoch)
+                {
+                    return epoch;
+                }
+                // Waiting for departures may have begun since epoch was
+                // read, and might miss us; so try again.
+                m_counts[epoch].fetch_sub(1);
+            }
+        }
+
+        void depart(unsigned int p_epoch)
+        {
+            m_counts[p_epoch].fetch_sub(1);
+            return;
+        }
+
+        // Waits until every user that arrived before the call has departed.
+        // Must not be called by more than one thread at a time.
+        void await_departures()
+        {
+            unsigned int const epoch = m_epoch.load();
+            m_epoch.store(1 - epoch);
+            while (m_counts[epoch].load() != 0)
+            {
+                std::this_thread::yield();
+            }
+            return;
+        }
+
+    private:
+        atomic<unsigned int> m_epoch;
+        atomic<long> m_counts[2];
+    };
+
+    // Counts the calling thread as a user of p_users, for the lifetime of
+    // the Visit.
+    class Visit
+    {
+    public:
+        explicit Visit(ActiveUsers& p_users):
+            m_users(p_users),
+            m_epoch(p_users.arrive())
+        {
+        }
+        Visit(Visit const&) = delete;
+        Visit(Visit&&) = delete;
+        Visit& operator=(Visit const&) = delete;
+        Visit& operator=(Visit&&) = delete;
+        ~Visit()
+        {
+            m_users.depart(m_epoch);
+        }
+    private:
+        ActiveUsers& m_users;
+        unsigned int const m_epoch;
+    };
+
+    // A file being logged to. Each write to the file is a single
+    // write to a file opened for appending, so that records written
+    // concurrently by different threads are never interleaved.
+    //
+    // Unless the flush policy is to write every record at once, records
+    // are gathered in a buffer, which is guarded by m_buffer_mutex, and
+    // written to the file when the policy dictates.
+    //
+    // In binary format, the file keeps a table of the sites from which
+    // records have been logged, with each site identified by the addresses
+    // of its strings, which are assumed to be string literals.
+    class LogFile
+    {
+    public:
+        LogFile
+        (   int p_file_descriptor,
+            Log::Format p_format,
+            Log::FlushPolicy const& p_flush_policy
+        );
+        LogFile(LogFile const&) = delete;
+        LogFile(LogFile&&) = delete;
+        LogFile& operator=(LogFile const&) = delete;
+        LogFile& operator=(LogFile&&) = delete;
+        ~LogFile();
+
+        // Returns nullptr if the file could not be opened. If p_filepath
+        // is Log::standard_error_filepath, the LogFile writes to a
+        // duplicate of the file descriptor of standard error. Could throw
+        // std::bad_alloc.
+        static LogFile* open
+        (   string const& p_filepath,
+            Log::Format p_format,
+            Log::FlushPolicy const& p_flush_policy
+        );
+
+        // Appends p_record to p_out, in the format of the file. If
+        // p_record is the first from its site, in binary format, the site
+        // is written directly to the file. Could throw std::bad_alloc.
+        void format_record
+        (   string& p_out,
+            Record const& p_record,
+            long long p_id
+        );
+
+        // Appends a record of the commencement or end of logging to the
+        // file to p_out, in the format of the file. Could throw
+        // std::bad_alloc.
+        void format_event
+        (   string& p_out,
+            detail::LogEvent p_event,
+            long long p_id,
+            string const& p_message
+        );
+
+        // Writes p_text, which comprises p_num_records records of which
+        // the most severe has severity p_severity, to the file or to the
+        // buffer, as the flush policy dictates. Never throws. If an error
+        // occurs, the data is lost.
+        void write
+        (   string const& p_text,
+            size_t p_num_records = 0,
+            Log::Level p_severity = Log::trace
+        );
+
+        // Writes p_text to the file, after anything buffered. Never
+        // throws.
+        void write_and_flush(string const& p_text);
+
+        // Never throws.
+        void flush();
+
+        // Flushes the buffer if the flush policy has a non-zero
+        // milliseconds, and the oldest record in the buffer is at least
+        // that old. Never throws.
+        void flush_if_due();
+
+        // As flush(), but gives up if another thread has the buffer
+        // locked for longer than p_timeout, and does nothing if the
+        // calling thread has it locked. For use when the program is about
+        // to terminate. Never throws.
+        void flush_before_terminating(std::chrono::milliseconds p_timeout);
+
+        // Flushes the buffer, and then sets the policy to be followed
+        // henceforth. Could throw std::bad_alloc.
+        void set_flush_policy(Log::FlushPolicy const& p_flush_policy);
+
+        Log::Format format() const;
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        // Writes straight to the file. Never throws.
+        void write_through(char const* p_data, size_t p_size);
+
+        // Should be called only with m_buffer_mutex held.
+        void flush_buffer();
+
+        bool is_buffering() const;
+
+        struct SiteKey
+        {
+            bool operator==(SiteKey const& rhs) const;
+
+            int line;
+            char const* function;
+            char const* file;
+            char const* compilation_date;
+            char const* compilation_time;
+            char const* exception_type;
+            char const* expression;
+        };
+
+        struct SiteKeyHash
+        {
+            size_t operator()(SiteKey const& p_key) const;
+        };
+
+        // Returns the id of the site of p_record, writing the site to the
+        // file if it is new.
+        unsigned long long site_id(Record const& p_record);
+
+        int const m_file_descriptor;
+        Log::Format const m_format;
+        atomic<bool> m_buffering;
+        mutex m_buffer_mutex;
+        Log::FlushPolicy m_flush_policy;
+        string m_buffer;
+        size_t m_buffered_records;
+        Clock::time_point m_oldest_buffered;
+        mutex m_sites_mutex;
+        unordered_map<SiteKey, unsigned long long, SiteKeyHash> m_sites;
+    };
+
+    // True while the thread holds the buffer of a LogFile locked.
+    thread_local bool t_holding_buffer = false;
+
+    // Holds the buffer of a LogFile locked.
+    class BufferLock
     {
-        explicit StreamHolder(ostream* p_os = nullptr);
-        StreamHolder(StreamHolder const&) = delete;
-        StreamHolder(StreamHolder&&) = delete;
-        StreamHolder& operator=(StreamHolder const&) = delete;
-        StreamHolder& operator=(StreamHolder&&) = delete;
-        ~StreamHolder();
-        
-        void kill();
-        ostream* os;
+    public:
+        explicit BufferLock(mutex& p_mutex): m_lock(p_mutex)
+        {
+            t_holding_buffer = true;
+        }
+        BufferLock(BufferLock const&) = delete;
+        BufferLock(BufferLock&&) = delete;
+        BufferLock& operator=(BufferLock const&) = delete;
+        BufferLock& operator=(BufferLock&&) = delete;
+        ~BufferLock()
+        {
+            t_holding_buffer = false;
+        }
+    private:
+        lock_guard<mutex> m_lock;
     };
 
-    StreamHolder::StreamHolder(ostream* p_os): os(p_os)
+    LogFile::LogFile
+    (   int p_file_descriptor,
+        Log::Format p_format,
+        Log::FlushPolicy const& p_flush_policy
+    ):
+        m_file_descriptor(p_file_descriptor),
+        m_format(p_format),
+        m_buffering(false),
+        m_buffered_records(0)
     {
+        set_flush_policy(p_flush_policy);
     }
 
-    StreamHolder::~StreamHolder()
+    LogFile::~LogFile()
     {
-        kill();
+        flush();
+#       ifdef JEWEL_ON_WINDOWS
+            ::_close(m_file_descriptor);
+#       else
+            ::close(m_file_descriptor);
+#       endif
     }
 
-    void StreamHolder::kill()
+    LogFile*
+    LogFile::open
+    (   string const& p_filepath,
+        Log::Format p_format,
+        Log::FlushPolicy const& p_flush_policy
+    )
     {
-        if (os)
+        bool const is_standard_error =
+            (p_filepath == Log::standard_error_filepath);
+#       ifdef JEWEL_ON_WINDOWS
+            int const file_descriptor = is_standard_error?
+                ::_dup(2):
+                ::_open
+                (   p_filepath.c_str(),
+                    _O_WRONLY | _O_CREAT | _O_TRUNC | _O_APPEND | _O_BINARY,
+                    _S_IREAD | _S_IWRITE
+                );
+#       else
+            int const file_descriptor = is_standard_error?
+                ::dup(2):
+                ::open
+                (   p_filepath.c_str(),
+                    O_WRONLY | O_CREAT | O_TRUNC | O_APPEND,
+                    0666
+                );
+#       endif
+        if (file_descriptor < 0)
         {
-            *os << "{R}\n{F}[id]" << next_id()
-                << "\n{F}[message]End log";
-            write_date_time_now(*os);
-            *os << endl;
-            if ((os != &cerr) && (os != &clog) && (os != &cout))
-            {
-                delete os;
-            }
-            os = nullptr;
+            return nullptr;
+        }
+        unique_ptr<LogFile> ret;
+        try
+        {
+            ret.reset(new LogFile(file_descriptor, p_format, p_flush_policy));
+        }
+        catch (std::bad_alloc&)
+        {
+#           ifdef JEWEL_ON_WINDOWS
+                ::_close(file_descriptor);
+#           else
+                ::close(file_descriptor);
+#           endif
+            throw;
+        }
+        if (p_format == Log::binary)
+        {
+            string header
+            (   detail::log_binary_magic,
+                detail::log_binary_magic_size
+            );
+            header += static_cast<char>(detail::log_binary_version);
+            ret->write(header);
+        }
+        return ret.release();
+    }
+
+    void
+    LogFile::format_record
+    (   string& p_out,
+        Record const& p_record,
+        long long p_id
+    )
+    {
+        if (m_format == Log::text)
+        {
+            detail::append_log_text_record(p_out, p_record, p_id);
+            return;
+        }
+        if (m_format == Log::json)
+        {
+            detail::append_log_json_record(p_out, p_record, p_id);
+            return;
         }
-        assert (nullptr == os);
+        assert (m_format == Log::binary);
+        unsigned long long const site = site_id(p_record);
+        p_out += static_cast<char>(detail::log_binary_record);
+        detail::append_log_varint(p_out, site);
+        detail::append_log_varint(p_out, p_id);
+        detail::append_log_varint
+        (   p_out,
+            static_cast<unsigned long long>(p_record.timestamp)
+        );
+        p_out += static_cast<char>(p_record.severity);
+        detail::append_log_string(p_out, p_record.message);
+        detail::append_log_string(p_out, p_record.value);
         return;
     }
 
-}  // end anonymous namespace
+    void
+    LogFile::format_event
+    (   string& p_out,
+        detail::LogEvent p_event,
+        long long p_id,
+        string const& p_message
+    )
+    {
+        string const date_time = date_time_now();
+        char const* const date_time_ptr =
+            date_time.empty()? nullptr: date_time.c_str();
+        if (m_format == Log::text)
+        {
+            detail::append_log_text_event
+            (   p_out,
+                p_event,
+                p_id,
+                p_message.c_str(),
+                date_time_ptr
+            );
+            return;
+        }
+        if (m_format == Log::json)
+        {
+            detail::append_log_json_event
+            (   p_out,
+                p_id,
+                p_message.c_str(),
+                date_time_ptr
+            );
+            return;
+        }
+        assert (m_format == Log::binary);
+        p_out += static_cast<char>(detail::log_binary_event);
+        p_out += static_cast<char>(p_event);
+        detail::append_log_varint(p_out, p_id);
+        detail::append_log_string(p_out, p_message.c_str());
+        detail::append_log_string(p_out, date_time_ptr);
+        return;
+    }
 
-void
-Log::set_filepath(string const& p_filepath)
-{
-    static string filepath = "";
-    if (p_filepath != filepath)
+    unsigned long long
+    LogFile::site_id(Record const& p_record)
     {
-        filepath = p_filepath;
-        if (!filepath.empty())
+        SiteKey const key =
+        {   p_record.line,
+            p_record.function,
+            p_record.file,
+            p_record.compilation_date,
+            p_record.compilation_time,
+            p_record.exception_type,
+            p_record.expression
+        };
+        lock_guard<mutex> const lock(m_sites_mutex);
+        auto const it = m_sites.find(key);
+        if (it != m_sites.end())
+        {
+            return it->second;
+        }
+        unsigned long long const ret = m_sites.size();
+        string site;
+        site += static_cast<char>(detail::log_binary_site);
+        detail::append_log_varint(site, ret);
+        detail::append_log_varint(site, detail::log_zigzag_encode(key.line));
+        detail::append_log_string(site, key.function);
+        detail::append_log_string(site, key.file);
+        detail::append_log_string(site, key.compilation_date);
+        detail::append_log_string(site, key.compilation_time);
+        detail::append_log_string(site, key.exception_type);
+        detail::append_log_string(site, key.expression);
+        m_sites.insert(std::make_pair(key, ret));
+
+        // The site is written while the lock is held, so that no other
+        // thread can write a record referring to it until it has been
+        // written.
+        write(site);
+        return ret;
+    }
+
+    bool
+    LogFile::SiteKey::operator==(SiteKey const& rhs) const
+    {
+        return
+            (line == rhs.line) &&
+            (function == rhs.function) &&
+            (file == rhs.file) &&
+            (compilation_date == rhs.compilation_date) &&
+            (compilation_time == rhs.compilation_time) &&
+            (exception_type == rhs.exception_type) &&
+            (expression == rhs.expression);
+    }
+
+    size_t
+    LogFile::SiteKeyHash::operator()(SiteKey const& p_key) const
+    {
+        std::hash<char const*> const hasher;
+        size_t ret = static_cast<size_t>(p_key.line);
+        char const* const strings[] =
+        {   p_key.function,
+            p_key.file,
+            p_key.compilation_date,
+            p_key.compilation_time,
+            p_key.exception_type,
+            p_key.expression
+        };
+        for (char const* string: strings)
+        {
+            ret = ret * 31 + hasher(string);
+        }
+        return ret;
+    }
+
+    void
+    LogFile::write
+    (   string const& p_text,
+        size_t p_num_records,
+        Log::Level p_severity
+    )
+    {
+        if (!is_buffering())
+        {
+            write_through(p_text.data(), p_text.size());
+            return;
+        }
+        BufferLock const lock(m_buffer_mutex);
+        if (!is_buffering())
+        {
+            // The policy was changed since we checked.
+            write_through(p_text.data(), p_text.size());
+            return;
+        }
+        if (m_buffer.size() + p_text.size() > m_buffer.capacity())
         {
-            ofstream* f = new ofstream(filepath.c_str());
-            f->exceptions(ios::iostate(0));
-            stream_aux(f);
-            ostream* const osp = stream_aux();
-            if (osp)
+            flush_buffer();
+            if (p_text.size() > m_buffer.capacity())
             {
-                *osp << "{R}\n{F}[id]" << next_id() << "\n{F}[message]"
-                     << "Commenced logging to " << filepath << ".";
-                write_date_time_now(*osp);
-                *osp << '\n' << endl;
+                write_through(p_text.data(), p_text.size());
+                return;
             }
         }
+        if (m_buffer.empty() && (m_flush_policy.milliseconds != 0))
+        {
+            m_oldest_buffered = Clock::now();
+        }
+        m_buffer += p_text;  // Does not allocate, as there is room.
+        m_buffered_records += p_num_records;
+        if
+        (   (p_num_records != 0) &&
+            (   (p_severity >= m_flush_policy.severity) ||
+                (   (m_flush_policy.records != 0) &&
+                    (m_buffered_records >= m_flush_policy.records)
+                ) ||
+                (   (m_flush_policy.bytes != 0) &&
+                    (m_buffer.size() >= m_flush_policy.bytes)
+                ) ||
+                (   (m_flush_policy.milliseconds != 0) &&
+                    (   Clock::now() - m_oldest_buffered >=
+                        std::chrono::milliseconds(m_flush_policy.milliseconds)
+                    )
+                )
+            )
+        )
+        {
+            flush_buffer();
+        }
+        return;
     }
-    return;
-}
 
-void
-Log::set_threshold(Level p_level)
-{
-    threshold_aux() = p_level;
-    return;
-}
+    void
+    LogFile::write_and_flush(string const& p_text)
+    {
+        BufferLock const lock(m_buffer_mutex);
+        flush_buffer();
+        write_through(p_text.data(), p_text.size());
+        return;
+    }
 
-void
-Log::log
-(   Level p_severity,
-    char const* p_message,
-    char const* p_function,
-    char const* p_file,
-    int p_line,
-    char const* p_compilation_date,
-    char const* p_compilation_time,
-    char const* p_exception_type,
-    char const* p_expression,
-    char const* p_value
-)
-{
-    if (p_severity >= threshold_aux())
+    void
+    LogFile::flush()
+    {
+        BufferLock const lock(m_buffer_mutex);
+        flush_buffer();
+        return;
+    }
+
+    void
+    LogFile::flush_if_due()
+    {
+        BufferLock const lock(m_buffer_mutex);
+        std::chrono::milliseconds const age(m_flush_policy.milliseconds);
+        if
+        (   (age.count() != 0) &&
+            !m_buffer.empty() &&
+            (Clock::now() - m_oldest_buffered >= age)
+        )
+        {
+            flush_buffer();
+        }
+        return;
+    }
+
+    void
+    LogFile::flush_before_terminating(std::chrono::milliseconds p_timeout)
     {
-        ostream* const osp = stream_aux();
-        if (!osp)
+        if (t_holding_buffer)
         {
             return;
         }
-        assert (!osp->bad());  // guaranteed by stream_aux().
-        assert (!osp->exceptions());  // guaranteed by stream_aux().
-        *osp << "{R}\n"
-             << "{F}[id]" << next_id() << '\n'
-             << "{F}[severity]" << severity_string(p_severity) << '\n';
-        if (p_message)
+        Clock::time_point const deadline = Clock::now() + p_timeout;
+        while (!m_buffer_mutex.try_lock())
+        {
+            if (Clock::now() >= deadline)
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        flush_buffer();
+        m_buffer_mutex.unlock();
+        return;
+    }
+
+    void
+    LogFile::set_flush_policy(Log::FlushPolicy const& p_flush_policy)
+    {
+        BufferLock const lock(m_buffer_mutex);
+        flush_buffer();
+        bool const buffering = (p_flush_policy.records != 1);
+        if (buffering)
         {
-            *osp << "{F}[message]" << p_message << '\n';
+            // Reserve the whole buffer now, so that appending to it never
+            // allocates.
+            string buffer;
+            buffer.reserve(p_flush_policy.buffer_size);
+            m_buffer.swap(buffer);
         }
-        *osp << "{F}[function]" << p_function << '\n'
-             << "{F}[file]" << p_file << '\n'
-             << "{F}[line]" << p_line << '\n';
-        if (p_compilation_date)
+        else
         {
-            *osp << "{F}[compilation_date]" << p_compilation_date << '\n';
+            string().swap(m_buffer);
         }
-        if (p_compilation_time)
+        m_flush_policy = p_flush_policy;
+        m_buffering.store(buffering, memory_order_relaxed);
+        return;
+    }
+
+    void
+    LogFile::write_through(char const* p_data, size_t p_size)
+    {
+        // A write to a regular file is normally written in full. We
+        // loop to handle interruption by signals and the (unlikely)
+        // event of a partial write. A write of nothing is treated as an
+        // error, as retrying it could loop forever.
+        while (p_size != 0)
         {
-            *osp << "{F}[compilation_time]" << p_compilation_time << '\n';
+#           ifdef JEWEL_ON_WINDOWS
+                unsigned int const chunk = static_cast<unsigned int>
+                (   min<size_t>(p_size, INT_MAX)
+                );
+                int const written =
+                    ::_write(m_file_descriptor, p_data, chunk);
+#           else
+                ssize_t const written =
+                    ::write(m_file_descriptor, p_data, p_size);
+#           endif
+            if (written <= 0)
+            {
+                if ((written < 0) && (errno == EINTR))
+                {
+                    continue;
+                }
+                return;
+            }
+            p_data += written;
+            p_size -= static_cast<size_t>(written);
         }
-        if (p_exception_type)
+        return;
+    }
+
+    void
+    LogFile::flush_buffer()
+    {
+        write_through(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+        m_buffered_records = 0;
+        return;
+    }
+
+    Log::Format
+    LogFile::format() const
+    {
+        return m_format;
+    }
+
+    bool
+    LogFile::is_buffering() const
+    {
+        return m_buffering.load(memory_order_relaxed);
+    }
+
+    // SINKS
+
+    // An integer that is greater than any Log::Level, used as the
+    // threshold of a facility that is switched off.
+    int const no_threshold = INT_MAX;
+
+    // The threshold of the file set by Log::set_filepath, the lowest of
+    // the thresholds of the files added by Log::add_sink, and those of
+    // the flight recorder. The threshold returned by Log::threshold_aux,
+    // which the logging macros check before calling Log::log, is the
+    // lowest of file_threshold, sink_threshold, recorder_threshold and
+    // recorder_dump_severity.
+    atomic<int> file_threshold(Log::info);
+    atomic<int> sink_threshold(no_threshold);
+    atomic<int> recorder_threshold(no_threshold);
+    atomic<int> recorder_dump_severity(no_threshold);
+
+    // Sets p_lowest, which is the threshold returned by
+    // Log::threshold_aux, to the lowest of file_threshold, sink_threshold,
+    // recorder_threshold and recorder_dump_severity. Should be called
+    // after any of them is changed. Never throws.
+    void update_lowest_threshold(atomic<Log::Level>& p_lowest)
+    {
+        // If another thread changes a threshold after we have read it,
+        // then either it will store the new lowest threshold after we
+        // have stored ours, or we will notice the change and try again.
+        while (true)
         {
-            *osp << "{F}[exception_type]" << p_exception_type << '\n';
+            int const file = file_threshold.load();
+            int const sink = sink_threshold.load();
+            int const recorder = recorder_threshold.load();
+            int const dump = recorder_dump_severity.load();
+            int const lowest = min(min(file, sink), min(recorder, dump));
+            if (lowest != no_threshold)
+            {
+                p_lowest.store
+                (   static_cast<Log::Level>(lowest),
+                    memory_order_relaxed
+                );
+            }
+            if
+            (   (file_threshold.load() == file) &&
+                (sink_threshold.load() == sink) &&
+                (recorder_threshold.load() == recorder) &&
+                (recorder_dump_severity.load() == dump)
+            )
+            {
+                return;
+            }
         }
-        if (p_expression)
+    }
+
+    // A file being logged to, with the threshold that records must pass
+    // to be written to it.
+    struct Sink
+    {
+        // Never throws.
+        bool passes_threshold(Log::Level p_severity) const;
+
+        // True for the file set by Log::set_filepath, the threshold of
+        // which is file_threshold; false for a file added by
+        // Log::add_sink, the threshold and flush policy of which are
+        // those below.
+        bool is_main;
+        string filepath;
+        Log::Level threshold;
+        Log::FlushPolicy flush_policy;
+        shared_ptr<LogFile> file;
+    };
+
+    bool
+    Sink::passes_threshold(Log::Level p_severity) const
+    {
+        if (is_main)
         {
-            *osp << "{F}[expression]" << p_expression << '\n';
+            return p_severity >= file_threshold.load(memory_order_relaxed);
         }
-        if (p_value)
+        return p_severity >= threshold;
+    }
+
+    // The files being logged to. A SinkSet is never changed once it has
+    // been published in sinks; instead, a new SinkSet is published in its
+    // place, so that threads can find the files to log to without
+    // locking. Threads count themselves in sink_users while using the
+    // files, so that neither the SinkSet nor its files are destroyed
+    // while in use.
+    typedef vector<Sink> SinkSet;
+    atomic<SinkSet const*> sinks(nullptr);
+    ActiveUsers sink_users;
+
+    // Returns the file set by Log::set_filepath in p_sinks, which may be
+    // nullptr, or nullptr if there is none.
+    LogFile* main_file(SinkSet const* p_sinks)
+    {
+        if (p_sinks)
         {
-            *osp << "{F}[value]" << p_value << '\n';
+            for (auto const& sink: *p_sinks)
+            {
+                if (sink.is_main)
+                {
+                    return sink.file.get();
+                }
+            }
         }
-        *osp << endl;
+        return nullptr;
     }
-    return;
-}
 
+    // The number of values of Log::Format.
+    size_t const num_formats = 3;
 
-char const*
-Log::severity_string(Level p_level)
-{
-    static char const* strings[] =
-    {   "trace",
-        "info",
-        "warning",
-        "error"
+    // A record, formatted for each of the files to which it is written.
+    // The record is given an id, and formatted in each format, only when
+    // first required; and it is formatted at most once in each format,
+    // except Log::binary, in which each file has a table of sites of its
+    // own, so that the record must be formatted afresh for each file.
+    class FormattedRecord
+    {
+    public:
+        // p_buffers is an array of num_formats strings, in which the
+        // formatted record is kept.
+        FormattedRecord(Record const& p_record, string* p_buffers);
+        FormattedRecord(FormattedRecord const&) = delete;
+        FormattedRecord(FormattedRecord&&) = delete;
+        FormattedRecord& operator=(FormattedRecord const&) = delete;
+        FormattedRecord& operator=(FormattedRecord&&) = delete;
+        ~FormattedRecord() = default;
+
+        // Returns the record formatted for p_file. Could throw
+        // std::bad_alloc.
+        string const& for_file(LogFile& p_file);
+
+    private:
+        Record const& m_record;
+        string* const m_buffers;
+        long long m_id;  // -1 until first required
+        bool m_is_formatted[num_formats];
     };
-    if (p_level >= (end(strings) - begin(strings)))
+
+    FormattedRecord::FormattedRecord
+    (   Record const& p_record,
+        string* p_buffers
+    ):
+        m_record(p_record),
+        m_buffers(p_buffers),
+        m_id(-1)
     {
-        return "unrecognized";
+        std::fill(m_is_formatted, m_is_formatted + num_formats, false);
     }
-    return strings[p_level];
-}
 
-std::ostream*
-Log::stream_aux(std::ostream* p_stream)
-{
-    static StreamHolder holder;
+    string const&
+    FormattedRecord::for_file(LogFile& p_file)
+    {
+        Log::Format const format = p_file.format();
+        string& buffer = m_buffers[format];
+        if ((format == Log::binary) || !m_is_formatted[format])
+        {
+            if (m_id < 0)
+            {
+                m_id = next_id();
+            }
+            buffer.clear();
+            p_file.format_record(buffer, m_record, m_id);
+            m_is_formatted[format] = true;
+        }
+        return buffer;
+    }
 
-    if (p_stream != nullptr)
+    // Writes p_record to each file whose threshold it passes, formatting
+    // it in p_buffers, an array of num_formats strings. Never throws.
+    void write_to_sinks(Record const& p_record, string* p_buffers)
     {
-        // Then set the stream.
-        holder.kill();    
-        holder.os = p_stream;
+        Visit const visit(sink_users);
+        SinkSet const* const set = sinks.load();
+        if (set)
+        {
+            FormattedRecord formatted(p_record, p_buffers);
+            for (auto const& sink: *set)
+            {
+                if (sink.passes_threshold(p_record.severity))
+                {
+                    try
+                    {
+                        sink.file->write
+                        (   formatted.for_file(*sink.file),
+                            1,
+                            p_record.severity
+                        );
+                    }
+                    catch (std::bad_alloc&)
+                    {
+                    }
+                }
+            }
+        }
+        return;
     }
 
-    // Make sure the stream isn't in a bad state.
-    if (holder.os && holder.os->bad())
+    // Held while the configuration of the Log is changed, e.g. by
+    // Log::set_filepath, Log::add_sink and Log::set_asynchronous.
+    mutex configuration_mutex;
+
+    // Each thread formats its records in buffers of its own, one per
+    // format, which are reused from one record to the next, to avoid
+    // allocating on every call.
+    thread_local bool t_buffers_destroyed = false;
+
+    struct ThreadBuffers
     {
-        holder.kill();
-        assert (nullptr == holder.os);
+        ~ThreadBuffers()
+        {
+            t_buffers_destroyed = true;
+        }
+        string texts[num_formats];
+    };
+
+    // Returns an array of num_formats strings, or nullptr if called
+    // during or after the destruction of the thread's thread-local
+    // objects.
+    string* thread_buffers()
+    {
+        if (t_buffers_destroyed)
+        {
+            return nullptr;
+        }
+        static thread_local ThreadBuffers buffers;
+        return buffers.texts;
     }
 
-    assert
-    (   (nullptr == holder.os) ||
-        (!holder.os->bad() && !holder.os->exceptions())
-    );
 
-    return holder.os;
+    // STORED RECORDS
+
+    // A copy of a record that can be kept after Log::log has returned.
+    // The strings that are the same for every record from a site are
+    // literals, so only the pointers to them are copied; but the message
+    // and value are copied into the StoredRecord, and truncated if they
+    // are longer than the capacities below (including the terminating
+    // null character).
+    struct StoredRecord
+    {
+        static size_t const message_capacity = 256;
+        static size_t const value_capacity = 128;
+
+        StoredRecord() = default;
+
+        // The copy refers to its own copies of the message and value.
+        StoredRecord(StoredRecord const& rhs);
+        StoredRecord& operator=(StoredRecord const& rhs);
+
+        // Never throws.
+        void store(Record const& p_record);
+
+        Record record;
+        char message[message_capacity];
+        char value[value_capacity];
+    };
+
+    // Copies p_text, which may be nullptr, into p_buffer, truncating it
+    // if necessary, and returns p_buffer, or nullptr if p_text is nullptr.
+    char const* copy_text
+    (   char const* p_text,
+        char* p_buffer,
+        size_t p_capacity
+    )
+    {
+        if (!p_text)
+        {
+            return nullptr;
+        }
+        size_t i = 0;
+        for ( ; (i != p_capacity - 1) && (p_text[i] != '\0'); ++i)
+        {
+            p_buffer[i] = p_text[i];
+        }
+        p_buffer[i] = '\0';
+        return p_buffer;
+    }
+
+    StoredRecord::StoredRecord(StoredRecord const& rhs)
+    {
+        store(rhs.record);
+    }
+
+    StoredRecord&
+    StoredRecord::operator=(StoredRecord const& rhs)
+    {
+        if (this != &rhs)
+        {
+            store(rhs.record);
+        }
+        return *this;
+    }
+
+    void
+    StoredRecord::store(Record const& p_record)
+    {
+        record = p_record;
+        record.message =
+            copy_text(p_record.message, message, message_capacity);
+        record.value = copy_text(p_record.value, value, value_capacity);
+        return;
+    }
+
+
+    // ASYNCHRONOUS LOGGING
+
+    // The number of records discarded because the queue was full, over
+    // the life of the program.
+    atomic<unsigned long long> total_dropped(0);
+
+    /*
+     * Holds records in a bounded queue, into which any number of threads may
+     * push records without locking, and from which a single background
+     * thread pops them, formats them in batches and writes them to the
+     * files.
+     *
+     * The queue is the bounded queue described by Dmitry Vyukov, in which
+     * each cell has a sequence number that tells producers and the
+     * consumer whether the cell is free or full. Producers claim a cell by
+     * incrementing m_enqueue_position with compare-and-swap, and then
+     * publish the record by updating the sequence number of the cell.
+     */
+    class AsyncWriter
+    {
+    public:
+        AsyncWriter(size_t p_capacity, Log::QueueFullPolicy p_policy);
+        AsyncWriter(AsyncWriter const&) = delete;
+        AsyncWriter(AsyncWriter&&) = delete;
+        AsyncWriter& operator=(AsyncWriter const&) = delete;
+        AsyncWriter& operator=(AsyncWriter&&) = delete;
+
+        // Stops the writer thread, after it has written every record in
+        // the queue.
+        ~AsyncWriter();
+
+        // Never throws.
+        void push(Record const& p_record);
+
+        // Waits until every record pushed before the call has been
+        // written. Does nothing if called from the writer thread.
+        void drain();
+
+        // As drain(), but gives up after p_timeout. Returns true if the
+        // records were written.
+        bool drain_for(std::chrono::milliseconds p_timeout);
+
+    private:
+
+        // The maximum number of records formatted and then written
+        // together.
+        static size_t const batch_size = 256;
+
+        struct Cell
+        {
+            atomic<size_t> sequence;
+            StoredRecord stored;
+        };
+
+        // The text to be written to one of the files, with the number of
+        // records in it, and the highest of their severities.
+        struct Batch
+        {
+            string text;
+            size_t num_records;
+            Log::Level severity;
+        };
+
+        bool try_push(Record const& p_record);
+        bool is_empty() const;
+        void wake();
+        void run();
+
+        // Pops records, and formats each in m_batches for each of
+        // p_sinks whose threshold it passes. p_sinks may be nullptr, in
+        // which case the records are discarded. Returns the number of
+        // records popped.
+        size_t pop_batch(SinkSet const* p_sinks);
+
+        // Appends a warning, to the batch of every file, that p_dropped
+        // records were dropped. Could throw std::bad_alloc.
+        void append_dropped_warning
+        (   SinkSet const& p_sinks,
+            unsigned long long p_dropped
+        );
+
+        // Rounds p_capacity up to a power of two, so that a position in
+        // the queue can be mapped to a cell by masking.
+        static size_t queue_capacity(size_t p_capacity);
+
+        Log::QueueFullPolicy const m_policy;
+        size_t const m_mask;
+        unique_ptr<Cell[]> m_cells;
+        atomic<size_t> m_enqueue_position;
+        size_t m_dequeue_position;  // Used only by the writer thread
+        atomic<size_t> m_written;
+        atomic<unsigned long long> m_dropped;
+        unsigned long long m_dropped_reported;  // Only by writer thread
+
+        // Used only by the writer thread. The batches correspond to the
+        // sinks in the SinkSet in use.
+        vector<Batch> m_batches;
+        string m_formatted[num_formats];
+
+        atomic<bool> m_stopping;
+        atomic<bool> m_sleeping;
+        mutex m_wake_mutex;
+        condition_variable m_wake_condition;
+        thread m_thread;
+    };
+
+    AsyncWriter::AsyncWriter
+    (   size_t p_capacity,
+        Log::QueueFullPolicy p_policy
+    ):
+        m_policy(p_policy),
+        m_mask(queue_capacity(p_capacity) - 1),
+        m_enqueue_position(0),
+        m_dequeue_position(0),
+        m_written(0),
+        m_dropped(0),
+        m_dropped_reported(0),
+        m_stopping(false),
+        m_sleeping(false)
+    {
+        size_t const capacity = m_mask + 1;
+        m_cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i != capacity; ++i)
+        {
+            m_cells[i].sequence.store(i, memory_order_relaxed);
+        }
+        m_thread = thread(&AsyncWriter::run, this);
+    }
+
+    AsyncWriter::~AsyncWriter()
+    {
+        m_stopping.store(true);
+        wake();
+        m_thread.join();
+    }
+
+    void
+    AsyncWriter::push(Record const& p_record)
+    {
+        while (!try_push(p_record))
+        {
+            switch (m_policy)
+            {
+            case Log::block:
+                wake();
+                std::this_thread::yield();
+                break;
+            case Log::drop:
+            case Log::drop_and_count:
+                m_dropped.fetch_add(1, memory_order_relaxed);
+                total_dropped.fetch_add(1, memory_order_relaxed);
+                return;
+            default:
+                assert (false);
+                return;
+            }
+        }
+        if (m_sleeping.load())
+        {
+            wake();
+        }
+        return;
+    }
+
+    void
+    AsyncWriter::drain()
+    {
+        if (std::this_thread::get_id() == m_thread.get_id())
+        {
+            return;
+        }
+        size_t const target = m_enqueue_position.load();
+        while (m_written.load(memory_order_acquire) < target)
+        {
+            wake();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return;
+    }
+
+    bool
+    AsyncWriter::drain_for(std::chrono::milliseconds p_timeout)
+    {
+        if (std::this_thread::get_id() == m_thread.get_id())
+        {
+            return false;
+        }
+        auto const deadline = std::chrono::steady_clock::now() + p_timeout;
+        size_t const target = m_enqueue_position.load();
+        while (m_written.load(memory_order_acquire) < target)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            wake();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+    }
+
+    bool
+    AsyncWriter::try_push(Record const& p_record)
+    {
+        Cell* cell = nullptr;
+        size_t position = m_enqueue_position.load(memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[position & m_mask];
+            size_t const sequence = cell->sequence.load(memory_order_acquire);
+            std::ptrdiff_t const difference =
+                static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0)
+            {
+                if
+                (   m_enqueue_position.compare_exchange_weak
+                    (   position,
+                        position + 1,
+                        memory_order_relaxed
+                    )
+                )
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;  // The queue is full.
+            }
+            else
+            {
+                position = m_enqueue_position.load(memory_order_relaxed);
+            }
+        }
+        cell->stored.store(p_record);
+        cell->sequence.store(position + 1, memory_order_release);
+        return true;
+    }
+
+    bool
+    AsyncWriter::is_empty() const
+    {
+        Cell const& cell = m_cells[m_dequeue_position & m_mask];
+        return
+            cell.sequence.load(memory_order_acquire) != m_dequeue_position + 1;
+    }
+
+    void
+    AsyncWriter::wake()
+    {
+        lock_guard<mutex> lock(m_wake_mutex);
+        m_wake_condition.notify_one();
+        return;
+    }
+
+    void
+    AsyncWriter::run()
+    {
+        while (true)
+        {
+            size_t popped = 0;
+            {
+                Visit const visit(sink_users);
+                SinkSet const* const set = sinks.load();
+                popped = pop_batch(set);
+                for (size_t i = 0; i != m_batches.size(); ++i)
+                {
+                    Batch const& batch = m_batches[i];
+                    if (!batch.text.empty())
+                    {
+                        (*set)[i].file->write
+                        (   batch.text,
+                            batch.num_records,
+                            batch.severity
+                        );
+                    }
+                }
+            }
+            if (popped != 0)
+            {
+                m_written.fetch_add(popped, memory_order_release);
+                continue;
+            }
+            if (m_stopping.load())
+            {
+                return;
+            }
+            // Sleep until woken by a producer. The timeout guards against
+            // a wake-up being missed by a producer that saw m_sleeping
+            // as false just before it was set.
+            unique_lock<mutex> lock(m_wake_mutex);
+            m_sleeping.store(true);
+            if (is_empty() && !m_stopping.load())
+            {
+                m_wake_condition.wait_for(lock, std::chrono::milliseconds(10));
+            }
+            m_sleeping.store(false);
+        }
+    }
+
+    size_t
+    AsyncWriter::pop_batch(SinkSet const* p_sinks)
+    {
+        try
+        {
+            m_batches.resize(p_sinks? p_sinks->size(): 0);
+        }
+        catch (std::bad_alloc&)
+        {
+            // The records popped are lost.
+            m_batches.clear();
+            p_sinks = nullptr;
+        }
+        for (auto& batch: m_batches)
+        {
+            batch.text.clear();
+            batch.num_records = 0;
+            batch.severity = Log::trace;
+        }
+        size_t ret = 0;
+        for ( ; (ret != batch_size) && !is_empty(); ++ret)
+        {
+            Cell& cell = m_cells[m_dequeue_position & m_mask];
+            Record const& record = cell.stored.record;
+            FormattedRecord formatted(record, m_formatted);
+            for (size_t i = 0; i != m_batches.size(); ++i)
+            {
+                Sink const& sink = (*p_sinks)[i];
+                if (!sink.passes_threshold(record.severity))
+                {
+                    continue;
+                }
+                Batch& batch = m_batches[i];
+                try
+                {
+                    batch.text += formatted.for_file(*sink.file);
+                    ++batch.num_records;
+                    if (record.severity > batch.severity)
+                    {
+                        batch.severity = record.severity;
+                    }
+                }
+                catch (std::bad_alloc&)
+                {
+                    // The record is lost, for this file.
+                }
+            }
+            cell.sequence.store
+            (   m_dequeue_position + m_mask + 1,
+                memory_order_release
+            );
+            ++m_dequeue_position;
+        }
+        unsigned long long const dropped = m_dropped.load();
+        if
+        (   !m_batches.empty() &&
+            (m_policy == Log::drop_and_count) &&
+            (dropped != m_dropped_reported)
+        )
+        {
+            try
+            {
+                append_dropped_warning
+                (   *p_sinks,
+                    dropped - m_dropped_reported
+                );
+                m_dropped_reported = dropped;
+            }
+            catch (std::bad_alloc&)
+            {
+                // Try again with the next batch.
+            }
+        }
+        return ret;
+    }
+
+    void
+    AsyncWriter::append_dropped_warning
+    (   SinkSet const& p_sinks,
+        unsigned long long p_dropped
+    )
+    {
+        char buffer[max_numeric_chars];
+        char* const last =
+            to_chars(buffer, buffer + sizeof(buffer) - 1, p_dropped);
+        *last = '\0';
+        string const message =
+            string(buffer) + " log records were dropped, as the "
+            "asynchronous logging queue was full.";
+        Record record = Record();
+        record.timestamp = microseconds_since_epoch();
+        record.severity = Log::warning;
+        record.message = message.c_str();
+        record.function = __func__;
+        record.file = __FILE__;
+        record.line = __LINE__;
+
+        // The warning is written to every file, whatever its threshold.
+        FormattedRecord formatted(record, m_formatted);
+        for (size_t i = 0; i != m_batches.size(); ++i)
+        {
+            Batch& batch = m_batches[i];
+            batch.text += formatted.for_file(*p_sinks[i].file);
+            ++batch.num_records;
+            if (record.severity > batch.severity)
+            {
+                batch.severity = record.severity;
+            }
+        }
+        return;
+    }
+
+    size_t
+    AsyncWriter::queue_capacity(size_t p_capacity)
+    {
+        size_t ret = 2;
+        while (ret < p_capacity)
+        {
+            ret *= 2;
+        }
+        return ret;
+    }
+
+    // The writer currently in use, if logging is asynchronous. Log::log
+    // counts itself in async_writer_users while using it, so that it is
+    // not destroyed while still in use.
+    atomic<AsyncWriter*> async_writer(nullptr);
+    ActiveUsers async_writer_users;
+
+    // Returns true if p_record was passed to the asynchronous writer.
+    bool push_asynchronously(Record const& p_record)
+    {
+        Visit const visit(async_writer_users);
+        AsyncWriter* const writer = async_writer.load();
+        if (writer)
+        {
+            writer->push(p_record);
+        }
+        return writer != nullptr;
+    }
+
+    void drain_asynchronous_writer()
+    {
+        AsyncWriter* const writer = async_writer.load();
+        if (writer)
+        {
+            writer->drain();
+        }
+        return;
+    }
+
+    void stop_asynchronous_writer()
+    {
+        AsyncWriter* const writer = async_writer.exchange(nullptr);
+        if (writer)
+        {
+            async_writer_users.await_departures();
+            delete writer;
+        }
+        return;
+    }
+
+
+    // FLUSHING
+
+    // The flush policy for files set subsequently by Log::set_filepath.
+    // Guarded by configuration_mutex.
+    Log::FlushPolicy& flush_policy()
+    {
+        static Log::FlushPolicy ret;
+        return ret;
+    }
+
+    // Runs a thread that flushes the buffer of each file being logged to
+    // whenever the oldest record in it is older than the flush policy of
+    // the file allows. The thread checks often enough for a policy with
+    // a given number of milliseconds, and for any with more.
+    class PeriodicFlusher
+    {
+    public:
+        explicit PeriodicFlusher(unsigned int p_milliseconds);
+        PeriodicFlusher(PeriodicFlusher const&) = delete;
+        PeriodicFlusher(PeriodicFlusher&&) = delete;
+        PeriodicFlusher& operator=(PeriodicFlusher const&) = delete;
+        PeriodicFlusher& operator=(PeriodicFlusher&&) = delete;
+        ~PeriodicFlusher();
+
+        unsigned int milliseconds() const;
+
+    private:
+        void run();
+
+        unsigned int const m_milliseconds;
+        bool m_stopping;
+        mutex m_mutex;
+        condition_variable m_condition;
+        thread m_thread;
+    };
+
+    PeriodicFlusher::PeriodicFlusher(unsigned int p_milliseconds):
+        m_milliseconds(p_milliseconds),
+        m_stopping(false)
+    {
+        m_thread = thread(&PeriodicFlusher::run, this);
+    }
+
+    PeriodicFlusher::~PeriodicFlusher()
+    {
+        {
+            lock_guard<mutex> const lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+    }
+
+    unsigned int
+    PeriodicFlusher::milliseconds() const
+    {
+        return m_milliseconds;
+    }
+
+    void
+    PeriodicFlusher::run()
+    {
+        // Checking twice per period means that no record waits much
+        // longer than the period to be written.
+        std::chrono::milliseconds const interval = std::max
+        (   std::chrono::milliseconds(m_milliseconds / 2),
+            std::chrono::milliseconds(1)
+        );
+        unique_lock<mutex> lock(m_mutex);
+        while (!m_stopping)
+        {
+            m_condition.wait_for(lock, interval);
+            Visit const visit(sink_users);
+            SinkSet const* const set = sinks.load();
+            if (set)
+            {
+                for (auto const& sink: *set)
+                {
+                    sink.file->flush_if_due();
+                }
+            }
+        }
+        return;
+    }
+
+    // Guarded by configuration_mutex.
+    unique_ptr<PeriodicFlusher>& periodic_flusher()
+    {
+        static unique_ptr<PeriodicFlusher> ret;
+        return ret;
+    }
+
+    // Starts the periodic flusher, or starts it afresh, if it does not
+    // check often enough for the flush policies of the files in p_sinks
+    // (which may be nullptr) and of files set subsequently by
+    // Log::set_filepath; or stops it, if none of them needs it. Should be
+    // called only with configuration_mutex held. Could throw
+    // std::system_error, but only if the periodic flusher is to be
+    // started.
+    void update_periodic_flusher(SinkSet const* p_sinks)
+    {
+        unsigned int shortest = flush_policy().milliseconds;
+        if (p_sinks)
+        {
+            for (auto const& sink: *p_sinks)
+            {
+                unsigned int const milliseconds =
+                    sink.flush_policy.milliseconds;
+                if
+                (   !sink.is_main &&
+                    (milliseconds != 0) &&
+                    ((shortest == 0) || (milliseconds < shortest))
+                )
+                {
+                    shortest = milliseconds;
+                }
+            }
+        }
+        unique_ptr<PeriodicFlusher>& flusher = periodic_flusher();
+        if (shortest == 0)
+        {
+            flusher.reset();
+        }
+        else if (!flusher || (flusher->milliseconds() > shortest))
+        {
+            flusher.reset();
+            flusher.reset(new PeriodicFlusher(shortest));
+        }
+        return;
+    }
+
+    // Writes any queued or buffered records to the files being logged
+    // to, giving up if this takes longer than p_timeout. For use when the
+    // program is about to terminate. Never throws.
+    void flush_before_terminating(std::chrono::milliseconds p_timeout)
+    {
+        {
+            Visit const visit(async_writer_users);
+            AsyncWriter* const writer = async_writer.load();
+            if (writer)
+            {
+                writer->drain_for(p_timeout);
+            }
+        }
+        Visit const visit(sink_users);
+        SinkSet const* const set = sinks.load();
+        if (set)
+        {
+            for (auto const& sink: *set)
+            {
+                sink.file->flush_before_terminating(p_timeout);
+            }
+        }
+        return;
+    }
+
+    std::terminate_handler previous_terminate_handler = nullptr;
+
+    void terminate_handler()
+    {
+        flush_before_terminating(std::chrono::milliseconds(1000));
+        if (previous_terminate_handler)
+        {
+            previous_terminate_handler();
+        }
+        std::abort();
+    }
+
+    // Installs terminate_handler, unless already installed. Should be
+    // called only with configuration_mutex held.
+    void install_terminate_handler()
+    {
+        static bool installed = false;
+        if (!installed)
+        {
+            previous_terminate_handler = std::set_terminate(terminate_handler);
+            installed = true;
+        }
+        return;
+    }
+
+
+    // CHANGING THE SINKS
+
+    // Writes a record of the commencement of logging to p_file, which has
+    // been opened at p_filepath. This should be done before the file is
+    // made available to other threads, so that the record comes first.
+    // Could throw std::bad_alloc.
+    void commence_logging(LogFile& p_file, string const& p_filepath)
+    {
+        string text;
+        p_file.format_event
+        (   text,
+            detail::log_commenced,
+            next_id(),
+            "Commenced logging to " + p_filepath + "."
+        );
+        p_file.write_and_flush(text);
+        return;
+    }
+
+    // Writes an "End log" record to p_file. Never throws.
+    void finish_logging(LogFile& p_file)
+    {
+        try
+        {
+            string text;
+            p_file.format_event(text, detail::log_ended, next_id(), "End log");
+            p_file.write_and_flush(text);
+        }
+        catch (std::bad_alloc&)
+        {
+        }
+        return;
+    }
+
+    // Returns a copy of the set of files being logged to. Should be
+    // called only with configuration_mutex held. Could throw
+    // std::bad_alloc.
+    unique_ptr<SinkSet> copy_sinks()
+    {
+        SinkSet const* const current = sinks.load();
+        return unique_ptr<SinkSet>
+        (   current? new SinkSet(*current): new SinkSet
+        );
+    }
+
+    // Erases from p_sinks the file set by Log::set_filepath, if
+    // p_is_main, or else the file added by Log::add_sink at p_filepath.
+    // Returns true if there was such a file. Never throws.
+    bool erase_sink
+    (   SinkSet& p_sinks,
+        bool p_is_main,
+        string const& p_filepath
+    )
+    {
+        for (auto it = p_sinks.begin(); it != p_sinks.end(); ++it)
+        {
+            if
+            (   (it->is_main == p_is_main) &&
+                (p_is_main || (it->filepath == p_filepath))
+            )
+            {
+                p_sinks.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool includes_file(SinkSet const* p_sinks, LogFile const* p_file)
+    {
+        if (p_sinks)
+        {
+            for (auto const& sink: *p_sinks)
+            {
+                if (sink.file.get() == p_file)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Publishes p_sinks, which may be nullptr, as the set of files being
+    // logged to, in place of the current set, after writing any records
+    // still queued for the asynchronous writer; and then finishes each
+    // file that is no longer logged to with an "End log" record. Should
+    // be called only with configuration_mutex held. Never throws.
+    void replace_sinks(SinkSet const* p_sinks)
+    {
+        drain_asynchronous_writer();
+        unique_ptr<SinkSet const> const old_sinks(sinks.exchange(p_sinks));
+        sink_users.await_departures();
+        if (old_sinks)
+        {
+            for (auto const& sink: *old_sinks)
+            {
+                if (!includes_file(p_sinks, sink.file.get()))
+                {
+                    finish_logging(*sink.file);
+                }
+            }
+        }
+        return;
+    }
+
+    // Sets sink_threshold to the lowest of the thresholds of the files in
+    // p_sinks, which may be nullptr, that were added by Log::add_sink.
+    // Never throws.
+    void update_sink_threshold(SinkSet const* p_sinks)
+    {
+        int lowest = no_threshold;
+        if (p_sinks)
+        {
+            for (auto const& sink: *p_sinks)
+            {
+                if (!sink.is_main)
+                {
+                    lowest = min<int>(lowest, sink.threshold);
+                }
+            }
+        }
+        sink_threshold.store(lowest);
+        return;
+    }
+
+    // Finishes the files being logged to when the program exits.
+    struct LogFileCloser
+    {
+        ~LogFileCloser()
+        {
+            lock_guard<mutex> const lock(configuration_mutex);
+            periodic_flusher().reset();
+            stop_asynchronous_writer();
+            replace_sinks(nullptr);
+        }
+    };
+
+    // Should be called only with configuration_mutex held, whenever a
+    // file is to be logged to.
+    void close_files_at_exit()
+    {
+        static LogFileCloser closer;
+        return;
+    }
+
+
+    // FLIGHT RECORDER
+
+    // The records most recently logged by a thread. Any thread may push
+    // records to or collect records from the ring, but in practice only
+    // the thread to which the ring is assigned pushes records to it.
+    class RecorderRing
+    {
+    public:
+        explicit RecorderRing(size_t p_capacity);
+        RecorderRing(RecorderRing const&) = delete;
+        RecorderRing(RecorderRing&&) = delete;
+        RecorderRing& operator=(RecorderRing const&) = delete;
+        RecorderRing& operator=(RecorderRing&&) = delete;
+        ~RecorderRing() = default;
+
+        // Stores p_record, in place of the oldest record stored if the
+        // ring is full. Never throws.
+        void push(Record const& p_record);
+
+        // Appends the records stored to p_records, from oldest to newest,
+        // and empties the ring. Could throw std::bad_alloc, in which case
+        // the ring is unchanged.
+        void collect(vector<StoredRecord>& p_records);
+
+        // Whether the ring is assigned to a thread. Guarded by the mutex
+        // of the FlightRecorder.
+        bool is_assigned;
+
+    private:
+        size_t const m_capacity;
+        mutex m_mutex;
+        unique_ptr<StoredRecord[]> m_records;
+        size_t m_next;  // The position at which to store the next record
+        size_t m_size;
+    };
+
+    // Keeps the most recent records logged by each thread, up to a fixed
+    // number per thread, in memory, so that they can be written to the
+    // log file when something goes wrong.
+    class FlightRecorder
+    {
+    public:
+        explicit FlightRecorder(size_t p_records_per_thread);
+        FlightRecorder(FlightRecorder const&) = delete;
+        FlightRecorder(FlightRecorder&&) = delete;
+        FlightRecorder& operator=(FlightRecorder const&) = delete;
+        FlightRecorder& operator=(FlightRecorder&&) = delete;
+        ~FlightRecorder() = default;
+
+        // Stores p_record in the ring of the calling thread, assigning a
+        // ring to the thread if it does not have one. Never throws. If an
+        // error occurs, the record is lost.
+        void record(Record const& p_record);
+
+        // Appends the records stored, by all threads, to p_records, and
+        // empties the rings. Could throw std::bad_alloc.
+        void collect(vector<StoredRecord>& p_records);
+
+        // Makes p_ring available to be assigned to another thread. The
+        // records in it are kept until they are overwritten. Never
+        // throws.
+        void release(RecorderRing* p_ring);
+
+        unsigned long long generation() const;
+
+    private:
+        RecorderRing* assign_ring();
+
+        unsigned long long const m_generation;
+        size_t const m_records_per_thread;
+        mutex m_rings_mutex;
+        vector<unique_ptr<RecorderRing> > m_rings;
+    };
+
+    // The flight recorder in use, if any. Log::log counts itself in
+    // flight_recorder_users while using it, so that it is not destroyed
+    // while still in use.
+    atomic<FlightRecorder*> flight_recorder(nullptr);
+    ActiveUsers flight_recorder_users;
+
+    // Distinguishes each FlightRecorder from those that preceded it, even
+    // if it has the same address.
+    atomic<unsigned long long> last_recorder_generation(0);
+
+    // The ring assigned to the thread, if any, by the FlightRecorder with
+    // the given generation. The ring is released when the thread exits.
+    struct RingAssignment
+    {
+        ~RingAssignment();
+
+        bool is_destroyed;
+        unsigned long long generation;
+        RecorderRing* ring;
+    };
+
+    thread_local RingAssignment t_ring_assignment = { false, 0, nullptr };
+
+    RingAssignment::~RingAssignment()
+    {
+        is_destroyed = true;
+        Visit const visit(flight_recorder_users);
+        FlightRecorder* const recorder = flight_recorder.load();
+        if (recorder && (recorder->generation() == generation))
+        {
+            recorder->release(ring);
+        }
+    }
+
+    RecorderRing::RecorderRing(size_t p_capacity):
+        is_assigned(false),
+        m_capacity(p_capacity),
+        m_records(new StoredRecord[p_capacity]),
+        m_next(0),
+        m_size(0)
+    {
+    }
+
+    void
+    RecorderRing::push(Record const& p_record)
+    {
+        lock_guard<mutex> const lock(m_mutex);
+        m_records[m_next].store(p_record);
+        if (++m_next == m_capacity)
+        {
+            m_next = 0;
+        }
+        if (m_size != m_capacity)
+        {
+            ++m_size;
+        }
+        return;
+    }
+
+    void
+    RecorderRing::collect(vector<StoredRecord>& p_records)
+    {
+        lock_guard<mutex> const lock(m_mutex);
+        p_records.reserve(p_records.size() + m_size);
+        size_t position = (m_next + m_capacity - m_size) % m_capacity;
+        for (size_t i = 0; i != m_size; ++i)
+        {
+            p_records.push_back(m_records[position]);
+            if (++position == m_capacity)
+            {
+                position = 0;
+            }
+        }
+        m_size = 0;
+        return;
+    }
+
+    FlightRecorder::FlightRecorder(size_t p_records_per_thread):
+        m_generation(last_recorder_generation.fetch_add(1) + 1),
+        m_records_per_thread(std::max<size_t>(p_records_per_thread, 1))
+    {
+    }
+
+    void
+    FlightRecorder::record(Record const& p_record)
+    {
+        RingAssignment& assignment = t_ring_assignment;
+        if (assignment.is_destroyed)
+        {
+            return;
+        }
+        if (assignment.generation != m_generation)
+        {
+            try
+            {
+                assignment.ring = assign_ring();
+                assignment.generation = m_generation;
+            }
+            catch (std::exception&)
+            {
+                return;
+            }
+        }
+        assignment.ring->push(p_record);
+        return;
+    }
+
+    void
+    FlightRecorder::collect(vector<StoredRecord>& p_records)
+    {
+        lock_guard<mutex> const lock(m_rings_mutex);
+        for (auto const& ring: m_rings)
+        {
+            ring->collect(p_records);
+        }
+        return;
+    }
+
+    void
+    FlightRecorder::release(RecorderRing* p_ring)
+    {
+        try
+        {
+            lock_guard<mutex> const lock(m_rings_mutex);
+            p_ring->is_assigned = false;
+        }
+        catch (std::system_error&)
+        {
+            // The ring will not be reused.
+        }
+        return;
+    }
+
+    unsigned long long
+    FlightRecorder::generation() const
+    {
+        return m_generation;
+    }
+
+    RecorderRing*
+    FlightRecorder::assign_ring()
+    {
+        lock_guard<mutex> const lock(m_rings_mutex);
+        for (auto const& ring: m_rings)
+        {
+            if (!ring->is_assigned)
+            {
+                ring->is_assigned = true;
+                return ring.get();
+            }
+        }
+        m_rings.reserve(m_rings.size() + 1);
+        m_rings.push_back
+        (   unique_ptr<RecorderRing>(new RecorderRing(m_records_per_thread))
+        );
+        m_rings.back()->is_assigned = true;
+        return m_rings.back().get();
+    }
+
+    void record_in_flight_recorder(Record const& p_record)
+    {
+        Visit const visit(flight_recorder_users);
+        FlightRecorder* const recorder = flight_recorder.load();
+        if (recorder)
+        {
+            recorder->record(p_record);
+        }
+        return;
+    }
+
+    void stop_flight_recorder()
+    {
+        FlightRecorder* const recorder = flight_recorder.exchange(nullptr);
+        if (recorder)
+        {
+            flight_recorder_users.await_departures();
+            delete recorder;
+        }
+        return;
+    }
+
+    bool is_earlier(StoredRecord const* p_lhs, StoredRecord const* p_rhs)
+    {
+        return p_lhs->record.timestamp < p_rhs->record.timestamp;
+    }
+
+    // Appends a record of severity info, with message p_message, to
+    // p_batch, in the format of p_file. Could throw std::bad_alloc.
+    void append_dump_notice
+    (   string& p_batch,
+        LogFile& p_file,
+        string const& p_message
+    )
+    {
+        Record record = Record();
+        record.timestamp = microseconds_since_epoch();
+        record.severity = Log::info;
+        record.message = p_message.c_str();
+        record.function = __func__;
+        record.file = __FILE__;
+        record.line = __LINE__;
+        p_file.format_record(p_batch, record, next_id());
+        return;
+    }
+
+    // Writes the records held by the flight recorder, if any, to the file
+    // set by Log::set_filepath, and empties the flight recorder. Could
+    // throw std::bad_alloc.
+    void dump_flight_recorder_to_file()
+    {
+        vector<StoredRecord> records;
+        {
+            Visit const visit(flight_recorder_users);
+            FlightRecorder* const recorder = flight_recorder.load();
+            if (!recorder)
+            {
+                return;
+            }
+            recorder->collect(records);
+        }
+        if (records.empty())
+        {
+            return;
+        }
+
+        // The records of each thread are in order, but those of different
+        // threads need to be merged.
+        vector<StoredRecord const*> ordered;
+        ordered.reserve(records.size());
+        for (auto const& record: records)
+        {
+            ordered.push_back(&record);
+        }
+        std::stable_sort(ordered.begin(), ordered.end(), is_earlier);
+
+        // Records queued in asynchronous mode were logged before the dump
+        // was requested, so are written first.
+        {
+            Visit const visit(async_writer_users);
+            AsyncWriter* const writer = async_writer.load();
+            if (writer)
+            {
+                writer->drain();
+            }
+        }
+        Visit const visit(sink_users);
+        LogFile* const file = main_file(sinks.load());
+        if (!file)
+        {
+            return;
+        }
+        char count[max_numeric_chars + 1];
+        *to_chars(count, count + max_numeric_chars, records.size()) = '\0';
+        string batch;
+        append_dump_notice
+        (   batch,
+            *file,
+            string("Flight recorder dump: the ") + count +
+                " most recent records recorded follow."
+        );
+        for (auto record: ordered)
+        {
+            file->format_record(batch, record->record, next_id());
+        }
+        append_dump_notice(batch, *file, "End of flight recorder dump.");
+        file->write_and_flush(batch);
+        return;
+    }
+
+
+    // SITES
+
+    // Guards first_site and site_rules.
+    mutex sites_mutex;
+
+    // The most recently registered site, which is the head of a list of
+    // all the sites registered.
+    detail::LogSite* first_site = nullptr;
+
+    // The patterns passed to Log::enable_sites and Log::disable_sites,
+    // each with true if it enables and false if it disables, ordered from
+    // least to most recently passed.
+    typedef std::pair<string, bool> SiteRule;
+
+    vector<SiteRule>& site_rules()
+    {
+        static vector<SiteRule> ret;
+        return ret;
+    }
+
+    // Returns true if p_text matches p_pattern, in which '*' matches any
+    // sequence of characters and '?' matches any single character.
+    bool matches_pattern(char const* p_text, char const* p_pattern)
+    {
+        // After a mismatch, we backtrack to the most recent '*', and let
+        // it match one more character of the text than it did before.
+        char const* star = nullptr;
+        char const* text_after_star = nullptr;
+        while (*p_text != '\0')
+        {
+            if (*p_pattern == '*')
+            {
+                star = p_pattern++;
+                text_after_star = p_text;
+            }
+            else if ((*p_pattern == '?') || (*p_pattern == *p_text))
+            {
+                ++p_pattern;
+                ++p_text;
+            }
+            else if (star)
+            {
+                p_pattern = star + 1;
+                p_text = ++text_after_star;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        while (*p_pattern == '*')
+        {
+            ++p_pattern;
+        }
+        return *p_pattern == '\0';
+    }
+
+    bool matches_pattern(detail::LogSite const& p_site, char const* p_pattern)
+    {
+        return
+            matches_pattern(p_site.function(), p_pattern) ||
+            matches_pattern(p_site.file(), p_pattern);
+    }
+
+    void set_sites_enabled(string const& p_pattern, bool p_enabled)
+    {
+        lock_guard<mutex> const lock(sites_mutex);
+        vector<SiteRule>& rules = site_rules();
+        auto it = rules.begin();
+        while ((it != rules.end()) && (it->first != p_pattern))
+        {
+            ++it;
+        }
+        if (it == rules.end())
+        {
+            rules.push_back(SiteRule(p_pattern, p_enabled));
+        }
+        else
+        {
+            // Moving the rule to the end makes it the most recent, without
+            // allocating.
+            std::rotate(it, it + 1, rules.end());
+            rules.back().second = p_enabled;
+        }
+        for (auto site = first_site; site; site = site->next())
+        {
+            if (matches_pattern(*site, p_pattern.c_str()))
+            {
+                site->set_enabled(p_enabled);
+            }
+        }
+        return;
+    }
+
+}  // end anonymous namespace
+
+namespace detail
+{
+
+LogSite::LogSite(char const* p_function, char const* p_file, int p_line):
+    m_function(p_function),
+    m_file(p_file),
+    m_line(p_line),
+    m_enabled(true),
+    m_count(0),
+    m_last_logged(s_never),
+    m_next(nullptr)
+{
+    try
+    {
+        lock_guard<mutex> const lock(sites_mutex);
+        vector<SiteRule> const& rules = site_rules();
+        for (auto it = rules.rbegin(); it != rules.rend(); ++it)
+        {
+            if (matches_pattern(*this, it->first.c_str()))
+            {
+                set_enabled(it->second);
+                break;
+            }
+        }
+        m_next = first_site;
+        first_site = this;
+    }
+    catch (std::system_error&)
+    {
+        // The site will log, but cannot be disabled.
+    }
+}
+
+bool
+LogSite::should_log_every_ms(unsigned long long p_milliseconds)
+{
+    if (!should_log())
+    {
+        return false;
+    }
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    long long const now = duration_cast<milliseconds>
+    (   std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+    long long last = m_last_logged.load(memory_order_relaxed);
+    if
+    (   (last != s_never) &&
+        (static_cast<unsigned long long>(now - last) < p_milliseconds)
+    )
+    {
+        return false;
+    }
+    // If another thread logged since we loaded last, it is that thread
+    // that logs this time.
+    return m_last_logged.compare_exchange_strong
+    (   last,
+        now,
+        memory_order_relaxed
+    );
+}
+
+}  // namespace detail
+
+void
+Log::enable_sites(string const& p_pattern)
+{
+    set_sites_enabled(p_pattern, true);
+    return;
+}
+
+void
+Log::disable_sites(string const& p_pattern)
+{
+    set_sites_enabled(p_pattern, false);
+    return;
+}
+
+char const Log::standard_error_filepath[] = "<standard error>";
+
+void
+Log::set_filepath(string const& p_filepath, Format p_format)
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    close_files_at_exit();
+    static string filepath = "";
+    static Format format = text;
+    if ((p_filepath != filepath) || (p_format != format))
+    {
+        filepath = p_filepath;
+        format = p_format;
+        if (!filepath.empty())
+        {
+            unique_ptr<SinkSet> set = copy_sinks();
+            if (erase_sink(*set, true, filepath))
+            {
+                // As in add_sink, the old file is finished before the new
+                // one is opened, as they may be the same file.
+                replace_sinks(set.release());
+                set = copy_sinks();
+            }
+            shared_ptr<LogFile> file
+            (   LogFile::open(filepath, format, flush_policy())
+            );
+            if (file)
+            {
+                commence_logging(*file, filepath);
+                Sink const sink =
+                    { true, filepath, trace, flush_policy(), file };
+                set->insert(set->begin(), sink);
+            }
+            replace_sinks(set.release());
+        }
+    }
+    return;
+}
+
+void
+Log::set_threshold(Level p_level)
+{
+    file_threshold.store(p_level);
+    update_lowest_threshold(threshold_aux());
+    return;
+}
+
+void
+Log::add_sink
+(   string const& p_filepath,
+    Level p_threshold,
+    Format p_format,
+    FlushPolicy const& p_flush_policy
+)
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    close_files_at_exit();
+    unique_ptr<SinkSet> set = copy_sinks();
+    if (erase_sink(*set, false, p_filepath))
+    {
+        // The old file is finished before the new one is opened, as they
+        // are probably the same file.
+        replace_sinks(set.release());
+        set = copy_sinks();
+    }
+    shared_ptr<LogFile> file
+    (   LogFile::open(p_filepath, p_format, p_flush_policy)
+    );
+    if (file)
+    {
+        commence_logging(*file, p_filepath);
+        Sink const sink =
+            { false, p_filepath, p_threshold, p_flush_policy, file };
+        set->push_back(sink);
+        replace_sinks(set.release());
+    }
+    update_sink_threshold(sinks.load());
+    update_lowest_threshold(threshold_aux());
+    if (p_flush_policy.records != 1)
+    {
+        install_terminate_handler();
+    }
+    update_periodic_flusher(sinks.load());
+    return;
+}
+
+void
+Log::remove_sink(string const& p_filepath)
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    unique_ptr<SinkSet> set = copy_sinks();
+    if (erase_sink(*set, false, p_filepath))
+    {
+        replace_sinks(set.release());
+        update_sink_threshold(sinks.load());
+        update_lowest_threshold(threshold_aux());
+
+        // Does not throw, as the periodic flusher, if needed, is already
+        // running often enough.
+        update_periodic_flusher(sinks.load());
+    }
+    return;
+}
+
+void
+Log::set_flight_recorder
+(   size_t p_records_per_thread,
+    Level p_threshold,
+    Level p_dump_severity
+)
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    unique_ptr<FlightRecorder> recorder
+    (   new FlightRecorder(min<size_t>(p_records_per_thread, 1 << 20))
+    );
+    stop_flight_recorder();
+    flight_recorder.store(recorder.release());
+    recorder_dump_severity.store(p_dump_severity);
+    recorder_threshold.store(p_threshold);
+    update_lowest_threshold(threshold_aux());
+    return;
+}
+
+void
+Log::unset_flight_recorder()
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    recorder_threshold.store(no_threshold);
+    recorder_dump_severity.store(no_threshold);
+    update_lowest_threshold(threshold_aux());
+    stop_flight_recorder();
+    return;
+}
+
+void
+Log::dump_flight_recorder()
+{
+    try
+    {
+        dump_flight_recorder_to_file();
+    }
+    catch (std::bad_alloc&)
+    {
+    }
+    return;
+}
+
+void
+Log::set_asynchronous(size_t p_queue_capacity, QueueFullPolicy p_policy)
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    stop_asynchronous_writer();
+    unique_ptr<AsyncWriter> writer
+    (   new AsyncWriter(min<size_t>(p_queue_capacity, 1 << 24), p_policy)
+    );
+    async_writer.store(writer.release());
+    return;
+}
+
+void
+Log::set_synchronous()
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    stop_asynchronous_writer();
+    return;
+}
+
+unsigned long long
+Log::dropped_records()
+{
+    return total_dropped.load(memory_order_relaxed);
+}
+
+void
+Log::set_flush_policy(FlushPolicy const& p_policy)
+{
+    lock_guard<mutex> const lock(configuration_mutex);
+    flush_policy() = p_policy;
+    {
+        Visit const visit(sink_users);
+        LogFile* const file = main_file(sinks.load());
+        if (file)
+        {
+            file->set_flush_policy(p_policy);
+        }
+    }
+    if (p_policy.records != 1)
+    {
+        install_terminate_handler();
+    }
+    update_periodic_flusher(sinks.load());
+    return;
+}
+
+void
+Log::flush()
+{
+    {
+        Visit const visit(async_writer_users);
+        AsyncWriter* const writer = async_writer.load();
+        if (writer)
+        {
+            writer->drain();
+        }
+    }
+    Visit const visit(sink_users);
+    SinkSet const* const set = sinks.load();
+    if (set)
+    {
+        for (auto const& sink: *set)
+        {
+            sink.file->flush();
+        }
+    }
+    return;
+}
+
+void
+Log::log
+(   Level p_severity,
+    char const* p_message,
+    char const* p_function,
+    char const* p_file,
+    int p_line,
+    char const* p_compilation_date,
+    char const* p_compilation_time,
+    char const* p_exception_type,
+    char const* p_expression,
+    char const* p_value
+)
+{
+    if (passes_threshold(p_severity))
+    {
+        Record record;
+        record.timestamp = microseconds_since_epoch();
+        record.severity = p_severity;
+        record.line = p_line;
+        record.message = p_message;
+        record.function = p_function;
+        record.file = p_file;
+        record.compilation_date = p_compilation_date;
+        record.compilation_time = p_compilation_time;
+        record.exception_type = p_exception_type;
+        record.expression = p_expression;
+        record.value = p_value;
+        if (p_severity >= recorder_dump_severity.load(memory_order_relaxed))
+        {
+            dump_flight_recorder();
+        }
+        if (p_severity >= recorder_threshold.load(memory_order_relaxed))
+        {
+            record_in_flight_recorder(record);
+        }
+        if
+        (   (p_severity < file_threshold.load(memory_order_relaxed)) &&
+            (p_severity < sink_threshold.load(memory_order_relaxed))
+        )
+        {
+            return;
+        }
+        if (push_asynchronously(record))
+        {
+            return;
+        }
+        string* const buffers = thread_buffers();
+        if (buffers)
+        {
+            write_to_sinks(record, buffers);
+        }
+        else
+        {
+            string local_buffers[num_formats];
+            write_to_sinks(record, local_buffers);
+        }
+    }
+    return;
+}
+
+
+Log::FlushPolicy::FlushPolicy():
+    records(1),
+    bytes(0),
+    milliseconds(0),
+    severity(error),
+    buffer_size(default_buffer_size)
+{
+}
+
+Log::FlushPolicy
+Log::FlushPolicy::every_record()
+{
+    return FlushPolicy();
+}
+
+Log::FlushPolicy
+Log::FlushPolicy::every_n_records(size_t p_records)
+{
+    FlushPolicy ret;
+    ret.records = p_records;
+    return ret;
+}
+
+Log::FlushPolicy
+Log::FlushPolicy::every_n_bytes(size_t p_bytes)
+{
+    FlushPolicy ret;
+    ret.records = 0;
+    ret.bytes = p_bytes;
+    return ret;
+}
+
+Log::FlushPolicy
+Log::FlushPolicy::every_n_milliseconds(unsigned int p_milliseconds)
+{
+    FlushPolicy ret;
+    ret.records = 0;
+    ret.milliseconds = p_milliseconds;
+    return ret;
+}
+
+Log::FlushPolicy
+Log::FlushPolicy::at_severity(Level p_severity)
+{
+    FlushPolicy ret;
+    ret.records = 0;
+    ret.severity = p_severity;
+    return ret;
+}
+
+char const*
+Log::severity_string(Level p_level)
+{
+    return detail::log_severity_name(p_level);
 }
 
 }  // namespace jewel
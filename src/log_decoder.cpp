@@ -0,0 +1,524 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "log_decoder.hpp"
+#include "exception.hpp"
+#include "log.hpp"
+#include "detail/log_format.hpp"
+#include <cstddef>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::istream;
+using std::istreambuf_iterator;
+using std::ostream;
+using std::size_t;
+using std::streambuf;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    // The decoded text is written to the output stream in chunks of
+    // about this size.
+    size_t const output_chunk_size = 1 << 16;
+
+    // A string read from a binary log, which may be absent.
+    struct OptionalString
+    {
+        OptionalString(): present(false)
+        {
+        }
+        char const* c_str() const
+        {
+            return present? text.c_str(): nullptr;
+        }
+        bool present;
+        string text;
+    };
+
+    // The strings that are the same for every record from a given site.
+    struct Site
+    {
+        Site(): line(0)
+        {
+        }
+        int line;
+        OptionalString function;
+        OptionalString file;
+        OptionalString compilation_date;
+        OptionalString compilation_time;
+        OptionalString exception_type;
+        OptionalString expression;
+    };
+
+    // The most bytes of a string we allocate before checking they are
+    // actually present in the log.
+    unsigned long long const max_string_chunk = 64 * 1024;
+
+    // Reads the parts of the entries of a binary log.
+    class BinaryReader
+    {
+    public:
+        explicit BinaryReader(istream& p_is): m_buffer(*p_is.rdbuf())
+        {
+        }
+
+        // Returns false if there are no more bytes.
+        bool at_end()
+        {
+            return m_buffer.sgetc() == streambuf::traits_type::eof();
+        }
+
+        unsigned char read_byte()
+        {
+            streambuf::int_type const c = m_buffer.sbumpc();
+            if (c == streambuf::traits_type::eof())
+            {
+                JEWEL_THROW
+                (   LogDecoderException,
+                    "Binary log ends part way through an entry."
+                );
+            }
+            return static_cast<unsigned char>(c);
+        }
+
+        unsigned long long read_varint()
+        {
+            unsigned long long ret = 0;
+            for (int shift = 0; ; shift += 7)
+            {
+                if (shift >= 64)
+                {
+                    JEWEL_THROW
+                    (   LogDecoderException,
+                        "Integer in binary log is too large."
+                    );
+                }
+                unsigned char const byte = read_byte();
+                ret |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return ret;
+                }
+            }
+        }
+
+        void read_string(OptionalString& p_out)
+        {
+            unsigned long long const size_plus_one = read_varint();
+            p_out.present = (size_plus_one != 0);
+            p_out.text.clear();
+            if (p_out.present)
+            {
+                // Read in chunks, so that a corrupt length can't cause a
+                // huge allocation before we find the log is too short.
+                unsigned long long remaining = size_plus_one - 1;
+                while (remaining != 0)
+                {
+                    size_t const chunk = static_cast<size_t>
+                    (   (remaining < max_string_chunk)?
+                        remaining:
+                        max_string_chunk
+                    );
+                    size_t const old_size = p_out.text.size();
+                    p_out.text.resize(old_size + chunk);
+                    std::streamsize const got = m_buffer.sgetn
+                    (   &p_out.text[old_size],
+                        static_cast<std::streamsize>(chunk)
+                    );
+                    if (got != static_cast<std::streamsize>(chunk))
+                    {
+                        JEWEL_THROW
+                        (   LogDecoderException,
+                            "Binary log ends part way through an entry."
+                        );
+                    }
+                    remaining -= chunk;
+                }
+            }
+            return;
+        }
+
+    private:
+        streambuf& m_buffer;
+    };
+
+    void read_site(BinaryReader& p_reader, vector<Site>& p_sites)
+    {
+        unsigned long long const id = p_reader.read_varint();
+        if (id != p_sites.size())
+        {
+            JEWEL_THROW
+            (   LogDecoderException,
+                "Sites in binary log are not numbered consecutively."
+            );
+        }
+        Site site;
+        site.line = static_cast<int>
+        (   detail::log_zigzag_decode(p_reader.read_varint())
+        );
+        p_reader.read_string(site.function);
+        p_reader.read_string(site.file);
+        if (!site.function.present || !site.file.present)
+        {
+            JEWEL_THROW
+            (   LogDecoderException,
+                "Site in binary log has no function or file."
+            );
+        }
+        p_reader.read_string(site.compilation_date);
+        p_reader.read_string(site.compilation_time);
+        p_reader.read_string(site.exception_type);
+        p_reader.read_string(site.expression);
+        p_sites.push_back(site);
+        return;
+    }
+
+    void read_record
+    (   BinaryReader& p_reader,
+        vector<Site> const& p_sites,
+        string& p_out
+    )
+    {
+        unsigned long long const site_id = p_reader.read_varint();
+        if (site_id >= p_sites.size())
+        {
+            JEWEL_THROW
+            (   LogDecoderException,
+                "Record in binary log refers to an undefined site."
+            );
+        }
+        long long const id = static_cast<long long>(p_reader.read_varint());
+        long long const timestamp =
+            static_cast<long long>(p_reader.read_varint());
+        Log::Level const severity = static_cast<Log::Level>
+        (   p_reader.read_byte()
+        );
+        OptionalString message;
+        OptionalString value;
+        p_reader.read_string(message);
+        p_reader.read_string(value);
+        Site const& site = p_sites[site_id];
+        detail::LogRecord record;
+        record.timestamp = timestamp;
+        record.severity = severity;
+        record.line = site.line;
+        record.message = message.c_str();
+        record.function = site.function.c_str();
+        record.file = site.file.c_str();
+        record.compilation_date = site.compilation_date.c_str();
+        record.compilation_time = site.compilation_time.c_str();
+        record.exception_type = site.exception_type.c_str();
+        record.expression = site.expression.c_str();
+        record.value = value.c_str();
+        detail::append_log_text_record(p_out, record, id);
+        return;
+    }
+
+    void read_event(BinaryReader& p_reader, string& p_out)
+    {
+        detail::LogEvent const event =
+            static_cast<detail::LogEvent>(p_reader.read_byte());
+        long long const id = static_cast<long long>(p_reader.read_varint());
+        OptionalString message;
+        OptionalString date_time;
+        p_reader.read_string(message);
+        p_reader.read_string(date_time);
+        detail::append_log_text_event
+        (   p_out,
+            event,
+            id,
+            message.text.c_str(),
+            date_time.c_str()
+        );
+        return;
+    }
+
+    // Python's str.strip() strips these characters, among others outside
+    // the ASCII range.
+    bool is_python_space(char c)
+    {
+        return
+            (c == ' ') ||
+            ((c >= '\t') && (c <= '\r')) ||
+            ((c >= '\x1c') && (c <= '\x1f'));
+    }
+
+    // Returns p_text[p_begin, p_end) with leading and trailing white
+    // space removed.
+    string strip(string const& p_text, size_t p_begin, size_t p_end)
+    {
+        while ((p_begin != p_end) && is_python_space(p_text[p_begin]))
+        {
+            ++p_begin;
+        }
+        while ((p_end != p_begin) && is_python_space(p_text[p_end - 1]))
+        {
+            --p_end;
+        }
+        return p_text.substr(p_begin, p_end - p_begin);
+    }
+
+    // Splits p_text at each occurrence of p_separator, as does Python's
+    // str.split.
+    vector<string> split(string const& p_text, string const& p_separator)
+    {
+        vector<string> ret;
+        size_t begin = 0;
+        while (true)
+        {
+            size_t const end = p_text.find(p_separator, begin);
+            if (end == string::npos)
+            {
+                ret.push_back(p_text.substr(begin));
+                return ret;
+            }
+            ret.push_back(p_text.substr(begin, end - begin));
+            begin = end + p_separator.size();
+        }
+    }
+
+    // Writes p_field as Python's csv module does by default, i.e. quoted
+    // only if it contains a delimiter, quote or line break.
+    void append_csv_field(string& p_out, string const& p_field)
+    {
+        if (p_field.find_first_of(",\"\r\n") == string::npos)
+        {
+            p_out += p_field;
+            return;
+        }
+        p_out += '"';
+        for (char c: p_field)
+        {
+            if (c == '"')
+            {
+                p_out += '"';
+            }
+            p_out += c;
+        }
+        p_out += '"';
+        return;
+    }
+
+    void append_csv_row(string& p_out, vector<string> const& p_row)
+    {
+        if ((p_row.size() == 1) && p_row[0].empty())
+        {
+            // As with Python's csv module, so that the row is not read
+            // back as an empty row.
+            p_out += "\"\"";
+        }
+        else
+        {
+            for (size_t i = 0; i != p_row.size(); ++i)
+            {
+                if (i != 0)
+                {
+                    p_out += ',';
+                }
+                append_csv_field(p_out, p_row[i]);
+            }
+        }
+        p_out += "\r\n";
+        return;
+    }
+
+}  // end anonymous namespace
+
+
+void
+decode_binary_log(istream& p_binary_log, ostream& p_text_log)
+{
+    BinaryReader reader(p_binary_log);
+    for (size_t i = 0; i != detail::log_binary_magic_size; ++i)
+    {
+        if
+        (   reader.at_end() ||
+            (reader.read_byte() != static_cast<unsigned char>
+                (detail::log_binary_magic[i]))
+        )
+        {
+            JEWEL_THROW(LogDecoderException, "Not a binary log.");
+        }
+    }
+    if (reader.at_end() || (reader.read_byte() != detail::log_binary_version))
+    {
+        JEWEL_THROW
+        (   LogDecoderException,
+            "Unsupported version of binary log format."
+        );
+    }
+    vector<Site> sites;
+    string text;
+    while (!reader.at_end())
+    {
+        unsigned char const tag = reader.read_byte();
+        switch (tag)
+        {
+        case detail::log_binary_site:
+            read_site(reader, sites);
+            break;
+        case detail::log_binary_record:
+            read_record(reader, sites, text);
+            break;
+        case detail::log_binary_event:
+            read_event(reader, text);
+            break;
+        default:
+            p_text_log.write(text.data(), text.size());
+            JEWEL_THROW
+            (   LogDecoderException,
+                "Unrecognized entry in binary log."
+            );
+        }
+        if (text.size() >= output_chunk_size)
+        {
+            p_text_log.write(text.data(), text.size());
+            text.clear();
+        }
+    }
+    p_text_log.write(text.data(), text.size());
+    return;
+}
+
+void
+convert_log_to_csv(istream& p_text_log, ostream& p_csv)
+{
+    // Read the whole file, with line endings translated as by Python's
+    // "universal newlines" mode.
+    string const raw_contents
+    (   (istreambuf_iterator<char>(p_text_log)),
+        istreambuf_iterator<char>()
+    );
+    string contents;
+    contents.reserve(raw_contents.size());
+    for (size_t i = 0; i != raw_contents.size(); ++i)
+    {
+        if (raw_contents[i] != '\r')
+        {
+            contents += raw_contents[i];
+            continue;
+        }
+        contents += '\n';
+        if ((i + 1 != raw_contents.size()) && (raw_contents[i + 1] == '\n'))
+        {
+            ++i;
+        }
+    }
+
+    // Each record is a sequence of (field name, contents) pairs, in the
+    // order in which the fields first appear in the record.
+    typedef vector<std::pair<size_t, string> > Record;
+    vector<Record> records;
+    vector<string> headers;
+    unordered_map<string, size_t> header_positions;
+    for (string const& raw_record: split(contents, "{R}"))
+    {
+        string const stripped_record =
+            strip(raw_record, 0, raw_record.size());
+        if (stripped_record.empty())
+        {
+            continue;
+        }
+        Record record;
+        for (string const& raw_cell: split(stripped_record, "{F}"))
+        {
+            string const cell = strip(raw_cell, 0, raw_cell.size());
+            if (cell.empty())
+            {
+                continue;
+            }
+            if (cell[0] != '[')
+            {
+                JEWEL_THROW
+                (   LogDecoderException,
+                    "Field in text log does not start with \"[\"."
+                );
+            }
+            string name;
+            string field_contents;
+            bool in_contents = false;
+            for (char c: cell)
+            {
+                if (c == ']')
+                {
+                    in_contents = true;
+                }
+                else if (in_contents)
+                {
+                    field_contents += c;
+                }
+                else if (c != '[')
+                {
+                    name += c;
+                }
+            }
+            auto const inserted =
+                header_positions.insert(std::make_pair(name, headers.size()));
+            if (inserted.second)
+            {
+                headers.push_back(name);
+            }
+            size_t const position = inserted.first->second;
+            bool found = false;
+            for (auto& field: record)
+            {
+                if (field.first == position)
+                {
+                    field.second = field_contents;
+                    found = true;
+                }
+            }
+            if (!found)
+            {
+                record.push_back(std::make_pair(position, field_contents));
+            }
+        }
+        records.push_back(record);
+    }
+
+    string out;
+    append_csv_row(out, headers);
+    vector<string> row;
+    for (Record const& record: records)
+    {
+        row.assign(headers.size(), string());
+        for (auto const& field: record)
+        {
+            row[field.first] = field.second;
+        }
+        append_csv_row(out, row);
+        if (out.size() >= output_chunk_size)
+        {
+            p_csv.write(out.data(), out.size());
+            out.clear();
+        }
+    }
+    p_csv.write(out.data(), out.size());
+    return;
+}
+
+}  // namespace jewel
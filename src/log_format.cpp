@@ -0,0 +1,377 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "detail/log_format.hpp"
+#include "log.hpp"
+#include "on_windows.hpp"
+#include "to_chars.hpp"
+
+// We deliberately do NOT use "jewel/assert.hpp" here, for the same
+// reason as in log.cpp.
+#include <cassert>
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <string>
+
+using std::begin;
+using std::end;
+using std::memcpy;
+using std::size_t;
+using std::strftime;
+using std::string;
+using std::time_t;
+using std::tm;
+
+namespace jewel
+{
+namespace detail
+{
+
+namespace
+{
+    void append_field(string& p_out, char const* p_name, char const* p_value)
+    {
+        p_out += "{F}[";
+        p_out += p_name;
+        p_out += ']';
+        p_out += p_value;
+        p_out += '\n';
+        return;
+    }
+
+    template <typename Integer>
+    void append_integer(string& p_out, Integer p_value)
+    {
+        char buffer[max_numeric_chars];
+        char* const last = to_chars(buffer, buffer + sizeof(buffer), p_value);
+        assert (last != nullptr);
+        p_out.append(buffer, last);
+        return;
+    }
+
+    template <typename Integer>
+    void append_field(string& p_out, char const* p_name, Integer p_value)
+    {
+        p_out += "{F}[";
+        p_out += p_name;
+        p_out += ']';
+        append_integer(p_out, p_value);
+        p_out += '\n';
+        return;
+    }
+
+    // Appends p_text to p_out as a JSON string, in quotes.
+    void append_json_string(string& p_out, char const* p_text)
+    {
+        static char const hex_digits[] = "0123456789abcdef";
+        p_out += '"';
+        for ( ; *p_text != '\0'; ++p_text)
+        {
+            char const c = *p_text;
+            switch (c)
+            {
+            case '"':
+            case '\\':
+                p_out += '\\';
+                p_out += c;
+                break;
+            case '\n':
+                p_out += "\\n";
+                break;
+            case '\r':
+                p_out += "\\r";
+                break;
+            case '\t':
+                p_out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    unsigned char const u = static_cast<unsigned char>(c);
+                    p_out += "\\u00";
+                    p_out += hex_digits[u >> 4];
+                    p_out += hex_digits[u & 0xf];
+                }
+                else
+                {
+                    p_out += c;
+                }
+                break;
+            }
+        }
+        p_out += '"';
+        return;
+    }
+
+    // Appends a member of a JSON object, preceded by a comma, to p_out.
+    void append_json_field
+    (   string& p_out,
+        char const* p_name,
+        char const* p_value
+    )
+    {
+        p_out += ",\"";
+        p_out += p_name;
+        p_out += "\":";
+        append_json_string(p_out, p_value);
+        return;
+    }
+
+    template <typename Integer>
+    void append_json_field(string& p_out, char const* p_name, Integer p_value)
+    {
+        p_out += ",\"";
+        p_out += p_name;
+        p_out += "\":";
+        append_integer(p_out, p_value);
+        return;
+    }
+
+    long long const microseconds_per_second = 1000000;
+
+    // The local date and time, to the second, last formatted by
+    // append_log_timestamp on this thread, and the second it represents.
+    size_t const date_time_size = 19;  // "YYYY-MM-DDTHH:MM:SS"
+    thread_local long long t_formatted_second = LLONG_MIN;
+    thread_local char t_formatted_date_time[date_time_size + 1];
+
+    // Sets t_formatted_date_time to the local date and time of
+    // p_second. Returns false if they cannot be determined.
+    bool format_date_time(long long p_second)
+    {
+        time_t const time = static_cast<time_t>(p_second);
+        tm local;
+#       ifdef JEWEL_ON_WINDOWS
+            if (localtime_s(&local, &time) != 0)
+            {
+                return false;
+            }
+#       else
+            if (!localtime_r(&time, &local))
+            {
+                return false;
+            }
+#       endif
+        size_t const check = strftime
+        (   t_formatted_date_time,
+            date_time_size + 1,
+            "%Y-%m-%dT%H:%M:%S",
+            &local
+        );
+        return check == date_time_size;
+    }
+
+}  // end anonymous namespace
+
+char const*
+log_severity_name(Log::Level p_level)
+{
+    static char const* strings[] =
+    {   "trace",
+        "info",
+        "warning",
+        "error"
+    };
+    if ((p_level < 0) || (p_level >= (end(strings) - begin(strings))))
+    {
+        return "unrecognized";
+    }
+    return strings[p_level];
+}
+
+void
+append_log_text_record
+(   string& p_out,
+    LogRecord const& p_record,
+    long long p_id
+)
+{
+    p_out += "{R}\n";
+    append_field(p_out, "id", p_id);
+    p_out += "{F}[timestamp]";
+    append_log_timestamp(p_out, p_record.timestamp);
+    p_out += '\n';
+    append_field(p_out, "severity", log_severity_name(p_record.severity));
+    if (p_record.message)
+    {
+        append_field(p_out, "message", p_record.message);
+    }
+    append_field(p_out, "function", p_record.function);
+    append_field(p_out, "file", p_record.file);
+    append_field(p_out, "line", p_record.line);
+    if (p_record.compilation_date)
+    {
+        append_field(p_out, "compilation_date", p_record.compilation_date);
+    }
+    if (p_record.compilation_time)
+    {
+        append_field(p_out, "compilation_time", p_record.compilation_time);
+    }
+    if (p_record.exception_type)
+    {
+        append_field(p_out, "exception_type", p_record.exception_type);
+    }
+    if (p_record.expression)
+    {
+        append_field(p_out, "expression", p_record.expression);
+    }
+    if (p_record.value)
+    {
+        append_field(p_out, "value", p_record.value);
+    }
+    p_out += '\n';
+    return;
+}
+
+void
+append_log_timestamp(string& p_out, long long p_microseconds)
+{
+    // Round towards negative infinity, so that the fraction is never
+    // negative.
+    long long second = p_microseconds / microseconds_per_second;
+    long long fraction = p_microseconds % microseconds_per_second;
+    if (fraction < 0)
+    {
+        --second;
+        fraction += microseconds_per_second;
+    }
+    if (second != t_formatted_second)
+    {
+        if (!format_date_time(second))
+        {
+            append_integer(p_out, p_microseconds);
+            return;
+        }
+        t_formatted_second = second;
+    }
+    char buffer[date_time_size + 7];  // For the '.' and six digits
+    memcpy(buffer, t_formatted_date_time, date_time_size);
+    buffer[date_time_size] = '.';
+    for (size_t i = date_time_size + 6; i != date_time_size; --i)
+    {
+        buffer[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    p_out.append(buffer, sizeof(buffer));
+    return;
+}
+
+void
+append_log_text_event
+(   string& p_out,
+    LogEvent p_event,
+    long long p_id,
+    char const* p_message,
+    char const* p_date_time
+)
+{
+    p_out += "{R}\n{F}[id]";
+    append_integer(p_out, p_id);
+    p_out += "\n{F}[message]";
+    p_out += p_message;
+    if (p_date_time)
+    {
+        p_out += "\n{F}[date_time_written]";
+        p_out += p_date_time;
+    }
+    // The record of the commencement of logging is followed by a blank
+    // line, like other records; but the record of its end is not.
+    p_out += (p_event == log_commenced)? "\n\n": "\n";
+    return;
+}
+
+void
+append_log_json_record
+(   string& p_out,
+    LogRecord const& p_record,
+    long long p_id
+)
+{
+    p_out += "{\"id\":";
+    append_integer(p_out, p_id);
+    p_out += ",\"timestamp\":\"";
+    append_log_timestamp(p_out, p_record.timestamp);
+    p_out += '"';
+    append_json_field
+    (   p_out,
+        "severity",
+        log_severity_name(p_record.severity)
+    );
+    if (p_record.message)
+    {
+        append_json_field(p_out, "message", p_record.message);
+    }
+    append_json_field(p_out, "function", p_record.function);
+    append_json_field(p_out, "file", p_record.file);
+    append_json_field(p_out, "line", p_record.line);
+    if (p_record.compilation_date)
+    {
+        append_json_field
+        (   p_out,
+            "compilation_date",
+            p_record.compilation_date
+        );
+    }
+    if (p_record.compilation_time)
+    {
+        append_json_field
+        (   p_out,
+            "compilation_time",
+            p_record.compilation_time
+        );
+    }
+    if (p_record.exception_type)
+    {
+        append_json_field(p_out, "exception_type", p_record.exception_type);
+    }
+    if (p_record.expression)
+    {
+        append_json_field(p_out, "expression", p_record.expression);
+    }
+    if (p_record.value)
+    {
+        append_json_field(p_out, "value", p_record.value);
+    }
+    p_out += "}\n";
+    return;
+}
+
+void
+append_log_json_event
+(   string& p_out,
+    long long p_id,
+    char const* p_message,
+    char const* p_date_time
+)
+{
+    p_out += "{\"id\":";
+    append_integer(p_out, p_id);
+    append_json_field(p_out, "message", p_message);
+    if (p_date_time)
+    {
+        append_json_field(p_out, "date_time_written", p_date_time);
+    }
+    p_out += "}\n";
+    return;
+}
+
+}  // namespace detail
+}  // namespace jewel
@@ -0,0 +1,506 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "record_writer.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include "exception.hpp"
+#include "on_windows.hpp"
+#include "to_chars.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef JEWEL_ON_WINDOWS
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+using std::max;
+using std::memcpy;
+using std::memmove;
+using std::size_t;
+using std::strlen;
+using std::string;
+using std::vector;
+
+namespace jewel
+{
+
+namespace
+{
+    // The most characters that escaping one character for JSON can
+    // produce, as in "\u001f".
+    size_t const max_json_escape_length = 6;
+
+    // Writes the \e p_size characters at \e p_data to \e p_out, as the
+    // contents of a JSON string (without the surrounding quotes), and
+    // returns a pointer one past the last character written. There must
+    // be room for max_json_escape_length characters per input character.
+    char* write_json_escaped(char const* p_data, size_t p_size, char* p_out)
+    {
+        static char const hex_digits[] = "0123456789abcdef";
+        for (char const* const end = p_data + p_size; p_data != end; ++p_data)
+        {
+            char const c = *p_data;
+            switch (c)
+            {
+            case '"':
+            case '\\':
+                *p_out++ = '\\';
+                *p_out++ = c;
+                break;
+            case '\n':
+                *p_out++ = '\\';
+                *p_out++ = 'n';
+                break;
+            case '\r':
+                *p_out++ = '\\';
+                *p_out++ = 'r';
+                break;
+            case '\t':
+                *p_out++ = '\\';
+                *p_out++ = 't';
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    unsigned char const u = static_cast<unsigned char>(c);
+                    *p_out++ = '\\';
+                    *p_out++ = 'u';
+                    *p_out++ = '0';
+                    *p_out++ = '0';
+                    *p_out++ = hex_digits[u >> 4];
+                    *p_out++ = hex_digits[u & 0xf];
+                }
+                else
+                {
+                    *p_out++ = c;
+                }
+                break;
+            }
+        }
+        return p_out;
+    }
+
+    string json_string(string const& p_string)
+    {
+        vector<char> buffer(p_string.size() * max_json_escape_length + 2);
+        char* out = &buffer[0];
+        *out++ = '"';
+        out = write_json_escaped(p_string.data(), p_string.size(), out);
+        *out++ = '"';
+        return string(&buffer[0], out);
+    }
+
+    bool csv_requires_quotes(char const* p_data, size_t p_size)
+    {
+        for (char const* const end = p_data + p_size; p_data != end; ++p_data)
+        {
+            switch (*p_data)
+            {
+            case ',':
+            case '"':
+            case '\n':
+            case '\r':
+                return true;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+}  // end anonymous namespace
+
+
+// RecordSink
+
+RecordSink::~RecordSink()
+{
+}
+
+
+// FileDescriptorSink
+
+FileDescriptorSink::FileDescriptorSink(int p_file_descriptor):
+    m_file_descriptor(p_file_descriptor)
+{
+}
+
+FileDescriptorSink::~FileDescriptorSink()
+{
+}
+
+void
+FileDescriptorSink::write(char const* p_data, size_t p_size)
+{
+    while (p_size != 0)
+    {
+#       ifdef JEWEL_ON_WINDOWS
+            unsigned int const chunk = static_cast<unsigned int>
+            (   std::min<size_t>(p_size, INT_MAX)
+            );
+            int const written = ::_write(m_file_descriptor, p_data, chunk);
+#       else
+            ssize_t const written = ::write(m_file_descriptor, p_data, p_size);
+#       endif
+        // A write of nothing is treated as an error, as retrying it could
+        // loop forever.
+        if (written <= 0)
+        {
+            if ((written < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            JEWEL_THROW
+            (   RecordWriterException,
+                "Could not write to file descriptor."
+            );
+        }
+        p_data += written;
+        p_size -= static_cast<size_t>(written);
+    }
+    return;
+}
+
+
+// MemorySink
+
+MemorySink::~MemorySink()
+{
+}
+
+void
+MemorySink::write(char const* p_data, size_t p_size)
+{
+    m_contents.append(p_data, p_size);
+    return;
+}
+
+string const&
+MemorySink::contents() const
+{
+    return m_contents;
+}
+
+void
+MemorySink::clear()
+{
+    m_contents.clear();
+    return;
+}
+
+
+// RecordWriter
+
+RecordWriter::RecordWriter
+(   RecordSink& p_sink,
+    Format p_format,
+    vector<string> const& p_field_names,
+    size_t p_buffer_size
+):
+    m_sink(p_sink),
+    m_format(p_format),
+    m_buffer_size(p_buffer_size),
+    m_num_fields(p_field_names.size()),
+    m_size(0),
+    m_record_start(0),
+    m_field_index(0)
+{
+    if (m_format == json_lines)
+    {
+        if (p_field_names.empty())
+        {
+            JEWEL_THROW
+            (   RecordWriterException,
+                "Field names are required for JSON lines."
+            );
+        }
+        for (size_t i = 0; i != p_field_names.size(); ++i)
+        {
+            m_prefixes.push_back
+            (   ((i == 0)? "{": ",") + json_string(p_field_names[i]) + ":"
+            );
+        }
+    }
+
+    // Leave room for a record beyond the buffer size, so that the buffer
+    // does not usually have to grow before it is flushed.
+    m_buffer.resize(m_buffer_size + 1024);
+
+    if (m_format == csv && !p_field_names.empty())
+    {
+        for (size_t i = 0; i != p_field_names.size(); ++i)
+        {
+            append(p_field_names[i]);
+        }
+        end_record();
+    }
+}
+
+RecordWriter::~RecordWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+    }
+}
+
+template <typename Number>
+RecordWriter&
+RecordWriter::append_number(Number const& p_value)
+{
+    begin_field();
+    char* const first = reserve(max_numeric_chars);
+    char* const last = to_chars(first, first + max_numeric_chars, p_value);
+    JEWEL_ASSERT (last != nullptr);
+    m_size += (last - first);
+    return *this;
+}
+
+RecordWriter&
+RecordWriter::append(Decimal const& p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(int p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(long p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(long long p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(unsigned int p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(unsigned long p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(unsigned long long p_value)
+{
+    return append_number(p_value);
+}
+
+RecordWriter&
+RecordWriter::append(char const* p_string)
+{
+    return append(p_string, strlen(p_string));
+}
+
+RecordWriter&
+RecordWriter::append(char const* p_data, size_t p_size)
+{
+    begin_field();
+    if (m_format == json_lines)
+    {
+        append_json_text(p_data, p_size);
+    }
+    else
+    {
+        JEWEL_ASSERT (m_format == csv);
+        append_csv_text(p_data, p_size);
+    }
+    return *this;
+}
+
+RecordWriter&
+RecordWriter::append(string const& p_string)
+{
+    return append(p_string.data(), p_string.size());
+}
+
+void
+RecordWriter::end_record()
+{
+    if (m_num_fields != 0 && m_field_index != m_num_fields)
+    {
+        discard_record();
+        JEWEL_THROW
+        (   RecordWriterException,
+            "Record has fewer fields than there are field names."
+        );
+    }
+    if (m_format == json_lines)
+    {
+        *reserve(1) = '}';
+        ++m_size;
+    }
+    *reserve(1) = '\n';
+    ++m_size;
+    m_record_start = m_size;
+    m_field_index = 0;
+    if (m_size >= m_buffer_size)
+    {
+        flush();
+    }
+    return;
+}
+
+void
+RecordWriter::flush()
+{
+    size_t const complete = m_record_start;
+    if (complete == 0)
+    {
+        return;
+    }
+    try
+    {
+        m_sink.write(&m_buffer[0], complete);
+    }
+    catch (...)
+    {
+        remove_complete_records();
+        throw;
+    }
+    remove_complete_records();
+    return;
+}
+
+void
+RecordWriter::begin_field()
+{
+    if (m_num_fields != 0 && m_field_index == m_num_fields)
+    {
+        discard_record();
+        JEWEL_THROW
+        (   RecordWriterException,
+            "Record has more fields than there are field names."
+        );
+    }
+    if (m_format == json_lines)
+    {
+        string const& prefix = m_prefixes[m_field_index];
+        memcpy(reserve(prefix.size()), prefix.data(), prefix.size());
+        m_size += prefix.size();
+    }
+    else if (m_field_index != 0)
+    {
+        JEWEL_ASSERT (m_format == csv);
+        *reserve(1) = ',';
+        ++m_size;
+    }
+    ++m_field_index;
+    return;
+}
+
+void
+RecordWriter::remove_complete_records()
+{
+    // Move any incomplete record to the start of the buffer.
+    size_t const incomplete = m_size - m_record_start;
+    memmove(&m_buffer[0], &m_buffer[0] + m_record_start, incomplete);
+    m_size = incomplete;
+    m_record_start = 0;
+    return;
+}
+
+void
+RecordWriter::discard_record()
+{
+    m_size = m_record_start;
+    m_field_index = 0;
+    return;
+}
+
+char*
+RecordWriter::reserve(size_t p_size)
+{
+    if (m_buffer.size() - m_size < p_size)
+    {
+        try
+        {
+            m_buffer.resize(max(m_buffer.size() * 2, m_size + p_size));
+        }
+        catch (...)
+        {
+            discard_record();
+            throw;
+        }
+    }
+    return &m_buffer[0] + m_size;
+}
+
+void
+RecordWriter::append_csv_text(char const* p_data, size_t p_size)
+{
+    if (!csv_requires_quotes(p_data, p_size))
+    {
+        if (p_size != 0)
+        {
+            memcpy(reserve(p_size), p_data, p_size);
+            m_size += p_size;
+        }
+        return;
+    }
+    char* const first = reserve(2 * p_size + 2);
+    char* out = first;
+    *out++ = '"';
+    for (char const* const end = p_data + p_size; p_data != end; ++p_data)
+    {
+        if (*p_data == '"')
+        {
+            *out++ = '"';
+        }
+        *out++ = *p_data;
+    }
+    *out++ = '"';
+    m_size += (out - first);
+    return;
+}
+
+void
+RecordWriter::append_json_text(char const* p_data, size_t p_size)
+{
+    char* const first = reserve(p_size * max_json_escape_length + 2);
+    char* out = first;
+    *out++ = '"';
+    out = write_json_escaped(p_data, p_size, out);
+    *out++ = '"';
+    m_size += (out - first);
+    return;
+}
+
+}  // namespace jewel
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "to_chars.hpp"
+#include "assert.hpp"
+#include "decimal.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+
+using std::numeric_limits;
+using std::ptrdiff_t;
+using std::snprintf;
+using std::uint64_t;
+
+namespace jewel
+{
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+
+    // p_format should be a printf format for a single floating point
+    // number, with a precision of p_precision.
+    template <typename Float>
+    char* floating_to_chars
+    (   char* p_first,
+        char* p_last,
+        Float p_value,
+        char const* p_format,
+        int p_precision
+    )
+    {
+        char buffer[max_numeric_chars + 1];
+        int const length =
+            snprintf(buffer, sizeof(buffer), p_format, p_precision, p_value);
+        if
+        (   (length < 0) ||
+            (static_cast<std::size_t>(length) >= sizeof(buffer)) ||
+            (length > p_last - p_first)
+        )
+        {
+            return nullptr;
+        }
+        // snprintf uses the decimal point of the current C locale, which
+        // is the only character it writes other than digits, signs,
+        // exponents, "inf" and "nan".
+        for (int i = 0; i != length; ++i)
+        {
+            char const c = buffer[i];
+            bool const is_standard =
+                ((c >= '0') && (c <= '9')) ||
+                (c == '-') || (c == '+') || (c == 'e') ||
+                (c == 'i') || (c == 'n') || (c == 'f') || (c == 'a');
+            *p_first++ = is_standard? c: '.';
+        }
+        return p_first;
+    }
+
+}  // end anonymous namespace
+
+char* to_chars(char* p_first, char* p_last, double p_value)
+{
+    return floating_to_chars
+    (   p_first,
+        p_last,
+        p_value,
+        "%.*g",
+        numeric_limits<double>::max_digits10
+    );
+}
+
+char* to_chars(char* p_first, char* p_last, float p_value)
+{
+    return floating_to_chars
+    (   p_first,
+        p_last,
+        static_cast<double>(p_value),
+        "%.*g",
+        numeric_limits<float>::max_digits10
+    );
+}
+
+char* to_chars(char* p_first, char* p_last, long double p_value)
+{
+    return floating_to_chars
+    (   p_first,
+        p_last,
+        p_value,
+        "%.*Lg",
+        numeric_limits<long double>::max_digits10
+    );
+}
+
+char* to_chars(char* p_first, char* p_last, Decimal const& p_value)
+{
+    int_type const intval = p_value.intval();
+    ptrdiff_t const places = p_value.places();
+    bool const is_negative = (intval < 0);
+    uint64_t const magnitude =
+    (   is_negative?
+        (0 - static_cast<uint64_t>(intval)):
+        static_cast<uint64_t>(intval)
+    );
+    char digits[20];
+    char* const end = digits + sizeof(digits);
+    char const* begin = detail::write_digits_backwards(end, magnitude);
+    ptrdiff_t const num_digits = end - begin;
+
+    // If there are no more digits than places, then the whole part is a
+    // single zero, and the fractional part is padded with leading zeroes.
+    ptrdiff_t const whole_digits =
+        (num_digits > places)? (num_digits - places): 0;
+    ptrdiff_t const padding = (num_digits < places)? (places - num_digits): 0;
+    ptrdiff_t const length =
+        (is_negative? 1: 0) +
+        ((whole_digits == 0)? 1: whole_digits) +
+        ((places == 0)? 0: (1 + places));
+    if (p_last - p_first < length)
+    {
+        return nullptr;
+    }
+    char* out = p_first;
+    if (is_negative)
+    {
+        *out++ = '-';
+    }
+    if (whole_digits == 0)
+    {
+        *out++ = '0';
+    }
+    for (ptrdiff_t i = 0; i != whole_digits; ++i)
+    {
+        *out++ = *begin++;
+    }
+    if (places != 0)
+    {
+        *out++ = '.';
+        for (ptrdiff_t i = 0; i != padding; ++i)
+        {
+            *out++ = '0';
+        }
+        while (begin != end)
+        {
+            *out++ = *begin++;
+        }
+    }
+    JEWEL_ASSERT (out - p_first == length);
+    return out;
+}
+
+}  // namespace jewel
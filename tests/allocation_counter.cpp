@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_counter.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+using std::size_t;
+
+namespace
+{
+    thread_local size_t t_allocations = 0;
+
+    void* counted_allocate(size_t p_size) noexcept
+    {
+        ++t_allocations;
+        return std::malloc((p_size == 0)? 1: p_size);
+    }
+
+}  // end anonymous namespace
+
+namespace jewel
+{
+namespace detail
+{
+
+size_t thread_allocation_count()
+{
+    return t_allocations;
+}
+
+}  // namespace detail
+}  // namespace jewel
+
+void* operator new(size_t p_size)
+{
+    void* const ret = counted_allocate(p_size);
+    if (!ret)
+    {
+        throw std::bad_alloc();
+    }
+    return ret;
+}
+
+void* operator new[](size_t p_size)
+{
+    return operator new(p_size);
+}
+
+void* operator new(size_t p_size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(p_size);
+}
+
+void* operator new[](size_t p_size, std::nothrow_t const&) noexcept
+{
+    return counted_allocate(p_size);
+}
+
+void operator delete(void* p_pointer) noexcept
+{
+    std::free(p_pointer);
+    return;
+}
+
+void operator delete[](void* p_pointer) noexcept
+{
+    std::free(p_pointer);
+    return;
+}
+
+void operator delete(void* p_pointer, size_t) noexcept
+{
+    std::free(p_pointer);
+    return;
+}
+
+void operator delete[](void* p_pointer, size_t) noexcept
+{
+    std::free(p_pointer);
+    return;
+}
+
+void operator delete(void* p_pointer, std::nothrow_t const&) noexcept
+{
+    std::free(p_pointer);
+    return;
+}
+
+void operator delete[](void* p_pointer, std::nothrow_t const&) noexcept
+{
+    std::free(p_pointer);
+    return;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_allocation_counter_hpp_7730915846204521
+#define GUARD_allocation_counter_hpp_7730915846204521
+
+#include <cstddef>
+
+/**
+ * This file declares a means of counting heap allocations, for tests that
+ * check that some operation does not allocate.
+ *
+ * allocation_counter.cpp replaces every form of the global operator new
+ * and operator delete for the whole test driver. The replacements allocate
+ * and free using std::malloc and std::free, and count each allocation
+ * made by the calling thread. They are defined in a translation unit of
+ * their own, so that the compiler cannot inline them into code that pairs
+ * them with the standard library's own versions.
+ */
+
+
+namespace jewel
+{
+
+namespace detail
+{
+
+/**
+ * @returns the number of times the calling thread has called any form of
+ * operator new.
+ */
+std::size_t thread_allocation_count();
+
+}  // namespace detail
+
+}  // namespace jewel
+
+
+#endif  // GUARD_allocation_counter_hpp_7730915846204521
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "detail/bit_packing.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::detail::bits_required;
+using jewel::detail::pack_bits;
+using jewel::detail::packed_word_count;
+using jewel::detail::unpack_bit_field;
+using jewel::detail::unpack_bits;
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+TEST(bit_packing_bits_required)
+{
+    CHECK_EQUAL(bits_required(0), 1u);
+    CHECK_EQUAL(bits_required(1), 1u);
+    CHECK_EQUAL(bits_required(2), 2u);
+    CHECK_EQUAL(bits_required(255), 8u);
+    CHECK_EQUAL(bits_required(256), 9u);
+    CHECK_EQUAL(bits_required(4095), 12u);
+    CHECK_EQUAL(bits_required(0xFFFFFFFFu), 32u);
+    CHECK_EQUAL(bits_required(0x100000000ULL), 33u);
+    CHECK_EQUAL(bits_required(~static_cast<uint64_t>(0)), 64u);
+}
+
+TEST(bit_packing_round_trip)
+{
+    for (unsigned int width = 1; width <= 32; ++width)
+    {
+        size_t const count = 1000;
+        uint64_t const mask = (static_cast<uint64_t>(1) << width) - 1;
+        vector<uint32_t> in(count);
+        uint64_t x = 88172645463325252ULL;
+        for (size_t i = 0; i != count; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            in[i] = static_cast<uint32_t>(x & mask);
+        }
+        in[count - 1] = static_cast<uint32_t>(mask);
+        vector<uint64_t> words(packed_word_count(count, width), 0);
+
+        // Pack in two pieces, to exercise a non-zero starting position.
+        pack_bits(&in[0], 300, width, 0, &words[0]);
+        pack_bits(&in[300], count - 300, width, 300, &words[0]);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQUAL(unpack_bit_field(&words[0], width, i), in[i]);
+        }
+        vector<uint32_t> out(count - 7);
+        unpack_bits(&words[0], width, 7, out.size(), &out[0]);
+        for (size_t i = 0; i != out.size(); ++i)
+        {
+            CHECK_EQUAL(out[i], in[i + 7]);
+        }
+    }
+}
+
+TEST(bit_packing_round_trip_wide)
+{
+    for (unsigned int width = 33; width <= 64; ++width)
+    {
+        size_t const count = 300;
+        uint64_t const mask = ~static_cast<uint64_t>(0) >> (64 - width);
+        vector<uint64_t> in(count);
+        uint64_t x = 2463534242ULL;
+        for (size_t i = 0; i != count; ++i)
+        {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            in[i] = x & mask;
+        }
+        in[0] = mask;
+        in[1] = 0;
+        vector<uint64_t> words(packed_word_count(count, width), 0);
+        pack_bits(&in[0], count, width, 0, &words[0]);
+        vector<uint64_t> out(count);
+        unpack_bits(&words[0], width, 0, count, &out[0]);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQUAL(unpack_bit_field(&words[0], width, i), in[i]);
+            CHECK_EQUAL(out[i], in[i]);
+        }
+    }
+}
@@ -19,6 +19,7 @@
 #include "log.hpp"
 #include <UnitTest++/UnitTest++.h>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -811,3 +812,16 @@ TEST(capped_string_resize)
     cs1.resize(2);
     CHECK_EQUAL(cs1.size(), static_cast<size_t>(2));
 }
+
+TEST(capped_string_hash)
+{
+    std::hash<CappedString<16> > const hasher;
+    CappedString<16> const cs0("ACC-1001");
+    CappedString<16> const cs1(std::string("ACC-1001"));
+    CappedString<16> const cs2("ACC-1002");
+    CappedString<16> const cs3("ACC-100");
+    CHECK_EQUAL(hasher(cs0), hasher(cs1));
+    CHECK(hasher(cs0) != hasher(cs2));
+    CHECK(hasher(cs0) != hasher(cs3));
+    CHECK(hasher(CappedString<16>()) != hasher(cs3));
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal64.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalRangeException;
+using jewel::from_decimal64;
+using jewel::to_decimal64;
+using std::numeric_limits;
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+namespace
+{
+    typedef Decimal::int_type int_type;
+    typedef Decimal::places_type places_type;
+
+    // Mantissas that can be represented exactly in decimal64 at any
+    // number of places Decimal supports.
+    vector<int_type> representable_intvals()
+    {
+        int_type const largest_coefficient = 9999999999999999LL;
+        vector<int_type> ret;
+        ret.push_back(0);
+        ret.push_back(1);
+        ret.push_back(7);
+        ret.push_back(1000000000000000LL);
+        ret.push_back(9007199254740991LL);  // just under 2^53
+        ret.push_back(9007199254740992LL);  // 2^53
+        ret.push_back(largest_coefficient);
+        ret.push_back(largest_coefficient * 100);  // trailing zeroes
+        ret.push_back(1000000000000000000LL);
+        ret.push_back(numeric_limits<int_type>::max() / 1000 * 1000);
+        size_t const sz = ret.size();
+        for (size_t i = 0; i != sz; ++i)
+        {
+            ret.push_back(-ret[i]);
+        }
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal64_known_encodings)
+{
+    CHECK_EQUAL(to_decimal64(Decimal("1")), 0x31C0000000000001ULL);
+    CHECK_EQUAL(to_decimal64(Decimal("-1.50")), 0xB180000000000096ULL);
+    CHECK_EQUAL
+    (   to_decimal64(Decimal("9999999999999999")),
+        0x6C7386F26FC0FFFFULL
+    );
+    CHECK_EQUAL(to_decimal64(Decimal("0")), 0x31C0000000000000ULL);
+    CHECK_EQUAL(from_decimal64(0x31C0000000000001ULL), Decimal("1"));
+    CHECK_EQUAL(from_decimal64(0xB180000000000096ULL).places(), 2);
+    CHECK_EQUAL(from_decimal64(0xB180000000000096ULL), Decimal("-1.5"));
+    CHECK_EQUAL
+    (   from_decimal64(0x6C7386F26FC0FFFFULL),
+        Decimal("9999999999999999")
+    );
+}
+
+TEST(decimal64_round_trip_all_places)
+{
+    vector<int_type> const intvals = representable_intvals();
+    for (places_type p = 0; p <= Decimal::maximum_precision(); ++p)
+    {
+        for (auto intval: intvals)
+        {
+            Decimal const d(intval, p);
+            Decimal const e = from_decimal64(to_decimal64(d));
+            CHECK_EQUAL(e, d);
+            if (intval % 10 != 0 || intval == 0)
+            {
+                CHECK_EQUAL(e.places(), d.places());
+                CHECK_EQUAL(e.intval(), d.intval());
+            }
+        }
+    }
+}
+
+TEST(decimal64_unrepresentable_decimals)
+{
+    int_type const seventeen_digits = 12345678901234567LL;
+    for (places_type p = 0; p <= Decimal::maximum_precision(); ++p)
+    {
+        CHECK_THROW
+        (   to_decimal64(Decimal(seventeen_digits, p)),
+            DecimalRangeException
+        );
+        CHECK_THROW(to_decimal64(Decimal::maximum()), DecimalRangeException);
+        CHECK_THROW(to_decimal64(Decimal::minimum()), DecimalRangeException);
+        CHECK_THROW
+        (   to_decimal64(Decimal(-seventeen_digits, p)),
+            DecimalRangeException
+        );
+    }
+}
+
+TEST(decimal64_exponent_extremes)
+{
+    // Coefficient 1 with exponents at and beyond the range of Decimal
+    uint64_t const one_e0 = 0x31C0000000000001ULL;
+    uint64_t const exponent_unit = 1ULL << 53;
+    Decimal const one_e18 = from_decimal64(one_e0 + 18 * exponent_unit);
+    CHECK_EQUAL(one_e18, Decimal("1000000000000000000"));
+    CHECK_THROW
+    (   from_decimal64(one_e0 + 19 * exponent_unit),
+        DecimalRangeException
+    );
+    Decimal const one_e_neg19 = from_decimal64(one_e0 - 19 * exponent_unit);
+    CHECK_EQUAL(one_e_neg19, Decimal(1, Decimal::maximum_precision()));
+    CHECK_THROW
+    (   from_decimal64(one_e0 - 20 * exponent_unit),
+        DecimalRangeException
+    );
+
+    // 10E-20 is exactly representable after dropping a trailing zero.
+    CHECK_EQUAL
+    (   from_decimal64(one_e0 + 9 - 20 * exponent_unit),
+        Decimal(1, Decimal::maximum_precision())
+    );
+
+    // Zero with extreme exponents
+    CHECK_EQUAL(from_decimal64(0x0000000000000000ULL), Decimal("0"));
+    CHECK_EQUAL
+    (   from_decimal64(0x0000000000000000ULL).places(),
+        Decimal::maximum_precision()
+    );
+    CHECK_EQUAL(from_decimal64(0x5FE0000000000000ULL).places(), 0);
+
+    // Extremes of int_type, via exponent
+    uint64_t const nine_e18 = to_decimal64(Decimal("9000000000000000000"));
+    CHECK_EQUAL(from_decimal64(nine_e18), Decimal("9000000000000000000"));
+    uint64_t const neg_nine_e18 =
+        to_decimal64(Decimal("-9000000000000000000"));
+    CHECK_EQUAL(from_decimal64(neg_nine_e18), Decimal("-9000000000000000000"));
+    CHECK_THROW
+    (   from_decimal64(to_decimal64(Decimal("9300000000000000000"))),
+        DecimalRangeException
+    );
+}
+
+TEST(decimal64_special_values)
+{
+    uint64_t const infinity = 0x7800000000000000ULL;
+    uint64_t const negative_infinity = 0xF800000000000000ULL;
+    uint64_t const quiet_nan = 0x7C00000000000000ULL;
+    uint64_t const signalling_nan = 0x7E00000000000000ULL;
+    CHECK_THROW(from_decimal64(infinity), DecimalRangeException);
+    CHECK_THROW(from_decimal64(negative_infinity), DecimalRangeException);
+    CHECK_THROW(from_decimal64(quiet_nan), DecimalRangeException);
+    CHECK_THROW(from_decimal64(signalling_nan), DecimalRangeException);
+
+    // Non-canonical coefficient is treated as zero.
+    uint64_t const non_canonical = 0x6C7FFFFFFFFFFFFFULL;
+    CHECK_EQUAL(from_decimal64(non_canonical), Decimal("0"));
+
+    // Negative zero
+    CHECK_EQUAL(from_decimal64(0xB1C0000000000000ULL), Decimal("0"));
+}
+
+TEST(decimal64_batch_conversion)
+{
+    vector<Decimal> decimals;
+    for (auto intval: representable_intvals())
+    {
+        decimals.push_back(Decimal(intval, 4));
+    }
+    vector<uint64_t> encoded(decimals.size());
+    CHECK_EQUAL
+    (   to_decimal64(&decimals[0], &encoded[0], decimals.size()),
+        decimals.size()
+    );
+    vector<Decimal> decoded(decimals.size());
+    CHECK_EQUAL
+    (   from_decimal64(&encoded[0], &decoded[0], encoded.size()),
+        encoded.size()
+    );
+    for (size_t i = 0; i != decimals.size(); ++i)
+    {
+        CHECK_EQUAL(encoded[i], to_decimal64(decimals[i]));
+        CHECK_EQUAL(decoded[i], decimals[i]);
+    }
+
+    // Conversion stops at the first failure.
+    decimals[3] = Decimal::maximum();
+    CHECK_EQUAL
+    (   to_decimal64(&decimals[0], &encoded[0], decimals.size()),
+        size_t(3)
+    );
+    encoded[5] = 0x7800000000000000ULL;
+    CHECK_EQUAL
+    (   from_decimal64(&encoded[0], &decoded[0], encoded.size()),
+        size_t(5)
+    );
+    CHECK_EQUAL(to_decimal64(&decimals[0], &encoded[0], 0), size_t(0));
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal_allocation.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <cstddef>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalDivisionByZeroException;
+using jewel::DecimalDomainException;
+using jewel::DecimalRangeException;
+using jewel::allocate;
+using std::size_t;
+using std::vector;
+
+namespace
+{
+    Decimal sum(vector<Decimal> const& p_vec)
+    {
+        Decimal ret;
+        for (auto const& d: p_vec)
+        {
+            ret += d;
+        }
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal_allocate_simple)
+{
+    vector<Decimal> const weights(3, Decimal("1"));
+    vector<Decimal> out(3);
+    allocate(Decimal("100"), &weights[0], weights.size(), 2, &out[0]);
+    CHECK_EQUAL(out[0], Decimal("33.34"));
+    CHECK_EQUAL(out[1], Decimal("33.33"));
+    CHECK_EQUAL(out[2], Decimal("33.33"));
+    for (auto const& part: out)
+    {
+        CHECK_EQUAL(part.places(), 2);
+    }
+
+    allocate(Decimal("-100"), &weights[0], weights.size(), 2, &out[0]);
+    CHECK_EQUAL(out[0], Decimal("-33.34"));
+    CHECK_EQUAL(out[1], Decimal("-33.33"));
+    CHECK_EQUAL(out[2], Decimal("-33.33"));
+
+    allocate(Decimal("0"), &weights[0], weights.size(), 1, &out[0]);
+    CHECK_EQUAL(out[0], Decimal("0"));
+    CHECK_EQUAL(out[2].places(), 1);
+}
+
+TEST(decimal_allocate_largest_remainder)
+{
+    vector<Decimal> weights;
+    weights.push_back(Decimal("0.2"));
+    weights.push_back(Decimal("0.45"));
+    weights.push_back(Decimal("0"));
+    weights.push_back(Decimal("0.35"));
+    vector<Decimal> out(weights.size());
+
+    // Exact shares are 0.02, 0.045, 0 and 0.035.
+    allocate(Decimal("0.10"), &weights[0], weights.size(), 2, &out[0]);
+    CHECK_EQUAL(out[0], Decimal("0.02"));
+    CHECK_EQUAL(out[1], Decimal("0.05"));
+    CHECK_EQUAL(out[2], Decimal("0"));
+    CHECK_EQUAL(out[3], Decimal("0.03"));
+
+    // Exact shares are 0.2, 0.45, 0 and 0.35.
+    allocate(Decimal("1"), &weights[0], weights.size(), 1, &out[0]);
+    CHECK_EQUAL(out[0], Decimal("0.2"));
+    CHECK_EQUAL(out[1], Decimal("0.5"));
+    CHECK_EQUAL(out[3], Decimal("0.3"));
+
+    // Total with fewer places than requested, and places beyond those of
+    // the total that are zero.
+    allocate(Decimal("7.000"), &weights[0], weights.size(), 0, &out[0]);
+    CHECK_EQUAL(out[0], Decimal("1"));
+    CHECK_EQUAL(out[1], Decimal("3"));
+    CHECK_EQUAL(out[3], Decimal("3"));
+    CHECK_EQUAL(sum(out), Decimal("7"));
+}
+
+TEST(decimal_allocate_sums_exactly)
+{
+    size_t const n = 10007;
+    vector<Decimal> weights;
+    for (size_t i = 0; i != n; ++i)
+    {
+        weights.push_back
+        (   Decimal
+            (   static_cast<Decimal::int_type>((i * 7919) % 1000 + 1),
+                static_cast<Decimal::places_type>(i % 4)
+            )
+        );
+    }
+    vector<Decimal> out(n);
+    Decimal const totals[] =
+    {   Decimal("1234567.89"),
+        Decimal("-0.01"),
+        Decimal("9.99"),
+        Decimal("92233720368547758.07")
+    };
+    for (auto const& total: totals)
+    {
+        allocate(total, &weights[0], n, 2, &out[0]);
+        CHECK_EQUAL(sum(out), total);
+    }
+
+    // Very large weights, whose sum doesn't fit in 64 bits
+    vector<Decimal> big_weights(5, Decimal::maximum());
+    big_weights[2] = Decimal("1");
+    vector<Decimal> big_out(5);
+    allocate
+    (   Decimal::minimum(),
+        &big_weights[0],
+        big_weights.size(),
+        0,
+        &big_out[0]
+    );
+    CHECK_EQUAL(big_out[0], Decimal("-2305843009213693952"));
+    CHECK_EQUAL(big_out[1], Decimal("-2305843009213693952"));
+    CHECK_EQUAL(big_out[2], Decimal("0"));
+    CHECK_EQUAL(big_out[3], Decimal("-2305843009213693952"));
+    CHECK_EQUAL(big_out[4], Decimal("-2305843009213693952"));
+}
+
+TEST(decimal_allocate_exceptions)
+{
+    vector<Decimal> weights(3, Decimal("1"));
+    vector<Decimal> out(3, Decimal("5"));
+    CHECK_THROW
+    (   allocate(Decimal("1.001"), &weights[0], 3, 2, &out[0]),
+        DecimalRangeException
+    );
+    CHECK_THROW
+    (   allocate(Decimal::maximum(), &weights[0], 3, 1, &out[0]),
+        DecimalRangeException
+    );
+    CHECK_THROW
+    (   allocate(Decimal("1"), &weights[0], 3, 20, &out[0]),
+        DecimalRangeException
+    );
+    CHECK_THROW
+    (   allocate(Decimal("1"), &weights[0], 0, 2, &out[0]),
+        DecimalDivisionByZeroException
+    );
+    weights[1] = Decimal("0.0000000000000000001");
+    weights[2] = Decimal("100");
+    CHECK_THROW
+    (   allocate(Decimal("1"), &weights[0], 3, 2, &out[0]),
+        DecimalRangeException
+    );
+    weights[1] = Decimal("-1");
+    CHECK_THROW
+    (   allocate(Decimal("1"), &weights[0], 3, 2, &out[0]),
+        DecimalDomainException
+    );
+    weights = vector<Decimal>(3, Decimal("0"));
+    CHECK_THROW
+    (   allocate(Decimal("1"), &weights[0], 3, 2, &out[0]),
+        DecimalDivisionByZeroException
+    );
+
+    // Strong guarantee
+    for (auto const& d: out)
+    {
+        CHECK_EQUAL(d, Decimal("5"));
+        CHECK_EQUAL(d.places(), 0);
+    }
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_column.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalColumn;
+using jewel::DecimalColumnException;
+using jewel::DecimalColumnWriter;
+using jewel::DecimalRangeException;
+using jewel::detail::DecimalColumnBlockInfo;
+using jewel::detail::DecimalColumnHeader;
+using std::fstream;
+using std::ios;
+using std::ofstream;
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace
+{
+    string const column_filepath = "decimal_column_test.dat";
+
+    vector<Decimal> make_values()
+    {
+        vector<Decimal> ret;
+        for (int i = 0; i != 1000; ++i)
+        {
+            // A slowly increasing series with mixed scales.
+            ret.push_back(Decimal(i * 25 - 3000, (i % 3 == 0)? 1: 2));
+        }
+        ret.push_back(Decimal("-0.0001"));
+        return ret;
+    }
+
+    // Writes a valid column of 5 values in blocks of 2, and returns its
+    // header.
+    DecimalColumnHeader write_small_column()
+    {
+        {
+            DecimalColumnWriter writer
+            (   column_filepath,
+                DecimalColumnWriter::per_block_scale,
+                0,
+                2
+            );
+            for (int i = 0; i != 5; ++i)
+            {
+                writer.append(Decimal(i, 1));
+            }
+        }
+        DecimalColumnHeader header;
+        fstream file(column_filepath.c_str(), ios::in | ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        return header;
+    }
+
+    void overwrite(std::streamoff p_offset, void const* p_data, size_t p_size)
+    {
+        fstream file
+        (   column_filepath.c_str(),
+            ios::in | ios::out | ios::binary
+        );
+        file.seekp(p_offset);
+        file.write(static_cast<char const*>(p_data), p_size);
+        return;
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal_column_round_trip_per_block_scale)
+{
+    vector<Decimal> const values = make_values();
+    {
+        DecimalColumnWriter writer
+        (   column_filepath,
+            DecimalColumnWriter::per_block_scale,
+            0,
+            64
+        );
+        writer.append(&values[0], values.size());
+        writer.close();
+        writer.close();  // no further effect
+    }
+    DecimalColumn const column(column_filepath);
+    CHECK_EQUAL(column.size(), values.size());
+    CHECK_EQUAL(column.block_size(), size_t(64));
+    CHECK_EQUAL(column.block_count(), (values.size() + 63) / 64);
+    for (size_t i = 0; i != values.size(); ++i)
+    {
+        CHECK_EQUAL(column[i], values[i]);
+    }
+    DecimalColumn::Block const last = column.block(column.block_count() - 1);
+    CHECK_EQUAL(last.size(), values.size() % 64);
+    CHECK_EQUAL(last.places(), 4);
+    CHECK_EQUAL(last[last.size() - 1], Decimal("-0.0001"));
+    DecimalColumn::Block const first = column.block(0);
+    CHECK_EQUAL(first.places(), 2);
+    CHECK_EQUAL(first.intvals()[1], -2975);
+    CHECK_EQUAL(first.minimum(), Decimal("-300"));
+    CHECK_EQUAL(first.maximum(), Decimal("-14.5"));
+}
+
+TEST(decimal_column_fixed_scale)
+{
+    {
+        DecimalColumnWriter writer
+        (   column_filepath,
+            DecimalColumnWriter::fixed_scale,
+            2,
+            3
+        );
+        writer.append(Decimal("1.005"));
+        writer.append(Decimal("-7"));
+        writer.append(Decimal("0.1"));
+        writer.append(Decimal("100"));
+    }
+    DecimalColumn const column(column_filepath);
+    CHECK_EQUAL(column.size(), size_t(4));
+    CHECK_EQUAL(column.block_count(), size_t(2));
+    CHECK_EQUAL(column[0], Decimal("1.01"));
+    CHECK_EQUAL(column[1], Decimal("-7"));
+    CHECK_EQUAL(column[2], Decimal("0.1"));
+    CHECK_EQUAL(column[3], Decimal("100"));
+    for (size_t i = 0; i != column.block_count(); ++i)
+    {
+        CHECK_EQUAL(column.block(i).places(), 2);
+    }
+    CHECK_EQUAL(column.block(0).intvals()[1], -700);
+}
+
+TEST(decimal_column_for_each_in_range)
+{
+    vector<Decimal> const values = make_values();
+    {
+        DecimalColumnWriter writer
+        (   column_filepath,
+            DecimalColumnWriter::per_block_scale,
+            0,
+            50
+        );
+        writer.append(&values[0], values.size());
+    }
+    DecimalColumn const column(column_filepath);
+    Decimal const lower("-1.005");
+    Decimal const upper("12.3");
+    vector<size_t> found;
+    size_t const count = column.for_each_in_range
+    (   lower,
+        upper,
+        [&found](size_t i, Decimal const& x)
+        {
+            CHECK(x >= Decimal("-1.005"));
+            CHECK(x <= Decimal("12.3"));
+            found.push_back(i);
+        }
+    );
+    CHECK_EQUAL(count, found.size());
+    vector<size_t> expected;
+    for (size_t i = 0; i != values.size(); ++i)
+    {
+        if (values[i] >= lower && values[i] <= upper) expected.push_back(i);
+    }
+    CHECK(!expected.empty());
+    CHECK(found == expected);
+
+    // Ranges beyond the extremes of int_type at the block scale
+    size_t const all = column.for_each_in_range
+    (   Decimal::minimum(),
+        Decimal::maximum(),
+        [](size_t, Decimal const&) {}
+    );
+    CHECK_EQUAL(all, values.size());
+    size_t const none = column.for_each_in_range
+    (   upper,
+        lower,
+        [](size_t, Decimal const&) {}
+    );
+    CHECK_EQUAL(none, size_t(0));
+}
+
+TEST(decimal_column_exceptions)
+{
+    CHECK_THROW
+    (   DecimalColumnWriter
+        (   column_filepath,
+            DecimalColumnWriter::per_block_scale,
+            0,
+            0
+        ),
+        DecimalColumnException
+    );
+    {
+        DecimalColumnWriter writer
+        (   column_filepath,
+            DecimalColumnWriter::per_block_scale,
+            0,
+            2
+        );
+        writer.append(Decimal::maximum());
+        CHECK_THROW(writer.append(Decimal("0.1")), DecimalRangeException);
+    }
+    {
+        DecimalColumnWriter writer
+        (   column_filepath,
+            DecimalColumnWriter::fixed_scale,
+            3
+        );
+        CHECK_THROW(writer.append(Decimal::maximum()), DecimalRangeException);
+    }
+    CHECK_THROW
+    (   DecimalColumn("nonexistent_decimal_column.dat"),
+        DecimalColumnException
+    );
+    {
+        ofstream garbage(column_filepath.c_str());
+        garbage << "This is not a Decimal column file, but it is long enough "
+                << "to contain a header.";
+    }
+    CHECK_THROW
+    (   DecimalColumn column(column_filepath),
+        DecimalColumnException
+    );
+}
+
+TEST(decimal_column_append_after_range_error)
+{
+    {
+        DecimalColumnWriter writer
+        (   column_filepath,
+            DecimalColumnWriter::per_block_scale,
+            0,
+            2
+        );
+        writer.append(Decimal("1000000000000000000"));
+        CHECK_THROW(writer.append(Decimal("0.01")), DecimalRangeException);
+        writer.append(Decimal("7"));
+        writer.append(Decimal("0.01"));
+        CHECK_THROW
+        (   writer.append(Decimal("1000000000000000000")),
+            DecimalRangeException
+        );
+        writer.append(Decimal("-3.5"));
+        writer.close();
+    }
+    DecimalColumn const column(column_filepath);
+    CHECK_EQUAL(column.size(), size_t(4));
+    CHECK_EQUAL(column[0], Decimal("1000000000000000000"));
+    CHECK_EQUAL(column[1], Decimal("7"));
+    CHECK_EQUAL(column[2], Decimal("0.01"));
+    CHECK_EQUAL(column[3], Decimal("-3.5"));
+}
+
+TEST(decimal_column_corrupt_block_table)
+{
+    DecimalColumnHeader header = write_small_column();
+    CHECK_EQUAL(DecimalColumn(column_filepath).size(), size_t(5));
+
+    // A block count large enough to wrap when multiplied by the size of a
+    // block table entry.
+    header.block_count = (std::uint64_t(1) << 59) + 2;
+    overwrite(0, &header, sizeof(header));
+    CHECK_THROW
+    (   DecimalColumn column(column_filepath),
+        DecimalColumnException
+    );
+
+    // A block other than the last that is not full.
+    header = write_small_column();
+    DecimalColumnBlockInfo info;
+    {
+        fstream file(column_filepath.c_str(), ios::in | ios::binary);
+        file.seekg(header.block_table_offset);
+        file.read(reinterpret_cast<char*>(&info), sizeof(info));
+    }
+    info.count = 1;
+    overwrite(header.block_table_offset, &info, sizeof(info));
+    CHECK_THROW
+    (   DecimalColumn column(column_filepath),
+        DecimalColumnException
+    );
+
+    // Block counts that don't add up to the number of values.
+    header = write_small_column();
+    header.value_count = 4;
+    overwrite(0, &header, sizeof(header));
+    CHECK_THROW
+    (   DecimalColumn column(column_filepath),
+        DecimalColumnException
+    );
+}
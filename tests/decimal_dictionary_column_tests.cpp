@@ -0,0 +1,169 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_dictionary_column.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <cstddef>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalAdditionException;
+using jewel::DecimalDictionaryColumn;
+using jewel::DecimalRangeException;
+using std::size_t;
+using std::vector;
+
+namespace
+{
+    vector<Decimal> make_prices()
+    {
+        vector<Decimal> ret;
+        for (int i = 0; i != 5000; ++i)
+        {
+            // 37 distinct price levels, some with fewer places.
+            int const level = (i * 7919) % 37 - 10;
+            ret.push_back
+            (   (level % 4 == 0)?
+                Decimal(level / 4 + 100, 0):
+                Decimal(level * 25 + 10000, 2)
+            );
+        }
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal_dictionary_column_round_trip)
+{
+    vector<Decimal> const prices = make_prices();
+    DecimalDictionaryColumn const column(&prices[0], prices.size());
+    CHECK_EQUAL(column.size(), prices.size());
+    CHECK_EQUAL(column.places(), 2);
+    CHECK_EQUAL(column.dictionary_size(), 37u);
+    CHECK_EQUAL(column.code_width(), 6u);
+    CHECK(column.memory_usage() < prices.size() * sizeof(Decimal) / 10);
+    for (size_t i = 0; i != prices.size(); ++i)
+    {
+        CHECK_EQUAL(column[i], prices[i]);
+        CHECK_EQUAL(column[i].places(), 2);
+    }
+    for (size_t c = 1; c < column.dictionary_size(); ++c)
+    {
+        CHECK(column.dictionary_entry(c - 1) < column.dictionary_entry(c));
+    }
+    vector<Decimal> decoded(100);
+    column.decode(4321, decoded.size(), &decoded[0]);
+    for (size_t i = 0; i != decoded.size(); ++i)
+    {
+        CHECK_EQUAL(decoded[i], prices[4321 + i]);
+    }
+}
+
+TEST(decimal_dictionary_column_small)
+{
+    DecimalDictionaryColumn const empty;
+    CHECK_EQUAL(empty.size(), 0u);
+    CHECK_EQUAL(empty.dictionary_size(), 0u);
+    CHECK_EQUAL(empty.sum(), Decimal("0"));
+    CHECK_EQUAL(empty.count_in_range(Decimal("-1"), Decimal("1")), 0u);
+
+    vector<Decimal> values;
+    values.push_back(Decimal("1.5"));
+    values.push_back(Decimal("1.50"));
+    values.push_back(Decimal("-2.25"));
+    values.push_back(Decimal("1.5"));
+    DecimalDictionaryColumn const column(&values[0], values.size());
+    CHECK_EQUAL(column.dictionary_size(), 2u);
+    CHECK_EQUAL(column.code_width(), 1u);
+    CHECK_EQUAL(column.code(0), 1u);
+    CHECK_EQUAL(column.code(2), 0u);
+    CHECK_EQUAL(column[0], Decimal("1.50"));
+    CHECK_EQUAL(column[2], Decimal("-2.25"));
+    CHECK_EQUAL(column.sum(), Decimal("2.25"));
+
+    vector<Decimal> bad;
+    bad.push_back(Decimal::maximum());
+    bad.push_back(Decimal("0.1"));
+    CHECK_THROW
+    (   DecimalDictionaryColumn(&bad[0], bad.size()),
+        DecimalRangeException
+    );
+    vector<Decimal> big(2, Decimal::maximum());
+    DecimalDictionaryColumn const big_column(&big[0], big.size());
+    CHECK_THROW(big_column.sum(), DecimalAdditionException);
+    CHECK_EQUAL
+    (   big_column.sum_in_range(Decimal("0"), Decimal("1")),
+        Decimal("0")
+    );
+}
+
+TEST(decimal_dictionary_column_aggregation_and_ranges)
+{
+    vector<Decimal> const prices = make_prices();
+    DecimalDictionaryColumn const column(&prices[0], prices.size());
+
+    Decimal expected_sum;
+    for (size_t i = 0; i != prices.size(); ++i)
+    {
+        expected_sum += prices[i];
+    }
+    CHECK_EQUAL(column.sum(), expected_sum);
+
+    Decimal const lower("99.255");
+    Decimal const upper("101");
+    Decimal expected_range_sum;
+    size_t expected_count = 0;
+    for (size_t i = 0; i != prices.size(); ++i)
+    {
+        if (lower <= prices[i] && prices[i] <= upper)
+        {
+            expected_range_sum += prices[i];
+            ++expected_count;
+        }
+    }
+    CHECK(expected_count > 0);
+    CHECK(expected_count < prices.size());
+    CHECK_EQUAL(column.count_in_range(lower, upper), expected_count);
+    CHECK_EQUAL(column.sum_in_range(lower, upper), expected_range_sum);
+
+    vector<size_t> positions;
+    size_t const n = column.for_each_in_range
+    (   lower,
+        upper,
+        [&](size_t i, Decimal const& x)
+        {
+            CHECK_EQUAL(x, prices[i]);
+            positions.push_back(i);
+        }
+    );
+    CHECK_EQUAL(n, expected_count);
+    CHECK_EQUAL(positions.size(), expected_count);
+
+    DecimalDictionaryColumn::code_type first = 99;
+    DecimalDictionaryColumn::code_type last = 99;
+    CHECK(!column.code_bounds(Decimal("1000"), Decimal("2000"), first, last));
+    CHECK(!column.code_bounds(upper, lower, first, last));
+    CHECK_EQUAL(first, 99u);
+    CHECK(column.code_bounds(Decimal("-1000"), Decimal("1000"), first, last));
+    CHECK_EQUAL(first, 0u);
+    CHECK_EQUAL(last, column.dictionary_size() - 1);
+    CHECK_EQUAL
+    (   column.count_in_range(Decimal("-1000"), Decimal("1000")),
+        prices.size()
+    );
+}
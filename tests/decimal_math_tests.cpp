@@ -0,0 +1,151 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_math.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalDivisionByZeroException;
+using jewel::DecimalDomainException;
+using jewel::DecimalRangeException;
+using jewel::exp;
+using jewel::ln;
+using jewel::pow;
+using jewel::sqrt;
+
+TEST(decimal_math_sqrt)
+{
+    CHECK_EQUAL(sqrt(Decimal("4"), 0), Decimal("2"));
+    CHECK_EQUAL(sqrt(Decimal("0"), 5), Decimal("0"));
+    CHECK_EQUAL(sqrt(Decimal("0"), 5).places(), 5);
+    CHECK_EQUAL(sqrt(Decimal("2"), 10), Decimal("1.4142135624"));
+    CHECK_EQUAL(sqrt(Decimal("2"), 10).places(), 10);
+    CHECK_EQUAL(sqrt(Decimal("2"), 18), Decimal("1.414213562373095049"));
+    CHECK_EQUAL(sqrt(Decimal("0.25"), 2), Decimal("0.50"));
+    CHECK_EQUAL(sqrt(Decimal("0.25"), 2).places(), 2);
+    CHECK_EQUAL
+    (   sqrt(Decimal("0.0000000000000000002"), 19),
+        Decimal("0.0000000004472135955")
+    );
+    CHECK_EQUAL(sqrt(Decimal::maximum(), 0), Decimal("3037000500"));
+
+    // Exact halves round away from zero.
+    CHECK_EQUAL(sqrt(Decimal("0.0625"), 1), Decimal("0.3"));
+    CHECK_EQUAL(sqrt(Decimal("6.25"), 1), Decimal("2.5"));
+    CHECK_EQUAL(sqrt(Decimal("6.25"), 0), Decimal("3"));
+
+    CHECK_THROW(sqrt(Decimal("-0.01"), 2), DecimalDomainException);
+    CHECK_THROW(sqrt(Decimal("2"), 19), DecimalRangeException);
+    CHECK_THROW(sqrt(Decimal::maximum(), 10), DecimalRangeException);
+    CHECK_THROW(sqrt(Decimal("2"), 20), DecimalRangeException);
+}
+
+TEST(decimal_math_pow)
+{
+    CHECK_EQUAL(pow(Decimal("1.5"), 2, 2), Decimal("2.25"));
+    CHECK_EQUAL(pow(Decimal("1.5"), 2, 1), Decimal("2.3"));
+    CHECK_EQUAL(pow(Decimal("-1.5"), 3, 3), Decimal("-3.375"));
+    CHECK_EQUAL(pow(Decimal("2"), -2, 2), Decimal("0.25"));
+    CHECK_EQUAL(pow(Decimal("3"), -1, 5), Decimal("0.33333"));
+    CHECK_EQUAL(pow(Decimal("7.3"), 0, 3), Decimal("1"));
+    CHECK_EQUAL(pow(Decimal("7.3"), 0, 3).places(), 3);
+    CHECK_EQUAL(pow(Decimal("0"), 0, 0), Decimal("1"));
+    CHECK_EQUAL(pow(Decimal("0"), 5, 2), Decimal("0"));
+    CHECK_EQUAL(pow(Decimal("10"), 18, 0), Decimal("1000000000000000000"));
+    CHECK_EQUAL(pow(Decimal("1.0001"), 10000, 10), Decimal("2.7181459268"));
+    CHECK_EQUAL(pow(Decimal("1.07"), 30, 12), Decimal("7.612255042662"));
+    CHECK_EQUAL(pow(Decimal("0.95"), -40, 12), Decimal("7.781365022020"));
+    CHECK_EQUAL(pow(Decimal("0.5"), 1000, 5), Decimal("0"));
+    CHECK_EQUAL(pow(Decimal("-0.5"), 1000000001, 19), Decimal("0"));
+
+    CHECK_THROW(pow(Decimal("0"), -1, 2), DecimalDivisionByZeroException);
+    CHECK_THROW(pow(Decimal("10"), 19, 0), DecimalRangeException);
+    CHECK_THROW(pow(Decimal("1.1"), 1000000, 0), DecimalRangeException);
+    CHECK_THROW(pow(Decimal("0.1"), -19, 0), DecimalRangeException);
+    CHECK_THROW(pow(Decimal("2"), 2, 20), DecimalRangeException);
+}
+
+TEST(decimal_math_exp)
+{
+    CHECK_EQUAL(exp(Decimal("0"), 5), Decimal("1"));
+    CHECK_EQUAL(exp(Decimal("0"), 5).places(), 5);
+    CHECK_EQUAL(exp(Decimal("1"), 18), Decimal("2.718281828459045235"));
+    CHECK_EQUAL(exp(Decimal("-1"), 18), Decimal("0.367879441171442322"));
+    CHECK_EQUAL(exp(Decimal("0.5"), 18), Decimal("1.648721270700128147"));
+    CHECK_EQUAL(exp(Decimal("10"), 10), Decimal("22026.4657948067"));
+    CHECK_EQUAL(exp(Decimal("-20.123"), 15), Decimal("0.000000001822603"));
+    CHECK_EQUAL
+    (   exp(Decimal("0.0000000000000000001"), 18),
+        Decimal("1")
+    );
+    CHECK_EQUAL
+    (   exp(Decimal("0.6931471805599453094"), 18),
+        Decimal("2")
+    );
+    CHECK_EQUAL(exp(Decimal("43.5"), 0), Decimal("7794889495725306400"));
+    CHECK_EQUAL(exp(Decimal("43.66"), 0), Decimal("9147387561413516777"));
+    CHECK_EQUAL(exp(Decimal("-46"), 19), Decimal("0"));
+    CHECK_EQUAL(exp(Decimal("-1000"), 19), Decimal("0"));
+    CHECK_EQUAL(exp(Decimal("-1000"), 19).places(), 19);
+
+    CHECK_THROW(exp(Decimal("43.7"), 0), DecimalRangeException);
+    CHECK_THROW(exp(Decimal("1000"), 0), DecimalRangeException);
+    CHECK_THROW(exp(Decimal("40"), 5), DecimalRangeException);
+    CHECK_THROW(exp(Decimal("1"), 20), DecimalRangeException);
+}
+
+TEST(decimal_math_ln)
+{
+    CHECK_EQUAL(ln(Decimal("1"), 5), Decimal("0"));
+    CHECK_EQUAL(ln(Decimal("1"), 5).places(), 5);
+    CHECK_EQUAL(ln(Decimal("2"), 18), Decimal("0.693147180559945309"));
+    CHECK_EQUAL(ln(Decimal("10"), 18), Decimal("2.302585092994045684"));
+    CHECK_EQUAL(ln(Decimal("0.5"), 18), Decimal("-0.693147180559945309"));
+    CHECK_EQUAL(ln(Decimal("1.5"), 18), Decimal("0.405465108108164382"));
+    CHECK_EQUAL(ln(Decimal("123.456"), 17), Decimal("4.81588481728326388"));
+    CHECK_EQUAL
+    (   ln(Decimal("0.9999999"), 18),
+        Decimal("-0.000000100000005000")
+    );
+    CHECK_EQUAL
+    (   ln(Decimal("1.000000000000000001"), 19),
+        Decimal("0.0000000000000000010")
+    );
+    CHECK_EQUAL(ln(Decimal::maximum(), 17), Decimal("43.66827237527655449"));
+    CHECK_EQUAL
+    (   ln(Decimal("0.0000000000000000001"), 17),
+        Decimal("-43.74911676688686800")
+    );
+
+    CHECK_THROW(ln(Decimal("0"), 2), DecimalDomainException);
+    CHECK_THROW(ln(Decimal("-1"), 2), DecimalDomainException);
+    CHECK_THROW(ln(Decimal("10"), 19), DecimalRangeException);
+    CHECK_THROW(ln(Decimal("2"), 20), DecimalRangeException);
+}
+
+TEST(decimal_math_exp_ln_inverse)
+{
+    char const* const values[] =
+    {   "0.001", "0.3", "1.7", "2.5", "17", "123.45", "99999.9", "1234567.89"
+    };
+    for (auto value: values)
+    {
+        Decimal const x(value);
+        CHECK_EQUAL(exp(ln(x, 17), 10), round(x, 10));
+    }
+}
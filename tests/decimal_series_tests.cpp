@@ -0,0 +1,158 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal_series.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalRangeException;
+using jewel::DecimalSeries;
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+namespace
+{
+    size_t const block_size = DecimalSeries::block_size;
+
+    // A random walk, moving a few ticks at a time, with occasional jumps.
+    vector<Decimal> make_walk(size_t p_count)
+    {
+        vector<Decimal> ret;
+        Decimal::int_type x = 1234500;
+        uint64_t r = 88172645463325252ULL;
+        for (size_t i = 0; i != p_count; ++i)
+        {
+            r ^= r << 13;
+            r ^= r >> 7;
+            r ^= r << 17;
+            x += static_cast<Decimal::int_type>(r % 7) - 3;
+            if (r % 1000 == 0)
+            {
+                x += 500000;
+            }
+            ret.push_back(Decimal(x, 4));
+        }
+        return ret;
+    }
+
+    void check_series
+    (   DecimalSeries const& p_series,
+        vector<Decimal> const& p_values
+    )
+    {
+        CHECK_EQUAL(p_series.size(), p_values.size());
+        for (size_t i = 0; i != p_values.size(); ++i)
+        {
+            CHECK_EQUAL(p_series[i], p_values[i]);
+            CHECK_EQUAL(p_series[i].places(), p_series.places());
+        }
+        vector<Decimal> decoded(p_values.size());
+        if (!decoded.empty())
+        {
+            p_series.decode(0, decoded.size(), &decoded[0]);
+        }
+        for (size_t i = 0; i != p_values.size(); ++i)
+        {
+            CHECK_EQUAL(decoded[i], p_values[i]);
+        }
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal_series_random_walk)
+{
+    vector<Decimal> const walk = make_walk(block_size * 20 + 37);
+    DecimalSeries series(4);
+    CHECK_EQUAL(series.size(), 0u);
+    CHECK_EQUAL(series.block_count(), 0u);
+    series.append(&walk[0], walk.size());
+    CHECK_EQUAL(series.places(), 4);
+    CHECK_EQUAL(series.block_count(), 21u);
+    check_series(series, walk);
+    CHECK(series.memory_usage() * 8 < walk.size() * sizeof(Decimal));
+
+    vector<Decimal::int_type> intvals(block_size);
+    CHECK_EQUAL(series.decode_block(3, &intvals[0]), block_size);
+    for (size_t i = 0; i != block_size; ++i)
+    {
+        CHECK_EQUAL(intvals[i], walk[3 * block_size + i].intval());
+    }
+    CHECK_EQUAL(series.decode_block(20, &intvals[0]), 37u);
+    CHECK_EQUAL(intvals[36], walk.back().intval());
+
+    // Ranges that start and end part-way through blocks
+    vector<Decimal> decoded(300);
+    series.decode(block_size - 5, decoded.size(), &decoded[0]);
+    for (size_t i = 0; i != decoded.size(); ++i)
+    {
+        CHECK_EQUAL(decoded[i], walk[block_size - 5 + i]);
+    }
+    series.decode(walk.size() - 40, 40, &decoded[0]);
+    CHECK_EQUAL(decoded[39], walk.back());
+}
+
+TEST(decimal_series_extremes)
+{
+    // Alternating extremes need the full 64 bits in either form.
+    vector<Decimal> values;
+    for (size_t i = 0; i != block_size * 2 + 1; ++i)
+    {
+        values.push_back
+        (   (i % 2 == 0)?
+            Decimal::maximum():
+            Decimal::minimum()
+        );
+    }
+    values[5] = Decimal("0");
+    DecimalSeries series(0);
+    series.append(&values[0], values.size());
+    check_series(series, values);
+
+    // A constant series
+    vector<Decimal> const constant(block_size * 3, Decimal("-7.25"));
+    DecimalSeries constant_series(2);
+    constant_series.append(&constant[0], constant.size());
+    check_series(constant_series, constant);
+}
+
+TEST(decimal_series_scale)
+{
+    DecimalSeries series(2);
+    series.append(Decimal("1.5"));
+    series.append(Decimal("-3"));
+    series.append(Decimal("2.005"));
+    CHECK_EQUAL(series.size(), 3u);
+    CHECK_EQUAL(series[0], Decimal("1.50"));
+    CHECK_EQUAL(series[1].places(), 2);
+    CHECK_EQUAL(series[2], Decimal("2.01"));
+
+    DecimalSeries narrow(Decimal::maximum_precision());
+    CHECK_THROW(narrow.append(Decimal("10")), DecimalRangeException);
+    CHECK_EQUAL(narrow.size(), 0u);
+    narrow.append(Decimal("0.5"));
+    CHECK_EQUAL(narrow.size(), 1u);
+
+    CHECK_THROW
+    (   DecimalSeries(Decimal::maximum_precision() + 1),
+        DecimalRangeException
+    );
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal_stats.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "group_by_aggregator.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using jewel::DecimalAdditionException;
+using jewel::DecimalAggregate;
+using jewel::DecimalDivisionByZeroException;
+using jewel::DecimalFromStringException;
+using jewel::DecimalStats;
+using std::ostringstream;
+using std::string;
+using std::thread;
+
+namespace
+{
+    // Does a little of everything that DecimalStats counts.
+    void exercise()
+    {
+        Decimal x("1.500");
+        CHECK(x == Decimal("1.5"));
+        x += Decimal("0.25");
+        x /= Decimal("3");
+        CHECK(x < Decimal("0.6"));
+        CHECK_THROW(x /= Decimal("0"), DecimalDivisionByZeroException);
+        CHECK_THROW(Decimal("1.2.3"), DecimalFromStringException);
+        return;
+    }
+}
+
+TEST(decimal_stats_default_constructor)
+{
+    DecimalStats const stats;
+    for (int i = 0; i != DecimalStats::num_counters; ++i)
+    {
+        CHECK_EQUAL(stats.count(static_cast<DecimalStats::Counter>(i)), 0);
+    }
+}
+
+TEST(decimal_stats_thread_snapshot)
+{
+    DecimalStats const before = DecimalStats::thread_snapshot();
+    exercise();
+    DecimalStats const delta = DecimalStats::thread_snapshot() - before;
+    if (DecimalStats::enabled())
+    {
+        // Comparing "1.500" with "1.5" strips two trailing zeroes.
+        CHECK(delta.count(DecimalStats::rationalize_iterations) >= 2);
+        CHECK(delta.count(DecimalStats::rescales) > 0);
+        CHECK(delta.count(DecimalStats::co_normalizations) >= 2);
+        CHECK(delta.count(DecimalStats::division_iterations) > 0);
+        CHECK_EQUAL(delta.count(DecimalStats::exceptions), 2);
+    }
+    else
+    {
+        for (int i = 0; i != DecimalStats::num_counters; ++i)
+        {
+            DecimalStats::Counter const c =
+                static_cast<DecimalStats::Counter>(i);
+            CHECK_EQUAL(delta.count(c), 0);
+        }
+    }
+}
+
+TEST(decimal_stats_aggregate_exception)
+{
+    // Exceptions thrown outside Decimal itself are counted too.
+    DecimalAggregate big;
+    big.add(Decimal::maximum());
+    big.add(Decimal::maximum());
+    DecimalStats const before = DecimalStats::thread_snapshot();
+    CHECK_THROW(big.sum(), DecimalAdditionException);
+    DecimalStats const delta = DecimalStats::thread_snapshot() - before;
+    CHECK_EQUAL
+    (   delta.count(DecimalStats::exceptions),
+        DecimalStats::enabled()? 1: 0
+    );
+}
+
+TEST(decimal_stats_global_snapshot)
+{
+    DecimalStats const before_global = DecimalStats::global_snapshot();
+    DecimalStats const before_thread = DecimalStats::thread_snapshot();
+    DecimalStats other_thread;
+    thread t
+    (   [&other_thread]()
+        {
+            exercise();
+            other_thread = DecimalStats::thread_snapshot();
+        }
+    );
+    t.join();
+    exercise();
+    DecimalStats const this_thread =
+        DecimalStats::thread_snapshot() - before_thread;
+    DecimalStats const global =
+        DecimalStats::global_snapshot() - before_global;
+
+    // Counts made by the other thread survive its exit, and both threads
+    // did the same work.
+    for (int i = 0; i != DecimalStats::num_counters; ++i)
+    {
+        DecimalStats::Counter const c = static_cast<DecimalStats::Counter>(i);
+        CHECK_EQUAL(other_thread.count(c), this_thread.count(c));
+        CHECK(global.count(c) >= other_thread.count(c) + this_thread.count(c));
+    }
+}
+
+TEST(decimal_stats_arithmetic)
+{
+    DecimalStats const a = DecimalStats::thread_snapshot();
+    exercise();
+    DecimalStats const b = DecimalStats::thread_snapshot();
+    DecimalStats const delta = b - a;
+    DecimalStats sum = a + delta;
+    for (int i = 0; i != DecimalStats::num_counters; ++i)
+    {
+        DecimalStats::Counter const c = static_cast<DecimalStats::Counter>(i);
+        CHECK_EQUAL(sum.count(c), b.count(c));
+    }
+    sum -= delta;
+    sum += DecimalStats();
+    for (int i = 0; i != DecimalStats::num_counters; ++i)
+    {
+        DecimalStats::Counter const c = static_cast<DecimalStats::Counter>(i);
+        CHECK_EQUAL(sum.count(c), a.count(c));
+    }
+}
+
+TEST(decimal_stats_output)
+{
+    DecimalStats const stats;
+    ostringstream oss;
+    oss << stats;
+    CHECK_EQUAL
+    (   oss.str(),
+        string
+        (   "rescales: 0\n"
+            "rationalize_iterations: 0\n"
+            "co_normalizations: 0\n"
+            "division_iterations: 0\n"
+            "exceptions: 0\n"
+        )
+    );
+    CHECK_EQUAL(DecimalStats::name(DecimalStats::exceptions), "exceptions");
+}
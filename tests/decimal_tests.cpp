@@ -26,6 +26,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <UnitTest++/UnitTest++.h>
 
 using jewel::Decimal;
@@ -43,6 +44,13 @@ using jewel::DecimalUnaryMinusException;
 using jewel::DecimalFromStringException;
 using jewel::DecimalStreamReadException;
 using jewel::round;
+using jewel::round_n;
+using jewel::RoundingMode;
+using jewel::round_half_up;
+using jewel::round_half_even;
+using jewel::round_floor;
+using jewel::round_ceiling;
+using jewel::round_truncate;
 using std::cin;
 using std::cout;
 using std::cerr;
@@ -55,6 +63,7 @@ using std::numpunct;
 using std::ostringstream;
 using std::string;
 using std::use_facet;
+using std::vector;
 using std::wostringstream;
 using std::wstring;
 using weird_punct::WeirdPunct;
@@ -1574,6 +1583,9 @@ TEST(decimal_increment)
     Decimal d11 = ++d10;
     // Then this should throw
     CHECK_THROW(d11++, DecimalIncrementationException);
+    Decimal d13("0.0000000000000000001");
+    CHECK_THROW(++d13, DecimalIncrementationException);
+    CHECK_EQUAL(d13, Decimal("0.0000000000000000001"));
 
     // Test preservation of fractional precision
     Decimal d12("1.900");
@@ -1732,6 +1744,15 @@ TEST(decimal_operator_equality)
     CHECK(!(Decimal("-38") == Decimal("-380")));
     CHECK(Decimal("0.000") == Decimal("-0"));
     CHECK(Decimal("234.123000") == Decimal("234.123"));
+    CHECK(Decimal("1.000000000000000000") == Decimal("1"));
+    CHECK(Decimal("-9.000000000000000000") == Decimal("-9"));
+    CHECK(Decimal("0.1000000000000000000") == Decimal("0.1"));
+    CHECK
+    (   Decimal("-0.0000000000000000010") ==
+        Decimal("-0.000000000000000001")
+    );
+    CHECK(!(Decimal("1.000000000000000001") == Decimal("1")));
+    CHECK(!(Decimal("0.2000000000000000000") == Decimal("0.1")));
 }
 
 TEST(decimal_operator_inequality)
@@ -2106,8 +2127,255 @@ TEST(round_decimal)
     CHECK_EQUAL(d7, Decimal(3, 2));
     CHECK_THROW(round(d7, -1), DecimalRangeException);
     CHECK_EQUAL(d7, Decimal(3, 2));
+
+    // Rounding away many places at once
+    Decimal const d8("0.5000000000000000000");
+    CHECK_EQUAL(round(d8, 0), Decimal("1"));
+    CHECK_EQUAL(round(-d8, 0), Decimal("-1"));
+    CHECK_EQUAL(round(Decimal("0.4999999999999999999"), 0), Decimal("0"));
+    CHECK_EQUAL(round(Decimal("-0.4999999999999999999"), 0), Decimal("0"));
+    CHECK_EQUAL
+    (   round(Decimal("-922337203.6854775808"), 0),
+        Decimal("-922337204")
+    );
+    CHECK_EQUAL
+    (   round(Decimal("922337203.6854775807"), 9),
+        Decimal("922337203.685477581")
+    );
+    CHECK_EQUAL(round(Decimal::minimum(), 0), Decimal::minimum());
+
+    // Scaling up many places at once
+    CHECK_EQUAL(round(Decimal("0"), 19).places(), 19);
+    CHECK_EQUAL(round(Decimal("0.1"), 19).intval(), 1000000000000000000LL);
+    CHECK_THROW(round(Decimal("1"), 19), DecimalRangeException);
+    CHECK_THROW(round(Decimal("-1"), 19), DecimalRangeException);
 }
 
+TEST(round_decimal_with_mode)
+{
+    // Each row gives an input followed by the result of rounding it to one
+    // place with each of half up, half even, floor, ceiling and truncate.
+    char const* const cases[][6] =
+    {   { "2.34", "2.3", "2.3", "2.3", "2.4", "2.3" },
+        { "2.35", "2.4", "2.4", "2.3", "2.4", "2.3" },
+        { "2.45", "2.5", "2.4", "2.4", "2.5", "2.4" },
+        { "2.451", "2.5", "2.5", "2.4", "2.5", "2.4" },
+        { "2.36", "2.4", "2.4", "2.3", "2.4", "2.3" },
+        { "-2.34", "-2.3", "-2.3", "-2.4", "-2.3", "-2.3" },
+        { "-2.35", "-2.4", "-2.4", "-2.4", "-2.3", "-2.3" },
+        { "-2.45", "-2.5", "-2.4", "-2.5", "-2.4", "-2.4" },
+        { "-2.449", "-2.4", "-2.4", "-2.5", "-2.4", "-2.4" },
+        { "0.05", "0.1", "0.0", "0.0", "0.1", "0.0" },
+        { "-0.05", "-0.1", "0.0", "-0.1", "0.0", "0.0" },
+        { "7", "7.0", "7.0", "7.0", "7.0", "7.0" },
+        { "-7.1", "-7.1", "-7.1", "-7.1", "-7.1", "-7.1" }
+    };
+    RoundingMode const modes[] =
+    {   round_half_up,
+        round_half_even,
+        round_floor,
+        round_ceiling,
+        round_truncate
+    };
+    for (auto const& row: cases)
+    {
+        for (int m = 0; m != 5; ++m)
+        {
+            Decimal const result = round(Decimal(row[0]), 1, modes[m]);
+            CHECK_EQUAL(result, Decimal(row[m + 1]));
+            CHECK_EQUAL(result.places(), 1);
+        }
+    }
+
+    // Removing all places of a Decimal with the maximum number of places
+    Decimal const tiny(1, Decimal::maximum_precision());
+    Decimal const half(5000000000000000000LL, Decimal::maximum_precision());
+    CHECK_EQUAL(round(tiny, 0, round_ceiling), Decimal("1"));
+    CHECK_EQUAL(round(-tiny, 0, round_floor), Decimal("-1"));
+    CHECK_EQUAL(round(tiny, 0, round_half_up), Decimal("0"));
+    CHECK_EQUAL(round(half, 0, round_half_up), Decimal("1"));
+    CHECK_EQUAL(round(-half, 0, round_half_up), Decimal("-1"));
+    CHECK_EQUAL(round(half, 0, round_half_even), Decimal("0"));
+    CHECK_EQUAL(round(-half, 0, round_truncate), Decimal("0"));
+
+    // Extremes
+    CHECK_EQUAL
+    (   round(Decimal::maximum(), 0, round_ceiling),
+        Decimal::maximum()
+    );
+    CHECK_EQUAL
+    (   round(Decimal::minimum(), 0, round_floor),
+        Decimal::minimum()
+    );
+    CHECK_EQUAL
+    (   round(Decimal("-922337203.6854775808"), 0, round_floor),
+        Decimal("-922337204")
+    );
+    CHECK_EQUAL
+    (   round(Decimal("922337203.6854775807"), 0, round_ceiling),
+        Decimal("922337204")
+    );
+
+    // Adding places
+    CHECK_EQUAL(round(Decimal("1.5"), 4, round_floor).places(), 4);
+    CHECK_THROW(round(Decimal("1"), 19, round_floor), DecimalRangeException);
+    CHECK_THROW(round(Decimal("1"), 20, round_floor), DecimalRangeException);
+
+    // Agreement with round(x, places)
+    for (Decimal::places_type p = 0; p <= 5; ++p)
+    {
+        for (int i = -2000; i < 2000; i += 7)
+        {
+            Decimal const x(i, 3);
+            CHECK_EQUAL
+            (   round(x, p, round_half_up).intval(),
+                round(x, p).intval()
+            );
+        }
+    }
+}
+
+TEST(round_n_decimal)
+{
+    vector<Decimal> in;
+    for (int i = -300; i != 300; ++i)
+    {
+        // Runs of the same number of places, interspersed with others
+        Decimal::places_type const places = (i % 50 == 0)? (i % 7 + 7): 3;
+        in.push_back(Decimal(i * 17, places));
+    }
+    in.push_back(Decimal("0.0000000000000000001"));
+    in.push_back(Decimal("922337203.6854775807"));
+    in.push_back(Decimal("-922337203.6854775808"));
+    RoundingMode const modes[] =
+    {   round_half_up,
+        round_half_even,
+        round_floor,
+        round_ceiling,
+        round_truncate
+    };
+    for (auto mode: modes)
+    {
+        for (Decimal::places_type p = 0; p <= 2; ++p)
+        {
+            vector<Decimal> out(in.size());
+            round_n(&in[0], &out[0], in.size(), p, mode);
+            for (vector<Decimal>::size_type i = 0; i != in.size(); ++i)
+            {
+                Decimal const expected = round(in[i], p, mode);
+                CHECK_EQUAL(out[i], expected);
+                CHECK_EQUAL(out[i].places(), expected.places());
+            }
+
+            // In place
+            vector<Decimal> inout = in;
+            round_n(&inout[0], &inout[0], inout.size(), p, mode);
+            CHECK(inout == out);
+        }
+    }
+
+    // Half even and half up differ on ties only.
+    Decimal const ties[] = { Decimal("0.125"), Decimal("0.135") };
+    Decimal results[2];
+    round_n(ties, results, 2, 2, round_half_even);
+    CHECK_EQUAL(results[0], Decimal("0.12"));
+    CHECK_EQUAL(results[1], Decimal("0.14"));
+
+    // Empty range and failure
+    round_n(ties, results, 0, 2, round_floor);
+    CHECK_EQUAL(results[0], Decimal("0.12"));
+    vector<Decimal> big(3, Decimal::maximum());
+    vector<Decimal> out(3);
+    CHECK_THROW
+    (   round_n(&big[0], &out[0], big.size(), 1, round_floor),
+        DecimalRangeException
+    );
+    CHECK_THROW
+    (   round_n(&in[0], &out[0], 0, 20, round_floor),
+        DecimalRangeException
+    );
+}
+
+
+TEST(decimal_integer_scalar_operations)
+{
+    // mul preserves places and matches Decimal multiplication
+    Decimal d0("12.340");
+    d0.mul(3);
+    CHECK_EQUAL(d0, Decimal("37.020"));
+    CHECK_EQUAL(d0.places(), 3);
+    d0 *= -2;
+    CHECK_EQUAL(d0, Decimal("-74.040"));
+    CHECK_EQUAL(d0.places(), 3);
+    Decimal const d1 = 3 * Decimal("0.25");
+    CHECK_EQUAL(d1, Decimal("0.75"));
+    CHECK_EQUAL(d1.places(), 2);
+    CHECK_EQUAL(Decimal("-1.5") * 4, Decimal("-6.0"));
+    for (int i = -50; i < 50; i += 7)
+    {
+        Decimal x("-3.0713");
+        x.mul(i);
+        CHECK_EQUAL(x, Decimal("-3.0713") * Decimal(i, 0));
+        CHECK_EQUAL(x.places(), 4);
+    }
+    Decimal big = Decimal::maximum();
+    CHECK_THROW(big.mul(2), DecimalMultiplicationException);
+    CHECK_EQUAL(big, Decimal::maximum());
+    Decimal small = Decimal::minimum();
+    CHECK_THROW(small *= -1, DecimalMultiplicationException);
+    CHECK_EQUAL(small, Decimal::minimum());
+
+    // div rounds half away from zero at the current places
+    Decimal d2("10.00");
+    d2.div(3);
+    CHECK_EQUAL(d2, Decimal("3.33"));
+    CHECK_EQUAL(d2.places(), 2);
+    Decimal d3("20.00");
+    d3.div(3);
+    CHECK_EQUAL(d3, Decimal("6.67"));
+    Decimal d4("-20.00");
+    d4.div(3);
+    CHECK_EQUAL(d4, Decimal("-6.67"));
+    Decimal d5("0.05");
+    d5.div(-2);
+    CHECK_EQUAL(d5, Decimal("-0.03"));
+    Decimal d6("-0.05");
+    d6.div(-2);
+    CHECK_EQUAL(d6, Decimal("0.03"));
+    Decimal d7("0.07");
+    d7.div(-10);
+    CHECK_EQUAL(d7, Decimal("-0.01"));
+    Decimal d8("7");
+    d8.div(1);
+    CHECK_EQUAL(d8, Decimal("7"));
+    Decimal d9 = Decimal::minimum();
+    d9.div(numeric_limits<Decimal::int_type>::min());
+    CHECK_EQUAL(d9, Decimal("1"));
+    Decimal d10 = Decimal::maximum();
+    d10.div(numeric_limits<Decimal::int_type>::min());
+    CHECK_EQUAL(d10, Decimal("-1"));
+    Decimal d11("1");
+    d11.div(numeric_limits<Decimal::int_type>::min());
+    CHECK_EQUAL(d11, Decimal("0"));
+    CHECK_THROW(d2.div(0), DecimalDivisionByZeroException);
+    CHECK_EQUAL(d2, Decimal("3.33"));
+    Decimal d12 = Decimal::minimum();
+    CHECK_THROW(d12.div(-1), DecimalDivisionException);
+    CHECK_EQUAL(d12, Decimal::minimum());
+
+    // add_units adds in units of the last place
+    Decimal d13("1.990");
+    d13.add_units(15);
+    CHECK_EQUAL(d13, Decimal("2.005"));
+    CHECK_EQUAL(d13.places(), 3);
+    d13.add_units(-3000);
+    CHECK_EQUAL(d13, Decimal("-0.995"));
+    Decimal d14 = Decimal::maximum();
+    CHECK_THROW(d14.add_units(1), DecimalAdditionException);
+    CHECK_EQUAL(d14, Decimal::maximum());
+    Decimal d15 = Decimal::minimum();
+    CHECK_THROW(d15.add_units(-1), DecimalAdditionException);
+}
 
 TEST(decimal_operations_in_combination)
 {
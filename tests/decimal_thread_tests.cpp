@@ -0,0 +1,117 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal.hpp"
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Decimal;
+using std::ostringstream;
+using std::size_t;
+using std::string;
+using std::thread;
+using std::vector;
+
+namespace
+{
+    typedef Decimal::places_type places_type;
+
+    // Inputs spanning every number of places, so that every entry of the
+    // power-of-ten table is used.
+    vector<Decimal> stress_inputs()
+    {
+        vector<Decimal> ret;
+        for (places_type p = 0; p <= Decimal::maximum_precision(); ++p)
+        {
+            ret.push_back(Decimal(3, p));
+            ret.push_back(Decimal(-27, p));
+            ret.push_back(Decimal(1000, p));
+            ret.push_back(Decimal(982451653, p));
+        }
+        return ret;
+    }
+
+    // Exercises the operations that make use of Decimal's static data
+    // and describes the results as a string, which is the same on every
+    // thread if there is no data race.
+    string exercise(vector<Decimal> const& p_inputs, int p_rounds)
+    {
+        ostringstream oss;
+        for (int r = 0; r != p_rounds; ++r)
+        {
+            for (auto const& d: p_inputs)
+            {
+                Decimal x = d;
+                if (x.places() < Decimal::maximum_precision())
+                {
+                    ++x;
+                    --x;
+                }
+                Decimal y = round(d, 2);
+                y *= Decimal("-0.4");
+                y /= Decimal("3");
+                y = round(y, 6) + Decimal("7.25");
+                bool const extreme =
+                (   x == Decimal::maximum() ||
+                    x == Decimal::minimum() ||
+                    x < Decimal::minimum()
+                );
+                if (r == 0)
+                {
+                    oss << x << ' ' << y << ' ' << extreme << '\n';
+                }
+            }
+        }
+        return oss.str();
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal_concurrent_use)
+{
+    vector<Decimal> const inputs = stress_inputs();
+    int const rounds = 200;
+    string const expected = exercise(inputs, rounds);
+    CHECK(!expected.empty());
+
+    size_t const num_threads = 8;
+    vector<string> results(num_threads);
+    vector<thread> threads;
+    for (size_t i = 0; i != num_threads; ++i)
+    {
+        threads.push_back
+        (   thread
+            (   [&inputs, &results, rounds, i]()
+                {
+                    results[i] = exercise(inputs, rounds);
+                }
+            )
+        );
+    }
+    for (auto& t: threads)
+    {
+        t.join();
+    }
+    for (auto const& result: results)
+    {
+        CHECK_EQUAL(result, expected);
+    }
+}
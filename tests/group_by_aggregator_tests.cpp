@@ -0,0 +1,245 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "group_by_aggregator.hpp"
+#include "capped_string.hpp"
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include <cstddef>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::CappedString;
+using jewel::Decimal;
+using jewel::DecimalAdditionException;
+using jewel::DecimalAggregate;
+using jewel::GroupByAggregator;
+using std::map;
+using std::size_t;
+using std::string;
+using std::thread;
+using std::vector;
+
+namespace
+{
+    typedef CappedString<16> AccountCode;
+    typedef GroupByAggregator<AccountCode, Decimal> Aggregator;
+
+    struct Expected
+    {
+        Expected(): count(0) {}
+        size_t count;
+        Decimal sum;
+        Decimal minimum;
+        Decimal maximum;
+    };
+
+    void make_entries
+    (   size_t p_count,
+        vector<AccountCode>& p_keys,
+        vector<Decimal>& p_values
+    )
+    {
+        for (size_t i = 0; i != p_count; ++i)
+        {
+            string const code =
+                "ACC-" + std::to_string((i * 7919) % 257);
+            p_keys.push_back(AccountCode(code.c_str()));
+            int const units = static_cast<int>((i * 104729) % 20001) - 10000;
+            p_values.push_back(Decimal(units, (i % 5 == 0)? 1: 2));
+        }
+        return;
+    }
+
+    map<string, Expected> expected_results
+    (   vector<AccountCode> const& p_keys,
+        vector<Decimal> const& p_values
+    )
+    {
+        map<string, Expected> ret;
+        for (size_t i = 0; i != p_keys.size(); ++i)
+        {
+            Expected& e = ret[p_keys[i].c_str()];
+            if (e.count == 0 || p_values[i] < e.minimum)
+            {
+                e.minimum = p_values[i];
+            }
+            if (e.count == 0 || e.maximum < p_values[i])
+            {
+                e.maximum = p_values[i];
+            }
+            e.sum += p_values[i];
+            ++e.count;
+        }
+        return ret;
+    }
+
+    void check_results
+    (   Aggregator const& p_aggregator,
+        map<string, Expected> const& p_expected
+    )
+    {
+        CHECK_EQUAL(p_aggregator.size(), p_expected.size());
+        for (auto const& entry: p_expected)
+        {
+            DecimalAggregate const* const aggregate =
+                p_aggregator.find(AccountCode(entry.first.c_str()));
+            CHECK(aggregate != nullptr);
+            if (aggregate == nullptr)
+            {
+                continue;
+            }
+            CHECK_EQUAL(aggregate->count(), entry.second.count);
+            CHECK_EQUAL(aggregate->sum(), entry.second.sum);
+            CHECK_EQUAL(aggregate->minimum(), entry.second.minimum);
+            CHECK_EQUAL(aggregate->maximum(), entry.second.maximum);
+        }
+        size_t num_visited = 0;
+        p_aggregator.for_each
+        (   [&](AccountCode const& p_key, DecimalAggregate const& p_agg)
+            {
+                CHECK(p_expected.count(p_key.c_str()) == 1);
+                CHECK(p_agg.count() > 0);
+                ++num_visited;
+            }
+        );
+        CHECK_EQUAL(num_visited, p_expected.size());
+    }
+
+}  // end anonymous namespace
+
+TEST(decimal_aggregate)
+{
+    DecimalAggregate aggregate;
+    CHECK_EQUAL(aggregate.count(), 0u);
+    CHECK_EQUAL(aggregate.sum(), Decimal("0"));
+    aggregate.add(Decimal("1.5"));
+    aggregate.add(Decimal("-2"));
+    aggregate.add(Decimal("0.25"));
+    CHECK_EQUAL(aggregate.count(), 3u);
+    CHECK_EQUAL(aggregate.sum(), Decimal("-0.25"));
+    CHECK_EQUAL(aggregate.sum().places(), 2);
+    CHECK_EQUAL(aggregate.minimum(), Decimal("-2"));
+    CHECK_EQUAL(aggregate.maximum(), Decimal("1.5"));
+
+    DecimalAggregate other(Decimal("10.125"));
+    other.merge(aggregate);
+    CHECK_EQUAL(other.count(), 4u);
+    CHECK_EQUAL(other.sum(), Decimal("9.875"));
+    CHECK_EQUAL(other.maximum(), Decimal("10.125"));
+    other.merge(DecimalAggregate());
+    CHECK_EQUAL(other.count(), 4u);
+
+    // The sum may exceed the range of Decimal part-way through.
+    DecimalAggregate big;
+    big.add(Decimal::maximum());
+    big.add(Decimal::maximum());
+    CHECK_THROW(big.sum(), DecimalAdditionException);
+    big.add(Decimal::minimum());
+    big.add(Decimal::minimum());
+    CHECK_EQUAL(big.sum(), Decimal("-2"));
+    CHECK_EQUAL(big.minimum(), Decimal::minimum());
+
+    // Sums that fit only without trailing zeros are still representable.
+    DecimalAggregate scaled;
+    scaled.add(Decimal("900000000000000000"));
+    scaled.add(Decimal("0.1"));
+    scaled.add(Decimal("-0.1"));
+    CHECK_EQUAL(scaled.sum(), Decimal("900000000000000000"));
+    CHECK_EQUAL(scaled.maximum(), Decimal("900000000000000000"));
+}
+
+TEST(group_by_aggregator_by_account_code)
+{
+    vector<AccountCode> keys;
+    vector<Decimal> values;
+    make_entries(20000, keys, values);
+    Aggregator aggregator;
+    CHECK(aggregator.empty());
+    aggregator.add(&keys[0], &values[0], keys.size());
+    check_results(aggregator, expected_results(keys, values));
+    CHECK(aggregator.find(AccountCode("ACC-9999")) == nullptr);
+
+    aggregator.clear();
+    CHECK(aggregator.empty());
+    CHECK(aggregator.find(keys[0]) == nullptr);
+    aggregator.add(keys[0], values[0]);
+    CHECK_EQUAL(aggregator.size(), 1u);
+    CHECK_EQUAL(aggregator.find(keys[0])->sum(), values[0]);
+}
+
+TEST(group_by_aggregator_parallel_merge)
+{
+    vector<AccountCode> keys;
+    vector<Decimal> values;
+    make_entries(40000, keys, values);
+
+    size_t const num_threads = 4;
+    size_t const chunk = keys.size() / num_threads;
+    vector<Aggregator> partials(num_threads);
+    vector<thread> threads;
+    for (size_t i = 0; i != num_threads; ++i)
+    {
+        threads.push_back
+        (   thread
+            (   [&keys, &values, &partials, chunk, i]()
+                {
+                    partials[i].add
+                    (   &keys[i * chunk],
+                        &values[i * chunk],
+                        chunk
+                    );
+                }
+            )
+        );
+    }
+    for (auto& t: threads)
+    {
+        t.join();
+    }
+    Aggregator total(300);
+    for (auto const& partial: partials)
+    {
+        total.merge(partial);
+    }
+    check_results(total, expected_results(keys, values));
+}
+
+TEST(group_by_aggregator_integer_keys)
+{
+    // Consecutive integer keys, which std::hash maps to themselves,
+    // and enough of them to make the table grow several times.
+    GroupByAggregator<int, Decimal> aggregator;
+    for (int r = 0; r != 3; ++r)
+    {
+        for (int i = 0; i != 5000; ++i)
+        {
+            aggregator.add(i * 64, Decimal(i, 2));
+        }
+    }
+    CHECK_EQUAL(aggregator.size(), 5000u);
+    for (int i = 0; i != 5000; ++i)
+    {
+        DecimalAggregate const* const aggregate = aggregator.find(i * 64);
+        CHECK(aggregate != nullptr);
+        CHECK_EQUAL(aggregate->count(), 3u);
+        CHECK_EQUAL(aggregate->sum(), Decimal(3 * i, 2));
+    }
+    CHECK(aggregator.find(1) == nullptr);
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "log_decoder.hpp"
+#include "log.hpp"
+#include "detail/log_format.hpp"
+#include <sstream>
+#include <string>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::convert_log_to_csv;
+using jewel::decode_binary_log;
+using jewel::Log;
+using jewel::LogDecoderException;
+using jewel::detail::append_log_json_event;
+using jewel::detail::append_log_json_record;
+using jewel::detail::append_log_string;
+using jewel::detail::append_log_timestamp;
+using jewel::detail::append_log_varint;
+using jewel::detail::log_binary_event;
+using jewel::detail::log_binary_magic;
+using jewel::detail::log_binary_record;
+using jewel::detail::log_binary_site;
+using jewel::detail::log_binary_version;
+using jewel::detail::log_commenced;
+using jewel::detail::log_ended;
+using jewel::detail::LogRecord;
+using jewel::detail::log_zigzag_decode;
+using jewel::detail::log_zigzag_encode;
+using std::istringstream;
+using std::ostringstream;
+using std::string;
+
+namespace
+{
+    string binary_header()
+    {
+        string ret(log_binary_magic);
+        ret += static_cast<char>(log_binary_version);
+        return ret;
+    }
+
+    void append_site(string& p_out, unsigned long long p_id, int p_line)
+    {
+        p_out += static_cast<char>(log_binary_site);
+        append_log_varint(p_out, p_id);
+        append_log_varint(p_out, log_zigzag_encode(p_line));
+        append_log_string(p_out, "operator/=");
+        append_log_string(p_out, "src/decimal.cpp");
+        append_log_string(p_out, "Nov 29 2013");
+        append_log_string(p_out, "09:41:57");
+        append_log_string(p_out, "DecimalDivisionByZeroException");
+        append_log_string(p_out, nullptr);
+        return;
+    }
+
+    long long const record_timestamp = 1385718117000321LL;
+
+    string timestamp_text(long long p_microseconds)
+    {
+        string ret;
+        append_log_timestamp(ret, p_microseconds);
+        return ret;
+    }
+
+    void append_record
+    (   string& p_out,
+        unsigned long long p_site_id,
+        unsigned long long p_id,
+        char const* p_message
+    )
+    {
+        p_out += static_cast<char>(log_binary_record);
+        append_log_varint(p_out, p_site_id);
+        append_log_varint(p_out, p_id);
+        append_log_varint(p_out, record_timestamp);
+        p_out += static_cast<char>(Log::warning);
+        append_log_string(p_out, p_message);
+        append_log_string(p_out, nullptr);
+        return;
+    }
+
+    string decode(string const& p_binary)
+    {
+        istringstream is(p_binary);
+        ostringstream os;
+        decode_binary_log(is, os);
+        return os.str();
+    }
+
+    string to_csv(string const& p_text)
+    {
+        istringstream is(p_text);
+        ostringstream os;
+        convert_log_to_csv(is, os);
+        return os.str();
+    }
+
+}  // end anonymous namespace
+
+TEST(log_zigzag)
+{
+    CHECK_EQUAL(log_zigzag_encode(0), 0u);
+    CHECK_EQUAL(log_zigzag_encode(-1), 1u);
+    CHECK_EQUAL(log_zigzag_encode(1), 2u);
+    CHECK_EQUAL(log_zigzag_encode(-2), 3u);
+    long long const values[] = { 0, 1, -1, 503, -70000, 1LL << 62 };
+    for (long long value: values)
+    {
+        CHECK_EQUAL(log_zigzag_decode(log_zigzag_encode(value)), value);
+    }
+}
+
+TEST(decode_binary_log)
+{
+    string binary = binary_header();
+    binary += static_cast<char>(log_binary_event);
+    binary += static_cast<char>(log_commenced);
+    append_log_varint(binary, 0);
+    append_log_string(binary, "Commenced logging to test.log.");
+    append_log_string(binary, "2013-11-29T09:41:57");
+    append_site(binary, 0, 503);
+    append_record(binary, 0, 1, "Division by zero.");
+    append_record(binary, 0, 200, nullptr);
+    binary += static_cast<char>(log_binary_event);
+    binary += static_cast<char>(log_ended);
+    append_log_varint(binary, 201);
+    append_log_string(binary, "End log");
+    append_log_string(binary, nullptr);
+
+    string const timestamp =
+        "{F}[timestamp]" + timestamp_text(record_timestamp) + "\n";
+    string const expected =
+        "{R}\n"
+        "{F}[id]0\n"
+        "{F}[message]Commenced logging to test.log.\n"
+        "{F}[date_time_written]2013-11-29T09:41:57\n"
+        "\n"
+        "{R}\n"
+        "{F}[id]1\n" +
+        timestamp +
+        "{F}[severity]warning\n"
+        "{F}[message]Division by zero.\n"
+        "{F}[function]operator/=\n"
+        "{F}[file]src/decimal.cpp\n"
+        "{F}[line]503\n"
+        "{F}[compilation_date]Nov 29 2013\n"
+        "{F}[compilation_time]09:41:57\n"
+        "{F}[exception_type]DecimalDivisionByZeroException\n"
+        "\n"
+        "{R}\n"
+        "{F}[id]200\n" +
+        timestamp +
+        "{F}[severity]warning\n"
+        "{F}[function]operator/=\n"
+        "{F}[file]src/decimal.cpp\n"
+        "{F}[line]503\n"
+        "{F}[compilation_date]Nov 29 2013\n"
+        "{F}[compilation_time]09:41:57\n"
+        "{F}[exception_type]DecimalDivisionByZeroException\n"
+        "\n"
+        "{R}\n"
+        "{F}[id]201\n"
+        "{F}[message]End log\n";
+    CHECK_EQUAL(decode(binary), expected);
+    CHECK_EQUAL(decode(binary_header()), "");
+}
+
+TEST(append_log_timestamp)
+{
+    string const formatted = timestamp_text(record_timestamp);
+    CHECK_EQUAL(formatted.size(), 26u);
+    CHECK_EQUAL(formatted.substr(19), ".000321");
+
+    // A later time in the same second, formatted from the cache
+    string const later = timestamp_text(record_timestamp + 999000);
+    CHECK_EQUAL(later.substr(0, 19), formatted.substr(0, 19));
+    CHECK_EQUAL(later.substr(19), ".999321");
+
+    // A time before the epoch
+    CHECK_EQUAL(timestamp_text(-1).substr(19), ".999999");
+}
+
+TEST(append_log_json_record)
+{
+    LogRecord record = LogRecord();
+    record.timestamp = record_timestamp;
+    record.severity = Log::warning;
+    record.line = 503;
+    record.message = "Say \"hello\"\n\tto C:\\ \x01";
+    record.function = "operator/=";
+    record.file = "src/decimal.cpp";
+    record.exception_type = "DecimalDivisionByZeroException";
+    string json;
+    append_log_json_record(json, record, 198);
+    string const expected =
+        "{\"id\":198,\"timestamp\":\"" +
+        timestamp_text(record_timestamp) + "\","
+        "\"severity\":\"warning\","
+        "\"message\":\"Say \\\"hello\\\"\\n\\tto C:\\\\ \\u0001\","
+        "\"function\":\"operator/=\","
+        "\"file\":\"src/decimal.cpp\","
+        "\"line\":503,"
+        "\"exception_type\":\"DecimalDivisionByZeroException\"}\n";
+    CHECK_EQUAL(json, expected);
+
+    json.clear();
+    append_log_json_event(json, 0, "Commenced logging to test.log.", nullptr);
+    CHECK_EQUAL
+    (   json,
+        "{\"id\":0,\"message\":\"Commenced logging to test.log.\"}\n"
+    );
+}
+
+TEST(decode_binary_log_errors)
+{
+    CHECK_THROW(decode("{R}\n{F}[id]0\n"), LogDecoderException);
+    CHECK_THROW(decode(""), LogDecoderException);
+    CHECK_THROW
+    (   decode(string(log_binary_magic) + '\x7f'),
+        LogDecoderException
+    );
+
+    // A record referring to a site that has not been defined
+    string undefined_site = binary_header();
+    append_record(undefined_site, 0, 1, "Division by zero.");
+    CHECK_THROW(decode(undefined_site), LogDecoderException);
+
+    // A log that ends part way through an entry
+    string truncated = binary_header();
+    append_site(truncated, 0, 503);
+    append_record(truncated, 0, 1, "Division by zero.");
+    truncated.resize(truncated.size() - 5);
+    CHECK_THROW(decode(truncated), LogDecoderException);
+
+    // A string whose length is far greater than the rest of the log
+    string huge_string = binary_header();
+    huge_string += static_cast<char>(log_binary_site);
+    append_log_varint(huge_string, 0);
+    append_log_varint(huge_string, log_zigzag_encode(503));
+    append_log_varint(huge_string, (1ULL << 62) + 1);
+    CHECK_THROW(decode(huge_string), LogDecoderException);
+
+    // A site with no function or file
+    string absent_file = binary_header();
+    absent_file += static_cast<char>(log_binary_site);
+    append_log_varint(absent_file, 0);
+    append_log_varint(absent_file, log_zigzag_encode(503));
+    append_log_string(absent_file, "operator/=");
+    for (int i = 0; i != 5; ++i) append_log_string(absent_file, nullptr);
+    append_record(absent_file, 0, 1, nullptr);
+    CHECK_THROW(decode(absent_file), LogDecoderException);
+
+    string unrecognized = binary_header() + 'X';
+    CHECK_THROW(decode(unrecognized), LogDecoderException);
+}
+
+TEST(convert_log_to_csv)
+{
+    // The expected output is that of tools/jewel_log_to_csv.py.
+    string const text =
+        "{R}\n"
+        "{F}[id]0\n"
+        "{F}[message]Commenced logging to x.log.\n"
+        "{F}[date_time_written]2013-11-29T09:41:57\n"
+        "\n"
+        "{R}\n"
+        "{F}[id]1\n"
+        "{F}[severity]warning\n"
+        "{F}[message]Hello, \"world\" [1]\n"
+        "{F}[function]f\n"
+        "{F}[file]a.cpp\n"
+        "{F}[line]7\n"
+        "\n"
+        "{R}\n"
+        "{F}[id]2\n"
+        "{F}[message]  padded  \r\n"
+        "{F}[value]x\n";
+    string const expected =
+        "id,message,date_time_written,severity,function,file,line,value\r\n"
+        "0,Commenced logging to x.log.,2013-11-29T09:41:57,,,,,\r\n"
+        "1,\"Hello, \"\"world\"\" [1\",,warning,f,a.cpp,7,\r\n"
+        "2,  padded,,,,,,x\r\n";
+    CHECK_EQUAL(to_csv(text), expected);
+    CHECK_EQUAL(to_csv(""), "\r\n");
+    CHECK_THROW(to_csv("{R}\n{F}id]0\n"), LogDecoderException);
+}
@@ -0,0 +1,446 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "log.hpp"
+#include "log_decoder.hpp"
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::Log;
+using jewel::decode_binary_log;
+using std::ifstream;
+using std::ios;
+using std::ofstream;
+using std::ostringstream;
+using std::size_t;
+using std::string;
+using std::thread;
+using std::vector;
+
+// These tests rely on the test driver having directed logging to
+// "test.log", with a threshold of Log::trace.
+
+namespace
+{
+    // Returns the number of lines in p_filepath, a log file in
+    // Log::text format, that begin with "{F}[message]" followed by
+    // p_prefix.
+    size_t count_messages
+    (   string const& p_prefix,
+        string const& p_filepath = "test.log"
+    )
+    {
+        string const target = "{F}[message]" + p_prefix;
+        ifstream file(p_filepath);
+        size_t ret = 0;
+        string line;
+        while (getline(file, line))
+        {
+            if (line.compare(0, target.size(), target) == 0)
+            {
+                ++ret;
+            }
+        }
+        return ret;
+    }
+
+    // Returns the lines in p_filepath.
+    vector<string> read_lines(string const& p_filepath)
+    {
+        ifstream file(p_filepath);
+        vector<string> ret;
+        string line;
+        while (getline(file, line))
+        {
+            ret.push_back(line);
+        }
+        return ret;
+    }
+
+    // Returns the number of records in p_filepath, a log file in
+    // Log::json format, with a message beginning with p_prefix.
+    size_t count_json_messages
+    (   string const& p_prefix,
+        string const& p_filepath
+    )
+    {
+        string const target = "\"message\":\"" + p_prefix;
+        size_t ret = 0;
+        for (auto const& line: read_lines(p_filepath))
+        {
+            if (line.find(target) != string::npos)
+            {
+                ++ret;
+            }
+        }
+        return ret;
+    }
+
+    // Logs p_count messages of severity p_severity from each of
+    // p_num_threads threads, each beginning with p_prefix.
+    void log_from_threads
+    (   string const& p_prefix,
+        size_t p_num_threads,
+        size_t p_count,
+        Log::Level p_severity = Log::info
+    )
+    {
+        vector<thread> threads;
+        for (size_t t = 0; t != p_num_threads; ++t)
+        {
+            threads.push_back(thread([=]()
+            {
+                for (size_t i = 0; i != p_count; ++i)
+                {
+                    ostringstream oss;
+                    oss << p_prefix << ' ' << t << ' ' << i;
+                    string const message = oss.str();
+                    Log::log
+                    (   p_severity,
+                        message.c_str(),
+                        __func__,
+                        __FILE__,
+                        __LINE__
+                    );
+                }
+            }));
+        }
+        for (auto& th: threads)
+        {
+            th.join();
+        }
+        return;
+    }
+
+}  // end anonymous namespace
+
+TEST(log_synchronous_threads)
+{
+    string const prefix = "log_synchronous_threads";
+    log_from_threads(prefix, 4, 1000);
+    CHECK_EQUAL(count_messages(prefix), 4000u);
+
+    // Check that records from different threads were not interleaved,
+    // by checking that each message is followed by its function.
+    ifstream file("test.log");
+    string const target = "{F}[message]" + prefix;
+    size_t num_intact = 0;
+    string line;
+    while (getline(file, line))
+    {
+        if (line.compare(0, target.size(), target) == 0)
+        {
+            getline(file, line);
+            if (line == "{F}[function]operator()")
+            {
+                ++num_intact;
+            }
+        }
+    }
+    CHECK_EQUAL(num_intact, 4000u);
+}
+
+TEST(log_asynchronous_blocking)
+{
+    string const prefix = "log_asynchronous_blocking";
+    Log::set_asynchronous(64, Log::block);
+    log_from_threads(prefix, 4, 1000);
+    Log::set_synchronous();
+    CHECK_EQUAL(count_messages(prefix), 4000u);
+
+    // Logging is synchronous again.
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    CHECK_EQUAL(count_messages(prefix), 4001u);
+}
+
+TEST(log_asynchronous_dropping)
+{
+    string const prefix = "log_asynchronous_dropping";
+    unsigned long long const dropped_before = Log::dropped_records();
+    Log::set_asynchronous(2, Log::drop);
+    log_from_threads(prefix, 4, 1000);
+    Log::set_synchronous();
+    unsigned long long const dropped =
+        Log::dropped_records() - dropped_before;
+    CHECK_EQUAL(count_messages(prefix) + dropped, 4000u);
+}
+
+TEST(log_asynchronous_truncation)
+{
+    string const prefix = "log_asynchronous_truncation";
+    string const message = prefix + string(1000, 'x');
+    Log::set_asynchronous();
+    Log::log(Log::info, message.c_str(), __func__, __FILE__, __LINE__);
+    Log::set_synchronous();
+    ifstream file("test.log");
+    string line;
+    string found;
+    while (getline(file, line))
+    {
+        if (line.find(prefix) != string::npos)
+        {
+            found = line;
+        }
+    }
+    CHECK_EQUAL(found, "{F}[message]" + message.substr(0, 255));
+}
+
+TEST(log_flush_policy)
+{
+    string const prefix = "log_flush_policy";
+    Log::set_flush_policy(Log::FlushPolicy::every_n_records(1000));
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    CHECK_EQUAL(count_messages(prefix), 0u);
+    Log::flush();
+    CHECK_EQUAL(count_messages(prefix), 1u);
+
+    // Records at or above the severity of the policy are written at
+    // once, together with anything buffered before them.
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    CHECK_EQUAL(count_messages(prefix), 1u);
+    Log::log(Log::error, prefix.c_str(), __func__, __FILE__, __LINE__);
+    CHECK_EQUAL(count_messages(prefix), 3u);
+
+    // Reaching the number of records in the policy causes a flush.
+    Log::set_flush_policy(Log::FlushPolicy::every_n_records(10));
+    log_from_threads(prefix, 1, 9);
+    CHECK_EQUAL(count_messages(prefix), 3u);
+    log_from_threads(prefix, 1, 1);
+    CHECK_EQUAL(count_messages(prefix), 13u);
+
+    // Changing the policy flushes the buffer.
+    log_from_threads(prefix, 1, 5);
+    Log::set_flush_policy(Log::FlushPolicy());
+    CHECK_EQUAL(count_messages(prefix), 18u);
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    CHECK_EQUAL(count_messages(prefix), 19u);
+}
+
+TEST(log_flush_policy_periodic)
+{
+    string const prefix = "log_flush_policy_periodic";
+    Log::set_flush_policy(Log::FlushPolicy::every_n_milliseconds(10));
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    for (int i = 0; (i != 200) && (count_messages(prefix) == 0); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK_EQUAL(count_messages(prefix), 1u);
+    Log::set_flush_policy(Log::FlushPolicy());
+}
+
+TEST(log_flush_policy_asynchronous)
+{
+    string const prefix = "log_flush_policy_asynchronous";
+    Log::set_flush_policy(Log::FlushPolicy::every_n_bytes(1 << 16));
+    Log::set_asynchronous();
+    log_from_threads(prefix, 4, 100);
+    Log::flush();
+    CHECK_EQUAL(count_messages(prefix), 400u);
+    Log::set_synchronous();
+    Log::set_flush_policy(Log::FlushPolicy());
+}
+
+namespace
+{
+    void log_from_chatty_site()
+    {
+        JEWEL_LOG_MESSAGE(Log::info, "log_sites chatty");
+        return;
+    }
+
+    void log_from_quiet_site()
+    {
+        JEWEL_LOG_MESSAGE(Log::info, "log_sites quiet");
+        return;
+    }
+
+}  // end anonymous namespace
+
+TEST(log_sites)
+{
+    Log::disable_sites("log_from_chatty_site");
+    log_from_chatty_site();
+    log_from_quiet_site();
+    CHECK_EQUAL(count_messages("log_sites chatty"), 0u);
+    CHECK_EQUAL(count_messages("log_sites quiet"), 1u);
+
+    // The latest matching pattern prevails.
+    Log::disable_sites("*log_tests.cpp");
+    Log::enable_sites("log_from_quiet_site");
+    log_from_chatty_site();
+    log_from_quiet_site();
+    CHECK_EQUAL(count_messages("log_sites chatty"), 0u);
+    CHECK_EQUAL(count_messages("log_sites quiet"), 2u);
+
+    Log::enable_sites("*");
+    log_from_chatty_site();
+    CHECK_EQUAL(count_messages("log_sites chatty"), 1u);
+}
+
+TEST(log_rate_limited_macros)
+{
+    for (int i = 0; i != 10; ++i)
+    {
+        JEWEL_LOG_EVERY_N(Log::info, 4, "log_every_n");
+        JEWEL_LOG_FIRST_N(Log::info, 3, "log_first_n");
+        JEWEL_LOG_EVERY_MS(Log::info, 60000, "log_every_ms");
+    }
+    CHECK_EQUAL(count_messages("log_every_n"), 3u);
+    CHECK_EQUAL(count_messages("log_first_n"), 3u);
+    CHECK_EQUAL(count_messages("log_every_ms"), 1u);
+}
+
+TEST(log_flight_recorder)
+{
+    string const prefix = "log_flight_recorder";
+    string const trace_message = prefix + " trace";
+    Log::set_threshold(Log::info);
+    Log::set_flight_recorder(3, Log::trace, Log::error);
+    for (int i = 0; i != 5; ++i)
+    {
+        JEWEL_LOG_MESSAGE(Log::trace, trace_message.c_str());
+    }
+    CHECK_EQUAL(count_messages(trace_message), 0u);
+
+    // Only the most recent 3 records are kept.
+    Log::dump_flight_recorder();
+    CHECK_EQUAL(count_messages(trace_message), 3u);
+    CHECK_EQUAL(count_messages("Flight recorder dump: the 3 "), 1u);
+
+    // The flight recorder was emptied by the dump.
+    Log::dump_flight_recorder();
+    CHECK_EQUAL(count_messages(trace_message), 3u);
+
+    // A record of the dump severity causes a dump, before it is written,
+    // of the records of every thread.
+    log_from_threads(trace_message, 1, 2, Log::trace);
+    JEWEL_LOG_MESSAGE(Log::trace, trace_message.c_str());
+    CHECK_EQUAL(count_messages(trace_message), 3u);
+    JEWEL_LOG_MESSAGE(Log::error, (prefix + " error").c_str());
+    CHECK_EQUAL(count_messages(trace_message), 6u);
+    CHECK_EQUAL(count_messages(prefix + " error"), 1u);
+
+    Log::unset_flight_recorder();
+    JEWEL_LOG_MESSAGE(Log::trace, trace_message.c_str());
+    Log::dump_flight_recorder();
+    CHECK_EQUAL(count_messages(trace_message), 6u);
+    Log::set_threshold(Log::trace);
+}
+
+TEST(log_flight_recorder_dump_severity)
+{
+    // The dump severity may be below the threshold of the flight
+    // recorder.
+    string const prefix = "log_flight_recorder_dump_severity";
+    string const error_message = prefix + " error";
+    Log::set_threshold(Log::error);
+    Log::set_flight_recorder(3, Log::error, Log::warning);
+    JEWEL_LOG_MESSAGE(Log::error, error_message.c_str());
+    CHECK_EQUAL(count_messages(error_message), 1u);
+    JEWEL_LOG_MESSAGE(Log::warning, (prefix + " warning").c_str());
+    CHECK_EQUAL(count_messages(error_message), 2u);
+    CHECK_EQUAL(count_messages(prefix + " warning"), 0u);
+    Log::unset_flight_recorder();
+    Log::set_threshold(Log::trace);
+}
+
+TEST(log_sinks)
+{
+    string const prefix = "log_sinks";
+    string const text_filepath = "test_sink.log";
+    string const json_filepath = "test_sink.json";
+    Log::set_threshold(Log::info);
+    Log::add_sink(text_filepath, Log::warning);
+    Log::add_sink(json_filepath, Log::trace, Log::json);
+    Log::Level const severities[] = { Log::trace, Log::info, Log::warning };
+
+    // Each file receives the records that pass its own threshold.
+    for (auto severity: severities)
+    {
+        Log::log(severity, prefix.c_str(), __func__, __FILE__, __LINE__);
+    }
+    CHECK_EQUAL(count_messages(prefix), 2u);
+    CHECK_EQUAL(count_messages(prefix, text_filepath), 1u);
+    CHECK_EQUAL(count_json_messages(prefix, json_filepath), 3u);
+
+    Log::set_asynchronous();
+    for (auto severity: severities)
+    {
+        Log::log(severity, prefix.c_str(), __func__, __FILE__, __LINE__);
+    }
+    Log::set_synchronous();
+    CHECK_EQUAL(count_messages(prefix), 4u);
+    CHECK_EQUAL(count_messages(prefix, text_filepath), 2u);
+    CHECK_EQUAL(count_json_messages(prefix, json_filepath), 6u);
+
+    // A record has the same id in every file.
+    string id;
+    for (auto const& line: read_lines(text_filepath))
+    {
+        if (line.compare(0, 7, "{F}[id]") == 0)
+        {
+            id = line.substr(7);
+        }
+    }
+    vector<string> json_lines = read_lines(json_filepath);
+    CHECK_EQUAL(json_lines.size(), 7u);
+    CHECK_EQUAL
+    (   json_lines.back().substr(0, 7 + id.size()),
+        "{\"id\":" + id + ","
+    );
+
+    // Removing a file finishes it, and nothing more is written to it.
+    Log::remove_sink(json_filepath);
+    Log::log(Log::error, prefix.c_str(), __func__, __FILE__, __LINE__);
+    json_lines = read_lines(json_filepath);
+    CHECK_EQUAL(json_lines.size(), 8u);
+    CHECK(json_lines.back().find("\"message\":\"End log\"") != string::npos);
+    CHECK_EQUAL(count_messages(prefix, text_filepath), 3u);
+    CHECK_EQUAL(count_messages(prefix), 5u);
+
+    Log::remove_sink(text_filepath);
+    Log::set_threshold(Log::trace);
+}
+
+TEST(log_set_filepath_format)
+{
+    // Changing the format of the file at the same path finishes the old
+    // file before the new one is written.
+    string const prefix = "log_set_filepath_format";
+    string const filepath = "test_format.log";
+    Log::set_filepath(filepath);
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    Log::set_filepath(filepath, Log::binary);
+    Log::log(Log::info, prefix.c_str(), __func__, __FILE__, __LINE__);
+    Log::set_filepath("test.log");
+    string const decoded_filepath = "test_format_decoded.log";
+    {
+        ifstream binary(filepath, ios::binary);
+        ofstream decoded(decoded_filepath);
+        decode_binary_log(binary, decoded);
+    }
+    CHECK_EQUAL(count_messages(prefix, decoded_filepath), 1u);
+    CHECK_EQUAL(count_messages("End log", decoded_filepath), 1u);
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "log.hpp"
+#include "allocation_counter.hpp"
+#include "capped_string.hpp"
+#include "decimal.hpp"
+#include "version.hpp"
+#include "detail/log_value.hpp"
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::CappedString;
+using jewel::Decimal;
+using jewel::Log;
+using jewel::Version;
+using jewel::detail::IsFormattedByToChars;
+using jewel::detail::LogValue;
+using jewel::detail::thread_allocation_count;
+using std::ifstream;
+using std::size_t;
+using std::string;
+
+namespace
+{
+    enum Colour { red, green };
+
+    // Returns the "value" field of the last record in test.log with the
+    // given expression.
+    string last_value_logged(string const& p_expression)
+    {
+        ifstream file("test.log");
+        string const expression_field = "{F}[expression]" + p_expression;
+        string const value_field = "{F}[value]";
+        string ret;
+        bool is_match = false;
+        string line;
+        while (getline(file, line))
+        {
+            if (line == expression_field)
+            {
+                is_match = true;
+            }
+            else if
+            (   is_match &&
+                (line.compare(0, value_field.size(), value_field) == 0)
+            )
+            {
+                ret = line.substr(value_field.size());
+                is_match = false;
+            }
+        }
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+TEST(log_value_formatting)
+{
+    CHECK(IsFormattedByToChars<int>::value);
+    CHECK(IsFormattedByToChars<double>::value);
+    CHECK(IsFormattedByToChars<bool>::value);
+    CHECK(IsFormattedByToChars<Decimal>::value);
+    CHECK(IsFormattedByToChars<CappedString<20> >::value);
+    CHECK(IsFormattedByToChars<Version>::value);
+    CHECK(!IsFormattedByToChars<char>::value);
+    CHECK(!IsFormattedByToChars<Colour>::value);
+    CHECK(!IsFormattedByToChars<string>::value);
+
+    CHECK_EQUAL(LogValue(-45).c_str(), string("-45"));
+    CHECK_EQUAL(LogValue(0.25).c_str(), string("0.25"));
+    CHECK_EQUAL(LogValue(true).c_str(), string("1"));
+    CHECK_EQUAL(LogValue(Decimal("-0.050")).c_str(), string("-0.050"));
+    CHECK_EQUAL(LogValue(Version(1, 2, 3)).c_str(), string("1.2.3"));
+    CHECK_EQUAL(LogValue('x').c_str(), string("x"));
+    CHECK_EQUAL(LogValue(green).c_str(), string("1"));
+    CHECK_EQUAL(LogValue(string(200, 'y')).c_str(), string(200, 'y'));
+
+    // Too long for the buffer, so converted by boost::lexical_cast
+    CappedString<200> const long_string(string(150, 'z').c_str());
+    CHECK_EQUAL(LogValue(long_string).c_str(), string(150, 'z'));
+}
+
+TEST(log_value_allocation_free)
+{
+    int const i = 17;
+    double const d = 3.5;
+    Decimal const decimal("12.34");
+    CappedString<20> const capped("capped");
+    Version const version(4, 5, 6);
+
+    // The first call from each site may allocate, in setting up buffers.
+    for (int pass = 0; pass != 2; ++pass)
+    {
+        size_t const allocations_before = thread_allocation_count();
+        for (int n = 0; n != 100; ++n)
+        {
+            JEWEL_LOG_VALUE(Log::info, i);
+            JEWEL_LOG_VALUE(Log::info, d);
+            JEWEL_LOG_VALUE(Log::info, decimal);
+            JEWEL_LOG_VALUE(Log::info, capped);
+            JEWEL_LOG_VALUE(Log::info, version);
+        }
+        if (pass == 1)
+        {
+            CHECK_EQUAL(thread_allocation_count() - allocations_before, 0u);
+        }
+    }
+
+    // Check that allocations are indeed being counted.
+    size_t const allocations_before = thread_allocation_count();
+    JEWEL_LOG_VALUE(Log::info, string(100, 'q'));
+    CHECK(thread_allocation_count() > allocations_before);
+
+    CHECK_EQUAL(last_value_logged("i"), "17");
+    CHECK_EQUAL(last_value_logged("d"), "3.5");
+    CHECK_EQUAL(last_value_logged("decimal"), "12.34");
+    CHECK_EQUAL(last_value_logged("capped"), "capped");
+    CHECK_EQUAL(last_value_logged("version"), "4.5.6");
+}
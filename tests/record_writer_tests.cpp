@@ -0,0 +1,209 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "record_writer.hpp"
+#include "capped_string.hpp"
+#include "decimal.hpp"
+#include "on_windows.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <UnitTest++/UnitTest++.h>
+
+#ifndef JEWEL_ON_WINDOWS
+#   include <unistd.h>
+#endif
+
+using jewel::CappedString;
+using jewel::Decimal;
+using jewel::FileDescriptorSink;
+using jewel::MemorySink;
+using jewel::RecordSink;
+using jewel::RecordWriter;
+using jewel::RecordWriterException;
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace
+{
+    vector<string> names(char const* p_a, char const* p_b, char const* p_c)
+    {
+        vector<string> ret;
+        ret.push_back(p_a);
+        ret.push_back(p_b);
+        ret.push_back(p_c);
+        return ret;
+    }
+
+    // Records the size of each write, to check how writes are batched.
+    class CountingSink: public RecordSink
+    {
+    public:
+        virtual void write(char const* p_data, size_t p_size)
+        {
+            sizes.push_back(p_size);
+            contents.append(p_data, p_size);
+            return;
+        }
+        vector<size_t> sizes;
+        string contents;
+    };
+
+    class FailingSink: public RecordSink
+    {
+    public:
+        virtual void write(char const*, size_t)
+        {
+            throw RecordWriterException("Sink failed.");
+        }
+    };
+
+}  // end anonymous namespace
+
+TEST(record_writer_csv)
+{
+    MemorySink sink;
+    {
+        RecordWriter writer(sink, RecordWriter::csv);
+        writer.append(Decimal("-12.50")).append(42).append("plain");
+        writer.end_record();
+        writer.append("with, comma").append("say \"hi\"");
+        writer.append(string("line\nbreak")).append("");
+        writer.end_record();
+        writer.append(CappedString<8>("abc")).append(18446744073709551615ULL);
+        writer.append(-9223372036854775807LL - 1).append(Decimal("0.050"));
+        writer.end_record();
+        CHECK_EQUAL(sink.contents(), "");
+    }
+    CHECK_EQUAL
+    (   sink.contents(),
+        "-12.50,42,plain\n"
+        "\"with, comma\",\"say \"\"hi\"\"\",\"line\nbreak\",\n"
+        "abc,18446744073709551615,-9223372036854775808,0.050\n"
+    );
+}
+
+TEST(record_writer_csv_header)
+{
+    MemorySink sink;
+    RecordWriter writer(sink, RecordWriter::csv, names("a", "b,c", "d"));
+    writer.append(1).append(2).append(3).end_record();
+    writer.append(1).append(2);
+    CHECK_THROW(writer.end_record(), RecordWriterException);
+    writer.append(4).append(5).append(6);
+    CHECK_THROW(writer.append(7), RecordWriterException);
+    writer.append(7).append(8).append(9).end_record();
+    writer.flush();
+    CHECK_EQUAL(sink.contents(), "a,\"b,c\",d\n1,2,3\n7,8,9\n");
+}
+
+TEST(record_writer_json_lines)
+{
+    MemorySink sink;
+    RecordWriter writer
+    (   sink,
+        RecordWriter::json_lines,
+        names("amount", "count", "say \"x\"")
+    );
+    writer.append(Decimal("-0.05")).append(3U).append("a\"b\\c\n\t\x01");
+    writer.end_record();
+    writer.append(Decimal("7")).append(-1L).append(CappedString<4>("ok"));
+    writer.end_record();
+    writer.flush();
+    CHECK_EQUAL
+    (   sink.contents(),
+        "{\"amount\":-0.05,\"count\":3,\"say \\\"x\\\"\":"
+        "\"a\\\"b\\\\c\\n\\t\\u0001\"}\n"
+        "{\"amount\":7,\"count\":-1,\"say \\\"x\\\"\":\"ok\"}\n"
+    );
+    CHECK_THROW
+    (   RecordWriter(sink, RecordWriter::json_lines),
+        RecordWriterException
+    );
+}
+
+TEST(record_writer_batching)
+{
+    CountingSink sink;
+    {
+        RecordWriter writer(sink, RecordWriter::csv, vector<string>(), 100);
+        for (int i = 0; i != 1000; ++i)
+        {
+            writer.append(i).append(Decimal(i, 2));
+            writer.end_record();
+        }
+        writer.append("incomplete");
+        writer.flush();
+        CHECK(sink.sizes.size() > 1);
+        CHECK(sink.sizes.size() < 200);
+    }
+    // Each write holds whole records, and the incomplete record is never
+    // written.
+    string expected;
+    for (int i = 0; i != 1000; ++i)
+    {
+        char line[64];
+        std::sprintf(line, "%d,%d.%02d\n", i, i / 100, i % 100);
+        expected += line;
+    }
+    CHECK_EQUAL(sink.contents, expected);
+    size_t offset = 0;
+    for (size_t i = 0; i != sink.sizes.size(); ++i)
+    {
+        offset += sink.sizes[i];
+        CHECK_EQUAL(sink.contents[offset - 1], '\n');
+    }
+}
+
+TEST(record_writer_sink_failure)
+{
+    FailingSink sink;
+    RecordWriter writer(sink, RecordWriter::csv);
+    writer.append(1).end_record();
+    writer.append(2);
+    CHECK_THROW(writer.flush(), RecordWriterException);
+
+    // The records that failed are discarded, but the incomplete record
+    // survives.
+    writer.end_record();
+    CHECK_THROW(writer.flush(), RecordWriterException);
+    writer.flush();
+}
+
+#ifndef JEWEL_ON_WINDOWS
+TEST(record_writer_file_descriptor_sink)
+{
+    int fds[2];
+    CHECK_EQUAL(::pipe(fds), 0);
+    {
+        FileDescriptorSink sink(fds[1]);
+        RecordWriter writer(sink, RecordWriter::csv, names("x", "y", "z"));
+        writer.append(Decimal("1.5")).append("two").append(3);
+        writer.end_record();
+    }
+    ::close(fds[1]);
+    char buffer[64];
+    ssize_t const n = ::read(fds[0], buffer, sizeof(buffer));
+    ::close(fds[0]);
+    CHECK_EQUAL(string(buffer, n > 0? n: 0), "x,y,z\n1.5,two,3\n");
+
+    FileDescriptorSink bad_sink(-1);
+    CHECK_THROW(bad_sink.write("a", 1), RecordWriterException);
+}
+#endif
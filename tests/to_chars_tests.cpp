@@ -0,0 +1,180 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "to_chars.hpp"
+#include "capped_string.hpp"
+#include "decimal.hpp"
+#include "version.hpp"
+#include <cstdint>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <UnitTest++/UnitTest++.h>
+
+using jewel::CappedString;
+using jewel::Decimal;
+using jewel::max_numeric_chars;
+using jewel::to_chars;
+using jewel::Version;
+using std::int64_t;
+using std::numeric_limits;
+using std::ostringstream;
+using std::string;
+using std::uint64_t;
+
+namespace
+{
+    template <typename T>
+    string text_of(T const& p_value)
+    {
+        char buffer[max_numeric_chars];
+        char* const end = to_chars(buffer, buffer + sizeof(buffer), p_value);
+        CHECK(end != nullptr);
+        return (end == nullptr)? string(): string(buffer, end);
+    }
+
+    template <typename T>
+    string stream_text_of(T const& p_value)
+    {
+        ostringstream oss;
+        oss.imbue(std::locale::classic());
+        oss << p_value;
+        return oss.str();
+    }
+
+}  // end anonymous namespace
+
+TEST(to_chars_integers)
+{
+    CHECK_EQUAL(text_of(0), "0");
+    CHECK_EQUAL(text_of(7), "7");
+    CHECK_EQUAL(text_of(-7), "-7");
+    CHECK_EQUAL(text_of(10), "10");
+    CHECK_EQUAL(text_of(-99), "-99");
+    CHECK_EQUAL(text_of(100), "100");
+    CHECK_EQUAL(text_of(1234567890L), "1234567890");
+    CHECK_EQUAL
+    (   text_of(numeric_limits<long long>::min()),
+        "-9223372036854775808"
+    );
+    CHECK_EQUAL
+    (   text_of(numeric_limits<long long>::max()),
+        "9223372036854775807"
+    );
+    CHECK_EQUAL
+    (   text_of(numeric_limits<unsigned long long>::max()),
+        "18446744073709551615"
+    );
+    CHECK_EQUAL(text_of(numeric_limits<int>::min()), "-2147483648");
+    CHECK_EQUAL(text_of(4000000000U), "4000000000");
+    uint64_t r = 88172645463325252ULL;
+    for (int i = 0; i != 10000; ++i)
+    {
+        r ^= r << 13;
+        r ^= r >> 7;
+        r ^= r << 17;
+        int64_t const x = static_cast<int64_t>(r) >> (i % 64);
+        CHECK_EQUAL(text_of(x), stream_text_of(x));
+        CHECK_EQUAL(text_of(r >> (i % 64)), stream_text_of(r >> (i % 64)));
+    }
+}
+
+TEST(to_chars_decimal)
+{
+    CHECK_EQUAL(text_of(Decimal("0")), "0");
+    CHECK_EQUAL(text_of(Decimal("0.00")), "0.00");
+    CHECK_EQUAL(text_of(Decimal("-12.50")), "-12.50");
+    CHECK_EQUAL(text_of(Decimal("0.050")), "0.050");
+    CHECK_EQUAL(text_of(Decimal("-0.0001")), "-0.0001");
+    CHECK_EQUAL(text_of(Decimal("1000000")), "1000000");
+    CHECK_EQUAL(text_of(Decimal::maximum()), "9223372036854775807");
+    CHECK_EQUAL(text_of(Decimal::minimum()), "-9223372036854775808");
+    CHECK_EQUAL
+    (   text_of(Decimal(numeric_limits<Decimal::int_type>::max(), 19)),
+        "0.9223372036854775807"
+    );
+    CHECK_EQUAL
+    (   text_of(Decimal(-1, 19)),
+        "-0.0000000000000000001"
+    );
+    uint64_t r = 88172645463325252ULL;
+    for (int i = 0; i != 10000; ++i)
+    {
+        r ^= r << 13;
+        r ^= r >> 7;
+        r ^= r << 17;
+        Decimal::int_type const intval =
+            static_cast<Decimal::int_type>(r) >> (i % 64);
+        Decimal::places_type const places =
+            static_cast<Decimal::places_type>(i % 20);
+        Decimal const d(intval, places);
+        CHECK_EQUAL(text_of(d), stream_text_of(d));
+    }
+}
+
+TEST(to_chars_insufficient_space)
+{
+    char buffer[max_numeric_chars];
+    CHECK(to_chars(buffer, buffer + 3, 1234) == nullptr);
+    CHECK(to_chars(buffer, buffer + 4, 1234) == buffer + 4);
+    CHECK(to_chars(buffer, buffer + 4, -1234) == nullptr);
+    CHECK(to_chars(buffer, buffer, 0) == nullptr);
+    CHECK(to_chars(buffer, buffer + 5, Decimal("-1.23")) == buffer + 5);
+    CHECK(to_chars(buffer, buffer + 4, Decimal("-1.23")) == nullptr);
+    CHECK(to_chars(buffer, buffer + 4, Decimal("0.05")) == buffer + 4);
+    CHECK(to_chars(buffer, buffer + 3, Decimal("0.05")) == nullptr);
+}
+
+TEST(to_chars_floating_point)
+{
+    // The text is that of boost::lexical_cast, which uses enough digits
+    // for the value to be read back exactly.
+    CHECK_EQUAL(text_of(0.1), "0.10000000000000001");
+    CHECK_EQUAL(text_of(-2.5), "-2.5");
+    CHECK_EQUAL(text_of(100.0), "100");
+    CHECK_EQUAL(text_of(1e100), "1e+100");
+    CHECK_EQUAL(text_of(numeric_limits<double>::infinity()), "inf");
+    CHECK_EQUAL(text_of(0.1f), "0.100000001");
+    CHECK_EQUAL(text_of(1.5L), "1.5");
+    CHECK
+    (   text_of(-numeric_limits<long double>::max()).size() <=
+        max_numeric_chars
+    );
+    CHECK
+    (   text_of(-numeric_limits<long double>::denorm_min()).size() <=
+        max_numeric_chars
+    );
+    CHECK(text_of(-numeric_limits<double>::denorm_min()).size() <= 32u);
+
+    char buffer[max_numeric_chars];
+    CHECK(to_chars(buffer, buffer + 3, 2.25) == nullptr);
+    CHECK(to_chars(buffer, buffer + 4, 2.25) == buffer + 4);
+}
+
+TEST(to_chars_capped_string_and_version)
+{
+    CHECK_EQUAL(text_of(CappedString<10>("abc")), "abc");
+    CHECK_EQUAL(text_of(CappedString<10>("")), "");
+    CHECK_EQUAL(text_of(Version(2, 0, 13)), "2.0.13");
+
+    char buffer[max_numeric_chars];
+    CHECK(to_chars(buffer, buffer + 2, CappedString<10>("abc")) == nullptr);
+    CHECK(to_chars(buffer, buffer + 5, Version(2, 0, 13)) == nullptr);
+    CHECK(to_chars(buffer, buffer + 6, Version(2, 0, 13)) == buffer + 6);
+}
+
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Usage:
+// jewel_log_decode [--csv] path_to_logfile
+
+// Takes a log file produced by jewel::Log, in either the text or the binary
+// format, and prints it to stdout in the text format, or in CSV form if
+// "--csv" is passed. The CSV is the same as that produced by
+// jewel_log_to_csv.py.
+
+#include "log_decoder.hpp"
+#include "detail/log_format.hpp"
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using jewel::convert_log_to_csv;
+using jewel::decode_binary_log;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ios;
+using std::istringstream;
+using std::ostringstream;
+using std::string;
+
+namespace
+{
+
+int usage()
+{
+    cerr << "Usage: jewel_log_decode [--csv] path_to_logfile" << endl;
+    return 1;
+}
+
+}  // end anonymous namespace
+
+int main(int argc, char** argv)
+{
+    bool csv = false;
+    char const* filepath = nullptr;
+    for (int i = 1; i != argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else if (!filepath)
+        {
+            filepath = argv[i];
+        }
+        else
+        {
+            return usage();
+        }
+    }
+    if (!filepath)
+    {
+        return usage();
+    }
+    ifstream file(filepath, ios::in | ios::binary);
+    if (!file)
+    {
+        cerr << "Could not open " << filepath << "." << endl;
+        return 1;
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    string text = contents.str();
+    try
+    {
+        if
+        (   text.compare
+            (   0,
+                jewel::detail::log_binary_magic_size,
+                jewel::detail::log_binary_magic
+            ) == 0
+        )
+        {
+            istringstream binary(text);
+            ostringstream decoded;
+            decode_binary_log(binary, decoded);
+            text = decoded.str();
+        }
+        if (csv)
+        {
+            istringstream text_stream(text);
+            convert_log_to_csv(text_stream, cout);
+        }
+        else
+        {
+            cout << text;
+        }
+    }
+    catch (std::exception& e)
+    {
+        cerr << filepath << ": " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,823 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal.hpp"
+#include "decimal_exceptions.hpp"
+#include "decimal_stats.hpp"
+#include "info.hpp"
+#include "version.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using jewel::Decimal;
+using jewel::DecimalDivisionByZeroException;
+using jewel::DecimalMultiplicationException;
+using jewel::DecimalStats;
+using jewel::Info;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::istringstream;
+using std::numeric_limits;
+using std::ostream;
+using std::ostringstream;
+using std::size_t;
+using std::sort;
+using std::sqrt;
+using std::string;
+using std::uint64_t;
+using std::vector;
+
+// Benchmarks the Decimal operations over several realistic distributions
+// of values, reporting statistics over repeated samples, either as a
+// table or (with --json) as JSON, so that results can be compared between
+// releases.
+//
+// Each sample times one pass of an operation over a whole dataset, using
+// wall-clock time, after a number of unmeasured warm-up passes. Every pass
+// folds its results into a checksum, so that the optimizer cannot remove
+// the work being measured.
+//
+// Usage: decimal_benchmark [--json] [--samples N] [--warmup N] [--size N]
+//                          [--filter TEXT]
+
+namespace
+{
+
+typedef Decimal::int_type int_type;
+typedef Decimal::places_type places_type;
+
+// Reproducible pseudo-random numbers ("xorshift"), so that every run sees
+// the same values.
+class Random
+{
+public:
+    Random(): m_state(88172645463325252ULL)
+    {
+    }
+    uint64_t next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+    // Returns a number from p_min to p_max inclusive.
+    int_type uniform(int_type p_min, int_type p_max)
+    {
+        uint64_t const range =
+            static_cast<uint64_t>(p_max) - static_cast<uint64_t>(p_min);
+        uint64_t const offset =
+            (range == numeric_limits<uint64_t>::max())?
+            next():
+            next() % (range + 1);
+        return static_cast<int_type>(static_cast<uint64_t>(p_min) + offset);
+    }
+private:
+    uint64_t m_state;
+};
+
+// The operands for the benchmarks run over one distribution of values.
+struct Dataset
+{
+    string name;
+
+    // The values themselves, to be used as left-hand operands.
+    vector<Decimal> values;
+
+    // The same values rotated by one place, to be used as right-hand
+    // operands of additions, subtractions and comparisons.
+    vector<Decimal> others;
+
+    // Rates near 1, to be used as right-hand operands of multiplications
+    // and divisions, as in the application of an exchange rate.
+    vector<Decimal> rates;
+
+    // The values written as strings, individually and all together
+    // separated by spaces.
+    vector<string> strings;
+    string text;
+};
+
+enum Distribution
+{
+    same_scale,
+    mixed_scale,
+    near_overflow,
+    negative
+};
+
+Dataset make_dataset
+(   char const* p_name,
+    Distribution p_distribution,
+    size_t p_size
+)
+{
+    Dataset ret;
+    ret.name = p_name;
+    Random random;
+    int_type const max = numeric_limits<int_type>::max();
+    for (size_t i = 0; i != p_size; ++i)
+    {
+        int_type intval = 0;
+        places_type places = 0;
+        switch (p_distribution)
+        {
+        case same_scale:
+            // Amounts of money in cents
+            intval = random.uniform(-100000000, 100000000);
+            places = 2;
+            break;
+        case mixed_scale:
+            intval = random.uniform(-1000000000, 1000000000);
+            places = static_cast<places_type>(random.uniform(0, 6));
+            break;
+        case near_overflow:
+            // Large enough that most operations are near to overflowing,
+            // but small enough that the sum of any two does not.
+            intval = random.uniform(max / 4, max / 2);
+            if (random.next() % 2 == 0)
+            {
+                intval = -intval;
+            }
+            places = 2;
+            break;
+        case negative:
+            intval = random.uniform(-1000000000, -1);
+            places = static_cast<places_type>(random.uniform(2, 4));
+            break;
+        }
+        ret.values.push_back(Decimal(intval, places));
+        ret.rates.push_back(Decimal(random.uniform(5000, 15000), 4));
+    }
+    ret.others = ret.values;
+    if (!ret.others.empty())
+    {
+        std::rotate
+        (   ret.others.begin(),
+            ret.others.begin() + 1,
+            ret.others.end()
+        );
+    }
+    ostringstream oss;
+    for (size_t i = 0; i != p_size; ++i)
+    {
+        ostringstream one;
+        one << ret.values[i];
+        ret.strings.push_back(one.str());
+        oss << ret.strings.back() << ' ';
+    }
+    ret.text = oss.str();
+    return ret;
+}
+
+
+// Kernels. Each performs one operation on every element of a dataset and
+// returns a checksum of the results.
+
+uint64_t checksum_of(Decimal const& p_decimal)
+{
+    return static_cast<uint64_t>(p_decimal.intval()) + p_decimal.places();
+}
+
+uint64_t add(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x += p_data.others[i];
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t subtract(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x -= p_data.others[i];
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t multiply(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x *= p_data.rates[i];
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t divide(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x /= p_data.rates[i];
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t multiply_by_integer(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x.mul(3);
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t divide_by_integer(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x.div(3);
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t add_units(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        x.add_units(1);
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+// Adds every value to a running total, as in totalling a ledger.
+uint64_t sum(Dataset const& p_data)
+{
+    Decimal total;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        total += p_data.values[i];
+    }
+    return checksum_of(total);
+}
+
+uint64_t less(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        ret += (p_data.values[i] < p_data.others[i]);
+    }
+    return ret;
+}
+
+uint64_t equal(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        ret += (p_data.values[i] == p_data.others[i]);
+    }
+    return ret;
+}
+
+uint64_t round_half_away(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        ret += checksum_of(round(p_data.values[i], 1));
+    }
+    return ret;
+}
+
+uint64_t round_half_even(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        ret += checksum_of
+        (   round(p_data.values[i], 1, jewel::round_half_even)
+        );
+    }
+    return ret;
+}
+
+uint64_t round_n_half_even(Dataset const& p_data)
+{
+    vector<Decimal> rounded(p_data.values.size());
+    if (!rounded.empty())
+    {
+        round_n
+        (   &p_data.values[0],
+            &rounded[0],
+            rounded.size(),
+            1,
+            jewel::round_half_even
+        );
+    }
+    uint64_t ret = 0;
+    for (size_t i = 0; i != rounded.size(); ++i)
+    {
+        ret += checksum_of(rounded[i]);
+    }
+    return ret;
+}
+
+uint64_t increment(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        ++x;
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t decrement(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        --x;
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t stream_out(Dataset const& p_data)
+{
+    ostringstream oss;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        oss << p_data.values[i] << ' ';
+    }
+    return static_cast<uint64_t>(oss.tellp());
+}
+
+uint64_t stream_in(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    istringstream iss(p_data.text);
+    Decimal x;
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        iss >> x;
+        ret += checksum_of(x);
+    }
+    return ret;
+}
+
+uint64_t construct_from_string(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != p_data.strings.size(); ++i)
+    {
+        ret += checksum_of(Decimal(p_data.strings[i]));
+    }
+    return ret;
+}
+
+uint64_t divide_by_zero(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    Decimal const zero(0, 0);
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        try
+        {
+            x /= zero;
+        }
+        catch (DecimalDivisionByZeroException&)
+        {
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+uint64_t multiply_overflow(Dataset const& p_data)
+{
+    uint64_t ret = 0;
+    Decimal const ten(10, 0);
+    for (size_t i = 0; i != p_data.values.size(); ++i)
+    {
+        Decimal x = p_data.values[i];
+        try
+        {
+            x *= ten;
+        }
+        catch (DecimalMultiplicationException&)
+        {
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+typedef uint64_t (*Kernel)(Dataset const&);
+
+struct Benchmark
+{
+    char const* name;
+    Kernel kernel;
+    Dataset const* dataset;
+};
+
+struct Options
+{
+    Options():
+        json(false),
+        samples(15),
+        warmup(3),
+        size(100000)
+    {
+    }
+    bool json;
+    size_t samples;
+    size_t warmup;
+    size_t size;
+    string filter;
+};
+
+struct Result
+{
+    string name;
+    string dataset;
+    size_t operations;
+    uint64_t checksum;
+
+    // Nanoseconds per operation
+    double minimum;
+    double median;
+    double mean;
+    double standard_deviation;
+    double maximum;
+
+    // Only populated if DecimalStats::enabled().
+    DecimalStats counters;
+};
+
+double nanoseconds_per_operation(Benchmark const& p_benchmark, uint64_t& p_sum)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point const start = Clock::now();
+    p_sum += p_benchmark.kernel(*p_benchmark.dataset);
+    Clock::time_point const end = Clock::now();
+    std::chrono::duration<double, std::nano> const elapsed = end - start;
+    return elapsed.count() / p_benchmark.dataset->values.size();
+}
+
+Result run(Benchmark const& p_benchmark, Options const& p_options)
+{
+    Result ret;
+    ret.name = p_benchmark.name;
+    ret.dataset = p_benchmark.dataset->name;
+    ret.operations = p_benchmark.dataset->values.size();
+    ret.checksum = 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i != p_options.warmup; ++i)
+    {
+        nanoseconds_per_operation(p_benchmark, sum);
+    }
+    DecimalStats const before = DecimalStats::thread_snapshot();
+    vector<double> samples;
+    for (size_t i = 0; i != p_options.samples; ++i)
+    {
+        samples.push_back(nanoseconds_per_operation(p_benchmark, sum));
+    }
+    ret.counters = DecimalStats::thread_snapshot() - before;
+    ret.checksum = sum;
+    sort(samples.begin(), samples.end());
+    size_t const n = samples.size();
+    ret.minimum = samples.front();
+    ret.maximum = samples.back();
+    ret.median =
+    (   (n % 2 == 1)?
+        samples[n / 2]:
+        (samples[n / 2 - 1] + samples[n / 2]) / 2
+    );
+    double total = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        total += samples[i];
+    }
+    ret.mean = total / n;
+    double squares = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        squares += (samples[i] - ret.mean) * (samples[i] - ret.mean);
+    }
+    ret.standard_deviation = (n > 1)? sqrt(squares / (n - 1)): 0;
+    return ret;
+}
+
+bool parse_count(char const* p_text, size_t& p_count)
+{
+    char* end = 0;
+    unsigned long const count = std::strtoul(p_text, &end, 10);
+    if (end == p_text || *end != '\0' || count == 0)
+    {
+        return false;
+    }
+    p_count = count;
+    return true;
+}
+
+bool parse_options(int argc, char** argv, Options& p_options)
+{
+    for (int i = 1; i != argc; ++i)
+    {
+        string const arg = argv[i];
+        bool const has_value = (i + 1 != argc);
+        if (arg == "--json")
+        {
+            p_options.json = true;
+        }
+        else if (arg == "--samples" && has_value)
+        {
+            if (!parse_count(argv[++i], p_options.samples)) return false;
+        }
+        else if (arg == "--warmup" && has_value)
+        {
+            if (!parse_count(argv[++i], p_options.warmup)) return false;
+        }
+        else if (arg == "--size" && has_value)
+        {
+            if (!parse_count(argv[++i], p_options.size)) return false;
+        }
+        else if (arg == "--filter" && has_value)
+        {
+            p_options.filter = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void write_json_string(ostream& p_os, string const& p_string)
+{
+    p_os << '"';
+    for
+    (   string::const_iterator it = p_string.begin();
+        it != p_string.end();
+        ++it
+    )
+    {
+        if (*it == '"' || *it == '\\')
+        {
+            p_os << '\\';
+        }
+        p_os << *it;
+    }
+    p_os << '"';
+    return;
+}
+
+void write_json
+(   ostream& p_os,
+    Options const& p_options,
+    vector<Result> const& p_results
+)
+{
+    p_os << "{\n"
+         << "  \"library\": \"jewel\",\n"
+         << "  \"version\": \"" << Info::version() << "\",\n"
+         << "  \"compiler\": ";
+#   ifdef __VERSION__
+        write_json_string(p_os, __VERSION__);
+#   else
+        write_json_string(p_os, "unknown");
+#   endif
+    p_os << ",\n"
+#   ifdef NDEBUG
+         << "  \"assertions\": false,\n"
+#   else
+         << "  \"assertions\": true,\n"
+#   endif
+         << "  \"decimal_stats\": "
+         << (DecimalStats::enabled()? "true": "false") << ",\n"
+         << "  \"samples\": " << p_options.samples << ",\n"
+         << "  \"warmup\": " << p_options.warmup << ",\n"
+         << "  \"unit\": \"ns/op\",\n"
+         << "  \"benchmarks\": [";
+    p_os << std::setprecision(6);
+    for (size_t i = 0; i != p_results.size(); ++i)
+    {
+        Result const& r = p_results[i];
+        p_os << ((i == 0)? "\n": ",\n")
+             << "    {\"name\": \"" << r.name << "\", "
+             << "\"dataset\": \"" << r.dataset << "\", "
+             << "\"operations\": " << r.operations << ", "
+             << "\"min\": " << r.minimum << ", "
+             << "\"median\": " << r.median << ", "
+             << "\"mean\": " << r.mean << ", "
+             << "\"stddev\": " << r.standard_deviation << ", "
+             << "\"max\": " << r.maximum << ", "
+             << "\"checksum\": " << r.checksum;
+        if (DecimalStats::enabled())
+        {
+            p_os << ", \"counters\": {";
+            for (int c = 0; c != DecimalStats::num_counters; ++c)
+            {
+                DecimalStats::Counter const counter =
+                    static_cast<DecimalStats::Counter>(c);
+                p_os << ((c == 0)? "": ", ")
+                     << '"' << DecimalStats::name(counter) << "\": "
+                     << r.counters.count(counter);
+            }
+            p_os << '}';
+        }
+        p_os << '}';
+    }
+    p_os << "\n  ]\n}" << endl;
+    return;
+}
+
+void write_table(ostream& p_os, vector<Result> const& p_results)
+{
+    p_os << std::left << std::setw(36) << "benchmark"
+         << std::right
+         << std::setw(10) << "median"
+         << std::setw(10) << "min"
+         << std::setw(10) << "max"
+         << std::setw(10) << "stddev"
+         << "  (ns/op)" << '\n';
+    p_os << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i != p_results.size(); ++i)
+    {
+        Result const& r = p_results[i];
+        p_os << std::left << std::setw(36) << (r.name + '/' + r.dataset)
+             << std::right
+             << std::setw(10) << r.median
+             << std::setw(10) << r.minimum
+             << std::setw(10) << r.maximum
+             << std::setw(10) << r.standard_deviation
+             << '\n';
+    }
+    p_os.flush();
+    return;
+}
+
+}  // end anonymous namespace
+
+int decimal_benchmark(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options))
+    {
+        cerr << "Usage: " << argv[0] << " [--json] [--samples N] "
+             << "[--warmup N] [--size N] [--filter TEXT]" << endl;
+        return 2;
+    }
+
+    Dataset const same = make_dataset("same_scale", same_scale, options.size);
+    Dataset const mixed =
+        make_dataset("mixed_scale", mixed_scale, options.size);
+    Dataset const big =
+        make_dataset("near_overflow", near_overflow, options.size);
+    Dataset const neg = make_dataset("negative", negative, options.size);
+
+    // Exceptions are so much slower than everything else that they are
+    // measured over fewer values.
+    size_t const exception_size = std::max<size_t>(options.size / 100, 1);
+    Dataset const big_few =
+        make_dataset("near_overflow", near_overflow, exception_size);
+
+    Benchmark const benchmarks[] =
+    {
+        { "add", add, &same },
+        { "add", add, &mixed },
+        { "add", add, &big },
+        { "add", add, &neg },
+        { "subtract", subtract, &same },
+        { "subtract", subtract, &mixed },
+        { "subtract", subtract, &big },
+        { "subtract", subtract, &neg },
+        { "multiply", multiply, &same },
+        { "multiply", multiply, &mixed },
+        { "multiply", multiply, &neg },
+        { "divide", divide, &same },
+        { "divide", divide, &mixed },
+        { "divide", divide, &neg },
+        { "multiply_by_integer", multiply_by_integer, &same },
+        { "multiply_by_integer", multiply_by_integer, &mixed },
+        { "divide_by_integer", divide_by_integer, &same },
+        { "divide_by_integer", divide_by_integer, &mixed },
+        { "add_units", add_units, &same },
+        { "add_units", add_units, &mixed },
+        { "sum", sum, &same },
+        { "sum", sum, &mixed },
+        { "sum", sum, &neg },
+        { "less", less, &same },
+        { "less", less, &mixed },
+        { "less", less, &big },
+        { "less", less, &neg },
+        { "equal", equal, &same },
+        { "equal", equal, &mixed },
+        { "equal", equal, &big },
+        { "equal", equal, &neg },
+        { "round", round_half_away, &same },
+        { "round", round_half_away, &mixed },
+        { "round", round_half_away, &big },
+        { "round_half_even", round_half_even, &same },
+        { "round_half_even", round_half_even, &mixed },
+        { "round_n_half_even", round_n_half_even, &same },
+        { "round_n_half_even", round_n_half_even, &mixed },
+        { "increment", increment, &same },
+        { "increment", increment, &mixed },
+        { "decrement", decrement, &same },
+        { "decrement", decrement, &mixed },
+        { "stream_out", stream_out, &mixed },
+        { "stream_in", stream_in, &mixed },
+        { "construct_from_string", construct_from_string, &mixed },
+        { "divide_by_zero", divide_by_zero, &big_few },
+        { "multiply_overflow", multiply_overflow, &big_few }
+    };
+
+    if (!options.json)
+    {
+        cout << "Running Decimal benchmark." << endl;
+    }
+    vector<Result> results;
+    size_t const num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+    for (size_t i = 0; i != num_benchmarks; ++i)
+    {
+        Benchmark const& benchmark = benchmarks[i];
+        string const full_name =
+            string(benchmark.name) + '/' + benchmark.dataset->name;
+        if (full_name.find(options.filter) == string::npos)
+        {
+            continue;
+        }
+        try
+        {
+            results.push_back(run(benchmark, options));
+        }
+        catch (std::exception& e)
+        {
+            cerr << full_name << " failed: " << e.what() << endl;
+            return 1;
+        }
+    }
+    if (options.json)
+    {
+        write_json(cout, options, results);
+    }
+    else
+    {
+        write_table(cout, results);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    return decimal_benchmark(argc, argv);
+}
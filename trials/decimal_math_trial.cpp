@@ -0,0 +1,151 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal.hpp"
+#include "decimal_math.hpp"
+#include "stopwatch.hpp"
+#include <boost/lexical_cast.hpp>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using boost::lexical_cast;
+using jewel::Decimal;
+using jewel::Stopwatch;
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::ostringstream;
+using std::setprecision;
+using std::string;
+using std::vector;
+
+// Compares the Decimal math functions with the common alternative of
+// converting to double via a string, calling the <cmath> function, and
+// converting back.
+
+namespace
+{
+
+Decimal::places_type const places = 8;
+
+enum Function
+{
+    sqrt_function,
+    exp_function,
+    ln_function,
+    pow_function
+};
+
+char const* function_name(Function p_function)
+{
+    switch (p_function)
+    {
+    case sqrt_function: return "sqrt";
+    case exp_function: return "exp";
+    case ln_function: return "ln";
+    case pow_function: return "pow";
+    }
+    return "";
+}
+
+int const exponent = 4;
+
+Decimal via_decimal(Function p_function, Decimal const& x)
+{
+    switch (p_function)
+    {
+    case sqrt_function: return jewel::sqrt(x, places);
+    case exp_function: return jewel::exp(x, places);
+    case ln_function: return jewel::ln(x, places);
+    case pow_function: return jewel::pow(x, exponent, places);
+    }
+    return x;
+}
+
+Decimal via_double(Function p_function, Decimal const& x)
+{
+    double const d = lexical_cast<double>(lexical_cast<string>(x));
+    double result = 0.0;
+    switch (p_function)
+    {
+    case sqrt_function: result = std::sqrt(d); break;
+    case exp_function: result = std::exp(d); break;
+    case ln_function: result = std::log(d); break;
+    case pow_function: result = std::pow(d, exponent); break;
+    }
+    ostringstream oss;
+    oss << fixed << setprecision(places) << result;
+    return Decimal(oss.str());
+}
+
+}  // end anonymous namespace
+
+int decimal_math_trial()
+{
+    cout << "Running Decimal math trial." << endl;
+
+    int const lim = 100000;
+    vector<Decimal> vec;
+    for (int i = 0; i != lim; ++i)
+    {
+        // Spread over (0.01, 5.01).
+        vec.push_back(Decimal(1 + (i * 7919) % 500000, 5));
+    }
+    Function const functions[] =
+    {   sqrt_function, exp_function, ln_function, pow_function
+    };
+    for (auto function: functions)
+    {
+        Decimal total;
+        Stopwatch sw_decimal;
+        for (auto const& x: vec)
+        {
+            total += via_decimal(function, x);
+        }
+        double const decimal_seconds = sw_decimal.seconds_elapsed();
+
+        Decimal double_total;
+        Stopwatch sw_double;
+        for (auto const& x: vec)
+        {
+            double_total += via_double(function, x);
+        }
+        double const double_seconds = sw_double.seconds_elapsed();
+
+        int discrepancies = 0;
+        for (auto const& x: vec)
+        {
+            if (!(via_decimal(function, x) == via_double(function, x)))
+            {
+                ++discrepancies;
+            }
+        }
+        cout << lim << " calls to " << function_name(function)
+             << " take " << decimal_seconds << " seconds, versus "
+             << double_seconds << " seconds via double. Results differ in "
+             << discrepancies << " cases." << endl;
+    }
+    return 0;
+}
+
+int main()
+{
+    return decimal_math_trial();
+}
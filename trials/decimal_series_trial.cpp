@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decimal.hpp"
+#include "decimal_series.hpp"
+#include "stopwatch.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using jewel::Decimal;
+using jewel::DecimalSeries;
+using jewel::Stopwatch;
+using std::cout;
+using std::endl;
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+
+// Measures the compression achieved by DecimalSeries on a price-like
+// random walk, and the speed of decoding it, compared with holding
+// and copying the values as plain Decimals.
+
+namespace
+{
+
+double gigabytes_per_second(size_t p_bytes, double p_seconds)
+{
+    return p_bytes / p_seconds / 1e9;
+}
+
+}  // end anonymous namespace
+
+int decimal_series_trial()
+{
+    cout << "Running Decimal series trial." << endl;
+
+    size_t const lim = 10000000;
+    vector<Decimal> vec;
+    vec.reserve(lim);
+    Decimal::int_type x = 1234500;
+    uint64_t r = 88172645463325252ULL;
+    for (size_t i = 0; i != lim; ++i)
+    {
+        // Moves by up to 5 ticks at a time.
+        r ^= r << 13;
+        r ^= r >> 7;
+        r ^= r << 17;
+        x += static_cast<Decimal::int_type>(r % 11) - 5;
+        vec.push_back(Decimal(x, 4));
+    }
+
+    DecimalSeries series(4);
+    Stopwatch sw_append;
+    series.append(&vec[0], vec.size());
+    cout << lim << " appends take " << sw_append.seconds_elapsed()
+         << " seconds." << endl;
+
+    size_t const plain_bytes = lim * sizeof(Decimal);
+    cout << "Compression ratio versus vector<Decimal>: "
+         << static_cast<double>(plain_bytes) / series.memory_usage()
+         << " (" << series.memory_usage() << " bytes versus "
+         << plain_bytes << " bytes)." << endl;
+
+    vector<Decimal::int_type> intvals(DecimalSeries::block_size);
+    Decimal::int_type checksum = 0;
+    Stopwatch sw_decode_blocks;
+    for (size_t i = 0; i != series.block_count(); ++i)
+    {
+        size_t const n = series.decode_block(i, &intvals[0]);
+        checksum += intvals[n - 1];
+    }
+    double const block_seconds = sw_decode_blocks.seconds_elapsed();
+    size_t const intval_bytes = lim * sizeof(Decimal::int_type);
+    cout << "Decoding all blocks to underlying integers takes "
+         << block_seconds << " seconds ("
+         << gigabytes_per_second(intval_bytes, block_seconds)
+         << " GB/s of integers)." << endl;
+
+    vector<Decimal> decoded(lim);
+    Stopwatch sw_decode;
+    series.decode(0, lim, &decoded[0]);
+    double const decode_seconds = sw_decode.seconds_elapsed();
+    cout << "Decoding all values to Decimals takes " << decode_seconds
+         << " seconds ("
+         << gigabytes_per_second(plain_bytes, decode_seconds)
+         << " GB/s of Decimals)." << endl;
+
+    Stopwatch sw_copy;
+    vector<Decimal> copied(vec);
+    double const copy_seconds = sw_copy.seconds_elapsed();
+    cout << "Copying the uncompressed values takes " << copy_seconds
+         << " seconds ("
+         << gigabytes_per_second(plain_bytes, copy_seconds)
+         << " GB/s)." << endl;
+
+    if (!(decoded == vec) || !(copied == vec) || checksum == 0)
+    {
+        cout << "Decoded values differ from originals!" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    return decimal_series_trial();
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using jewel::Decimal;
+using std::cout;
+using std::endl;
+using std::thread;
+using std::vector;
+
+// Measures how Decimal throughput scales with the number of threads. As
+// Decimal has no mutable shared state, throughput should scale roughly
+// linearly up to the number of hardware threads.
+//
+// Wall-clock time is used here, rather than jewel::Stopwatch, as the
+// latter measures processor time summed over all threads.
+
+namespace
+{
+
+int const ops_per_thread = 1000000;
+
+void work(vector<Decimal> const& p_vec, Decimal& p_result)
+{
+    Decimal total;
+    Decimal::places_type const places = 4;
+    vector<Decimal>::size_type const sz = p_vec.size();
+    for (int i = 0; i != ops_per_thread; ++i)
+    {
+        Decimal x = p_vec[i % sz];
+        ++x;
+        x *= p_vec[(i + 1) % sz];
+        total = round(total + x, places);
+        if (total > Decimal("1000000"))
+        {
+            total = Decimal("0");
+        }
+    }
+    p_result = total;
+}
+
+// Returns the wall-clock seconds taken for p_num_threads threads each to
+// perform ops_per_thread iterations of work().
+double run(vector<Decimal> const& p_vec, unsigned int p_num_threads)
+{
+    vector<Decimal> results(p_num_threads);
+    vector<thread> threads;
+    auto const start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i != p_num_threads; ++i)
+    {
+        threads.push_back
+        (   thread(work, std::cref(p_vec), std::ref(results[i]))
+        );
+    }
+    for (auto& t: threads)
+    {
+        t.join();
+    }
+    std::chrono::duration<double> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+}  // end anonymous namespace
+
+int decimal_thread_trial()
+{
+    cout << "Running Decimal thread scaling trial." << endl;
+    vector<Decimal> vec;
+    vec.push_back(Decimal("3.2"));
+    vec.push_back(Decimal("98.357"));
+    vec.push_back(Decimal("0.0000001"));
+    vec.push_back(Decimal("-12.5"));
+    vec.push_back(Decimal("7"));
+
+    unsigned int const max_threads =
+        std::max(thread::hardware_concurrency(), 1u);
+    double const base_seconds = run(vec, 1);
+    for (unsigned int n = 1; n <= max_threads; n *= 2)
+    {
+        double const seconds = (n == 1)? base_seconds: run(vec, n);
+        double const speedup = n * base_seconds / seconds;
+        cout << n << " thread(s) perform " << n * ops_per_thread
+             << " iterations in " << seconds << " seconds: "
+             << "throughput is " << speedup << " times that of 1 thread."
+             << endl;
+    }
+    return 0;
+}
+
+int main()
+{
+    return decimal_thread_trial();
+}
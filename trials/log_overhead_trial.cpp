@@ -0,0 +1,209 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JEWEL_ENABLE_LOGGING
+#   define JEWEL_ENABLE_LOGGING
+#endif
+
+#include "log.hpp"
+#include "to_chars.hpp"
+#include <boost/lexical_cast.hpp>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using jewel::Log;
+using std::cout;
+using std::endl;
+using std::size_t;
+using std::string;
+
+// Measures the cost per call of logging statements: those that are
+// filtered out by the runtime threshold or by having their site disabled,
+// and those that are logged. Also compares the conversion of values by
+// jewel::to_chars, as done by JEWEL_LOG_VALUE for numbers, with that by
+// boost::lexical_cast. Logged records are written to
+// "log_overhead_trial.log".
+
+namespace
+{
+
+char const* const filepath = "log_overhead_trial.log";
+
+size_t const filtered_calls = 100000000;
+size_t const logged_calls = 200000;
+
+// Keeps the compiler from optimizing away the values converted.
+size_t volatile sink = 0;
+
+void below_threshold(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        JEWEL_LOG_MESSAGE(Log::trace, "Below the threshold.");
+    }
+}
+
+void below_threshold_out_of_line(size_t p_calls)
+{
+    // This is what a statement below the threshold cost before the
+    // threshold was checked inline.
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        Log::log
+        (   Log::trace,
+            "Below the threshold.",
+            __func__,
+            __FILE__,
+            __LINE__,
+            __DATE__,
+            __TIME__
+        );
+    }
+}
+
+void site_disabled(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        JEWEL_LOG_MESSAGE(Log::info, "From a disabled site.");
+    }
+}
+
+void every_n(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        JEWEL_LOG_EVERY_N(Log::info, 1000000, "Every millionth call.");
+    }
+}
+
+void log_message(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        JEWEL_LOG_MESSAGE(Log::info, "Logged.");
+    }
+}
+
+void log_value(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        double const x = static_cast<double>(i) / 7;
+        JEWEL_LOG_VALUE(Log::info, x);
+    }
+}
+
+void to_chars_double(size_t p_calls)
+{
+    char buffer[jewel::max_numeric_chars];
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        double const x = static_cast<double>(i) / 7;
+        char* const last =
+            jewel::to_chars(buffer, buffer + sizeof(buffer), x);
+        sink += static_cast<size_t>(last - buffer);
+    }
+}
+
+void lexical_cast_int(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        sink += boost::lexical_cast<string>(i).size();
+    }
+}
+
+void lexical_cast_double(size_t p_calls)
+{
+    for (size_t i = 0; i != p_calls; ++i)
+    {
+        double const x = static_cast<double>(i) / 7;
+        sink += boost::lexical_cast<string>(x).size();
+    }
+}
+
+void report(char const* p_name, void (*p_function)(size_t), size_t p_calls)
+{
+    auto const start = std::chrono::steady_clock::now();
+    p_function(p_calls);
+    std::chrono::duration<double, std::nano> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    cout << std::left << std::setw(44) << p_name
+         << std::right << std::setw(10) << std::fixed << std::setprecision(2)
+         << elapsed.count() / p_calls << " ns per call" << endl;
+    return;
+}
+
+}  // end anonymous namespace
+
+int log_overhead_trial()
+{
+    cout << "Running Log overhead trial." << endl;
+    Log::set_filepath(filepath);
+    Log::set_threshold(Log::info);
+    Log::disable_sites("site_disabled");
+
+    cout << "Filtered out:" << endl;
+    report
+    (   "JEWEL_LOG_MESSAGE below threshold",
+        below_threshold,
+        filtered_calls
+    );
+    report
+    (   "Log::log below threshold",
+        below_threshold_out_of_line,
+        filtered_calls
+    );
+    report
+    (   "JEWEL_LOG_MESSAGE from disabled site",
+        site_disabled,
+        filtered_calls
+    );
+    report("JEWEL_LOG_EVERY_N (n = 1000000)", every_n, filtered_calls);
+
+    cout << "Logged, synchronously:" << endl;
+    report("JEWEL_LOG_MESSAGE", log_message, logged_calls);
+    report("JEWEL_LOG_VALUE (double)", log_value, logged_calls);
+
+    cout << "Logged, asynchronously:" << endl;
+    Log::set_asynchronous();
+    report("JEWEL_LOG_MESSAGE", log_message, logged_calls);
+    report("JEWEL_LOG_VALUE (double)", log_value, logged_calls);
+    Log::set_synchronous();
+
+    cout << "Conversion of values:" << endl;
+    report
+    (   "boost::lexical_cast<string>(size_t)",
+        lexical_cast_int,
+        logged_calls
+    );
+    report
+    (   "boost::lexical_cast<string>(double)",
+        lexical_cast_double,
+        logged_calls
+    );
+    report("jewel::to_chars(double)", to_chars_double, logged_calls);
+    return 0;
+}
+
+int main()
+{
+    return log_overhead_trial();
+}
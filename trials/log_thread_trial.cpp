@@ -0,0 +1,121 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef JEWEL_ENABLE_LOGGING
+#   define JEWEL_ENABLE_LOGGING
+#endif
+
+#include "log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using jewel::Log;
+using std::cout;
+using std::endl;
+using std::thread;
+using std::vector;
+
+// Measures how the throughput of jewel::Log scales with the number of
+// threads logging at once, in both synchronous and asynchronous mode. The
+// maximum number of threads may be passed as an argument; by default, it
+// is the number of hardware threads.
+// The records are written to "log_thread_trial.log".
+//
+// In asynchronous mode, the time taken includes the time taken to
+// write the records still queued when the logging threads finish.
+
+namespace
+{
+
+char const* const filepath = "log_thread_trial.log";
+
+int const records_per_thread = 100000;
+
+void work()
+{
+    for (int i = 0; i != records_per_thread; ++i)
+    {
+        JEWEL_LOG_MESSAGE(Log::info, "Logging from a worker thread.");
+    }
+}
+
+// Returns the wall-clock seconds taken for p_num_threads threads each to
+// log records_per_thread records.
+double run(unsigned int p_num_threads, bool p_asynchronous)
+{
+    auto const start = std::chrono::steady_clock::now();
+    if (p_asynchronous)
+    {
+        Log::set_asynchronous();
+    }
+    vector<thread> threads;
+    for (unsigned int i = 0; i != p_num_threads; ++i)
+    {
+        threads.push_back(thread(work));
+    }
+    for (auto& t: threads)
+    {
+        t.join();
+    }
+    Log::set_synchronous();
+    std::chrono::duration<double> const elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void report(unsigned int p_max_threads, bool p_asynchronous)
+{
+    cout << (p_asynchronous? "Asynchronous": "Synchronous")
+         << " logging:" << endl;
+    for (unsigned int n = 1; n <= p_max_threads; n *= 2)
+    {
+        double const seconds = run(n, p_asynchronous);
+        double const records = static_cast<double>(n) * records_per_thread;
+        cout << n << " thread(s) log " << records
+             << " records in " << seconds << " seconds: "
+             << static_cast<long>(records / seconds) << " records per second."
+             << endl;
+    }
+    return;
+}
+
+}  // end anonymous namespace
+
+int log_thread_trial(unsigned int p_max_threads)
+{
+    cout << "Running Log thread scaling trial." << endl;
+    Log::set_filepath(filepath);
+    Log::set_threshold(Log::info);
+    report(p_max_threads, false);
+    report(p_max_threads, true);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int max_threads = std::max(thread::hardware_concurrency(), 1u);
+    if (argc > 1)
+    {
+        max_threads = std::max(std::atoi(argv[1]), 1);
+    }
+    return log_thread_trial(max_threads);
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "decimal.hpp"
+#include "on_windows.hpp"
+#include "record_writer.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef JEWEL_ON_WINDOWS
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using jewel::Decimal;
+using jewel::FileDescriptorSink;
+using jewel::MemorySink;
+using jewel::RecordWriter;
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::ostringstream;
+using std::size_t;
+using std::string;
+using std::uint64_t;
+using std::vector;
+
+// Compares the speed of exporting records of an account code, an amount
+// and a quantity as CSV, using an ostream, with that of using a
+// RecordWriter, both in memory and to a file.
+//
+// Wall-clock time is used here, rather than jewel::Stopwatch, so that time
+// spent in system calls is included.
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point p_start)
+{
+    std::chrono::duration<double> const elapsed = Clock::now() - p_start;
+    return elapsed.count();
+}
+
+struct Entry
+{
+    string account;
+    Decimal amount;
+    long long quantity;
+};
+
+}  // end anonymous namespace
+
+int record_writer_trial()
+{
+    cout << "Running record writer trial." << endl;
+
+    size_t const lim = 1000000;
+    vector<Entry> entries;
+    entries.reserve(lim);
+    uint64_t r = 88172645463325252ULL;
+    for (size_t i = 0; i != lim; ++i)
+    {
+        r ^= r << 13;
+        r ^= r >> 7;
+        r ^= r << 17;
+        Entry entry;
+        entry.account = "ACC-" + std::to_string(r % 1000);
+        Decimal::int_type const cents =
+            static_cast<Decimal::int_type>(r % 20000000) - 10000000;
+        entry.amount = Decimal(cents, 2);
+        entry.quantity = static_cast<long long>(r % 500);
+        entries.push_back(entry);
+    }
+
+    Clock::time_point const stream_start = Clock::now();
+    ostringstream oss;
+    for (size_t i = 0; i != lim; ++i)
+    {
+        oss << entries[i].account << ','
+            << entries[i].amount << ','
+            << entries[i].quantity << '\n';
+    }
+    double const stream_seconds = seconds_since(stream_start);
+    cout << lim << " records written to an ostringstream take "
+         << stream_seconds << " seconds." << endl;
+
+    Clock::time_point const writer_start = Clock::now();
+    MemorySink memory_sink;
+    {
+        RecordWriter writer(memory_sink, RecordWriter::csv);
+        for (size_t i = 0; i != lim; ++i)
+        {
+            writer.append(entries[i].account)
+                  .append(entries[i].amount)
+                  .append(entries[i].quantity);
+            writer.end_record();
+        }
+    }
+    double const writer_seconds = seconds_since(writer_start);
+    cout << lim << " records written to a MemorySink take "
+         << writer_seconds << " seconds." << endl;
+
+    if (memory_sink.contents() != oss.str())
+    {
+        cout << "Output differs!" << endl;
+        return 1;
+    }
+
+    char const* const filepath = "record_writer_trial.csv";
+    Clock::time_point const file_stream_start = Clock::now();
+    {
+        ofstream file(filepath);
+        for (size_t i = 0; i != lim; ++i)
+        {
+            file << entries[i].account << ','
+                 << entries[i].amount << ','
+                 << entries[i].quantity << endl;
+        }
+    }
+    cout << lim << " records written to an ofstream, flushing each, take "
+         << seconds_since(file_stream_start) << " seconds." << endl;
+
+#   ifndef JEWEL_ON_WINDOWS
+        Clock::time_point const file_writer_start = Clock::now();
+        int const fd = ::open(filepath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1)
+        {
+            cout << "Could not open " << filepath << endl;
+            return 1;
+        }
+        {
+            FileDescriptorSink file_sink(fd);
+            RecordWriter writer(file_sink, RecordWriter::csv);
+            for (size_t i = 0; i != lim; ++i)
+            {
+                writer.append(entries[i].account)
+                      .append(entries[i].amount)
+                      .append(entries[i].quantity);
+                writer.end_record();
+            }
+        }
+        ::close(fd);
+        cout << lim << " records written to a file descriptor take "
+             << seconds_since(file_writer_start) << " seconds." << endl;
+#   endif
+
+    std::remove(filepath);
+    return 0;
+}
+
+int main()
+{
+    return record_writer_trial();
+}